@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+#include "fixtures.hpp"
+#include <estar/Facade.hpp>
+#include <estar/Algorithm.hpp>
+#include <estar/numeric.hpp>
+
+
+using namespace estar;
+
+
+Facade * create_walled(ssize_t size)
+{
+  Facade * facade(Facade::CreateDefault(size, size, 1));
+  for (ssize_t iy(size / 4); iy < size; ++iy)
+    facade->SetMeta(size / 2, iy, facade->GetObstacleMeta());
+  return facade;
+}
+
+
+size_t flush(Facade & facade)
+{
+  size_t const step0(facade.GetAlgorithm().GetStep());
+  while (facade.HaveWork())
+    facade.ComputeOne();
+  return facade.GetAlgorithm().GetStep() - step0;
+}
+
+
+double max_delta(Facade const & one, Facade const & two, ssize_t size)
+{
+  double maxdelta(0);
+  for (ssize_t ix(0); ix < size; ++ix)
+    for (ssize_t iy(0); iy < size; ++iy) {
+      double const v1(one.GetValue(ix, iy));
+      double const v2(two.GetValue(ix, iy));
+      if ((infinity == v1) != (infinity == v2))
+	return infinity;
+      if ((infinity != v1) && (absval(v1 - v2) > maxdelta))
+	maxdelta = absval(v1 - v2);
+    }
+  return maxdelta;
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+/**
+   Fixtures shared by the test programs that compare several ways of
+   computing the same navigation function.
+*/
+
+
+#ifndef FIXTURES_HPP
+#define FIXTURES_HPP
+
+
+#include <sys/types.h>
+#include <stddef.h>
+
+
+namespace estar {
+  class Facade;
+}
+
+
+/** Facade::CreateDefault(size, size, 1) with a wall at
+    x=size/2 that runs from y=size/4 to the upper border. No goal is
+    set. */
+estar::Facade * create_walled(ssize_t size);
+
+/** Call Facade::ComputeOne() until there is no work left.
+    \return The number of steps that took. */
+size_t flush(estar::Facade & facade);
+
+/** \return The largest difference between the values of the two
+    facades over [0, size) x [0, size), or infinity if they do not
+    agree on which cells are reachable. */
+double max_delta(estar::Facade const & one, estar::Facade const & two,
+		 ssize_t size);
+
+#endif // FIXTURES_HPP
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+/**
+   Converts a map into a TileStore file, for planning on maps that do
+   not fit into memory (see Facade::SetTileStore()). The input is
+   either an ASCII grid as read by test_estar_gfx, or a PGM image (P2
+   or P5, recognized by its magic number), see convert_ascii_grid()
+   and convert_pgm() for how costs become metas.
+   
+   usage: map2tiles [-t tilesize] [-v] input output
+   
+   -t  edge length of the tiles, a power of two (default 64)
+   -v  reserve a channel for the values in each tile
+*/
+
+
+#include <estar/TileStore.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <stdlib.h>
+
+
+using namespace estar;
+using namespace boost;
+using namespace std;
+
+
+static void usage(char const * self)
+{
+  cerr << "usage: " << self << " [-t tilesize] [-v] input output\n";
+  exit(EXIT_FAILURE);
+}
+
+
+int main(int argc, char ** argv)
+{
+  ssize_t tilesize(64);
+  bool with_values(false);
+  int iarg(1);
+  for (/**/; (iarg < argc) && ('-' == argv[iarg][0]); ++iarg) {
+    string const opt(argv[iarg]);
+    if ("-v" == opt)
+      with_values = true;
+    else if (("-t" == opt) && (iarg + 1 < argc)) {
+      istringstream is(argv[++iarg]);
+      if ( ! (is >> tilesize) || (tilesize < 1)
+	  || (0 != (tilesize & (tilesize - 1)))) {
+	cerr << argv[0] << ": invalid tilesize \"" << argv[iarg] << "\"\n";
+	exit(EXIT_FAILURE);
+      }
+    }
+    else
+      usage(argv[0]);
+  }
+  if (iarg + 2 != argc)
+    usage(argv[0]);
+  string const infile(argv[iarg]);
+  string const outfile(argv[iarg + 1]);
+  
+  char magic[2] = { 0, 0 };
+  {
+    ifstream is(infile.c_str(), ios::binary);
+    if ( ! is) {
+      cerr << argv[0] << ": couldn't open \"" << infile << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+    is.read(magic, 2);
+  }
+  bool const pgm(('P' == magic[0])
+		 && (('2' == magic[1]) || ('5' == magic[1])));
+  
+  scoped_ptr<TileStore> store;
+  try {
+    if (pgm)
+      store.reset(convert_pgm(infile, outfile, tilesize, with_values, 1,
+			      &cerr));
+    else
+      store.reset(convert_ascii_grid(infile, outfile, tilesize, with_values,
+				     1, &cerr));
+  }
+  catch (std::exception const & ee) {
+    cerr << argv[0] << ": " << ee.what() << "\n";
+    exit(EXIT_FAILURE);
+  }
+  if ( ! store)
+    exit(EXIT_FAILURE);
+  
+  cout << outfile << ": " << (pgm ? "PGM" : "ASCII grid")
+       << " range [" << store->GetXBegin() << ", " << store->GetXEnd()
+       << "[ x [" << store->GetYBegin() << ", " << store->GetYEnd()
+       << "[, tiles of " << tilesize << "x" << tilesize
+       << (with_values ? " with values" : "")
+       << ", " << store->GetFileSize() << " bytes\n";
+}
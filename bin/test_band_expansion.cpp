@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+
+/**
+   Compares band expansion (see Algorithm::SetBandExpansion()) with
+   single expansions: a grid with a few walls is propagated from a
+   corner, then a new wall is inserted and the values are repaired.
+   This is done for an increasing number of threads and for a band
+   that is wider than what keeps the results exact. Finally, the
+   band is combined with check_queue_key, where the workers must not
+   query the queue themselves. The queue-key check depends on the
+   expansion order, so that case compares against a band expanded by
+   a single thread. Reports the timings, the number of steps, and
+   the largest value difference.
+
+   usage: test_band_expansion [size [max_threads]]
+*/
+
+
+#include "fixtures.hpp"
+#include <estar/Facade.hpp>
+#include <estar/Algorithm.hpp>
+#include <estar/Kernel.hpp>
+#include <estar/util.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+using namespace estar;
+using namespace boost;
+using namespace std;
+
+
+/** Uses Facade::CreateDefault() unless options are given. */
+static Facade * create(ssize_t size, AlgorithmOptions const * options)
+{
+  Facade * facade(options
+		  ? Facade::Create("lsm", 1, GridOptions(0, size, 0, size),
+				   *options, stderr)
+		  : Facade::CreateDefault(size, size, 1));
+  for (ssize_t ii(0); ii < size; ++ii) {
+    if (ii > size / 5)
+      facade->SetMeta(size / 3, ii, facade->GetObstacleMeta());
+    if (ii < 4 * size / 5)
+      facade->SetMeta(2 * size / 3, ii, facade->GetObstacleMeta());
+  }
+  facade->AddGoal(1, 1, 0);
+  return facade;
+}
+
+
+static void add_wall(Facade & facade, ssize_t size)
+{
+  for (ssize_t iy(size / 10); iy < size; ++iy)
+    facade.SetMeta(size / 6, iy, facade.GetObstacleMeta());
+}
+
+
+/** Runs without slack: with slack, the values depend on the
+    expansion order by up to the slack per cell along the wavefront,
+    which would hide real differences. */
+static double propagate(Facade & facade)
+{
+  Algorithm & algo(facade.GetAlgorithm());
+  Kernel const & kernel(facade.GetKernel());
+  double const t0(get_monotonic_time());
+  while (algo.HaveWork())
+    algo.ComputeOne(kernel, 0);
+  return get_monotonic_time() - t0;
+}
+
+
+static bool run(Facade const & reference, Facade const & repaired,
+		ssize_t size, size_t nthreads, double width, double tolerance,
+		AlgorithmOptions const * options)
+{
+  scoped_ptr<Facade> facade(create(size, options));
+  facade->SetBandExpansion(nthreads, width);
+  size_t const step0(facade->GetAlgorithm().GetStep());
+  double const tinit(propagate(*facade));
+  size_t const ninit(facade->GetAlgorithm().GetStep() - step0);
+  double const dinit(max_delta(reference, *facade, size));
+  add_wall(*facade, size);
+  size_t const step1(facade->GetAlgorithm().GetStep());
+  double const trepair(propagate(*facade));
+  size_t const nrepair(facade->GetAlgorithm().GetStep() - step1);
+  double const drepair(max_delta(repaired, *facade, size));
+  printf("band %.2f  %2zu thread(s)  init %7.3f s %7zu steps  delta %-9.3g"
+	 "  repair %7.3f s %7zu steps  delta %g\n",
+	 width, nthreads, tinit, ninit, dinit, trepair, nrepair, drepair);
+  if ((dinit > tolerance) || (drepair > tolerance)) {
+    printf("ERROR band %g with %zu threads differs from single expansions\n",
+	   width, nthreads);
+    return false;
+  }
+  return true;
+}
+
+
+int main(int argc, char ** argv)
+{
+  ssize_t size(400);
+  if (argc > 1) {
+    istringstream is(argv[1]);
+    if ( ! (is >> size) || (size < 10)) {
+      cerr << argv[0] << ": invalid size \"" << argv[1] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+  size_t max_threads(8);
+  if (argc > 2) {
+    istringstream is(argv[2]);
+    if ( ! (is >> max_threads) || (max_threads < 1)) {
+      cerr << argv[0] << ": invalid max_threads \"" << argv[2] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  scoped_ptr<Facade> reference(create(size, 0));
+  double const tinit(propagate(*reference));
+  size_t const ninit(reference->GetAlgorithm().GetStep());
+  scoped_ptr<Facade> repaired(create(size, 0));
+  propagate(*repaired);
+  add_wall(*repaired, size);
+  size_t const step1(repaired->GetAlgorithm().GetStep());
+  double const trepair(propagate(*repaired));
+  size_t const nrepair(repaired->GetAlgorithm().GetStep() - step1);
+  printf("grid %zdx%zd\n"
+	 "single               init %7.3f s %7zu steps"
+	 "                  repair %7.3f s %7zu steps\n",
+	 size, size, tinit, ninit, trepair, nrepair);
+
+  bool ok(true);
+  double const tolerance(1e-6 * reference->scale);
+  for (size_t nthreads(1); nthreads <= max_threads; nthreads *= 2)
+    ok &= run(*reference, *repaired, size, nthreads, 0.5, tolerance, 0);
+  ok &= run(*reference, *repaired, size, max_threads, 2, tolerance, 0);
+  
+  AlgorithmOptions const keyed(false, false, true, false, false);
+  reference.reset(create(size, &keyed));
+  reference->SetBandExpansion(1, 0.5);
+  propagate(*reference);
+  repaired.reset(create(size, &keyed));
+  repaired->SetBandExpansion(1, 0.5);
+  propagate(*repaired);
+  add_wall(*repaired, size);
+  propagate(*repaired);
+  printf("check_queue_key\n");
+  ok &= run(*reference, *repaired, size, max_threads, 0.5, tolerance,
+	    &keyed);
+
+  if ( ! ok) {
+    printf("FAILURE\n");
+    exit(EXIT_FAILURE);
+  }
+  printf("SUCCESS\n");
+}
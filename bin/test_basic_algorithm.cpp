@@ -0,0 +1,160 @@
+/* 
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+/**
+   Compares BasicAlgorithm against Algorithm on a Grid: propagates
+   from a goal in the corner, then inserts a wall and repairs, and
+   finally moves the goal by a few cells and repairs again. The
+   values must be identical, and the timings show the speedup of the
+   compile-time specialized version. The first configuration is the
+   LSM four-connected one built by Facade::CreateDefault().
+   
+   usage: test_basic_algorithm [size]
+*/
+
+
+#include <estar/BasicAlgorithm.hpp>
+#include <estar/Algorithm.hpp>
+#include <estar/Grid.hpp>
+#include <estar/GridNode.hpp>
+#include <estar/CSpace.hpp>
+#include <estar/util.hpp>
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+using namespace estar;
+using namespace boost;
+using namespace std;
+
+
+template<class BasicKernelT, class NeighborhoodT>
+static bool run(char const * name, ssize_t size,
+		shared_ptr<Grid> grid, shared_ptr<Kernel> kernel,
+		BasicKernelT const & basic_kernel)
+{
+  double const slack(kernel->scale / 10000);
+  Algorithm algo(grid->GetCSpace(), false, false, false, false, false);
+  BasicAlgorithm<BasicKernelT, NeighborhoodT>
+    basic(size, size, basic_kernel);
+  
+  double tt[4];
+  tt[0] = get_monotonic_time();
+  algo.AddGoal(grid->GetNode(0, 0)->vertex, 0);
+  while (algo.HaveWork())
+    algo.ComputeOne(*kernel, slack);
+  tt[1] = get_monotonic_time();
+  for (ssize_t iy(size / 4); iy < 3 * size / 4; ++iy)
+    algo.SetMeta(grid->GetNode(size / 2, iy)->vertex,
+		 kernel->obstacle_meta, *kernel);
+  while (algo.HaveWork())
+    algo.ComputeOne(*kernel, slack);
+  tt[2] = get_monotonic_time();
+  algo.RemoveAllGoals();
+  algo.AddGoal(grid->GetNode(2, 1)->vertex, 0);
+  while (algo.HaveWork())
+    algo.ComputeOne(*kernel, slack);
+  tt[3] = get_monotonic_time();
+  
+  double bt[4];
+  bt[0] = get_monotonic_time();
+  basic.AddGoal(0, 0, 0);
+  while (basic.HaveWork())
+    basic.ComputeOne(slack);
+  bt[1] = get_monotonic_time();
+  for (ssize_t iy(size / 4); iy < 3 * size / 4; ++iy)
+    basic.SetMeta(size / 2, iy, BasicKernelT::traits::obstacle_meta());
+  while (basic.HaveWork())
+    basic.ComputeOne(slack);
+  bt[2] = get_monotonic_time();
+  basic.RemoveAllGoals();
+  basic.AddGoal(2, 1, 0);
+  while (basic.HaveWork())
+    basic.ComputeOne(slack);
+  bt[3] = get_monotonic_time();
+  
+  size_t mismatch(0);
+  for (ssize_t ix(0); ix < size; ++ix)
+    for (ssize_t iy(0); iy < size; ++iy)
+      if (basic.GetValue(ix, iy)
+	  != grid->GetCSpace()->GetValue(grid->GetNode(ix, iy)->vertex))
+	++mismatch;
+  
+  printf("%-10s  Algorithm %6.3f %6.3f %6.3f  BasicAlgorithm %6.3f %6.3f %6.3f"
+	 "  speedup %4.1f  steps %zu %zu  %s\n", name,
+	 tt[1] - tt[0], tt[2] - tt[1], tt[3] - tt[2],
+	 bt[1] - bt[0], bt[2] - bt[1], bt[3] - bt[2],
+	 (tt[3] - tt[0]) / (bt[3] - bt[0]), algo.GetStep(), basic.GetStep(),
+	 mismatch ? "MISMATCH" : "ok");
+  return (0 == mismatch) && (algo.GetStep() == basic.GetStep());
+}
+
+
+int main(int argc, char ** argv)
+{
+  ssize_t size(300);
+  if (argc > 1) {
+    istringstream is(argv[1]);
+    if ( ! (is >> size) || (size < 10)) {
+      cerr << argv[0] << ": invalid size \"" << argv[1] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+  
+  printf("grid %zdx%zd, times in seconds for init, replan, and goal move\n",
+	 size, size);
+  bool ok(true);
+  {
+    shared_ptr<Grid> grid(new Grid(0, size, 0, size, Grid::FOUR,
+				   KernelTraits<LSMKernel>::freespace_meta()));
+    shared_ptr<Kernel> kernel(new LSMKernel(grid->GetCSpace(), 1));
+    ok &= run<BasicLSMKernel, FourNeighborhood>("LSM four", size, grid, kernel,
+						BasicLSMKernel(1));
+  }
+  {
+    shared_ptr<Grid> grid(new Grid(0, size, 0, size, Grid::EIGHT,
+				   KernelTraits<LSMKernel>::freespace_meta()));
+    shared_ptr<Kernel> kernel(new LSMKernel(grid->GetCSpace(), 1));
+    ok &= run<BasicLSMKernel, EightNeighborhood>("LSM eight", size, grid,
+						 kernel, BasicLSMKernel(1));
+  }
+  {
+    shared_ptr<Grid> grid(new Grid(0, size, 0, size, Grid::EIGHT,
+				   KernelTraits<NF1Kernel>::freespace_meta()));
+    shared_ptr<Kernel> kernel(new NF1Kernel());
+    ok &= run<BasicNF1Kernel, EightNeighborhood>("NF1 eight", size, grid,
+						 kernel, BasicNF1Kernel());
+  }
+  {
+    shared_ptr<Grid> grid(new Grid(0, size, 0, size, Grid::SIX,
+				   KernelTraits<AlphaKernel>::freespace_meta()));
+    shared_ptr<Kernel> kernel(new AlphaKernel(1));
+    ok &= run<BasicAlphaKernel, SixNeighborhood>("Alpha six", size, grid,
+						 kernel, BasicAlphaKernel(1));
+  }
+  if ( ! ok) {
+    printf("FAILURE\n");
+    exit(EXIT_FAILURE);
+  }
+  printf("SUCCESS\n");
+}
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+/**
+   Checks the value ceiling of Algorithm::SetCeiling() on a distance
+   field, the way pnf::Flow uses it for the environment distance: a
+   few point obstacles are goals, and only distances up to the
+   ceiling are of interest. The bounded field must agree with an
+   unbounded one below the ceiling, and report BEYOND_HORIZON above
+   it. Then an obstacle is added and another one removed, and the
+   repaired field is checked again. Finally the ceiling is lifted,
+   after which the field must be complete.
+
+   usage: test_ceiling [size [ceiling]]
+*/
+
+
+#include "fixtures.hpp"
+#include <estar/Facade.hpp>
+#include <estar/Algorithm.hpp>
+#include <estar/numeric.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+using namespace estar;
+using namespace boost;
+using namespace std;
+
+
+static bool compare(char const * what, ssize_t size, double ceiling,
+		    Facade & bounded, size_t steps, Facade & reference)
+{
+  size_t const reference_steps(flush(reference));
+  double maxdelta(0);
+  size_t nbeyond(0);
+  bool ok(true);
+  for (ssize_t ix(0); ix < size; ++ix)
+    for (ssize_t iy(0); iy < size; ++iy) {
+      double const value(reference.GetValue(ix, iy));
+      Facade::node_status_t const status(bounded.GetStatus(ix, iy));
+      if (value > ceiling) {
+	++nbeyond;
+	if (Facade::BEYOND_HORIZON != status) {
+	  printf("ERROR (%zd, %zd) has value %g but status %d\n",
+		 ix, iy, value, status);
+	  ok = false;
+	}
+	continue;
+      }
+      if ((Facade::UPWIND != status) && (Facade::GOAL != status)) {
+	printf("ERROR (%zd, %zd) has value %g but status %d\n",
+	       ix, iy, value, status);
+	ok = false;
+      }
+      double const delta(absval(bounded.GetValue(ix, iy) - value));
+      if (delta > maxdelta)
+	maxdelta = delta;
+    }
+  // incremental repairs can differ from scratch by a few times the
+  // slack
+  ok &= maxdelta <= bounded.scale / 1000;
+  printf("%-20s  %8zu  %9zu  %8zu  %10g  %s\n", what, steps,
+	 reference_steps, nbeyond, maxdelta, ok ? "ok" : "MISMATCH");
+  return ok;
+}
+
+
+int main(int argc, char ** argv)
+{
+  ssize_t size(300);
+  double ceiling(20);
+  if (argc > 1) {
+    istringstream is(argv[1]);
+    if ( ! (is >> size) || (size < 20)) {
+      cerr << argv[0] << ": invalid size \"" << argv[1] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+  if (argc > 2) {
+    istringstream is(argv[2]);
+    if ( ! (is >> ceiling) || (ceiling <= 0)) {
+      cerr << argv[0] << ": invalid ceiling \"" << argv[2] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+  
+  scoped_ptr<Facade> bounded(Facade::CreateDefault(size, size, 1));
+  scoped_ptr<Facade> reference(Facade::CreateDefault(size, size, 1));
+  bounded->SetCeiling(ceiling);
+  ssize_t const obstacle[][2] = {
+    { size / 4, size / 4 },
+    { 3 * size / 4, size / 3 },
+    { size / 2, 3 * size / 4 }
+  };
+  for (size_t ii(0); ii < 3; ++ii) {
+    bounded->AddGoal(obstacle[ii][0], obstacle[ii][1], 0);
+    reference->AddGoal(obstacle[ii][0], obstacle[ii][1], 0);
+  }
+  
+  bool ok(true);
+  printf("grid %zdx%zd, ceiling %g\n"
+	 "change                bounded  unbounded    beyond   max delta\n",
+	 size, size, ceiling);
+  size_t steps(flush(*bounded));
+  ok &= compare("initial", size, ceiling, *bounded, steps, *reference);
+  
+  bounded->AddGoal(size / 4 + 10, size / 4, 0);
+  reference->AddGoal(size / 4 + 10, size / 4, 0);
+  steps = flush(*bounded);
+  ok &= compare("AddGoal", size, ceiling, *bounded, steps, *reference);
+  
+  bounded->RemoveGoal(obstacle[1][0], obstacle[1][1]);
+  reference->RemoveGoal(obstacle[1][0], obstacle[1][1]);
+  steps = flush(*bounded);
+  ok &= compare("RemoveGoal", size, ceiling, *bounded, steps, *reference);
+  
+  bounded->SetCeiling(infinity);
+  steps = flush(*bounded);
+  ok &= compare("lift ceiling", size, infinity, *bounded, steps, *reference);
+  
+  if ( ! ok) {
+    printf("FAILURE\n");
+    exit(EXIT_FAILURE);
+  }
+  printf("SUCCESS\n");
+}
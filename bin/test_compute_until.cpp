@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+/**
+   Compares Facade::ComputeUntil() with the classic client loop
+
+   \code
+   while (facade.HaveWork() && facade.GetStatus(rx, ry) != Facade::UPWIND)
+     facade.ComputeOne();
+   \endcode
+
+   Both must stop after the same number of steps with the same robot
+   value. Then the robot cell is settled again in slices of a fixed
+   time budget. ComputeUntil() should overrun each budget by about
+   one step. Being preempted can make a slice take much longer on the
+   wall clock, which is reported but not held against ComputeUntil().
+   Instead, the processor time of each slice (see clock()) must not
+   exceed the budget by more than a tenth of it, or 0.1 ms for very
+   small budgets.
+
+   usage: test_compute_until [size [budget_ms]]
+*/
+
+
+#include "fixtures.hpp"
+#include <estar/Facade.hpp>
+#include <estar/Algorithm.hpp>
+#include <estar/util.hpp>
+#include <estar/numeric.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+
+using namespace estar;
+using namespace boost;
+using namespace std;
+
+
+int main(int argc, char ** argv)
+{
+  ssize_t size(1000);
+  if (argc > 1) {
+    istringstream is(argv[1]);
+    if ( ! (is >> size) || (size < 10)) {
+      cerr << argv[0] << ": invalid size \"" << argv[1] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+  double budget(0.005);
+  if (argc > 2) {
+    istringstream is(argv[2]);
+    if ( ! (is >> budget) || (budget <= 0)) {
+      cerr << argv[0] << ": invalid budget_ms \"" << argv[2] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+    budget *= 1e-3;
+  }
+  ssize_t const rx(size - 2);
+  ssize_t const ry(size - 2);
+
+  scoped_ptr<Facade> classic(create_walled(size));
+  classic->AddGoal(1, 1, 0);
+  double const t0(get_monotonic_time());
+  while (classic->HaveWork() && (classic->GetStatus(rx, ry) != Facade::UPWIND))
+    classic->ComputeOne();
+  double const t1(get_monotonic_time());
+
+  scoped_ptr<Facade> facade(create_walled(size));
+  facade->AddGoal(1, 1, 0);
+  double const t2(get_monotonic_time());
+  compute_progress const progress(facade->ComputeUntil(rx, ry, infinity));
+  double const t3(get_monotonic_time());
+
+  printf("grid %zdx%zd, settling the robot at (%zd, %zd)\n"
+	 "classic loop   %8.3f s  %9zu steps\n"
+	 "ComputeUntil   %8.3f s  %9zu steps\n",
+	 size, size, rx, ry,
+	 t1 - t0, classic->GetAlgorithm().GetStep(),
+	 t3 - t2, progress.nsteps);
+  if ((classic->GetAlgorithm().GetStep() != progress.nsteps)
+      || ( ! progress.settled)
+      || (classic->GetValue(rx, ry) != facade->GetValue(rx, ry))) {
+    printf("ERROR ComputeUntil() and the classic loop disagree\n");
+    exit(EXIT_FAILURE);
+  }
+
+  scoped_ptr<Facade> sliced(create_walled(size));
+  sliced->AddGoal(1, 1, 0);
+  size_t nslices(0);
+  double overrun(0);
+  double cpu_overrun(0);
+  compute_progress slice;
+  do {
+    clock_t const cpu_start(clock());
+    double const start(get_monotonic_time());
+    slice = sliced->ComputeUntil(rx, ry, budget);
+    double const used(get_monotonic_time() - start);
+    double const cpu_used(static_cast<double>(clock() - cpu_start)
+			  / CLOCKS_PER_SEC);
+    ++nslices;
+    if (used - budget > overrun)
+      overrun = used - budget;
+    if (cpu_used - budget > cpu_overrun)
+      cpu_overrun = cpu_used - budget;
+  } while (slice.deadline_passed);
+  printf("budget %.3f ms: settled after %zu slices, top key %g\n"
+	 "worst overrun %.3f ms wall clock, %.3f ms processor time\n",
+	 1e3 * budget, nslices, slice.top_key,
+	 1e3 * overrun, 1e3 * cpu_overrun);
+  if (( ! slice.settled)
+      || (classic->GetValue(rx, ry) != sliced->GetValue(rx, ry))) {
+    printf("ERROR sliced ComputeUntil() did not settle the robot\n");
+    exit(EXIT_FAILURE);
+  }
+  if (cpu_overrun > maxval(budget / 10, 1e-4)) {
+    printf("ERROR sliced ComputeUntil() overran the budget by too much\n");
+    exit(EXIT_FAILURE);
+  }
+  printf("SUCCESS\n");
+}
@@ -0,0 +1,231 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+/**
+   Checks pnf::DistanceTransform against brute force on a grid with
+   random obstacles, then adds and removes obstacles and compares the
+   incremental brushfire with a transform from scratch. Finally, it
+   times the transform against the LSM E* propagation that Flow uses
+   for the environment distance by default.
+
+   usage: test_distance_transform [size [nobstacles]]
+*/
+
+
+#include <pnf/DistanceTransform.hpp>
+#include <estar/Facade.hpp>
+#include <estar/util.hpp>
+#include <estar/numeric.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+using namespace pnf;
+using namespace estar;
+using namespace boost;
+using namespace std;
+
+
+typedef vector<pair<ssize_t, ssize_t> > obstacles_t;
+
+
+static double brute_force(obstacles_t const & obstacles, double resolution,
+			  ssize_t ix, ssize_t iy)
+{
+  double best(infinity);
+  for (size_t ii(0); ii < obstacles.size(); ++ii) {
+    double const dx(obstacles[ii].first - ix);
+    double const dy(obstacles[ii].second - iy);
+    best = minval(best, dx * dx + dy * dy);
+  }
+  return resolution * sqrt(best);
+}
+
+
+static double max_delta(DistanceTransform const & one,
+			DistanceTransform const & two)
+{
+  double maxdelta(0);
+  for (ssize_t ix(0); ix < one.xsize; ++ix)
+    for (ssize_t iy(0); iy < one.ysize; ++iy) {
+      double const v1(one.GetValue(ix, iy));
+      double const v2(two.GetValue(ix, iy));
+      if ((infinity == v1) != (infinity == v2))
+	return infinity;
+      if ((infinity != v1) && (absval(v1 - v2) > maxdelta))
+	maxdelta = absval(v1 - v2);
+    }
+  return maxdelta;
+}
+
+
+static bool check_exact(ssize_t size, size_t nobstacles, double resolution)
+{
+  DistanceTransform edt(size, size, resolution);
+  if (infinity != edt.GetValue(0, 0)) {
+    printf("ERROR: empty grid should be infinitely far from obstacles\n");
+    return false;
+  }
+  obstacles_t obstacles;
+  for (size_t ii(0); ii < nobstacles; ++ii) {
+    ssize_t const ix(rand() % size);
+    ssize_t const iy(rand() % size);
+    edt.AddObstacle(ix, iy);
+    obstacles.push_back(make_pair(ix, iy));
+  }
+  edt.Compute();
+  double maxdelta(0);
+  for (ssize_t ix(0); ix < size; ++ix)
+    for (ssize_t iy(0); iy < size; ++iy) {
+      double const delta(absval(edt.GetValue(ix, iy)
+				- brute_force(obstacles, resolution, ix, iy)));
+      if (delta > maxdelta)
+	maxdelta = delta;
+    }
+  printf("exact %zdx%zd with %zu obstacles: max delta %g\n",
+	 size, size, nobstacles, maxdelta);
+  if (maxdelta > 1e-9 * resolution) {
+    printf("ERROR: transform differs from brute force\n");
+    return false;
+  }
+  return true;
+}
+
+
+static bool check_incremental(ssize_t size, size_t nobstacles)
+{
+  double const tolerance(0.1);
+  DistanceTransform incremental(size, size, 1);
+  DistanceTransform scratch(size, size, 1);
+  obstacles_t obstacles;
+  for (size_t ii(0); ii < nobstacles; ++ii) {
+    ssize_t const ix(rand() % size);
+    ssize_t const iy(rand() % size);
+    incremental.AddObstacle(ix, iy);
+    scratch.AddObstacle(ix, iy);
+    obstacles.push_back(make_pair(ix, iy));
+  }
+  incremental.Compute();
+  
+  bool ok(true);
+  for (size_t round(0); round < 20; ++round) {
+    size_t const nchange(1 + rand() % 5);
+    for (size_t ii(0); ii < nchange; ++ii) {
+      if (rand() % 2) {
+	ssize_t const ix(rand() % size);
+	ssize_t const iy(rand() % size);
+	incremental.AddObstacle(ix, iy);
+	scratch.AddObstacle(ix, iy);
+	obstacles.push_back(make_pair(ix, iy));
+      }
+      else if ( ! obstacles.empty()) {
+	size_t const jj(rand() % obstacles.size());
+	incremental.RemoveObstacle(obstacles[jj].first, obstacles[jj].second);
+	scratch.RemoveObstacle(obstacles[jj].first, obstacles[jj].second);
+	obstacles.erase(obstacles.begin() + jj);
+      }
+    }
+    double const t0(get_monotonic_time());
+    incremental.Compute();
+    double const t1(get_monotonic_time());
+    scratch.ComputeFromScratch();
+    double const t2(get_monotonic_time());
+    double const delta(max_delta(incremental, scratch));
+    printf("  round %2zu: %zu changes, incremental %.5f s (%zu cells),"
+	   " scratch %.5f s, max delta %g\n",
+	   round, nchange, t1 - t0, incremental.GetNUpdated(), t2 - t1, delta);
+    if (delta > tolerance) {
+      printf("ERROR: incremental update differs from scratch\n");
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+
+static void compare_estar(ssize_t size, size_t nobstacles)
+{
+  DistanceTransform edt(size, size, 1);
+  scoped_ptr<Facade> estar(Facade::Create("lsm", 1,
+					  GridOptions(0, size, 0, size,
+						      Grid::FOUR),
+					  AlgorithmOptions(), stderr));
+  for (size_t ii(0); ii < nobstacles; ++ii) {
+    ssize_t const ix(rand() % size);
+    ssize_t const iy(rand() % size);
+    edt.AddObstacle(ix, iy);
+    estar->AddGoal(ix, iy, 0);
+  }
+  double const t0(get_monotonic_time());
+  edt.Compute();
+  double const t1(get_monotonic_time());
+  while (estar->HaveWork())
+    estar->ComputeOne();
+  double const t2(get_monotonic_time());
+  double maxdelta(0);
+  for (ssize_t ix(0); ix < size; ++ix)
+    for (ssize_t iy(0); iy < size; ++iy)
+      maxdelta = maxval(maxdelta, absval(edt.GetValue(ix, iy)
+					 - estar->GetValue(ix, iy)));
+  printf("%zdx%zd with %zu obstacles: transform %.4f s, LSM E* %.4f s,"
+	 " max delta %g (the LSM approximation error)\n",
+	 size, size, nobstacles, t1 - t0, t2 - t1, maxdelta);
+}
+
+
+int main(int argc, char ** argv)
+{
+  ssize_t size(300);
+  if (argc > 1) {
+    istringstream is(argv[1]);
+    if ( ! (is >> size) || (size < 10)) {
+      cerr << argv[0] << ": invalid size \"" << argv[1] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+  size_t nobstacles(50);
+  if (argc > 2) {
+    istringstream is(argv[2]);
+    if ( ! (is >> nobstacles) || (nobstacles < 1)) {
+      cerr << argv[0] << ": invalid nobstacles \"" << argv[2] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+  srand(42);
+  
+  bool ok(true);
+  ok &= check_exact(size / 3, nobstacles, 0.5);
+  ok &= check_exact(size / 5, 1, 1);
+  printf("incremental %zdx%zd with %zu obstacles:\n",
+	 size, size, nobstacles);
+  ok &= check_incremental(size, nobstacles);
+  compare_estar(size, nobstacles);
+  
+  if ( ! ok) {
+    printf("FAILURE\n");
+    exit(EXIT_FAILURE);
+  }
+  printf("SUCCESS\n");
+}
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+
+/**
+   Compares Facade::ComputeFastSweep() with propagating from scratch:
+   a grid with a few walls and some slower regions is computed both
+   ways, then a new wall is inserted and both get repaired
+   incrementally. Reports the cold start times, and FastSweepSolver
+   alone against BasicAlgorithm.
+
+   usage: test_fast_sweep [size]
+*/
+
+
+#include "fixtures.hpp"
+#include <estar/Facade.hpp>
+#include <estar/FastSweepSolver.hpp>
+#include <estar/util.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+using namespace estar;
+using namespace boost;
+using namespace std;
+
+
+static double meta(ssize_t ix, ssize_t iy, ssize_t size)
+{
+  if (((ix == size / 3) && (iy > size / 5))
+      || ((ix == 2 * size / 3) && (iy < 4 * size / 5)))
+    return 0;
+  if ((ix > size / 3) && (ix < 2 * size / 3) && (iy > size / 4)
+      && (iy < size / 2))
+    return 0.3;
+  return 1;
+}
+
+
+static Facade * create(ssize_t size)
+{
+  Facade * facade(Facade::CreateDefault(size, size, 1));
+  for (ssize_t ix(0); ix < size; ++ix)
+    for (ssize_t iy(0); iy < size; ++iy)
+      if (meta(ix, iy, size) < 1)
+	facade->SetMeta(ix, iy, meta(ix, iy, size) * facade->GetFreespaceMeta());
+  facade->AddGoal(1, 1, 0);
+  return facade;
+}
+
+
+int main(int argc, char ** argv)
+{
+  ssize_t size(500);
+  if (argc > 1) {
+    istringstream is(argv[1]);
+    if ( ! (is >> size) || (size < 10)) {
+      cerr << argv[0] << ": invalid size \"" << argv[1] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+  
+  scoped_ptr<Facade> propagated(create(size));
+  scoped_ptr<Facade> swept(create(size));
+  double const tolerance(propagated->scale / 1000);
+  
+  double const t0(get_monotonic_time());
+  while (propagated->HaveWork())
+    propagated->ComputeOne();
+  double const t1(get_monotonic_time());
+  if ( ! swept->ComputeFastSweep()) {
+    printf("ERROR Facade::ComputeFastSweep() refused to run\n");
+    exit(EXIT_FAILURE);
+  }
+  double const t2(get_monotonic_time());
+  double const delta(max_delta(*propagated, *swept, size));
+  printf("grid %zdx%zd\n"
+	 "propagated    %8.3f s\n"
+	 "fast sweep    %8.3f s  (%.1f times faster)  max delta %g\n",
+	 size, size, t1 - t0, t2 - t1, (t1 - t0) / (t2 - t1), delta);
+  if ((delta > tolerance) || swept->HaveWork()) {
+    printf("ERROR the fast sweep differs from propagation\n");
+    exit(EXIT_FAILURE);
+  }
+  
+  for (ssize_t iy(size / 10); iy < size; ++iy) {
+    propagated->SetMeta(size / 6, iy, propagated->GetObstacleMeta());
+    swept->SetMeta(size / 6, iy, swept->GetObstacleMeta());
+  }
+  while (propagated->HaveWork())
+    propagated->ComputeOne();
+  size_t nrepair(0);
+  while (swept->HaveWork()) {
+    swept->ComputeOne();
+    ++nrepair;
+  }
+  double const repaired(max_delta(*propagated, *swept, size));
+  printf("repaired a new wall in %zu steps, max delta %g\n",
+	 nrepair, repaired);
+  if (repaired > tolerance) {
+    printf("ERROR incremental repair after the fast sweep went wrong\n");
+    exit(EXIT_FAILURE);
+  }
+  
+  BasicAlgorithm<BasicLSMKernel, FourNeighborhood>
+    basic(size, size, BasicLSMKernel(1));
+  FastSweepSolver solver(size, size, 1);
+  for (ssize_t ix(0); ix < size; ++ix)
+    for (ssize_t iy(0); iy < size; ++iy) {
+      basic.SetMeta(ix, iy, meta(ix, iy, size));
+      solver.SetMeta(ix, iy, meta(ix, iy, size));
+    }
+  basic.AddGoal(1, 1, 0);
+  solver.AddGoal(1, 1, 0);
+  double const t3(get_monotonic_time());
+  while (basic.HaveWork())
+    basic.ComputeOne(1e-4);
+  double const t4(get_monotonic_time());
+  solver.Compute(1e-4);
+  double const t5(get_monotonic_time());
+  printf("BasicAlgorithm  %8.3f s\n"
+	 "FastSweepSolver %8.3f s  %zu sweeps\n",
+	 t4 - t3, t5 - t4, solver.GetNSweeps());
+  
+  printf("SUCCESS\n");
+}
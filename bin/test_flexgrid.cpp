@@ -1,9 +1,23 @@
 // compile with g++ -g -O0 -Wall -I.. -o test_flexgrid test_flexgrid.cpp
 
+/**
+   Exercises flexgrid (resizing, iterators, lines), and then
+   benchmarks it against a grid made of nested sdeque lines, which
+   is how flexgrid used to be implemented. Both are grown cell by
+   cell in a spiral around the origin, then read randomly via at()
+   and get(), and sequentially via iterators. The contents have to
+   match.
+   
+   usage: test_flexgrid [size [nlookups]]
+*/
+
 #include <estar/flexgrid.hpp>
+#include <estar/sdeque.hpp>
 #include <cstdio>
+#include <cstdlib>
 #include <iostream>
 #include <sstream>
+#include <sys/time.h>
 
 
 using namespace estar;
@@ -76,21 +90,21 @@ void tsd()
     foo.at(-1000) = 30;
     cout << "BUG: at(-1000) should have thrown\n";
   }
-  catch (std::out_of_range) {
+  catch (std::out_of_range const &) {
     ////    cout << "at(-1000) threw like it should\n";
   }
   try {
     foo.at(1000) = 30;
     cout << "BUG: at(1000) should have thrown\n";
   }
-  catch (std::out_of_range) {
+  catch (std::out_of_range const &) {
     ////    cout << "at(1000) threw like it should\n";
   }
   try {
     foo.resize_end(-6);
     cout << "BUG: resize_end(-6) should have thrown\n";
   }
-  catch (std::out_of_range) {
+  catch (std::out_of_range const &) {
     ////    cout << "resize_end(-6) threw like it should\n";
     sd_t bar(foo);
     try {
@@ -98,7 +112,7 @@ void tsd()
       cout << "OK: resize_end(-5) didn't throw\n";
       dump(bar);
     }
-    catch (std::out_of_range) {
+    catch (std::out_of_range const &) {
       cout << "BUG: resize_end(-5) shouldn't have thrown\n";
     }
   }
@@ -106,7 +120,7 @@ void tsd()
     foo.resize_begin(6);
     cout << "BUG: resize_begin(6) should have thrown\n";
   }
-  catch (std::out_of_range) {
+  catch (std::out_of_range const &) {
     ////    cout << "resize_begin(6) threw like it should\n";
     sd_t bar(foo);
     try {
@@ -114,7 +128,7 @@ void tsd()
       cout << "OK: resize_begin(5) didn't throw\n";
       dump(bar);
     }
-    catch (std::out_of_range) {
+    catch (std::out_of_range const &) {
       cout << "BUG: resize_begin(5) shouldn't have thrown\n";
     }
   }
@@ -157,7 +171,7 @@ void tfg2()
   try {
     cout << fg.at(12, 34);
   }
-  catch (std::out_of_range) {
+  catch (std::out_of_range const &) {
     cout << "yep, caught it\n";
   }
   fg.smart_at(-2,  1) =  42;
@@ -176,7 +190,7 @@ void tfg_it(FGT & bar)
     for (ITT ii(bar.begin()); ii != bar.end(); ++ii)
       cout << "  " << *ii;
   }
-  catch (std::out_of_range) {
+  catch (std::out_of_range const &) {
     cout << "[out_of_range]";
   }
   
@@ -185,7 +199,7 @@ void tfg_it(FGT & bar)
     for (ITT ii(bar.begin()); ii != bar.end(); ii++)
       cout << "  " << *ii;
   }
-  catch (std::out_of_range) {
+  catch (std::out_of_range const &) {
     cout << "[out_of_range]";
   }
   
@@ -198,7 +212,7 @@ void tfg_it(FGT & bar)
 	cout << "  " << *ii;
       } while (ii != bar.begin());
   }
-  catch (std::out_of_range) {
+  catch (std::out_of_range const &) {
     cout << "[out_of_range]";
   }
   
@@ -211,7 +225,7 @@ void tfg_it(FGT & bar)
 	cout << "  " << *ii;
       } while (ii != bar.begin());
   }
-  catch (std::out_of_range) {
+  catch (std::out_of_range const &) {
     cout << "[out_of_range]";
   }
   
@@ -240,8 +254,204 @@ void tfg_it_helper(fg_t & bar)
 }
 
 
+static double now()
+{
+  struct timeval tv;
+  gettimeofday(&tv, 0);
+  return tv.tv_sec + 1e-6 * tv.tv_usec;
+}
+
+
+/** The former flexgrid storage, for comparison. */
+class nested_grid
+{
+public:
+  typedef sdeque<int> line_t;
+  
+  int & at(ssize_t ix, ssize_t iy) { return m_grid.at(iy).at(ix); }
+  
+  int & smart_at(ssize_t ix, ssize_t iy) {
+    if (ix < m_default.ibegin()) {
+      for (sdeque<line_t>::iterator ii(m_grid.begin());
+	   ii != m_grid.end(); ++ii)
+	ii->resize_begin(ix);
+      m_default.resize_begin(ix);
+    }
+    else if (ix >= m_default.iend()) {
+      for (sdeque<line_t>::iterator ii(m_grid.begin());
+	   ii != m_grid.end(); ++ii)
+	ii->resize_end(ix + 1);
+      m_default.resize_end(ix + 1);
+    }
+    if (iy < m_grid.ibegin())
+      m_grid.resize_begin(iy, m_default);
+    else if (iy >= m_grid.iend())
+      m_grid.resize_end(iy + 1, m_default);
+    return m_grid.at(iy).at(ix);
+  }
+  
+  sdeque<line_t> m_grid;
+  line_t m_default;
+};
+
+
+/** Visits the cells of a square of the given half-width, ring by
+    ring, so that the grid grows on all four sides. */
+template<typename grid_t>
+void spiral(grid_t & grid, ssize_t half)
+{
+  int count(0);
+  grid.smart_at(0, 0) = count++;
+  for (ssize_t rr(1); rr <= half; ++rr) {
+    for (ssize_t ix(-rr); ix <= rr; ++ix)
+      grid.smart_at(ix, rr) = count++;
+    for (ssize_t iy(rr - 1); iy >= -rr; --iy)
+      grid.smart_at(rr, iy) = count++;
+    for (ssize_t ix(rr - 1); ix >= -rr; --ix)
+      grid.smart_at(ix, -rr) = count++;
+    for (ssize_t iy(1 - rr); iy < rr; ++iy)
+      grid.smart_at(-rr, iy) = count++;
+  }
+}
+
+
+/** Linear congruential generator, so that all lookup loops visit
+    the same cells without depending on the platform's rand(). */
+static inline size_t lcg(size_t & state)
+{
+  state = state * 1103515245 + 12345;
+  return (state >> 8) & 0xffffff;
+}
+
+
+static void benchmark(ssize_t size, size_t nlookups)
+{
+  ssize_t const half(size / 2);
+  ssize_t const width(2 * half + 1);
+  
+  cout << "\n==================================================\n"
+       << "benchmark: " << width << "x" << width << " cells, "
+       << nlookups << " lookups\n";
+  
+  double t0(now());
+  nested_grid ng;
+  spiral(ng, half);
+  double const ng_grow(now() - t0);
+  
+  t0 = now();
+  fg_t fg;
+  spiral(fg, half);
+  double const fg_grow(now() - t0);
+  
+  if ((fg.xbegin() != -half) || (fg.xend() != half + 1)
+      || (fg.ybegin() != -half) || (fg.yend() != half + 1)) {
+    cout << "ERROR: flexgrid range [" << fg.xbegin() << ", " << fg.xend()
+	 << "[ x [" << fg.ybegin() << ", " << fg.yend() << "[\n";
+    exit(EXIT_FAILURE);
+  }
+  for (ssize_t ix(-half); ix <= half; ++ix)
+    for (ssize_t iy(-half); iy <= half; ++iy)
+      if (fg.at(ix, iy) != ng.at(ix, iy)) {
+	cout << "ERROR: mismatch at (" << ix << ", " << iy << "): "
+	     << fg.at(ix, iy) << " instead of " << ng.at(ix, iy) << "\n";
+	exit(EXIT_FAILURE);
+      }
+  
+  long ng_sum(0);
+  size_t state(42);
+  t0 = now();
+  for (size_t ii(0); ii < nlookups; ++ii) {
+    ssize_t const ix(lcg(state) % width - half);
+    ssize_t const iy(lcg(state) % width - half);
+    ng_sum += ng.at(ix, iy);
+  }
+  double const ng_random(now() - t0);
+  
+  long fg_sum(0);
+  state = 42;
+  t0 = now();
+  for (size_t ii(0); ii < nlookups; ++ii) {
+    ssize_t const ix(lcg(state) % width - half);
+    ssize_t const iy(lcg(state) % width - half);
+    fg_sum += fg.at(ix, iy);
+  }
+  double const fg_random(now() - t0);
+  
+  long get_sum(0);
+  state = 42;
+  t0 = now();
+  for (size_t ii(0); ii < nlookups; ++ii) {
+    ssize_t const ix(lcg(state) % width - half);
+    ssize_t const iy(lcg(state) % width - half);
+    get_sum += fg.get(ix, iy);
+  }
+  double const get_random(now() - t0);
+  
+  long ng_seq(0);
+  t0 = now();
+  for (sdeque<nested_grid::line_t>::const_iterator il(ng.m_grid.begin());
+       il != ng.m_grid.end(); ++il)
+    for (nested_grid::line_t::const_iterator ic(il->begin());
+	 ic != il->end(); ++ic)
+      ng_seq += *ic;
+  double const ng_sequential(now() - t0);
+  
+  long fg_seq(0);
+  t0 = now();
+  for (fg_t::const_iterator ii(fg.begin()); ii != fg.end(); ++ii)
+    fg_seq += *ii;
+  double const fg_sequential(now() - t0);
+  
+  long line_seq(0);
+  t0 = now();
+  for (fg_t::const_line_iterator il(fg.line_begin());
+       il != fg.line_end(); ++il)
+    for (fg_t::const_cell_iterator ic(il->begin()); ic != il->end(); ++ic)
+      line_seq += *ic;
+  double const line_sequential(now() - t0);
+  
+  if ((fg_sum != ng_sum) || (get_sum != ng_sum)) {
+    cout << "ERROR: random lookup sums " << fg_sum << " and " << get_sum
+	 << " instead of " << ng_sum << "\n";
+    exit(EXIT_FAILURE);
+  }
+  if ((fg_seq != ng_seq) || (line_seq != ng_seq)) {
+    cout << "ERROR: sequential sums " << fg_seq << " and " << line_seq
+	 << " instead of " << ng_seq << "\n";
+    exit(EXIT_FAILURE);
+  }
+  
+  printf("                  nested    flexgrid\n"
+	 "spiral smart_at  %8.4f  %8.4f\n"
+	 "random at()      %8.4f  %8.4f\n"
+	 "random get()          -    %8.4f\n"
+	 "iterator         %8.4f  %8.4f\n"
+	 "lines                 -    %8.4f\n",
+	 ng_grow, fg_grow, ng_random, fg_random, get_random,
+	 ng_sequential, fg_sequential, line_sequential);
+  cout << "SUCCESS\n";
+}
+
+
 int main(int argc, char ** argv)
 {
+  ssize_t size(1000);
+  if (argc > 1) {
+    istringstream is(argv[1]);
+    if ( ! (is >> size) || (size < 2)) {
+      cerr << argv[0] << ": invalid size \"" << argv[1] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+  size_t nlookups(10000000);
+  if (argc > 2) {
+    istringstream is(argv[2]);
+    if ( ! (is >> nlookups)) {
+      cerr << argv[0] << ": invalid nlookups \"" << argv[2] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+  
   {
     fg_t foo;
     fg_t const & bar(foo);
@@ -313,5 +523,7 @@ int main(int argc, char ** argv)
     fg_t fg;
     fg.resize(-2, 2, 0, 0);
     tfg_it_helper(fg);
-  }  
+  }
+  
+  benchmark(size, nlookups);
 }
@@ -0,0 +1,194 @@
+/* 
+ * Copyright (C) 2005 Roland Philippsen <roland dot philippsen at gmx net>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+
+/**
+   Compares focused and unfocused propagation on an open grid. The
+   goal sits near one side and the robot starts in the far corner,
+   then drives towards the goal in a few hops. After the second hop,
+   a wall appears between the robot and the goal. After each hop, the
+   robot cell is settled with Facade::ComputeUntil(), once after
+   Facade::SetFocus() and once without, and the expansions and
+   times are reported side by side. The robot values must agree with
+   a fully propagated reference, and the heuristic must not exceed
+   the cost of reaching the robot from any cell.
+
+   usage: test_focused [size [margin]]
+*/
+
+
+#include "fixtures.hpp"
+#include <estar/Facade.hpp>
+#include <estar/Algorithm.hpp>
+#include <estar/Kernel.hpp>
+#include <estar/numeric.hpp>
+#include <estar/util.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+
+using namespace estar;
+using namespace boost;
+using namespace std;
+
+
+static void wall(Facade & facade, ssize_t size)
+{
+  for (ssize_t ix(size / 4); ix < 3 * size / 4; ++ix)
+    facade.SetMeta(ix, size / 2, facade.GetObstacleMeta());
+}
+
+
+static Facade * create(ssize_t size, bool with_wall)
+{
+  Facade * facade(Facade::CreateDefault(size, size, 1));
+  if (with_wall)
+    wall(*facade, size);
+  facade->AddGoal(size / 2, 2, 0);
+  return facade;
+}
+
+
+static size_t settle(Facade & facade, ssize_t rx, ssize_t ry, double & dt)
+{
+  double const t0(get_monotonic_time());
+  compute_progress const progress(facade.ComputeUntil(rx, ry, infinity));
+  dt += get_monotonic_time() - t0;
+  if ( ! progress.settled) {
+    printf("ERROR robot (%zd, %zd) did not settle\n", rx, ry);
+    exit(EXIT_FAILURE);
+  }
+  return progress.nsteps;
+}
+
+
+int main(int argc, char ** argv)
+{
+  ssize_t size(400);
+  double margin(10);
+  if (argc > 1) {
+    istringstream is(argv[1]);
+    if ( ! (is >> size) || (size < 20)) {
+      cerr << argv[0] << ": invalid size \"" << argv[1] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+  if (argc > 2) {
+    istringstream is(argv[2]);
+    if ( ! (is >> margin) || (margin <= 0)) {
+      cerr << argv[0] << ": invalid margin \"" << argv[2] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+  
+  scoped_ptr<Facade> focused(create(size, false));
+  scoped_ptr<Facade> plain(create(size, false));
+  double const weight(focused->GetKernel().GetHeuristicWeight());
+  double const tolerance(focused->scale / 100);
+  bool ok(true);
+  
+  printf("grid %zdx%zd, horizon margin %g\n"
+	 "robot            focused     plain  focused value  plain value\n",
+	 size, size, margin);
+  size_t total_focused(0);
+  size_t total_plain(0);
+  double time_focused(0);
+  double time_plain(0);
+  ssize_t const nhops(6);
+  for (ssize_t ihop(0); ihop < nhops; ++ihop) {
+    ssize_t const rx(size - 3 - ihop * (size / 2 - 3) / nhops);
+    ssize_t const ry(size - 3 - ihop * (size / 3) / nhops);
+    bool const with_wall(ihop >= 2);
+    if (2 == ihop) {
+      wall(*focused, size);
+      wall(*plain, size);
+    }
+    focused->SetFocus(rx, ry, margin);
+    size_t const nfocused(settle(*focused, rx, ry, time_focused));
+    size_t const nplain(settle(*plain, rx, ry, time_plain));
+    total_focused += nfocused;
+    total_plain += nplain;
+    
+    scoped_ptr<Facade> reference(create(size, with_wall));
+    flush(*reference);
+    double const fval(focused->GetValue(rx, ry));
+    double const pval(plain->GetValue(rx, ry));
+    double const rval(reference->GetValue(rx, ry));
+    printf("(%4zd, %4zd)  %9zu %9zu  %13g %12g\n",
+	   rx, ry, nfocused, nplain, fval, pval);
+    if ((absval(fval - rval) > tolerance)
+	|| (absval(pval - rval) > tolerance)) {
+      printf("ERROR robot value differs from reference %g\n", rval);
+      ok = false;
+    }
+    
+    // the heuristic must not exceed the cost of reaching the robot
+    scoped_ptr<Facade> to_robot(Facade::CreateDefault(size, size, 1));
+    if (with_wall)
+      wall(*to_robot, size);
+    to_robot->AddGoal(rx, ry, 0);
+    flush(*to_robot);
+    for (ssize_t ix(0); ix < size; ++ix)
+      for (ssize_t iy(0); iy < size; ++iy) {
+	double const dx(ix - rx);
+	double const dy(iy - ry);
+	double const h(weight * sqrt(dx * dx + dy * dy));
+	if (h > to_robot->GetValue(ix, iy) + tolerance) {
+	  printf("ERROR heuristic %g at (%zd, %zd) exceeds %g\n",
+		 h, ix, iy, to_robot->GetValue(ix, iy));
+	  ok = false;
+	  ix = size;
+	  break;
+	}
+      }
+  }
+  printf("total         %9zu %9zu  (%.1fx fewer expansions)\n"
+	 "time          %8.3fs %8.3fs\n",
+	 total_focused, total_plain,
+	 static_cast<double>(total_plain) / total_focused,
+	 time_focused, time_plain);
+  
+  // flushing a focused queue must give the same result as flushing
+  // an unfocused one
+  flush(*focused);
+  flush(*plain);
+  double maxdelta(0);
+  for (ssize_t ix(0); ix < size; ++ix)
+    for (ssize_t iy(0); iy < size; ++iy) {
+      double const delta(absval(focused->GetValue(ix, iy)
+				- plain->GetValue(ix, iy)));
+      if (delta > maxdelta)
+	maxdelta = delta;
+    }
+  printf("after flushing, max delta %g\n", maxdelta);
+  if (maxdelta > tolerance)
+    ok = false;
+  
+  if ( ! ok) {
+    printf("FAILURE\n");
+    exit(EXIT_FAILURE);
+  }
+  printf("SUCCESS\n");
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+/**
+   Checks incremental goal removal: the goal is walked along a wall
+   in small steps with Facade::MoveGoal(), then replaced by a Region
+   with Facade::ReplaceGoals(), and finally a single cell is removed
+   from that region. After each change the navigation function is
+   repaired and compared against a fresh Facade that only ever saw
+   the new goal set. The number of expansions of the repair and of
+   the fresh propagation are reported side by side, and a repair
+   must never cost more than the fresh propagation, because
+   Algorithm falls back to a reset when that would be the case.
+
+   usage: test_goal_move [size]
+*/
+
+
+#include "fixtures.hpp"
+#include <estar/Facade.hpp>
+#include <estar/Algorithm.hpp>
+#include <estar/Region.hpp>
+#include <estar/numeric.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+using namespace estar;
+using namespace boost;
+using namespace std;
+
+
+static bool compare(char const * what, ssize_t size,
+		    Facade & facade, size_t steps, Facade & fresh)
+{
+  size_t const fresh_steps(flush(fresh));
+  double maxdelta(0);
+  for (ssize_t ix(0); ix < size; ++ix)
+    for (ssize_t iy(0); iy < size; ++iy) {
+      double const delta(absval(facade.GetValue(ix, iy)
+				- fresh.GetValue(ix, iy)));
+      if (delta > maxdelta)
+	maxdelta = delta;
+    }
+  // incremental repairs can differ from scratch by up to the slack
+  char const * problem(0);
+  if (maxdelta > facade.scale / 10000)
+    problem = "MISMATCH";
+  else if (steps > fresh_steps)
+    problem = "TOO EXPENSIVE";
+  printf("%-24s  %8zu  %8zu  %10g  %s\n", what, steps, fresh_steps,
+	 maxdelta, problem ? problem : "ok");
+  return 0 == problem;
+}
+
+
+int main(int argc, char ** argv)
+{
+  ssize_t size(200);
+  if (argc > 1) {
+    istringstream is(argv[1]);
+    if ( ! (is >> size) || (size < 20)) {
+      cerr << argv[0] << ": invalid size \"" << argv[1] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  bool ok(true);
+  scoped_ptr<Facade> facade(create_walled(size));
+  facade->AddGoal(size / 2 - 2, size / 4, 0);
+  flush(*facade);
+
+  printf("grid %zdx%zd\n"
+	 "change                    repair     fresh   max delta\n",
+	 size, size);
+  for (ssize_t iy(size / 4 + 1); iy < size / 4 + 6; ++iy) {
+    if ( ! facade->MoveGoal(size / 2 - 2, iy, 0)) {
+      printf("ERROR MoveGoal(%zd, %zd) failed\n", size / 2 - 2, iy);
+      exit(EXIT_FAILURE);
+    }
+    size_t const steps(flush(*facade));
+    scoped_ptr<Facade> fresh(create_walled(size));
+    fresh->AddGoal(size / 2 - 2, iy, 0);
+    char what[64];
+    snprintf(what, sizeof(what), "MoveGoal(%zd, %zd)", size / 2 - 2, iy);
+    ok &= compare(what, size, *facade, steps, *fresh);
+  }
+
+  Region const region(3, 1, size / 4, size / 2, 0, size, 0, size);
+  facade->ReplaceGoals(region);
+  {
+    size_t const steps(flush(*facade));
+    scoped_ptr<Facade> fresh(create_walled(size));
+    fresh->AddGoal(region);
+    ok &= compare("ReplaceGoals(region)", size, *facade, steps, *fresh);
+  }
+
+  Region const shifted(3, 1, size / 4 + 1, size / 2, 0, size, 0, size);
+  facade->ReplaceGoals(shifted);
+  {
+    size_t const steps(flush(*facade));
+    scoped_ptr<Facade> fresh(create_walled(size));
+    fresh->AddGoal(shifted);
+    ok &= compare("ReplaceGoals(shifted)", size, *facade, steps, *fresh);
+  }
+  
+  facade->ReplaceGoals(region);
+  flush(*facade);
+  facade->RemoveGoal(size / 4, size / 2);
+  {
+    size_t const steps(flush(*facade));
+    scoped_ptr<Facade> fresh(create_walled(size));
+    fresh->AddGoal(region);
+    fresh->RemoveGoal(size / 4, size / 2);
+    ok &= compare("RemoveGoal(center)", size, *facade, steps, *fresh);
+  }
+
+  facade->RemoveAllGoals();
+  facade->AddGoal(1, 1, 0);
+  {
+    size_t const steps(flush(*facade));
+    scoped_ptr<Facade> fresh(create_walled(size));
+    fresh->AddGoal(1, 1, 0);
+    ok &= compare("RemoveAllGoals+AddGoal", size, *facade, steps, *fresh);
+  }
+
+  if ( ! ok) {
+    printf("FAILURE\n");
+    exit(EXIT_FAILURE);
+  }
+  printf("SUCCESS\n");
+}
@@ -0,0 +1,267 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+
+/**
+   Compares HierarchicalFacade with a focused and a plain Facade on
+   a grid with a thick wall between the goal and the robot, which
+   forces a long detour around its open end. The Euclidean focus of
+   Facade::SetFocus() then covers most of the grid. The robot drives
+   along the wall in a few hops, and after the second hop a block
+   narrows the opening. After each hop, the robot cell is settled
+   with ComputeUntil() and the expansions and times are reported
+   side by side. The robot values must agree with a fully propagated
+   reference, the estimates must not exceed the cost of reaching the
+   focus, and all values must agree once the hierarchical planner
+   has run out of work. Over the whole trajectory, the hierarchical
+   planner must expand fewer cells than the focused Facade.
+
+   usage: test_hierarchical_facade [size [nlevels [margin]]]
+*/
+
+
+#include "fixtures.hpp"
+#include <estar/HierarchicalFacade.hpp>
+#include <estar/Facade.hpp>
+#include <estar/numeric.hpp>
+#include <estar/util.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+using namespace estar;
+using namespace boost;
+using namespace std;
+
+
+static bool is_wall(ssize_t ix, ssize_t iy, ssize_t size)
+{
+  return (ix >= size / 8) && (iy >= size / 2 - size / 20)
+    && (iy < size / 2 + size / 20);
+}
+
+
+/** Narrows the opening at the end of the wall. */
+static bool is_extra(ssize_t ix, ssize_t iy, ssize_t size)
+{
+  return (ix < size / 16) && (iy >= size / 2 - size / 20)
+    && (iy < size / 2 + size / 20);
+}
+
+
+template<class FacadeT>
+static void setup(FacadeT & facade, ssize_t size, bool with_extra)
+{
+  for (ssize_t ix(0); ix < size; ++ix)
+    for (ssize_t iy(0); iy < size; ++iy)
+      if (is_wall(ix, iy, size) || (with_extra && is_extra(ix, iy, size)))
+	facade.SetMeta(ix, iy, facade.GetObstacleMeta());
+}
+
+
+template<class FacadeT>
+static void extra(FacadeT & facade, ssize_t size)
+{
+  for (ssize_t ix(0); ix < size; ++ix)
+    for (ssize_t iy(0); iy < size; ++iy)
+      if (is_extra(ix, iy, size))
+	facade.SetMeta(ix, iy, facade.GetObstacleMeta());
+}
+
+
+static Facade * create(ssize_t size, bool with_extra)
+{
+  Facade * facade(Facade::CreateDefault(size, size, 1));
+  setup(*facade, size, with_extra);
+  facade->AddGoal(size - 10, size / 4, 0);
+  return facade;
+}
+
+
+static size_t settle(compute_progress const & progress,
+		     ssize_t rx, ssize_t ry, char const * name)
+{
+  if ( ! progress.settled) {
+    printf("ERROR %s robot (%zd, %zd) did not settle\n", name, rx, ry);
+    exit(EXIT_FAILURE);
+  }
+  return progress.nsteps;
+}
+
+
+int main(int argc, char ** argv)
+{
+  ssize_t size(600);
+  size_t nlevels(4);
+  double margin(20);
+  if (argc > 1) {
+    istringstream is(argv[1]);
+    if ( ! (is >> size) || (size < 80)) {
+      cerr << argv[0] << ": invalid size \"" << argv[1] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+  if (argc > 2) {
+    istringstream is(argv[2]);
+    if ( ! (is >> nlevels) || (nlevels < 1)) {
+      cerr << argv[0] << ": invalid nlevels \"" << argv[2] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+  if (argc > 3) {
+    istringstream is(argv[3]);
+    if ( ! (is >> margin) || (margin <= 0)) {
+      cerr << argv[0] << ": invalid margin \"" << argv[3] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+  
+  scoped_ptr<HierarchicalFacade>
+    hierarchical(HierarchicalFacade::Create("lsm", 1,
+					    GridOptions(0, size, 0, size),
+					    AlgorithmOptions(), nlevels,
+					    stderr));
+  setup(*hierarchical, size, false);
+  hierarchical->AddGoal(size - 10, size / 4, 0);
+  scoped_ptr<Facade> focused(create(size, false));
+  scoped_ptr<Facade> plain(create(size, false));
+  // the tight corridor leaves fewer settled neighbors beside the
+  // path than the Euclidean focus, so the interpolation error of the
+  // robot value is a bit larger, see Facade::SetFocus()
+  double const tolerance(focused->scale / 10);
+  bool ok(true);
+  
+  printf("grid %zdx%zd, %zu levels (%zdx%zd blocks), margin %g\n"
+	 "robot        hierarchical   focused     plain"
+	 "  hier. value  plain value\n",
+	 size, size, nlevels, hierarchical->factor, hierarchical->factor,
+	 margin);
+  size_t total_hier(0), total_focused(0), total_plain(0);
+  double time_hier(0), time_focused(0), time_plain(0);
+  ssize_t const nhops(5);
+  for (ssize_t ihop(0); ihop < nhops; ++ihop) {
+    ssize_t const rx(size - 10 - ihop * size / 8);
+    ssize_t const ry(3 * size / 4);
+    bool const with_extra(ihop >= 2);
+    if (2 == ihop) {
+      extra(*hierarchical, size);
+      extra(*focused, size);
+      extra(*plain, size);
+    }
+    
+    double const t0(get_monotonic_time());
+    hierarchical->SetRobot(rx, ry, margin);
+    size_t const nhier(settle(hierarchical->ComputeUntil(infinity),
+			      rx, ry, "hierarchical"));
+    double const t1(get_monotonic_time());
+    focused->SetFocus(rx, ry, margin);
+    size_t const nfocused(settle(focused->ComputeUntil(rx, ry, infinity),
+				 rx, ry, "focused"));
+    double const t2(get_monotonic_time());
+    size_t const nplain(settle(plain->ComputeUntil(rx, ry, infinity),
+			       rx, ry, "plain"));
+    double const t3(get_monotonic_time());
+    time_hier += t1 - t0;
+    time_focused += t2 - t1;
+    time_plain += t3 - t2;
+    total_hier += nhier;
+    total_focused += nfocused;
+    total_plain += nplain;
+    
+    scoped_ptr<Facade> reference(create(size, with_extra));
+    flush(*reference);
+    double const hval(hierarchical->GetValue(rx, ry));
+    double const rval(reference->GetValue(rx, ry));
+    printf("(%4zd, %4zd)  %12zu %9zu %9zu  %11g %12g\n",
+	   rx, ry, nhier, nfocused, nplain, hval, plain->GetValue(rx, ry));
+    if (absval(hval - rval) > tolerance) {
+      printf("ERROR robot value differs from reference %g\n", rval);
+      ok = false;
+    }
+    
+    // the estimates must not exceed the cost of reaching the focus
+    ssize_t fx, fy;
+    if ( ! hierarchical->GetFocus(fx, fy)) {
+      printf("ERROR no focus after hop to (%zd, %zd)\n", rx, ry);
+      exit(EXIT_FAILURE);
+    }
+    scoped_ptr<Facade> to_focus(Facade::CreateDefault(size, size, 1));
+    setup(*to_focus, size, with_extra);
+    to_focus->AddGoal(fx, fy, 0);
+    flush(*to_focus);
+    for (ssize_t ix(0); ix < size; ++ix)
+      for (ssize_t iy(0); iy < size; ++iy) {
+	double const estimate(hierarchical->GetEstimate(ix, iy));
+	if (estimate > to_focus->GetValue(ix, iy) + tolerance) {
+	  printf("ERROR estimate %g at (%zd, %zd) exceeds %g\n",
+		 estimate, ix, iy, to_focus->GetValue(ix, iy));
+	  ok = false;
+	  ix = size;
+	  break;
+	}
+      }
+    
+    carrot_trace trace;
+    if (0 > hierarchical->TraceCarrot(rx, ry, 1, 0.5, 10, trace, 0)) {
+      printf("ERROR TraceCarrot() failed at (%zd, %zd)\n", rx, ry);
+      ok = false;
+    }
+  }
+  printf("total         %12zu %9zu %9zu  (%.1fx fewer than focused,"
+	 " %.1fx fewer than plain)\n"
+	 "time          %11.3fs %8.3fs %8.3fs\n",
+	 total_hier, total_focused, total_plain,
+	 static_cast<double>(total_focused) / total_hier,
+	 static_cast<double>(total_plain) / total_hier,
+	 time_hier, time_focused, time_plain);
+  if (total_hier >= total_focused) {
+    printf("ERROR hierarchical planner expanded more than focused\n");
+    ok = false;
+  }
+  
+  // running out of work must give the same result as an unfocused
+  // propagation
+  while (hierarchical->HaveWork())
+    hierarchical->ComputeOne();
+  flush(*plain);
+  double maxdelta(0);
+  for (ssize_t ix(0); ix < size; ++ix)
+    for (ssize_t iy(0); iy < size; ++iy) {
+      double const hv(hierarchical->GetValue(ix, iy));
+      double const pv(plain->GetValue(ix, iy));
+      if ((infinity == hv) != (infinity == pv))
+	maxdelta = infinity;
+      else if ((infinity != hv) && (absval(hv - pv) > maxdelta))
+	maxdelta = absval(hv - pv);
+    }
+  printf("after flushing, max delta %g\n", maxdelta);
+  if (maxdelta > tolerance)
+    ok = false;
+  
+  if ( ! ok) {
+    printf("FAILURE\n");
+    exit(EXIT_FAILURE);
+  }
+  printf("SUCCESS\n");
+}
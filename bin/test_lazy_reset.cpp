@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+/**
+   Checks and times the epoch-based Algorithm::Reset(). A goal is
+   moved around a square grid with a wall in it. After each move, the
+   navigation function is propagated until the robot cell is UPWIND
+   and then flushed, and the result is compared against a fresh
+   Facade that only ever saw the new goal. The time spent in the
+   Reset() triggered by the goal move is reported separately.
+
+   usage: test_lazy_reset [size [nmoves]]
+*/
+
+
+#include "fixtures.hpp"
+#include <estar/Facade.hpp>
+#include <estar/Algorithm.hpp>
+#include <estar/util.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+using namespace estar;
+using namespace boost;
+using namespace std;
+
+
+int main(int argc, char ** argv)
+{
+  ssize_t size(500);
+  if (argc > 1) {
+    istringstream is(argv[1]);
+    if ( ! (is >> size) || (size < 10)) {
+      cerr << argv[0] << ": invalid size \"" << argv[1] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+  size_t nmoves(5);
+  if (argc > 2) {
+    istringstream is(argv[2]);
+    if ( ! (is >> nmoves) || (nmoves < 1)) {
+      cerr << argv[0] << ": invalid nmoves \"" << argv[2] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  ssize_t const robot(size - 2);
+  scoped_ptr<Facade> facade(create_walled(size));
+  facade->AddGoal(1, 1, 0);
+  while (facade->HaveWork())
+    facade->ComputeOne();
+
+  cout << "grid " << size << "x" << size << "\n"
+       << "move  goal          reset [s]  to robot [s]  steps\n";
+  for (size_t im(0); im < nmoves; ++im) {
+    ssize_t const gx(1 + im % 3);
+    ssize_t const gy(1 + (im * 7) % (size / 4));
+    facade->RemoveAllGoals();
+    facade->AddGoal(gx, gy, 0);
+
+    size_t const step0(facade->GetAlgorithm().GetStep());
+    double const t0(get_monotonic_time());
+    facade->GetAlgorithm().Reset();
+    double const t1(get_monotonic_time());
+    while (facade->HaveWork()
+	   && (facade->GetStatus(robot, robot) != Facade::UPWIND))
+      facade->ComputeOne();
+    double const t2(get_monotonic_time());
+    printf("%4zu  (%3zd, %3zd)  %11.6f  %12.3f  %zu\n", im, gx, gy,
+	   t1 - t0, t2 - t1, facade->GetAlgorithm().GetStep() - step0);
+    while (facade->HaveWork())
+      facade->ComputeOne();
+
+    scoped_ptr<Facade> fresh(create_walled(size));
+    fresh->AddGoal(gx, gy, 0);
+    while (fresh->HaveWork())
+      fresh->ComputeOne();
+    size_t mismatch(0);
+    for (ssize_t ix(0); ix < size; ++ix)
+      for (ssize_t iy(0); iy < size; ++iy)
+	if ((facade->GetValue(ix, iy) != fresh->GetValue(ix, iy))
+	    || (facade->GetAlgorithm().GetCSpace()->GetRhs(ix * size + iy)
+		!= fresh->GetAlgorithm().GetCSpace()->GetRhs(ix * size + iy)))
+	  ++mismatch;
+    if (0 != mismatch) {
+      cout << "ERROR move " << im << ": " << mismatch
+	   << " cells differ from a fresh Facade\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+  cout << "SUCCESS\n";
+}
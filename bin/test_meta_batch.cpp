@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+/**
+   Compares ingesting sensor scans cell by cell with ingesting them
+   through Facade::BeginMetaBatch() and Facade::CommitMetaBatch().
+   A robot drives along a row of the grid and takes a scan at each
+   stop: dense rays mark each cell they traverse with its true meta
+   until they hit an obstacle, so cells close to the robot get set
+   many times per scan (see scan()). Both navigation functions are repaired after
+   each scan and must end up the same.
+
+   usage: test_meta_batch [size [nrays]]
+*/
+
+
+#include "fixtures.hpp"
+#include <estar/Facade.hpp>
+#include <estar/util.hpp>
+#include <estar/numeric.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+
+using namespace estar;
+using namespace boost;
+using namespace std;
+
+
+/** The world that the sensor sees: a few rectangular blocks. */
+static bool is_obstacle(ssize_t size, ssize_t ix, ssize_t iy)
+{
+  if ((ix >= size / 4) && (ix < size / 4 + 5)
+      && (iy >= size / 8) && (iy < size / 2))
+    return true;
+  if ((ix >= size / 2) && (ix < 3 * size / 4)
+      && (iy >= size / 2) && (iy < size / 2 + 5))
+    return true;
+  if ((ix >= 3 * size / 4) && (ix < 3 * size / 4 + 5)
+      && (iy >= size / 4) && (iy < 3 * size / 4))
+    return true;
+  return false;
+}
+
+
+static double risk_to_meta(Facade const & facade, double risk)
+{
+  double const free(facade.GetFreespaceMeta());
+  return free + 0.9 * risk * (facade.GetObstacleMeta() - free);
+}
+
+
+/**
+   Each ray observation moves the collision risk of a cell a bit
+   towards what the sensor saw, like an occupancy grid would, and
+   the new meta is written right away. Cells close to the robot get
+   observed by many rays, so their meta changes many times per scan.
+   
+   \return The number of SetMeta() calls.
+*/
+static size_t scan(Facade & facade, array<double> & risk, ssize_t size,
+		   double rx, double ry, size_t nrays, double range)
+{
+  size_t ncalls(0);
+  for (size_t ir(0); ir < nrays; ++ir) {
+    double const angle(2 * M_PI * ir / nrays);
+    double const dx(cos(angle));
+    double const dy(sin(angle));
+    for (double rr(0); rr < range; rr += 0.5) {
+      ssize_t const ix(static_cast<ssize_t>(rint(rx + rr * dx)));
+      ssize_t const iy(static_cast<ssize_t>(rint(ry + rr * dy)));
+      if ((ix < 0) || (ix >= size) || (iy < 0) || (iy >= size))
+	break;
+      bool const obstacle(is_obstacle(size, ix, iy));
+      risk[ix][iy] += 0.2 * ((obstacle ? 1 : 0) - risk[ix][iy]);
+      facade.SetMeta(ix, iy, risk_to_meta(facade, risk[ix][iy]));
+      ++ncalls;
+      if (obstacle)
+	break;
+    }
+  }
+  return ncalls;
+}
+
+
+int main(int argc, char ** argv)
+{
+  ssize_t size(200);
+  size_t nrays(720);
+  if (argc > 1) {
+    istringstream is(argv[1]);
+    if ( ! (is >> size) || (size < 20)) {
+      cerr << argv[0] << ": invalid size \"" << argv[1] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+  if (argc > 2) {
+    istringstream is(argv[2]);
+    if ( ! (is >> nrays) || (nrays < 1)) {
+      cerr << argv[0] << ": invalid nrays \"" << argv[2] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+  
+  // unexplored cells start out with a risk of one half
+  array<double> single_risk(size, size, 0.5);
+  array<double> batched_risk(size, size, 0.5);
+  scoped_ptr<Facade> single(Facade::CreateDefault(size, size, 1));
+  scoped_ptr<Facade> batched(Facade::CreateDefault(size, size, 1));
+  for (ssize_t ix(0); ix < size; ++ix)
+    for (ssize_t iy(0); iy < size; ++iy) {
+      single->SetMeta(ix, iy, risk_to_meta(*single, 0.5));
+      batched->SetMeta(ix, iy, risk_to_meta(*batched, 0.5));
+    }
+  single->AddGoal(size - 2, size - 2, 0);
+  batched->AddGoal(size - 2, size - 2, 0);
+  flush(*single);
+  flush(*batched);
+  
+  double const range(size / 4);
+  size_t ncalls(0);
+  size_t nsaved(0);
+  double single_time(0);
+  double batched_time(0);
+  for (ssize_t ix(2); ix < size - 2; ix += size / 10) {
+    double t0(get_monotonic_time());
+    ncalls += scan(*single, single_risk, size, ix, size / 3, nrays, range);
+    flush(*single);
+    double t1(get_monotonic_time());
+    single_time += t1 - t0;
+    
+    t0 = get_monotonic_time();
+    batched->BeginMetaBatch();
+    scan(*batched, batched_risk, size, ix, size / 3, nrays, range);
+    nsaved += batched->CommitMetaBatch();
+    flush(*batched);
+    t1 = get_monotonic_time();
+    batched_time += t1 - t0;
+  }
+  
+  double maxdelta(0);
+  for (ssize_t ix(0); ix < size; ++ix)
+    for (ssize_t iy(0); iy < size; ++iy) {
+      double const delta(absval(single->GetValue(ix, iy)
+				- batched->GetValue(ix, iy)));
+      if (delta > maxdelta)
+	maxdelta = delta;
+    }
+  
+  printf("grid %zdx%zd, %zu rays per scan\n"
+	 "SetMeta calls          %9zu\n"
+	 "kernel evaluations saved %7zu\n"
+	 "cell by cell           %9.3f s\n"
+	 "batched                %9.3f s\n"
+	 "max delta              %9g\n",
+	 size, size, nrays, ncalls, nsaved,
+	 single_time, batched_time, maxdelta);
+  // the update order differs, so the slack can add up differently
+  if (maxdelta > single->scale / 1000) {
+    printf("FAILURE\n");
+    exit(EXIT_FAILURE);
+  }
+  printf("SUCCESS\n");
+}
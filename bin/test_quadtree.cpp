@@ -0,0 +1,271 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+
+/**
+   Compares QuadtreeFacade with a uniform LSM Facade. First, on a
+   small map with walls and blocks of a single cell, where the two
+   must agree exactly. Then on a large open map with a few round
+   obstacles, where the quadtree needs a fraction of the vertices and
+   of the propagation time, and the values at all fine cells must
+   stay within a few percent of the uniform grid. The quadtree values
+   tend to come out lower, mostly in the wake of the obstacles, where
+   the many small steps of the uniform grid accumulate more of the
+   LSM discretization error than the large blocks. Finally, a wall is
+   added to both through SetMeta(), which splits the blocks it
+   crosses, and the repaired values are compared again.
+
+   usage: test_quadtree [size [maxsize]]
+*/
+
+
+#include <estar/QuadtreeFacade.hpp>
+#include <estar/Facade.hpp>
+#include <estar/numeric.hpp>
+#include <estar/util.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+using namespace estar;
+using namespace boost;
+using namespace std;
+
+
+static bool is_wall(ssize_t ix, ssize_t iy, ssize_t size)
+{
+  return ((ix == size / 3) && (iy > size / 5))
+    || ((ix == 2 * size / 3) && (iy < 4 * size / 5));
+}
+
+
+/** a sparse grid of round obstacles */
+static bool is_rock(ssize_t ix, ssize_t iy, ssize_t size)
+{
+  ssize_t const spacing(size / 5);
+  ssize_t const radius(size / 40);
+  ssize_t const dx((ix + spacing / 2) % spacing - spacing / 2);
+  ssize_t const dy((iy + spacing / 2) % spacing - spacing / 2);
+  return (ix >= spacing / 2) && (iy >= spacing / 2)
+    && (dx * dx + dy * dy <= radius * radius);
+}
+
+
+/** the wall that gets added later, with a gap at either end */
+static bool is_late_wall(ssize_t ix, ssize_t iy, ssize_t size)
+{
+  return (iy == size / 2) && (ix > size / 10) && (ix < size - size / 10);
+}
+
+
+struct error_stats {
+  error_stats(): mean(0), max(0), inconsistent(0) {}
+  double mean, max;
+  size_t inconsistent;
+};
+
+
+/** relative value errors at all cells farther than five cells from
+    the goal */
+static error_stats compare(FacadeReadInterface const & reference,
+			   FacadeReadInterface const & other, ssize_t size)
+{
+  error_stats stats;
+  size_t count(0);
+  for (ssize_t ix(0); ix < size; ++ix)
+    for (ssize_t iy(0); iy < size; ++iy) {
+      double const vr(reference.GetValue(ix, iy));
+      double const vo(other.GetValue(ix, iy));
+      if ((infinity == vr) != (infinity == vo)) {
+	++stats.inconsistent;
+	continue;
+      }
+      if ((infinity == vr) || (vr < 5 * reference.GetScale()))
+	continue;
+      double const error(absval(vo - vr) / vr);
+      stats.mean += error;
+      if (error > stats.max)
+	stats.max = error;
+      ++count;
+    }
+  if (count > 0)
+    stats.mean /= count;
+  return stats;
+}
+
+
+static size_t propagate(FacadeReadInterface const & facade,
+			Facade * grid, QuadtreeFacade * quad)
+{
+  size_t count(0);
+  while (facade.HaveWork()) {
+    if (grid)
+      grid->ComputeOne();
+    else
+      quad->ComputeOne();
+    ++count;
+  }
+  return count;
+}
+
+
+static bool test_single_cells()
+{
+  ssize_t const size(40);
+  scoped_ptr<Facade>
+    grid(Facade::Create("lsm", 1, GridOptions(0, size, 0, size, Grid::FOUR),
+			AlgorithmOptions(), stderr));
+  scoped_ptr<QuadtreeFacade>
+    quad(QuadtreeFacade::Create(1, size, size, 1, AlgorithmOptions()));
+  for (ssize_t ix(0); ix < size; ++ix)
+    for (ssize_t iy(0); iy < size; ++iy)
+      if (is_wall(ix, iy, size)) {
+	grid->SetMeta(ix, iy, grid->GetObstacleMeta());
+	quad->SetMeta(ix, iy, quad->GetObstacleMeta());
+      }
+  grid->AddGoal(1, 1, 0);
+  quad->AddGoal(1, 1, 0);
+  propagate(*grid, grid.get(), 0);
+  propagate(*quad, 0, quad.get());
+  error_stats const stats(compare(*grid, *quad, size));
+  printf("single cells: %zu vertices, max error %g\n",
+	 quad->GetQuadtree().GetNLeaves(), stats.max);
+  if ((stats.inconsistent > 0) || (stats.max > 1e-9)) {
+    printf("ERROR blocks of a single cell should reproduce LSMKernel\n");
+    return false;
+  }
+  return true;
+}
+
+
+static bool test_sparse(ssize_t size, ssize_t maxsize)
+{
+  vector<double> meta(size * size, 1);
+  for (ssize_t ix(0); ix < size; ++ix)
+    for (ssize_t iy(0); iy < size; ++iy)
+      if (is_rock(ix, iy, size))
+	meta[ix * size + iy] = 0;
+  
+  scoped_ptr<Facade>
+    grid(Facade::Create("lsm", 1, GridOptions(0, size, 0, size, Grid::FOUR),
+			AlgorithmOptions(), stderr));
+  for (ssize_t ix(0); ix < size; ++ix)
+    for (ssize_t iy(0); iy < size; ++iy)
+      if (0 == meta[ix * size + iy])
+	grid->SetMeta(ix, iy, grid->GetObstacleMeta());
+  grid->AddGoal(size / 10, size / 10, 0);
+  double const t0(get_monotonic_time());
+  size_t const ngrid(propagate(*grid, grid.get(), 0));
+  double const t1(get_monotonic_time());
+  
+  scoped_ptr<QuadtreeFacade>
+    quad(QuadtreeFacade::Create(1, size, size, maxsize, meta,
+				AlgorithmOptions()));
+  quad->AddGoal(size / 10, size / 10, 0);
+  double const t2(get_monotonic_time());
+  size_t const nquad(propagate(*quad, 0, quad.get()));
+  double const t3(get_monotonic_time());
+  
+  size_t const nvertices(quad->GetQuadtree().GetNLeaves());
+  error_stats const stats(compare(*grid, *quad, size));
+  printf("sparse %zdx%zd, blocks of up to %zd cells\n"
+	 "  grid:     %8zu vertices  %8zu expansions  %8.3f s\n"
+	 "  quadtree: %8zu vertices  %8zu expansions  %8.3f s\n"
+	 "  relative error: mean %.4f  max %.4f\n",
+	 size, size, maxsize,
+	 static_cast<size_t>(size * size), ngrid, t1 - t0,
+	 nvertices, nquad, t3 - t2, stats.mean, stats.max);
+  bool ok(true);
+  if (stats.inconsistent > 0) {
+    printf("ERROR %zu cells are reachable in only one of the maps\n",
+	   stats.inconsistent);
+    ok = false;
+  }
+  if (10 * nvertices > static_cast<size_t>(size * size)) {
+    printf("ERROR the quadtree should have ten times fewer vertices\n");
+    ok = false;
+  }
+  if ((stats.mean > 0.05) || (stats.max > 0.1)) {
+    printf("ERROR quadtree values are too far off\n");
+    ok = false;
+  }
+  
+  for (ssize_t ix(0); ix < size; ++ix)
+    for (ssize_t iy(0); iy < size; ++iy)
+      if (is_late_wall(ix, iy, size)) {
+	grid->SetMeta(ix, iy, grid->GetObstacleMeta());
+	quad->SetMeta(ix, iy, quad->GetObstacleMeta());
+      }
+  propagate(*grid, grid.get(), 0);
+  double const t4(get_monotonic_time());
+  size_t const nrepair(propagate(*quad, 0, quad.get()));
+  double const t5(get_monotonic_time());
+  error_stats const repaired(compare(*grid, *quad, size));
+  printf("  late wall: %zu vertices (%zu retired), %zu expansions  %.3f s\n"
+	 "  relative error: mean %.4f  max %.4f\n",
+	 quad->GetQuadtree().GetNLeaves(),
+	 num_vertices(quad->GetAlgorithm().GetCSpaceGraph())
+	 - quad->GetQuadtree().GetNLeaves(),
+	 nrepair, t5 - t4, repaired.mean, repaired.max);
+  if (repaired.inconsistent > 0) {
+    printf("ERROR after the late wall, %zu cells are reachable in only"
+	   " one of the maps\n", repaired.inconsistent);
+    ok = false;
+  }
+  if ((repaired.mean > 0.05) || (repaired.max > 0.1)) {
+    printf("ERROR quadtree values are too far off after the late wall\n");
+    ok = false;
+  }
+  return ok;
+}
+
+
+int main(int argc, char ** argv)
+{
+  ssize_t size(1000);
+  if (argc > 1) {
+    istringstream is(argv[1]);
+    if ( ! (is >> size) || (size < 50)) {
+      cerr << argv[0] << ": invalid size \"" << argv[1] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+  ssize_t maxsize(64);
+  if (argc > 2) {
+    istringstream is(argv[2]);
+    if ( ! (is >> maxsize) || (maxsize < 1)) {
+      cerr << argv[0] << ": invalid maxsize \"" << argv[2] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+  
+  bool ok(test_single_cells());
+  ok &= test_sparse(size, maxsize);
+  
+  if ( ! ok) {
+    printf("FAILURE\n");
+    exit(EXIT_FAILURE);
+  }
+  printf("SUCCESS\n");
+}
@@ -0,0 +1,230 @@
+/* 
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+/**
+   Benchmark for the Queue backends: propagates an LSM navigation
+   function over a square grid, then inserts a long wall and
+   repairs. Each backend is timed, and the resulting values are
+   compared against the std::multimap backend. The heaps should give
+   identical results, as they expand in the same order. The bucket
+   queue only approximately sorts its keys, so for it the maximum
+   deviation is reported instead. Then the claims made for the
+   bucket queue are checked (see BucketQueueBackend): it must be
+   exact for NF1Kernel with a bucket width of one scale, and for
+   LSMKernel with a bucket width at the slack it must deviate from
+   the 4-ary heap by no more than the slack does when the expansion
+   order changes.
+   
+   usage: test_queue_backend [size [bucket_width]]
+*/
+
+
+#include <estar/Facade.hpp>
+#include <estar/Algorithm.hpp>
+#include <estar/numeric.hpp>
+#include <estar/util.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+using namespace estar;
+using namespace boost;
+using namespace std;
+
+
+static void flush(Facade & facade, size_t & maxqueue)
+{
+  while (facade.HaveWork()) {
+    facade.ComputeOne();
+    size_t const qs(facade.GetAlgorithm().GetQueue().GetSize());
+    if (qs > maxqueue)
+      maxqueue = qs;
+  }
+}
+
+
+/** Plans and replans like the benchmark, and retrieves the values.
+    A positive meta replaces the freespace meta of the kernel, by
+    integers from meta to 3*meta in a diagonal pattern.
+    \return The number of steps. */
+static size_t plan(char const * kernel_name, double meta,
+		 Queue::backend_t backend, double bucket_width, ssize_t size,
+		 vector<double> & value)
+{
+  AlgorithmOptions algo_options;
+  algo_options.queue_backend = backend;
+  algo_options.bucket_width = bucket_width;
+  scoped_ptr<Facade>
+    facade(Facade::Create(kernel_name, 1, GridOptions(0, size, 0, size),
+			  algo_options, stderr));
+  if (meta > 0)
+    for (ssize_t ix(0); ix < size; ++ix)
+      for (ssize_t iy(0); iy < size; ++iy)
+	facade->SetMeta(ix, iy, meta * (1 + (ix + 2 * iy) % 3));
+  size_t maxqueue(0);
+  facade->AddGoal(1, 1, 0);
+  flush(*facade, maxqueue);
+  for (ssize_t iy(size / 4); iy < size; ++iy)
+    facade->SetMeta(size / 2, iy, facade->GetObstacleMeta());
+  flush(*facade, maxqueue);
+  value.clear();
+  for (ssize_t ix(0); ix < size; ++ix)
+    for (ssize_t iy(0); iy < size; ++iy)
+      value.push_back(facade->GetValue(ix, iy));
+  return facade->GetAlgorithm().GetStep();
+}
+
+
+/** \return The largest difference between the two value sets, or
+    infinity if they do not agree on which cells are reachable. */
+static double max_delta(vector<double> const & one,
+			vector<double> const & two)
+{
+  double maxdelta(0);
+  for (size_t ii(0); ii < one.size(); ++ii) {
+    if ((infinity == one[ii]) != (infinity == two[ii]))
+      return infinity;
+    if ((infinity != one[ii]) && (absval(one[ii] - two[ii]) > maxdelta))
+      maxdelta = absval(one[ii] - two[ii]);
+  }
+  return maxdelta;
+}
+
+
+int main(int argc, char ** argv)
+{
+  ssize_t size(300);
+  if (argc > 1) {
+    istringstream is(argv[1]);
+    if ( ! (is >> size) || (size < 10)) {
+      cerr << argv[0] << ": invalid size \"" << argv[1] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+  double bucket_width(0.1);
+  if (argc > 2) {
+    istringstream is(argv[2]);
+    if ( ! (is >> bucket_width) || (bucket_width <= 0)) {
+      cerr << argv[0] << ": invalid bucket_width \"" << argv[2] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+  
+  static Queue::backend_t const backend[] =
+    { Queue::MULTIMAP, Queue::BINARY_HEAP, Queue::FOUR_HEAP, Queue::BUCKET };
+  static char const * name[] =
+    { "multimap", "binary heap", "4-ary heap", "bucket" };
+  vector<double> reference;
+  
+  cout << "grid " << size << "x" << size
+       << "   bucket width " << bucket_width << "\n"
+       << "backend       init [s]  replan [s]  max queue  steps\n";
+  for (size_t ib(0); ib < 4; ++ib) {
+    AlgorithmOptions algo_options;
+    algo_options.queue_backend = backend[ib];
+    algo_options.bucket_width = bucket_width;
+    scoped_ptr<Facade>
+      facade(Facade::Create("lsm", 1, GridOptions(0, size, 0, size),
+			    algo_options, stderr));
+    size_t maxqueue(0);
+    
+    double const t0(get_monotonic_time());
+    facade->AddGoal(1, 1, 0);
+    flush(*facade, maxqueue);
+    double const t1(get_monotonic_time());
+    for (ssize_t iy(size / 4); iy < size; ++iy)
+      facade->SetMeta(size / 2, iy, facade->GetObstacleMeta());
+    flush(*facade, maxqueue);
+    double const t2(get_monotonic_time());
+    
+    printf("%-12s  %8.3f  %10.3f  %9zu  %zu\n", name[ib],
+	   t1 - t0, t2 - t1, maxqueue, facade->GetAlgorithm().GetStep());
+    
+    size_t mismatch(0);
+    double maxdelta(0);
+    for (ssize_t ix(0); ix < size; ++ix)
+      for (ssize_t iy(0); iy < size; ++iy) {
+	double const value(facade->GetValue(ix, iy));
+	size_t const idx(ix * size + iy);
+	if (0 == ib)
+	  reference.push_back(value);
+	else if (value != reference[idx]) {
+	  ++mismatch;
+	  if (absval(value - reference[idx]) > maxdelta)
+	    maxdelta = absval(value - reference[idx]);
+	}
+      }
+    if (Queue::BUCKET == backend[ib])
+      cout << "  " << mismatch << " values differ, by at most "
+	   << maxdelta << "\n";
+    else if (0 != mismatch) {
+      cout << "ERROR " << name[ib] << ": " << mismatch
+	   << " values differ from multimap backend\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+  
+  bool ok(true);
+  vector<double> heap, bucket;
+  // NF1Kernel adds the meta of the cell, whose freespace meta is
+  // zero, so integer metas are needed for integer keys, and with
+  // equal metas the FIFO buckets would expand in the right order
+  // anyway. Any order converges to the same NF1 values, what the
+  // width buys is that nothing gets expanded too early.
+  size_t const heap_steps(plan("nf1", 1, Queue::FOUR_HEAP, 1, size, heap));
+  size_t const bucket_steps(plan("nf1", 1, Queue::BUCKET, 1, size, bucket));
+  double const nf1_delta(max_delta(heap, bucket));
+  cout << "NF1 with bucket width 1: max delta " << nf1_delta << ", "
+       << bucket_steps << " steps (heap " << heap_steps << ")\n";
+  if ((0 != nf1_delta) || (bucket_steps != heap_steps)) {
+    cout << "ERROR bucket queue is not exact for NF1\n";
+    ok = false;
+  }
+  
+  // Facade::ComputeOne() uses a slack of scale/10000. The same
+  // slack lets the values of the heap depend on the expansion order
+  // by up to the slack per cell along a path, which bounds the
+  // deviation by the slack times the longest path, in cells.
+  // Such narrow buckets make repairs slow (see BucketQueueBackend),
+  // so this uses a smaller grid.
+  double const slack(1e-4);
+  ssize_t const small(size < 100 ? size : 100);
+  double const bound(slack * 2 * small);
+  plan("lsm", 0, Queue::FOUR_HEAP, 1, small, heap);
+  plan("lsm", 0, Queue::BUCKET, slack, small, bucket);
+  double const lsm_delta(max_delta(heap, bucket));
+  cout << "LSM with bucket width " << slack << ": max delta " << lsm_delta
+       << " (bound " << bound << ")\n";
+  if (lsm_delta > bound) {
+    cout << "ERROR bucket queue deviates by more than the slack allows\n";
+    ok = false;
+  }
+  
+  if ( ! ok) {
+    cout << "FAILURE\n";
+    exit(EXIT_FAILURE);
+  }
+  cout << "SUCCESS\n";
+}
@@ -0,0 +1,268 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+/**
+   Checks the rolling-window mode of Grid and Facade. First, the
+   window is moved around in various ways, and after each move the
+   topology (which cell is where, who neighbors whom), the queue,
+   and the goal set are checked. Then a window that contains the
+   goal initially is driven away from it one column at a time, past
+   a wall, and after each move the repaired navigation function is
+   compared against a static grid that covers the whole traverse.
+   The number of expansions and the time per move are reported at
+   the start and the end of the traverse, they should not grow with
+   the distance travelled.
+
+   usage: test_rolling_window [size]
+*/
+
+
+#include "fixtures.hpp"
+#include <estar/Facade.hpp>
+#include <estar/Algorithm.hpp>
+#include <estar/numeric.hpp>
+#include <estar/util.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+using namespace estar;
+using namespace boost;
+using namespace std;
+
+
+/** A wall across the X-axis, shorter than the window is high. */
+struct wall_meta: public Grid::get_meta {
+  wall_meta(ssize_t _xwall, ssize_t _halfwidth,
+	    double _freespace, double _obstacle)
+    : xwall(_xwall), halfwidth(_halfwidth),
+      freespace(_freespace), obstacle(_obstacle) {}
+  
+  virtual double operator () (ssize_t ix, ssize_t iy) const {
+    if ((ix == xwall) && (iy >= -halfwidth) && (iy <= halfwidth))
+      return obstacle;
+    return freespace;
+  }
+  
+  ssize_t xwall, halfwidth;
+  double freespace, obstacle;
+};
+
+
+static bool check_window(char const * what, Facade const & facade,
+			 ssize_t x0, ssize_t y0, ssize_t xsize, ssize_t ysize)
+{
+  GridCSpace const & cspace(*facade.GetCSpace());
+  Algorithm const & algo(facade.GetAlgorithm());
+  if (num_vertices(algo.GetCSpaceGraph())
+      != static_cast<size_t>(xsize * ysize)) {
+    printf("ERROR %s: %zu vertices instead of %zd\n", what,
+	   num_vertices(algo.GetCSpaceGraph()), xsize * ysize);
+    return false;
+  }
+  
+  static ssize_t const offset[4][2] = { {0, -1}, {-1, 0}, {0, 1}, {1, 0} };
+  set<vertex_t> seen;
+  for (ssize_t ix(x0 - 2); ix < x0 + xsize + 2; ++ix)
+    for (ssize_t iy(y0 - 2); iy < y0 + ysize + 2; ++iy) {
+      vertex_t const vertex(cspace.FindVertex(ix, iy));
+      bool const inside((ix >= x0) && (ix < x0 + xsize)
+			&& (iy >= y0) && (iy < y0 + ysize));
+      if (inside != facade.IsValidIndex(ix, iy)) {
+	printf("ERROR %s: IsValidIndex(%zd, %zd) is wrong\n", what, ix, iy);
+	return false;
+      }
+      if ( ! inside) {
+	if (CSpaceGraph::null_vertex != vertex) {
+	  printf("ERROR %s: vertex %zu at (%zd, %zd) outside window\n",
+		 what, vertex, ix, iy);
+	  return false;
+	}
+	continue;
+      }
+      if ((CSpaceGraph::null_vertex == vertex)
+	  || (cspace.LookupNode(vertex).ix != ix)
+	  || (cspace.LookupNode(vertex).iy != iy)) {
+	printf("ERROR %s: bad or missing node at (%zd, %zd)\n", what, ix, iy);
+	return false;
+      }
+      seen.insert(vertex);
+      set<pair<ssize_t, ssize_t> > expected;
+      for (size_t in(0); in < 4; ++in) {
+	ssize_t const nx(ix + offset[in][0]);
+	ssize_t const ny(iy + offset[in][1]);
+	if ((nx >= x0) && (nx < x0 + xsize) && (ny >= y0) && (ny < y0 + ysize))
+	  expected.insert(make_pair(nx, ny));
+      }
+      set<pair<ssize_t, ssize_t> > found;
+      for (edge_read_iteration in(cspace.begin(vertex));
+	   in.not_at_end(); ++in) {
+	GridNode const & nbor(cspace.LookupNode(*in));
+	found.insert(make_pair(nbor.ix, nbor.iy));
+      }
+      if (found != expected) {
+	printf("ERROR %s: wrong neighbors of (%zd, %zd)\n", what, ix, iy);
+	return false;
+      }
+    }
+  if (seen.size() != static_cast<size_t>(xsize * ysize)) {
+    printf("ERROR %s: only %zu distinct vertices\n", what, seen.size());
+    return false;
+  }
+  
+  size_t nopen(0);
+  size_t ngoal(0);
+  for (vertex_read_iteration iv(cspace.begin()); iv.not_at_end(); ++iv) {
+    if (iv.get(cspace.GetFlagMap()) & OPEN)
+      ++nopen;
+    if (iv.get(cspace.GetFlagMap()) & GOAL)
+      ++ngoal;
+  }
+  if (nopen != algo.GetQueue().GetSize() + algo.GetQueue().GetParkedSize()) {
+    printf("ERROR %s: %zu vertices flagged OPEN, but %zu in queue\n", what,
+	   nopen, algo.GetQueue().GetSize() + algo.GetQueue().GetParkedSize());
+    return false;
+  }
+  if ((0 != ngoal) != algo.HaveGoal()) {
+    printf("ERROR %s: %zu vertices flagged GOAL, but HaveGoal() is %s\n",
+	   what, ngoal, algo.HaveGoal() ? "true" : "false");
+    return false;
+  }
+  printf("%-28s  ok\n", what);
+  return true;
+}
+
+
+static Facade * create(ssize_t xbegin, ssize_t xend,
+		       ssize_t ybegin, ssize_t yend, bool rolling)
+{
+  return Facade::Create("lsm", 1,
+			GridOptions(xbegin, xend, ybegin, yend,
+				    Grid::FOUR, rolling),
+			AlgorithmOptions(), stderr);
+}
+
+
+int main(int argc, char ** argv)
+{
+  ssize_t size(60);
+  if (argc > 1) {
+    istringstream is(argv[1]);
+    if ( ! (is >> size) || (size < 20)) {
+      cerr << argv[0] << ": invalid size \"" << argv[1] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+  ssize_t const xsize(size);
+  ssize_t const ysize(size / 2);
+  
+  bool ok(true);
+  {
+    printf("window %zdx%zd, moving it around\n", xsize, ysize);
+    scoped_ptr<Facade> facade(create(0, xsize, 0, ysize, true));
+    facade->AddGoal(xsize / 2, ysize / 2, 0);
+    flush(*facade);
+    ok &= check_window("initial", *facade, 0, 0, xsize, ysize);
+    ssize_t x0(0);
+    ssize_t y0(0);
+    static ssize_t const move[][2] = {
+      {1, 0}, {0, 1}, {-1, -1}, {3, -2}, {-7, 5}, {xsize / 2, ysize / 3},
+      {xsize + 5, 0}, {-2 * xsize, -3 * ysize}, {1, 1} };
+    for (size_t im(0); im < sizeof(move) / sizeof(*move); ++im) {
+      x0 += move[im][0];
+      y0 += move[im][1];
+      facade->MoveWindow(x0, y0, facade->GetFreespaceMeta());
+      flush(*facade);
+      char what[64];
+      snprintf(what, sizeof(what), "MoveWindow(%zd, %zd)", x0, y0);
+      ok &= check_window(what, *facade, x0, y0, xsize, ysize);
+    }
+    if (facade->AddRange(-1000, 1000, -1000, 1000, 1) != 0) {
+      printf("ERROR AddRange() should do nothing on a rolling grid\n");
+      ok = false;
+    }
+  }
+  
+  // Drive away from the goal, past a wall that is added as cells
+  // enter the window. The static grid covers the whole traverse, and
+  // also has the window's height, so all paths stay within it.
+  ssize_t const travel(3 * xsize);
+  ssize_t const xbegin(-xsize / 2);
+  ssize_t const ybegin(-ysize / 2);
+  scoped_ptr<Facade> reference(create(xbegin, xbegin + xsize + travel,
+				      ybegin, ybegin + ysize, false));
+  scoped_ptr<Facade> facade(create(xbegin, xbegin + xsize,
+				   ybegin, ybegin + ysize, true));
+  wall_meta const wall(xsize, ysize / 4, facade->GetFreespaceMeta(),
+		       facade->GetObstacleMeta());
+  for (ssize_t iy(ybegin); iy < ybegin + ysize; ++iy)
+    reference->SetMeta(wall.xwall, iy, wall(wall.xwall, iy));
+  reference->AddGoal(0, 0, 0);
+  flush(*reference);
+  facade->AddGoal(0, 0, 0);
+  size_t const initial_steps(flush(*facade));
+  
+  printf("\ntraverse of %zd cells, initial propagation %zu steps\n"
+	 "  move   steps      time   max delta\n", travel, initial_steps);
+  double maxdelta(0);
+  size_t maxqueue(0);
+  for (ssize_t im(1); im <= travel; ++im) {
+    double const t0(get_monotonic_time());
+    facade->MoveWindow(xbegin + im, ybegin, &wall);
+    maxqueue = maxval(maxqueue, facade->GetAlgorithm().GetQueue().GetSize());
+    size_t const steps(flush(*facade));
+    double const dt(get_monotonic_time() - t0);
+    double delta(0);
+    for (ssize_t ix(xbegin + im); ix < xbegin + im + xsize; ++ix)
+      for (ssize_t iy(ybegin); iy < ybegin + ysize; ++iy) {
+	double const dd(absval(facade->GetValue(ix, iy)
+			       - reference->GetValue(ix, iy)));
+	if (dd > delta)
+	  delta = dd;
+      }
+    if (delta > maxdelta)
+      maxdelta = delta;
+    if ((im <= 3) || (im > travel - 3) || (im % xsize == 0))
+      printf("  %4zd  %6zu  %8.6f  %10g\n", im, steps, dt, delta);
+  }
+  if ( ! check_window("after traverse", *facade,
+		      xbegin + travel, ybegin, xsize, ysize))
+    ok = false;
+  if (facade->GetAlgorithm().HaveGoal()) {
+    printf("ERROR goal should have left the window\n");
+    ok = false;
+  }
+  printf("max delta %g, max queue %zu\n", maxdelta, maxqueue);
+  if (maxdelta > 1e-3) {
+    printf("ERROR rolling window differs from static grid\n");
+    ok = false;
+  }
+  
+  if ( ! ok) {
+    printf("FAILURE\n");
+    exit(EXIT_FAILURE);
+  }
+  printf("SUCCESS\n");
+}
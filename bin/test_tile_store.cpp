@@ -0,0 +1,456 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+/**
+   Checks TileStore and plans on a map that lives in one. First, a
+   store gets filled through a working set of only two tiles and is
+   checked after reopening it. Then the same small map is converted
+   from an ASCII grid and from PGM images, and compared with the
+   metas that test_estar_gfx would use. Finally, a map with a few
+   walls is planned from one corner to the other on a tiled Facade
+   backed by a store whose working set is a tenth of the map, and
+   compared with a complete grid. The values are saved into the
+   store and read back. The same map is then planned on a store that
+   has been opened read-only, where SetMeta() must only change the
+   grid. The page-in, eviction, and write-back counts and the timings
+   are printed along the way.
+
+   usage: test_tile_store [size [tilesize]]
+*/
+
+
+#include <estar/TileStore.hpp>
+#include <estar/Facade.hpp>
+#include <estar/Algorithm.hpp>
+#include <estar/numeric.hpp>
+#include <estar/util.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+
+using namespace estar;
+using namespace boost;
+using namespace std;
+
+
+static void print_stats(char const * what, TileStore const & store)
+{
+  printf("%-40s  %zu page-ins, %zu evictions, %zu write-backs\n", what,
+	 store.GetNPageins(), store.GetNEvictions(), store.GetNWritebacks());
+}
+
+
+static Facade * create(ssize_t size, ssize_t tile_size)
+{
+  return Facade::Create("lsm", 1,
+			GridOptions(0, size, 0, size, Grid::FOUR, false,
+				    tile_size),
+			AlgorithmOptions(), stderr);
+}
+
+
+/** Walls across the map, each with a gap at alternating ends. */
+static bool is_wall(ssize_t size, ssize_t ix, ssize_t iy)
+{
+  ssize_t const spacing(size / 4);
+  if ((ix < spacing) || (ix % spacing != 0) || (ix >= 4 * spacing))
+    return false;
+  ssize_t const gap(size / 5);
+  if ((ix / spacing) % 2)
+    return iy < size - gap;
+  return iy >= gap;
+}
+
+
+static bool check_roundtrip(string const & path)
+{
+  ssize_t const x0(-5), x1(x0 + 3 * 16 + 7), y0(3), y1(y0 + 2 * 16 + 1);
+  {
+    scoped_ptr<TileStore>
+      store(TileStore::Create(path, x0, x1, y0, y1, 16, true, 0.5, 2));
+    if ((0.5 != store->GetMeta(x1 - 1, y1 - 1))
+	|| (infinity != store->GetValue(x0, y0))) {
+      printf("ERROR fresh store is not initialized\n");
+      return false;
+    }
+    // Y-major to make the small working set thrash.
+    for (ssize_t iy(y0); iy < y1; ++iy)
+      for (ssize_t ix(x0); ix < x1; ++ix) {
+	store->SetMeta(ix, iy, 0.001 * (ix - x0) + 0.0001 * (iy - y0));
+	store->SetValue(ix, iy, (ix + iy) % 7 ? ix * iy : infinity);
+      }
+    if (store->SetMeta(x1, y0, 1) || store->SetValue(x0, y0 - 1, 1)) {
+      printf("ERROR writing outside the range should fail\n");
+      return false;
+    }
+    if (store->GetNMapped() > 2) {
+      printf("ERROR %zu tiles mapped with a capacity of 2\n",
+	     store->GetNMapped());
+      return false;
+    }
+    print_stats("filled with 2 tiles mapped", *store);
+    if (0 == store->GetNWritebacks()) {
+      printf("ERROR evicted tiles have not been written back\n");
+      return false;
+    }
+  }
+  
+  scoped_ptr<TileStore> store(TileStore::Open(path, false, 3));
+  if ((x0 != store->GetXBegin()) || (x1 != store->GetXEnd())
+      || (y0 != store->GetYBegin()) || (y1 != store->GetYEnd())
+      || (16 != store->GetTileSize()) || ( ! store->HaveValues())) {
+    printf("ERROR reopened store has the wrong layout\n");
+    return false;
+  }
+  for (ssize_t ix(x0); ix < x1; ++ix)
+    for (ssize_t iy(y0); iy < y1; ++iy) {
+      float const meta(0.001 * (ix - x0) + 0.0001 * (iy - y0));
+      double const value((ix + iy) % 7 ? ix * iy : infinity);
+      if ((meta != store->GetMeta(ix, iy))
+	  || (value != store->GetValue(ix, iy))) {
+	printf("ERROR (%zd, %zd) has meta %g value %g instead of %g %g\n",
+	       ix, iy, store->GetMeta(ix, iy), store->GetValue(ix, iy),
+	       meta, value);
+	return false;
+      }
+    }
+  print_stats("reopened and checked", *store);
+  return true;
+}
+
+
+static bool check_map(char const * what, TileStore * converted,
+		      vector<vector<double> > const & cost, ssize_t xsize)
+{
+  scoped_ptr<TileStore> store(converted);
+  if ( ! store) {
+    printf("ERROR %s: conversion failed\n", what);
+    return false;
+  }
+  ssize_t const ysize(cost.size());
+  if ((0 != store->GetXBegin()) || (xsize != store->GetXEnd())
+      || (0 != store->GetYBegin()) || (ysize != store->GetYEnd())) {
+    printf("ERROR %s: wrong range\n", what);
+    return false;
+  }
+  
+  // Same as NHPRiskmap in test_estar_gfx with a maximum risk of one.
+  double maxcost(0);
+  for (size_t iline(0); iline < cost.size(); ++iline)
+    for (size_t icol(0); icol < cost[iline].size(); ++icol)
+      maxcost = maxval(maxcost, cost[iline][icol]);
+  double const scale(1 / maxcost);
+  for (ssize_t iline(0); iline < ysize; ++iline)
+    for (ssize_t ix(0); ix < xsize; ++ix) {
+      double meta(1);
+      if (ix < static_cast<ssize_t>(cost[iline].size())) {
+	double const cc(cost[iline][ix]);
+	meta = boundval(0.0, 1 - (cc < 0 ? 1 : cc * scale), 1.0);
+      }
+      float const want(meta);
+      if (want != store->GetMeta(ix, ysize - 1 - iline)) {
+	printf("ERROR %s: (%zd, %zd) has meta %g instead of %g\n", what,
+	       ix, ysize - 1 - iline, store->GetMeta(ix, ysize - 1 - iline),
+	       meta);
+	return false;
+      }
+    }
+  printf("%-40s  ok\n", what);
+  return true;
+}
+
+
+static bool check_conversion(string const & path)
+{
+  // Costs as in an ASCII grid, first line at the top.
+  ssize_t const xsize(21);
+  vector<vector<double> > cost;
+  for (ssize_t iline(0); iline < 13; ++iline) {
+    cost.push_back(vector<double>());
+    for (ssize_t ix(0); ix < (iline == 4 ? xsize - 6 : xsize); ++ix)
+      cost.back().push_back((ix == iline) ? -1 : (ix * iline) % 10);
+  }
+  
+  string const ascii(path + ".txt");
+  {
+    ofstream os(ascii.c_str());
+    os << "#goal 1 1\n#robot 3 4\n";
+    for (size_t iline(0); iline < cost.size(); ++iline) {
+      for (size_t ix(0); ix < cost[iline].size(); ++ix)
+	os << cost[iline][ix] << " ";
+      os << "\n";
+    }
+  }
+  bool ok(check_map("ASCII grid", convert_ascii_grid(ascii, path, 8, false,
+						     2, &cerr),
+		    cost, xsize));
+  unlink(ascii.c_str());
+  
+  // The same as PGM, where the maximum gray level marks obstacles.
+  // The short line becomes a line of zero costs.
+  for (size_t ix(xsize - 6); ix < xsize; ++ix)
+    cost[4].push_back(0);
+  string const pgm(path + ".pgm");
+  for (int raw(0); raw < 2; ++raw) {
+    {
+      ofstream os(pgm.c_str(), ios::binary);
+      os << (raw ? "P5" : "P2") << "\n# test\n" << xsize << " "
+	 << cost.size() << "\n255\n";
+      for (size_t iline(0); iline < cost.size(); ++iline) {
+	for (size_t ix(0); ix < cost[iline].size(); ++ix) {
+	  int const gray(cost[iline][ix] < 0 ? 255 : cost[iline][ix]);
+	  if (raw)
+	    os.put(gray);
+	  else
+	    os << gray << " ";
+	}
+	if ( ! raw)
+	  os << "\n";
+      }
+    }
+    ok &= check_map(raw ? "raw PGM" : "plain PGM",
+		    convert_pgm(pgm, path, 16, true, 1, &cerr), cost, xsize);
+  }
+  unlink(pgm.c_str());
+  return ok;
+}
+
+
+static bool check_planning(string const & path, ssize_t size, ssize_t tsize)
+{
+  ssize_t const ntiles(((size + tsize - 1) / tsize)
+		       * ((size + tsize - 1) / tsize));
+  size_t const capacity(maxval(static_cast<ssize_t>(1), ntiles / 10));
+  printf("\nmap %zdx%zd, tiles of %zdx%zd, %zu of %zd tiles mapped\n",
+	 size, size, tsize, tsize, capacity, ntiles);
+  
+  scoped_ptr<Facade> reference(create(size, 0));
+  double t0(get_monotonic_time());
+  {
+    scoped_ptr<TileStore>
+      store(TileStore::Create(path, 0, size, 0, size, tsize, true,
+			      reference->GetFreespaceMeta(), capacity));
+    for (ssize_t ix(0); ix < size; ++ix)
+      for (ssize_t iy(0); iy < size; ++iy)
+	if (is_wall(size, ix, iy))
+	  store->SetMeta(ix, iy, reference->GetObstacleMeta());
+    printf("%-40s  %zu bytes, working set %zu bytes\n", "store created",
+	   store->GetFileSize(), store->GetWorkingSetSize());
+  }
+  double const t_create(get_monotonic_time() - t0);
+  
+  for (ssize_t ix(0); ix < size; ++ix)
+    for (ssize_t iy(0); iy < size; ++iy)
+      if (is_wall(size, ix, iy))
+	reference->SetMeta(ix, iy, reference->GetObstacleMeta());
+  reference->AddGoal(1, 1, 0);
+  t0 = get_monotonic_time();
+  reference->ComputeUntil(size / 8, size - 2, infinity);
+  double const t_reference(get_monotonic_time() - t0);
+  
+  bool ok(true);
+  shared_ptr<TileStore> store(TileStore::Open(path, true, capacity));
+  scoped_ptr<Facade> facade(create(size, tsize));
+  if ( ! facade->SetTileStore(store)) {
+    printf("ERROR SetTileStore() failed on a tiled grid\n");
+    return false;
+  }
+  if (facade->GetMeta(size / 4, 0) != reference->GetObstacleMeta()) {
+    printf("ERROR missing tiles do not see the metas of the store\n");
+    ok = false;
+  }
+  facade->AddGoal(1, 1, 0);
+  t0 = get_monotonic_time();
+  compute_progress const
+    progress(facade->ComputeUntil(size / 8, size - 2, infinity));
+  double const t_tiled(get_monotonic_time() - t0);
+  if ( ! progress.settled) {
+    printf("ERROR robot did not get settled\n");
+    ok = false;
+  }
+  print_stats("robot settled", *store);
+  printf("%-40s  %zu tiles of %zd, %zu mapped\n", "planner",
+	 facade->GetCSpace()->GetNTiles(), ntiles, store->GetNMapped());
+  printf("%-40s  create %.3fs, reference %.3fs, tiled %.3fs\n", "timing",
+	 t_create, t_reference, t_tiled);
+  if (store->GetNMapped() > capacity) {
+    printf("ERROR %zu tiles mapped with a capacity of %zu\n",
+	   store->GetNMapped(), capacity);
+    ok = false;
+  }
+  
+  double delta(0);
+  GridCSpace const & cspace(*facade->GetCSpace());
+  for (ssize_t ix(0); ix < size; ++ix)
+    for (ssize_t iy(0); iy < size; ++iy) {
+      vertex_t const vertex(cspace.FindVertex(ix, iy));
+      if ((CSpaceGraph::null_vertex == vertex)
+	  || ( ! facade->GetAlgorithm().IsSettled(vertex)))
+	continue;
+      double const dd(absval(facade->GetValue(ix, iy)
+			     - reference->GetValue(ix, iy)));
+      if (dd > delta)
+	delta = dd;
+    }
+  printf("%-40s  max delta %g\n", "tiled vs complete grid", delta);
+  if (delta > 1e-6) {
+    printf("ERROR tiled grid differs from complete grid\n");
+    ok = false;
+  }
+  
+  // SetMeta() writes through, also to tiles that do not exist yet.
+  ssize_t const ix(size - 1), iy(0);
+  if (CSpaceGraph::null_vertex != cspace.FindVertex(ix, iy))
+    printf("note: the far corner has been reached\n");
+  facade->SetMeta(ix, iy, 0.25);
+  facade->SetMeta(2, 2, 0.75);
+  if ((0.25 != store->GetMeta(ix, iy)) || (0.75 != store->GetMeta(2, 2))) {
+    printf("ERROR SetMeta() did not write through to the store\n");
+    ok = false;
+  }
+  
+  size_t const nsaved(facade->SaveValues());
+  print_stats("values saved", *store);
+  facade.reset();
+  store.reset();
+  store.reset(TileStore::Open(path, false, 1));
+  size_t nchecked(0);
+  for (ssize_t ix(0); ix < size; ++ix)
+    for (ssize_t iy(0); iy < size; ++iy) {
+      double const value(reference->GetValue(ix, iy));
+      double const saved(store->GetValue(ix, iy));
+      if (saved >= infinity)
+	continue;
+      ++nchecked;
+      if (absval(saved - value) > 1e-5 * maxval(1.0, value)) {
+	printf("ERROR (%zd, %zd) saved value %g instead of %g\n",
+	       ix, iy, saved, value);
+	ok = false;
+	ix = size;
+	break;
+      }
+    }
+  printf("%-40s  %zu cells, %zu finite\n", "saved values read back",
+	 nsaved, nchecked);
+  if (0 == nchecked) {
+    printf("ERROR no values have been saved\n");
+    ok = false;
+  }
+  return ok;
+}
+
+
+static bool check_readonly(string const & path, ssize_t size, ssize_t tsize)
+{
+  shared_ptr<TileStore> store(TileStore::Open(path, false, 2));
+  scoped_ptr<Facade> facade(create(size, tsize));
+  if ( ! facade->SetTileStore(store)) {
+    printf("ERROR SetTileStore() failed with a read-only store\n");
+    return false;
+  }
+  double const freespace(facade->GetFreespaceMeta());
+  double const obstacle(facade->GetObstacleMeta());
+  
+  // A hole in the first wall, in a tile that does not exist yet.
+  ssize_t const ix(size / 4), iy(0);
+  bool ok(true);
+  try {
+    facade->SetMeta(ix, iy, freespace);
+    facade->SetMeta(ix, iy, freespace);
+    facade->AddGoal(1, 1, 0);
+    if ( ! facade->ComputeUntil(size / 8, size - 2, infinity).settled) {
+      printf("ERROR robot did not get settled on a read-only store\n");
+      ok = false;
+    }
+  }
+  catch (std::exception const & ee) {
+    printf("ERROR planning on a read-only store: %s\n", ee.what());
+    return false;
+  }
+  if ((freespace != facade->GetMeta(ix, iy))
+      || (obstacle != store->GetMeta(ix, iy))) {
+    printf("ERROR read-only store: meta %g in the grid and %g in the"
+	   " store\n", facade->GetMeta(ix, iy), store->GetMeta(ix, iy));
+    ok = false;
+  }
+  if (0 != facade->SaveValues()) {
+    printf("ERROR values saved into a read-only store\n");
+    ok = false;
+  }
+  print_stats("planned on read-only store", *store);
+  return ok;
+}
+
+
+int main(int argc, char ** argv)
+{
+  ssize_t size(512);
+  ssize_t tsize(32);
+  if (argc > 1) {
+    istringstream is(argv[1]);
+    if ( ! (is >> size) || (size < 20)) {
+      cerr << argv[0] << ": invalid size \"" << argv[1] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+  if (argc > 2) {
+    istringstream is(argv[2]);
+    if ( ! (is >> tsize) || (tsize < 1) || (0 != (tsize & (tsize - 1)))) {
+      cerr << argv[0] << ": invalid tilesize \"" << argv[2] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+  
+  char tmpl[] = "/tmp/test_tile_store.XXXXXX";
+  int const fd(mkstemp(tmpl));
+  if (fd < 0) {
+    perror("mkstemp");
+    exit(EXIT_FAILURE);
+  }
+  close(fd);
+  string const path(tmpl);
+  
+  bool ok(true);
+  try {
+    ok &= check_roundtrip(path);
+    ok &= check_conversion(path);
+    ok &= check_planning(path, size, tsize);
+    ok &= check_readonly(path, size, tsize);
+  }
+  catch (std::exception const & ee) {
+    printf("ERROR %s\n", ee.what());
+    ok = false;
+  }
+  unlink(path.c_str());
+  
+  if ( ! ok) {
+    printf("FAILURE\n");
+    exit(EXIT_FAILURE);
+  }
+  printf("SUCCESS\n");
+}
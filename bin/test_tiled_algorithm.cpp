@@ -0,0 +1,222 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+/**
+   Compares TiledAlgorithm against BasicAlgorithm on a grid with a
+   few walls, for an increasing number of threads, and reports the
+   timings along with the number of expansions and rounds. The values
+   must agree within a few times the slack. Then Facade::ComputeParallel()
+   is compared with the sequential Facade, and a wall is inserted
+   into both to check that incremental repairs work on the imported
+   navigation function.
+
+   usage: test_tiled_algorithm [size [max_threads]]
+*/
+
+
+#include "fixtures.hpp"
+#include <estar/TiledAlgorithm.hpp>
+#include <estar/Facade.hpp>
+#include <estar/util.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+using namespace estar;
+using namespace boost;
+using namespace std;
+
+
+static bool is_wall(ssize_t ix, ssize_t iy, ssize_t size)
+{
+  return ((ix == size / 3) && (iy > size / 5))
+    || ((ix == 2 * size / 3) && (iy < 4 * size / 5))
+    || ((iy == size / 2) && (ix > size / 3) && (ix < size / 2));
+}
+
+
+template<class BasicKernelT, class NeighborhoodT>
+static bool run(char const * name, ssize_t size, size_t max_threads,
+		BasicKernelT const & kernel)
+{
+  double const slack(kernel.scale / 10000);
+  double const tolerance(10 * slack);
+
+  BasicAlgorithm<BasicKernelT, NeighborhoodT> basic(size, size, kernel);
+  for (ssize_t ix(0); ix < size; ++ix)
+    for (ssize_t iy(0); iy < size; ++iy)
+      if (is_wall(ix, iy, size))
+	basic.SetMeta(ix, iy, BasicKernelT::traits::obstacle_meta());
+  basic.AddGoal(1, 1, 0);
+  double const t0(get_monotonic_time());
+  size_t nbasic(0);
+  while (basic.HaveWork()) {
+    basic.ComputeOne(slack);
+    ++nbasic;
+  }
+  double const tbasic(get_monotonic_time() - t0);
+  printf("%s %zdx%zd\n"
+	 "  basic            %8.3f s  %9zu expansions\n",
+	 name, size, size, tbasic, nbasic);
+
+  bool ok(true);
+  for (size_t nthreads(1); nthreads <= max_threads; nthreads *= 2) {
+    TiledAlgorithm<BasicKernelT, NeighborhoodT> tiled(size, size, kernel);
+    for (ssize_t ix(0); ix < size; ++ix)
+      for (ssize_t iy(0); iy < size; ++iy)
+	if (is_wall(ix, iy, size))
+	  tiled.SetMeta(ix, iy, BasicKernelT::traits::obstacle_meta());
+    tiled.AddGoal(1, 1, 0);
+    double const t1(get_monotonic_time());
+    tiled.Compute(nthreads, slack);
+    double const ttiled(get_monotonic_time() - t1);
+    double maxdelta(0);
+    for (ssize_t ix(0); ix < size; ++ix)
+      for (ssize_t iy(0); iy < size; ++iy) {
+	double const vb(basic.GetValue(ix, iy));
+	double const vt(tiled.GetValue(ix, iy));
+	if ((infinity == vb) != (infinity == vt))
+	  maxdelta = infinity;
+	else if ((infinity != vb) && (absval(vb - vt) > maxdelta))
+	  maxdelta = absval(vb - vt);
+      }
+    printf("  %2zu thread(s)     %8.3f s  %9zu expansions  %5zu rounds"
+	   "  speedup %5.2f  max delta %g\n",
+	   nthreads, ttiled, tiled.GetNExpanded(), tiled.GetNRounds(),
+	   tbasic / ttiled, maxdelta);
+    if (maxdelta > tolerance) {
+      printf("ERROR %s with %zu threads: values differ by %g\n",
+	     name, nthreads, maxdelta);
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+
+static Facade * create(ssize_t size, char const * kernel,
+		       Grid::neighborhood_t nbor)
+{
+  Facade * facade(Facade::Create(kernel, 1,
+				 GridOptions(0, size, 0, size, nbor),
+				 AlgorithmOptions(), stderr));
+  for (ssize_t ix(0); ix < size; ++ix)
+    for (ssize_t iy(0); iy < size; ++iy)
+      if (is_wall(ix, iy, size))
+	facade->SetMeta(ix, iy, facade->GetObstacleMeta());
+  facade->AddGoal(1, 1, 0);
+  return facade;
+}
+
+
+static bool run_facade(char const * name, ssize_t size, size_t nthreads,
+		       char const * kernel, Grid::neighborhood_t nbor)
+{
+  scoped_ptr<Facade> sequential(create(size, kernel, nbor));
+  scoped_ptr<Facade> parallel(create(size, kernel, nbor));
+  double const tolerance(sequential->scale / 1000);
+
+  double const t0(get_monotonic_time());
+  while (sequential->HaveWork())
+    sequential->ComputeOne();
+  double const t1(get_monotonic_time());
+  if ( ! parallel->ComputeParallel(nthreads)) {
+    printf("ERROR %s: Facade::ComputeParallel() refused to run\n", name);
+    return false;
+  }
+  double const t2(get_monotonic_time());
+  double const delta(max_delta(*sequential, *parallel, size));
+  printf("%s facade: sequential %.3f s, %zu threads %.3f s,"
+	 " max delta %g, work left %s\n",
+	 name, t1 - t0, nthreads, t2 - t1, delta,
+	 parallel->HaveWork() ? "yes" : "no");
+  if ((delta > tolerance) || parallel->HaveWork()) {
+    printf("ERROR %s: ComputeParallel() disagrees with the sequential"
+	   " Facade\n", name);
+    return false;
+  }
+
+  for (ssize_t iy(0); iy < size - 3; ++iy) {
+    sequential->SetMeta(size / 6, iy, sequential->GetObstacleMeta());
+    parallel->SetMeta(size / 6, iy, parallel->GetObstacleMeta());
+  }
+  while (sequential->HaveWork())
+    sequential->ComputeOne();
+  size_t nrepair(0);
+  while (parallel->HaveWork()) {
+    parallel->ComputeOne();
+    ++nrepair;
+  }
+  double const repaired(max_delta(*sequential, *parallel, size));
+  printf("%s facade: repaired a new wall in %zu steps, max delta %g\n",
+	 name, nrepair, repaired);
+  if (repaired > tolerance) {
+    printf("ERROR %s: incremental repair after ComputeParallel() went"
+	   " wrong\n", name);
+    return false;
+  }
+  return true;
+}
+
+
+int main(int argc, char ** argv)
+{
+  ssize_t size(600);
+  if (argc > 1) {
+    istringstream is(argv[1]);
+    if ( ! (is >> size) || (size < 10)) {
+      cerr << argv[0] << ": invalid size \"" << argv[1] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+  size_t max_threads(16);
+  if (argc > 2) {
+    istringstream is(argv[2]);
+    if ( ! (is >> max_threads) || (max_threads < 1)) {
+      cerr << argv[0] << ": invalid max_threads \"" << argv[2] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  bool ok(true);
+  ok &= run<BasicLSMKernel, FourNeighborhood>("LSM four", size, max_threads,
+					       BasicLSMKernel(1));
+  ok &= run<BasicLSMKernel, EightNeighborhood>("LSM eight", size, max_threads,
+						BasicLSMKernel(1));
+  ok &= run<BasicNF1Kernel, EightNeighborhood>("NF1 eight", size, max_threads,
+					       BasicNF1Kernel());
+  ok &= run<BasicAlphaKernel, SixNeighborhood>("Alpha six", size, max_threads,
+					       BasicAlphaKernel(1));
+
+  ssize_t const fsize(size / 3);
+  ok &= run_facade("LSM four", fsize, 4, "lsm", Grid::FOUR);
+  ok &= run_facade("NF1 eight", fsize, 4, "nf1", Grid::EIGHT);
+  ok &= run_facade("Alpha six", fsize, 4, "alpha", Grid::SIX);
+
+  if ( ! ok) {
+    printf("FAILURE\n");
+    exit(EXIT_FAILURE);
+  }
+  printf("SUCCESS\n");
+}
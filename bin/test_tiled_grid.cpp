@@ -0,0 +1,319 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+/**
+   Checks the tiled (sparse) mode of Grid and Facade. First, tiles
+   get created in a scattered order through the various entry
+   points, and the topology is checked across tile boundaries, for
+   both four and eight neighbors. Then a map with a few walls is
+   planned from one corner to the other, once on a tiled grid that
+   only creates the tiles that the wavefront reaches, and once on a
+   complete grid for reference. The values of all settled cells have
+   to agree, both when the propagation stops at the robot and after
+   flushing the queue. The tile occupancy map is printed along the
+   way.
+
+   usage: test_tiled_grid [size [tilesize]]
+*/
+
+
+#include <estar/Facade.hpp>
+#include <estar/Algorithm.hpp>
+#include <estar/numeric.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+using namespace estar;
+using namespace boost;
+using namespace std;
+
+
+static Facade * create(ssize_t xbegin, ssize_t xend,
+		       ssize_t ybegin, ssize_t yend,
+		       Grid::neighborhood_t neighborhood, ssize_t tile_size)
+{
+  return Facade::Create("lsm", 1,
+			GridOptions(xbegin, xend, ybegin, yend,
+				    neighborhood, false, tile_size),
+			AlgorithmOptions(), stderr);
+}
+
+
+/** Walls across the map, each with a gap at alternating ends. */
+struct wall_meta: public Grid::get_meta {
+  wall_meta(ssize_t _xbegin, ssize_t _xend, ssize_t _ybegin, ssize_t _yend,
+	    double _freespace, double _obstacle)
+    : xbegin(_xbegin), xend(_xend), ybegin(_ybegin), yend(_yend),
+      freespace(_freespace), obstacle(_obstacle) {}
+  
+  bool IsWall(ssize_t ix, ssize_t iy) const {
+    ssize_t const spacing((xend - xbegin) / 4);
+    ssize_t const jx(ix - xbegin);
+    if ((jx < spacing) || (jx % spacing != 0) || (jx >= 4 * spacing))
+      return false;
+    ssize_t const gap((yend - ybegin) / 5);
+    if ((jx / spacing) % 2)
+      return iy < yend - gap;
+    return iy >= ybegin + gap;
+  }
+  
+  virtual double operator () (ssize_t ix, ssize_t iy) const
+  { return IsWall(ix, iy) ? obstacle : freespace; }
+  
+  ssize_t xbegin, xend, ybegin, yend;
+  double freespace, obstacle;
+};
+
+
+static bool check_topology(char const * what, Facade const & facade,
+			   Grid::neighborhood_t neighborhood,
+			   ssize_t x0, ssize_t x1, ssize_t y0, ssize_t y1)
+{
+  GridCSpace const & cspace(*facade.GetCSpace());
+  ssize_t const tsize(cspace.GetTileSize());
+  size_t const ncells(num_vertices(cspace.GetGraph()));
+  if (ncells != cspace.GetNTiles() * tsize * tsize) {
+    printf("ERROR %s: %zu vertices in %zu tiles\n", what, ncells,
+	   cspace.GetNTiles());
+    return false;
+  }
+  
+  set<vertex_t> seen;
+  for (ssize_t ix(x0 - 2); ix < x1 + 2; ++ix)
+    for (ssize_t iy(y0 - 2); iy < y1 + 2; ++iy) {
+      vertex_t const vertex(cspace.FindVertex(ix, iy));
+      bool const inside((ix >= x0) && (ix < x1) && (iy >= y0) && (iy < y1));
+      if (( ! inside) || ( ! cspace.HaveTile(ix, iy))) {
+	if (CSpaceGraph::null_vertex != vertex) {
+	  printf("ERROR %s: vertex %zu at (%zd, %zd) without tile\n",
+		 what, vertex, ix, iy);
+	  return false;
+	}
+	if (inside && (facade.GetMeta(ix, iy) != facade.GetFreespaceMeta())) {
+	  printf("ERROR %s: (%zd, %zd) without tile is not freespace\n",
+		 what, ix, iy);
+	  return false;
+	}
+	continue;
+      }
+      if ((CSpaceGraph::null_vertex == vertex)
+	  || (cspace.LookupNode(vertex).ix != ix)
+	  || (cspace.LookupNode(vertex).iy != iy)) {
+	printf("ERROR %s: bad or missing node at (%zd, %zd)\n", what, ix, iy);
+	return false;
+      }
+      seen.insert(vertex);
+      set<pair<ssize_t, ssize_t> > expected;
+      for (ssize_t dx(-1); dx <= 1; ++dx)
+	for (ssize_t dy(-1); dy <= 1; ++dy) {
+	  if (((0 == dx) && (0 == dy))
+	      || ((Grid::FOUR == neighborhood) && (0 != dx) && (0 != dy)))
+	    continue;
+	  ssize_t const nx(ix + dx);
+	  ssize_t const ny(iy + dy);
+	  if ((nx >= x0) && (nx < x1) && (ny >= y0) && (ny < y1)
+	      && cspace.HaveTile(nx, ny))
+	    expected.insert(make_pair(nx, ny));
+	}
+      set<pair<ssize_t, ssize_t> > found;
+      for (edge_read_iteration in(cspace.begin(vertex));
+	   in.not_at_end(); ++in) {
+	GridNode const & nbor(cspace.LookupNode(*in));
+	found.insert(make_pair(nbor.ix, nbor.iy));
+      }
+      if (found != expected) {
+	printf("ERROR %s: wrong neighbors of (%zd, %zd)\n", what, ix, iy);
+	return false;
+      }
+    }
+  
+  // the vertices of cells beyond the end of the range are isolated
+  for (size_t it(0); it < cspace.GetNTiles(); ++it) {
+    ssize_t tx, ty;
+    cspace.GetTile(it, tx, ty);
+    for (ssize_t ix(tx); ix < tx + tsize; ++ix)
+      for (ssize_t iy(ty); iy < ty + tsize; ++iy) {
+	if ((ix < x1) && (iy < y1))
+	  continue;
+	vertex_t const vertex(cspace.FindVertex(tx, ty)
+			      + (ix - tx) * tsize + iy - ty);
+	if (cspace.begin(vertex).not_at_end()) {
+	  printf("ERROR %s: (%zd, %zd) is outside but has neighbors\n",
+		 what, ix, iy);
+	  return false;
+	}
+      }
+  }
+  printf("%-40s  ok, %zu tiles\n", what, cspace.GetNTiles());
+  return true;
+}
+
+
+static bool check_values(char const * what,
+			 Facade const & facade, Facade const & reference,
+			 ssize_t x0, ssize_t x1, ssize_t y0, ssize_t y1)
+{
+  double delta(0);
+  size_t nsettled(0);
+  Algorithm const & algo(facade.GetAlgorithm());
+  GridCSpace const & cspace(*facade.GetCSpace());
+  for (ssize_t ix(x0); ix < x1; ++ix)
+    for (ssize_t iy(y0); iy < y1; ++iy) {
+      vertex_t const vertex(cspace.FindVertex(ix, iy));
+      if ((CSpaceGraph::null_vertex == vertex) || ( ! algo.IsSettled(vertex)))
+	continue;
+      ++nsettled;
+      double const dd(absval(facade.GetValue(ix, iy)
+			     - reference.GetValue(ix, iy)));
+      if (dd > delta)
+	delta = dd;
+    }
+  printf("%-40s  %zu settled cells, max delta %g\n", what, nsettled, delta);
+  if (delta > 1e-6) {
+    printf("ERROR %s: tiled grid differs from complete grid\n", what);
+    return false;
+  }
+  return true;
+}
+
+
+int main(int argc, char ** argv)
+{
+  ssize_t size(300);
+  ssize_t tsize(32);
+  if (argc > 1) {
+    istringstream is(argv[1]);
+    if ( ! (is >> size) || (size < 20)) {
+      cerr << argv[0] << ": invalid size \"" << argv[1] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+  if (argc > 2) {
+    istringstream is(argv[2]);
+    if ( ! (is >> tsize) || (tsize < 1) || (0 != (tsize & (tsize - 1)))) {
+      cerr << argv[0] << ": invalid tilesize \"" << argv[2] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+  
+  bool ok(true);
+  
+  // A small odd-sized range with an origin that is not aligned with
+  // anything, so that tiles get cut off at the upper end.
+  ssize_t const x0(-7);
+  ssize_t const x1(x0 + 5 * 8 + 3);
+  ssize_t const y0(11);
+  ssize_t const y1(y0 + 4 * 8 + 5);
+  for (int in(0); in < 2; ++in) {
+    Grid::neighborhood_t const nbor(0 == in ? Grid::FOUR : Grid::EIGHT);
+    printf("%s neighbors, tiles of 8x8\n", 0 == in ? "four" : "eight");
+    scoped_ptr<Facade> facade(create(x0, x1, y0, y1, nbor, 8));
+    ok &= check_topology("empty", *facade, nbor, x0, x1, y0, y1);
+    if ( ! facade->SetMeta(x0 + 20, y0 + 20, facade->GetObstacleMeta())
+	|| (facade->GetMeta(x0 + 20, y0 + 20) != facade->GetObstacleMeta())) {
+      printf("ERROR SetMeta() should create the tile\n");
+      ok = false;
+    }
+    if (facade->SetMeta(x1, y0, facade->GetObstacleMeta())) {
+      printf("ERROR SetMeta() outside the range should fail\n");
+      ok = false;
+    }
+    ok &= check_topology("SetMeta()", *facade, nbor, x0, x1, y0, y1);
+    facade->AddGoal(x1 - 1, y1 - 1, 0);
+    ok &= check_topology("AddGoal() in a corner tile", *facade,
+			 nbor, x0, x1, y0, y1);
+    if (facade->AddNode(x1 - 2, y1 - 3, 1)) {
+      printf("ERROR AddNode() on an existing tile should do nothing\n");
+      ok = false;
+    }
+    facade->AddNode(x0 + 27, y0, 1);
+    ok &= check_topology("AddNode() on the border", *facade,
+			 nbor, x0, x1, y0, y1);
+    size_t const count(facade->AddRange(x0 + 10, x0 + 30, y0 + 5, y0 + 12,
+					facade->GetFreespaceMeta()));
+    if (0 != count % 64) {
+      printf("ERROR AddRange() added %zu cells, not whole tiles\n", count);
+      ok = false;
+    }
+    ok &= check_topology("AddRange() around existing tiles", *facade,
+			 nbor, x0, x1, y0, y1);
+    while (facade->HaveWork())
+      facade->ComputeOne();
+    ok &= check_topology("after flushing the queue", *facade,
+			 nbor, x0, x1, y0, y1);
+    facade->DumpTiles(stdout);
+  }
+  
+  // Plan across a map with walls, on a tiled and a complete grid.
+  printf("\nmap %zdx%zd, tiles of %zdx%zd\n", size, size, tsize, tsize);
+  scoped_ptr<Facade> reference(create(0, size, 0, size, Grid::FOUR, 0));
+  scoped_ptr<Facade> facade(create(0, size, 0, size, Grid::FOUR, tsize));
+  wall_meta const wall(0, size, 0, size, facade->GetFreespaceMeta(),
+		       facade->GetObstacleMeta());
+  for (ssize_t ix(0); ix < size; ++ix)
+    for (ssize_t iy(0); iy < size; ++iy)
+      if (wall.IsWall(ix, iy)) {
+	reference->SetMeta(ix, iy, wall(ix, iy));
+	facade->SetMeta(ix, iy, wall(ix, iy));
+      }
+  reference->AddGoal(1, 1, 0);
+  while (reference->HaveWork())
+    reference->ComputeOne();
+  size_t const ntiles(facade->GetCSpace()->GetNTiles());
+  facade->AddGoal(1, 1, 0);
+  compute_progress const
+    progress(facade->ComputeUntil(size / 8, size - 2, infinity));
+  if ( ! progress.settled) {
+    printf("ERROR robot did not get settled\n");
+    ok = false;
+  }
+  if (size <= 500)
+    facade->DumpTiles(stdout);
+  size_t const nvertices(num_vertices(facade->GetCSpace()->GetGraph()));
+  printf("%zu tiles for the walls, %zu tiles when the robot is settled,"
+	 " %zu of %zd cells\n", ntiles, facade->GetCSpace()->GetNTiles(),
+	 nvertices, size * size);
+  ok &= check_values("robot settled", *facade, *reference, 0, size, 0, size);
+  while (facade->HaveWork())
+    facade->ComputeOne();
+  ok &= check_values("queue flushed", *facade, *reference, 0, size, 0, size);
+  for (ssize_t ix(0); ix < size; ++ix)
+    for (ssize_t iy(0); iy < size; ++iy)
+      if (( ! wall.IsWall(ix, iy))
+	  && (facade->GetValue(ix, iy) != reference->GetValue(ix, iy))) {
+	printf("ERROR value at (%zd, %zd) is %g instead of %g\n", ix, iy,
+	       facade->GetValue(ix, iy), reference->GetValue(ix, iy));
+	ok = false;
+	ix = size;
+	break;
+      }
+  
+  if ( ! ok) {
+    printf("FAILURE\n");
+    exit(EXIT_FAILURE);
+  }
+  printf("SUCCESS\n");
+}
@@ -0,0 +1,170 @@
+/* 
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+/**
+   Stress test for concurrent read access to the Upwind graph: a
+   number of reader threads repeatedly traverse the upwind graph
+   while the main thread propagates an LSM navigation function and
+   repairs it after walls are toggled. Readers check that every
+   downwind vertex they see is a C-space neighbor, and they also query
+   vertices that do not exist. Without locking, this only works
+   because the const methods of Upwind never modify it and the masks
+   are accessed atomically. On a single core, this test cannot catch
+   a data race, it only checks what readers see.
+   
+   usage: test_upwind_threads [size [nthreads [nrounds]]]
+*/
+
+
+#include <estar/Facade.hpp>
+#include <estar/Algorithm.hpp>
+#include <estar/Upwind.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <pthread.h>
+#include <stdlib.h>
+
+
+using namespace estar;
+using namespace boost;
+using namespace std;
+
+
+struct reader_s {
+  Algorithm const * algo;
+  size_t npasses;
+  size_t nedges;
+  size_t nerrors;
+};
+
+
+static bool done(false);
+
+
+static bool is_neighbor(cspace_t const & cspace, vertex_t from, vertex_t to)
+{
+  adjacency_it in, nend;
+  for (tie(in, nend) = adjacent_vertices(from, cspace); in != nend; ++in)
+    if (*in == to)
+      return true;
+  return false;
+}
+
+
+static void * run_reader(void * arg)
+{
+  reader_s * reader(static_cast<reader_s *>(arg));
+  Upwind const & upwind(reader->algo->GetUpwind());
+  cspace_t const & cspace(reader->algo->GetCSpaceGraph());
+  vertex_t const nvertices(num_vertices(cspace));
+  while ( ! __atomic_load_n(&done, __ATOMIC_RELAXED)) {
+    for (vertex_t from(0); from < nvertices; ++from) {
+      Upwind::downwind_it id, dend;
+      for (tie(id, dend) = upwind.GetDownwind(from); id != dend; ++id) {
+	++reader->nedges;
+	if ( ! is_neighbor(cspace, from, *id))
+	  ++reader->nerrors;
+	upwind.HaveEdge(from, *id);
+      }
+    }
+    // vertices beyond the C-space must simply have no edges
+    for (vertex_t from(nvertices); from < nvertices + 100; ++from)
+      if (upwind.HaveEdge(from, 0)
+	  || (upwind.GetDownwind(from).first != upwind.GetDownwind(from).second))
+	++reader->nerrors;
+    ++reader->npasses;
+  }
+  return 0;
+}
+
+
+static void parse(int argc, char ** argv, int idx, ssize_t & value, ssize_t min)
+{
+  if (argc > idx) {
+    istringstream is(argv[idx]);
+    if ( ! (is >> value) || (value < min)) {
+      cerr << argv[0] << ": invalid argument \"" << argv[idx] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+}
+
+
+int main(int argc, char ** argv)
+{
+  ssize_t size(200);
+  ssize_t nthreads(4);
+  ssize_t nrounds(10);
+  parse(argc, argv, 1, size, 10);
+  parse(argc, argv, 2, nthreads, 1);
+  parse(argc, argv, 3, nrounds, 1);
+  
+  scoped_ptr<Facade> facade(Facade::CreateDefault(size, size, 1));
+  if ( ! facade) {
+    cerr << argv[0] << ": Facade::CreateDefault() failed\n";
+    exit(EXIT_FAILURE);
+  }
+  facade->AddGoal(0, 0, 0);
+  
+  vector<reader_s> reader(nthreads);
+  vector<pthread_t> thread(nthreads);
+  for (ssize_t ii(0); ii < nthreads; ++ii) {
+    reader[ii].algo = &facade->GetAlgorithm();
+    reader[ii].npasses = 0;
+    reader[ii].nedges = 0;
+    reader[ii].nerrors = 0;
+    if (0 != pthread_create(&thread[ii], 0, run_reader, &reader[ii])) {
+      cerr << argv[0] << ": pthread_create() failed\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+  
+  while (facade->HaveWork())
+    facade->ComputeOne();
+  for (ssize_t ir(0); ir < nrounds; ++ir) {
+    double const meta((ir % 2) ? facade->GetFreespaceMeta()
+		      : facade->GetObstacleMeta());
+    ssize_t const ix(size / 4 + (ir / 2) % (size / 2));
+    for (ssize_t iy(1); iy < size - 1; ++iy)
+      facade->SetMeta(ix, iy, meta);
+    while (facade->HaveWork())
+      facade->ComputeOne();
+    cout << "round " << ir << ": step " << facade->GetAlgorithm().GetStep()
+	 << "\n";
+  }
+  
+  __atomic_store_n(&done, true, __ATOMIC_RELAXED);
+  size_t nerrors(0);
+  for (ssize_t ii(0); ii < nthreads; ++ii) {
+    pthread_join(thread[ii], 0);
+    cout << "reader " << ii << ": " << reader[ii].npasses << " passes, "
+	 << reader[ii].nedges << " edges, " << reader[ii].nerrors
+	 << " errors\n";
+    nerrors += reader[ii].nerrors;
+  }
+  if (0 != nerrors) {
+    cout << "FAILURE\n";
+    exit(EXIT_FAILURE);
+  }
+  cout << "SUCCESS\n";
+}
@@ -0,0 +1,336 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+/**
+   Compares the vertex orders of Grid (see Grid::SetVertexOrder()) on
+   a map with a few walls that is planned from one corner to the
+   other. For each order, the full propagation is timed, and the
+   last-level cache misses are counted where the kernel lets us
+   (perf_event_open() on Linux). As a locality measure that does not
+   depend on hardware counters, the fractions of neighboring vertices
+   whose IDs lie at most 8 (one cache line of values) and at most 64
+   apart are printed too. The same is done for a grid that has grown
+   in thin strips with AddRange(), before and after
+   Facade::Renumber(). All values must match the default column
+   order. Finally, a grid gets renumbered in the middle of its
+   propagation, which must not change the outcome.
+
+   usage: test_vertex_order [size]
+*/
+
+
+#include <estar/Facade.hpp>
+#include <estar/Algorithm.hpp>
+#include <estar/numeric.hpp>
+#include <estar/util.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef __linux__
+# include <linux/perf_event.h>
+# include <sys/ioctl.h>
+# include <sys/syscall.h>
+#endif
+
+
+using namespace estar;
+using namespace boost;
+using namespace std;
+
+
+/** Counts last-level cache misses of this thread, if possible. */
+class miss_counter
+{
+public:
+  miss_counter(): m_fd(-1) {
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    m_fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+  }
+  
+  ~miss_counter() {
+    if (m_fd >= 0)
+      close(m_fd);
+  }
+  
+  bool Available() const { return m_fd >= 0; }
+  
+  void Start() {
+#ifdef __linux__
+    if (m_fd >= 0) {
+      ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+  
+  /** \return The number of misses since Start(), or -1. */
+  long long Stop() {
+    long long count(-1);
+#ifdef __linux__
+    if (m_fd >= 0) {
+      ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+      if (sizeof(count) != read(m_fd, &count, sizeof(count)))
+	count = -1;
+    }
+#endif
+    return count;
+  }
+  
+private:
+  int m_fd;
+};
+
+
+/** Walls across the map, each with a gap at alternating ends. */
+static bool is_wall(ssize_t size, ssize_t ix, ssize_t iy)
+{
+  ssize_t const spacing(size / 4);
+  if ((ix < spacing) || (ix % spacing != 0) || (ix >= 4 * spacing))
+    return false;
+  ssize_t const gap(size / 5);
+  if ((ix / spacing) % 2)
+    return iy < size - gap;
+  return iy >= gap;
+}
+
+
+struct wall_meta: public Grid::get_meta {
+  wall_meta(ssize_t _size, double _freespace, double _obstacle)
+    : size(_size), freespace(_freespace), obstacle(_obstacle) {}
+  
+  virtual double operator () (ssize_t ix, ssize_t iy) const
+  { return is_wall(size, ix, iy) ? obstacle : freespace; }
+  
+  ssize_t size;
+  double freespace, obstacle;
+};
+
+
+/** Create a map of the given size, either in one go or grown in
+    strips of nstrips along Y. */
+static Facade * create(ssize_t size, Grid::vertex_order_t order,
+		       size_t nstrips)
+{
+  ssize_t const ystrip(nstrips > 1 ? size / nstrips : size);
+  Facade * facade(Facade::Create("lsm", 1,
+				 GridOptions(0, size, 0, ystrip, Grid::FOUR,
+					     false, 0, order),
+				 AlgorithmOptions(), stderr));
+  wall_meta const walls(size, facade->GetFreespaceMeta(),
+			facade->GetObstacleMeta());
+  facade->BeginMetaBatch();
+  for (ssize_t ix(0); ix < size; ++ix)
+    for (ssize_t iy(0); iy < ystrip; ++iy)
+      if (is_wall(size, ix, iy))
+	facade->SetMeta(ix, iy, walls.obstacle);
+  facade->CommitMetaBatch();
+  for (ssize_t iy(ystrip); iy < size; iy += ystrip)
+    facade->AddRange(0, size, iy, minval(iy + ystrip, size), &walls);
+  return facade;
+}
+
+
+/** Print the fractions of neighboring vertices whose IDs lie within
+    8 and 64 of each other. */
+static void print_locality(char const * what, Facade const & facade,
+			   ssize_t size)
+{
+  GridCSpace const & cspace(*facade.GetCSpace());
+  size_t count(0), near(0), close(0);
+  for (ssize_t ix(0); ix < size; ++ix)
+    for (ssize_t iy(0); iy < size; ++iy) {
+      vertex_t const vertex(cspace.FindVertex(ix, iy));
+      vertex_t const nbor[2] = {
+	ix + 1 < size ? cspace.FindVertex(ix + 1, iy) : CSpaceGraph::null_vertex,
+	iy + 1 < size ? cspace.FindVertex(ix, iy + 1) : CSpaceGraph::null_vertex
+      };
+      for (size_t ii(0); ii < 2; ++ii) {
+	if (CSpaceGraph::null_vertex == nbor[ii])
+	  continue;
+	size_t const dist(vertex > nbor[ii] ? vertex - nbor[ii]
+			  : nbor[ii] - vertex);
+	++count;
+	if (dist <= 8)
+	  ++near;
+	if (dist <= 64)
+	  ++close;
+      }
+    }
+  printf("%-24s  neighbor IDs within 8: %5.1f%%, within 64: %5.1f%%\n",
+	 what, 100.0 * near / count, 100.0 * close / count);
+}
+
+
+/** Propagate from (1, 1) until the queue runs empty. */
+static void propagate(char const * what, Facade & facade,
+		      miss_counter & misses)
+{
+  facade.AddGoal(1, 1, 0);
+  double const t0(get_monotonic_time());
+  misses.Start();
+  while (facade.HaveWork())
+    facade.ComputeOne();
+  long long const nmisses(misses.Stop());
+  double const dt(get_monotonic_time() - t0);
+  if (nmisses >= 0)
+    printf("%-24s  %.3fs, %lld cache misses\n", what, dt, nmisses);
+  else
+    printf("%-24s  %.3fs\n", what, dt);
+}
+
+
+static bool compare(char const * what, Facade const & facade,
+		    Facade const & reference, ssize_t size)
+{
+  double delta(0);
+  for (ssize_t ix(0); ix < size; ++ix)
+    for (ssize_t iy(0); iy < size; ++iy) {
+      double const value(facade.GetValue(ix, iy));
+      double const want(reference.GetValue(ix, iy));
+      if ((value >= infinity) != (want >= infinity)) {
+	printf("ERROR %s: (%zd, %zd) has value %g instead of %g\n",
+	       what, ix, iy, value, want);
+	return false;
+      }
+      if (want >= infinity)
+	continue;
+      double const dd(absval(value - want));
+      if (dd > delta)
+	delta = dd;
+    }
+  if (delta > 1e-6) {
+    printf("ERROR %s: values differ by up to %g\n", what, delta);
+    return false;
+  }
+  return true;
+}
+
+
+static bool check_orders(ssize_t size)
+{
+  miss_counter misses;
+  if ( ! misses.Available())
+    printf("cache miss counters are not available, printing timings"
+	   " and ID locality only\n");
+  
+  scoped_ptr<Facade> reference(create(size, Grid::COLUMN_ORDER, 1));
+  print_locality("column order", *reference, size);
+  propagate("column order", *reference, misses);
+  
+  scoped_ptr<Facade> blocked(create(size, Grid::BLOCK_ORDER, 1));
+  print_locality("block order", *blocked, size);
+  propagate("block order", *blocked, misses);
+  bool ok(compare("block order", *blocked, *reference, size));
+  
+  scoped_ptr<Facade> grown(create(size, Grid::BLOCK_ORDER, size / 4));
+  print_locality("grown in strips", *grown, size);
+  size_t const nrenumbered(grown->Renumber());
+  print_locality("renumbered", *grown, size);
+  printf("%-24s  %zu of %zd vertices got a new ID\n", "renumbered",
+	 nrenumbered, size * size);
+  if (0 == nrenumbered) {
+    printf("ERROR strips have not been renumbered\n");
+    ok = false;
+  }
+  if (0 != grown->Renumber()) {
+    printf("ERROR renumbering twice changed IDs\n");
+    ok = false;
+  }
+  propagate("renumbered", *grown, misses);
+  ok &= compare("renumbered", *grown, *reference, size);
+  return ok;
+}
+
+
+/** Renumber a grown grid while its wavefront is halfway across, and
+    compare with the same grid propagated without renumbering. */
+static bool check_midway(ssize_t size)
+{
+  scoped_ptr<Facade> reference(create(size, Grid::BLOCK_ORDER, 4));
+  scoped_ptr<Facade> facade(create(size, Grid::BLOCK_ORDER, 4));
+  reference->AddGoal(1, 1, 0);
+  facade->AddGoal(1, 1, 0);
+  size_t const nsteps(size * size / 3);
+  for (size_t ii(0); (ii < nsteps) && facade->HaveWork(); ++ii)
+    facade->ComputeOne();
+  if ( ! facade->HaveWork()) {
+    printf("ERROR propagation is already done\n");
+    return false;
+  }
+  if (0 == facade->Renumber()) {
+    printf("ERROR nothing renumbered midway\n");
+    return false;
+  }
+  if ( ! facade->IsGoal(1, 1)) {
+    printf("ERROR goals have not been renumbered\n");
+    return false;
+  }
+  while (reference->HaveWork())
+    reference->ComputeOne();
+  while (facade->HaveWork())
+    facade->ComputeOne();
+  if ( ! compare("renumbered midway", *facade, *reference, size))
+    return false;
+  printf("%-24s  ok\n", "renumbered midway");
+  return true;
+}
+
+
+int main(int argc, char ** argv)
+{
+  ssize_t size(512);
+  if (argc > 1) {
+    istringstream is(argv[1]);
+    if ( ! (is >> size) || (size < 32)) {
+      cerr << argv[0] << ": invalid size \"" << argv[1] << "\"\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+  
+  bool ok(true);
+  try {
+    ok &= check_orders(size);
+    ok &= check_midway(64);
+  }
+  catch (std::exception const & ee) {
+    printf("ERROR %s\n", ee.what());
+    ok = false;
+  }
+  
+  if ( ! ok) {
+    printf("FAILURE\n");
+    exit(EXIT_FAILURE);
+  }
+  printf("SUCCESS\n");
+}
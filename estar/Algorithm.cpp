@@ -25,6 +25,8 @@
 #include "pdebug.hpp"
 #include <boost/assert.hpp>
 #include <iostream>
+#include <vector>
+#include <algorithm>
 
 
 using namespace boost;
@@ -40,12 +42,21 @@ namespace estar {
 	    bool check_local_consistency,
 	    bool check_queue_key,
 	    bool auto_reset,
-	    bool auto_flush)
+	    bool auto_flush,
+	    Queue::backend_t queue_backend,
+	    double bucket_width)
     : m_cspace(cspace),
+      m_queue(queue_backend, bucket_width),
+      m_upwind(cspace->GetGraph()),
       m_step(0),
       m_last_computed_value(-1),
       m_last_computed_vertex(0),
       m_last_popped_key(-1),
+      m_ceiling(infinity),
+      m_lower_hook(0),
+      m_meta_batch_open(false),
+      m_meta_batch_nset(0),
+      m_band_delta(0),
       m_pending_reset(false),
       m_auto_reset(auto_reset),
       m_auto_flush(auto_flush),
@@ -58,8 +69,13 @@ namespace estar {
 					  m_value, m_meta, m_rhs, m_flag,
 					  check_upwind,
 					  check_local_consistency,
-					  check_queue_key))
+					  check_queue_key
+					  && (Queue::BUCKET != queue_backend)))
   {
+    // AddVertex() makes room for vertices added later on.
+    size_t const nvertices(num_vertices(m_cspace_graph));
+    if (nvertices > 0)
+      m_queue.Reserve(nvertices - 1);
   }
   
   
@@ -70,18 +86,52 @@ namespace estar {
   void Algorithm::
   SetMeta(vertex_t vertex, double meta, const Kernel & kernel)
   {
-    if (absval(get(m_meta, vertex) - meta) < epsilon)
+    double const oldmeta(get(m_meta, vertex));
+    if (absval(oldmeta - meta) < epsilon)
       return;
     put(m_meta, vertex, meta);
-    UpdateVertex(vertex, kernel);
+    if (m_meta_batch_open) {
+      // remember the meta from before the batch, for CommitMetaBatch()
+      m_meta_batch.insert(make_pair(vertex, oldmeta));
+      ++m_meta_batch_nset;
+    }
+    else
+      UpdateVertex(vertex, kernel);
     if (m_auto_reset)
       m_pending_reset = true;
   }
   
   
+  void Algorithm::
+  BeginMetaBatch()
+  {
+    m_meta_batch_open = true;
+  }
+  
+  
+  size_t Algorithm::
+  CommitMetaBatch(const Kernel & kernel)
+  {
+    size_t nupdates(0);
+    for (metabatch_t::const_iterator ib(m_meta_batch.begin());
+	 ib != m_meta_batch.end(); ++ib)
+      if (absval(get(m_meta, ib->first) - ib->second) >= epsilon) {
+	UpdateVertex(ib->first, kernel);
+	++nupdates;
+      }
+    size_t const saved(m_meta_batch_nset - nupdates);
+    m_meta_batch.clear();
+    m_meta_batch_nset = 0;
+    m_meta_batch_open = false;
+    return saved;
+  }
+  
+  
   void Algorithm::
   ComputeOne(const Kernel & kernel, double slack)
   {
+    if (m_meta_batch_open)
+      CommitMetaBatch(kernel);
     if (m_auto_flush)
       while (HaveWork())
 	DoComputeOne(kernel, slack);
@@ -90,18 +140,83 @@ namespace estar {
   }
   
   
+  static bool have_downwind(Upwind const & upwind, vertex_t vertex)
+  {
+    Upwind::downwind_it id, dend;
+    tie(id, dend) = upwind.GetDownwind(vertex);
+    return id != dend;
+  }
+  
+  
+  /**
+     Only goals with downwind neighbors matter: the raise of a removed
+     goal sweeps over its downwind cone, and the lowering afterwards
+     sweeps over it again. If removed goals make up a fraction f of
+     the goals that have downwind neighbors, the repair costs about
+     2f times a fresh propagation, plus whatever the added goals
+     lower. Shifting a goal region by one cell lowers about half of
+     the map, so with added goals the threshold is f=1/4 instead of
+     f=1/2.
+  */
+  bool Algorithm::
+  PreferReset() const
+  {
+    if(m_removed_goal.empty())
+      return false;
+    size_t nremoved(0);
+    for(goalset_t::const_iterator ir(m_removed_goal.begin());
+	ir != m_removed_goal.end(); ++ir)
+      if(have_downwind(m_upwind, *ir))
+	++nremoved;
+    size_t nkept(0);
+    for(goalset_t::const_iterator ig(m_goalset.begin());
+	ig != m_goalset.end(); ++ig)
+      if((m_added_goal.end() == m_added_goal.find(*ig))
+	 && have_downwind(m_upwind, *ig))
+	++nkept;
+    if(m_added_goal.empty())
+      return nremoved >= nkept;
+    return 3 * nremoved >= nkept;
+  }
+  
+  
   void Algorithm::
   DoComputeOne(const Kernel & kernel, double slack)
   {
-    if(m_pending_reset){
+    if(m_pending_reset || PreferReset()){
       Reset();
       m_pending_reset = false;
     }
-    if(m_queue.IsEmpty())
+    else if( ! m_removed_goal.empty()){
+      // Removed goals have kept their value, so UpdateVertex() will
+      // typically queue them for a raise.
+      for(goalset_t::const_iterator ig(m_removed_goal.begin());
+	  ig != m_removed_goal.end(); ++ig)
+	UpdateVertex(*ig, kernel);
+      m_removed_goal.clear();
+    }
+    m_added_goal.clear();
+    // With a focused queue, vertices beyond the horizon are set aside
+    // until there is nothing else left to do. Vertices beyond the
+    // ceiling simply stay in the queue.
+    for(;;){
+      if( ! m_queue.IsEmpty()){
+	if(m_queue.ParkTop(m_value, m_rhs))
+	  continue;
+	if(m_queue.GetTopKey() <= m_ceiling)
+	  break;
+      }
+      if(0 == m_queue.GetParkedSize())
+	return;
+      m_queue.Unpark(m_value, m_rhs);
+    }
+    if((0 < m_band_delta) && ( ! m_queue.IsFocused())){
+      DoComputeBand(kernel, slack);
       return;
+    }
     ++m_step;
     
-    const double popped_key(m_queue.Get().begin()->first);
+    const double popped_key(m_queue.GetTopKey());
     const vertex_t vertex(m_queue.Pop(m_flag));
     const double rhs(get(m_rhs, vertex));
     const double val(get(m_value, vertex));
@@ -124,50 +239,242 @@ namespace estar {
       tie(in, nend) = adjacent_vertices(vertex, m_cspace_graph);
       for(/**/; in != nend; ++in)
 	UpdateVertex(*in, kernel);
+      if(m_lower_hook)
+	(*m_lower_hook)(vertex);
     }
     
     else{
       PVDEBUG("vertex gets raised   v: %g rhs: %g   delta: %g\n",
 	      val, rhs, rhs - val);
-      put(m_value, vertex, infinity);
-      
+      RaiseVertex(vertex, kernel);
+    }
+  }
+  
+  
+  void Algorithm::
+  RaiseVertex(vertex_t vertex, const Kernel & kernel)
+  {
+    put(m_value, vertex, infinity);
+    
 #define RE_PROPAGATE_LAST
 //#undef RE_PROPAGATE_LAST
 #ifndef RE_PROPAGATE_LAST
-      PVDEBUG("variant: update raised node before others\n");
-      UpdateVertex(vertex, kernel);
+    PVDEBUG("variant: update raised node before others\n");
+    UpdateVertex(vertex, kernel);
 #endif // ! RE_PROPAGATE_LAST
-      
+    
 #define RAISE_DOWNWIND_ONLY
 //#undef RAISE_DOWNWIND_ONLY
 #ifdef RAISE_DOWNWIND_ONLY
+    // Neighbors that were computed from this vertex but lost their
+    // upwind edge to it (see Upwind::AddEdge()) only get fixed by
+    // later lowers, and below a ceiling those might never come.
+    if(infinity == m_ceiling){
       PVDEBUG("variant: expand only downwind neighbors after raise\n");
-      // IMPORTANT: Get a copy, because m_upwind is modified inside
-      // the loop by UpdateVertex()!!!
-      Upwind::set_t dwnbors(m_upwind.GetDownwind(vertex));
-      for(Upwind::set_t::const_iterator id(dwnbors.begin());
-	  id != dwnbors.end(); ++id)
+      // The downwind iterators work on a copy of the edge bits, so
+      // it is OK that UpdateVertex() modifies m_upwind in the loop.
+      Upwind::downwind_it id, dend;
+      tie(id, dend) = m_upwind.GetDownwind(vertex);
+      for(/**/; id != dend; ++id)
 	UpdateVertex(*id, kernel);
-#else // RAISE_DOWNWIND_ONLY
+    }
+    else
+#endif // RAISE_DOWNWIND_ONLY
+    {
       PVDEBUG("variant: expand all neighbors after raise\n");
       adjacency_it in, nend;
       tie(in, nend) = adjacent_vertices(vertex, m_cspace_graph);
       for(/**/; in != nend; ++in)
 	UpdateVertex(*in, kernel);
-#endif // RAISE_DOWNWIND_ONLY
-      
+    }
+    
 #ifdef RE_PROPAGATE_LAST
-      PVDEBUG("variant: update raised node after others\n");
-      UpdateVertex(vertex, kernel);
+    PVDEBUG("variant: update raised node after others\n");
+    UpdateVertex(vertex, kernel);
 #endif // RE_PROPAGATE_LAST
+  }
+  
+  
+  /** Arguments for band_job(). */
+  struct band_job_s {
+    PropagatorFactory const * factory;
+    Kernel const * kernel;
+    /** computed once, because the queue must not be touched by the
+	workers, see PropagatorFactory::GetQueueBottom() */
+    double queue_bottom;
+    vertex_t const * nbor;
+    Propagator * prop;
+    double * rhs;
+  };
+  
+  
+  static void band_job(void * arg, size_t first, size_t last)
+  {
+    band_job_s const & job(*reinterpret_cast<band_job_s*>(arg));
+    for(size_t ii(first); ii < last; ++ii){
+      job.factory->Create(job.nbor[ii], job.queue_bottom, job.prop[ii]);
+      job.rhs[ii] = job.kernel->Compute(job.prop[ii]);
     }
   }
   
   
+  void Algorithm::
+  DoComputeBand(const Kernel & kernel, double slack)
+  {
+    ++m_step;
+    m_band.clear();
+    m_band_raise.clear();
+    m_band_nbor.clear();
+    m_queue.PopBand(m_band_delta, m_ceiling, m_flag, m_band);
+    
+    // Lower the whole band first, so that the neighbors see all the
+    // new values, and collect the neighbors that need an update.
+    for(size_t ib(0); ib < m_band.size(); ++ib){
+      const vertex_t vertex(m_band[ib]);
+      const double rhs(get(m_rhs, vertex));
+      const double val(get(m_value, vertex));
+      if(absval(val - rhs) <= slack)
+	continue;
+      m_last_computed_value = rhs;
+      m_last_computed_vertex = vertex;
+      m_last_popped_key = minval(val, rhs);
+      if(val < rhs){
+	m_band_raise.push_back(vertex);
+	continue;
+      }
+      put(m_value, vertex, rhs);
+      adjacency_it in, nend;
+      tie(in, nend) = adjacent_vertices(vertex, m_cspace_graph);
+      for(/**/; in != nend; ++in)
+	if( ! (get(m_flag, *in) & GOAL))
+	  m_band_nbor.push_back(*in);
+      if(m_lower_hook)
+	(*m_lower_hook)(vertex);
+    }
+    
+    if( ! m_band_nbor.empty()){
+      sort(m_band_nbor.begin(), m_band_nbor.end());
+      m_band_nbor.erase(unique(m_band_nbor.begin(), m_band_nbor.end()),
+			m_band_nbor.end());
+      size_t const nnbor(m_band_nbor.size());
+      if(m_band_prop.size() < nnbor){
+	m_band_prop.resize(nnbor);
+	m_band_rhs.resize(nnbor);
+      }
+      band_job_s job;
+      job.factory = m_propfactory.get();
+      job.kernel = &kernel;
+      job.queue_bottom = m_propfactory->GetQueueBottom();
+      job.nbor = &m_band_nbor[0];
+      job.prop = &m_band_prop[0];
+      job.rhs = &m_band_rhs[0];
+      m_band_pool->Run(band_job, &job, nnbor);
+      for(size_t in(0); in < nnbor; ++in)
+	SetRhs(m_band_nbor[in], m_band_rhs[in], m_band_prop[in]);
+    }
+    
+    for(size_t ir(0); ir < m_band_raise.size(); ++ir)
+      RaiseVertex(m_band_raise[ir], kernel);
+  }
+  
+  
+  compute_progress Algorithm::
+  ComputeUntil(const Kernel & kernel, double slack,
+	       vertex_t const * stop_vertex, double deadline,
+	       size_t check_interval)
+  {
+    compute_progress progress;
+    size_t const step0(m_step);
+    double last_check(get_monotonic_time());
+    if (last_check >= deadline)
+      progress.deadline_passed = true;
+    else {
+      if (m_meta_batch_open) {
+	CommitMetaBatch(kernel);
+	last_check = get_monotonic_time();
+      }
+      if (check_interval < 1)
+	check_interval = 1;
+      // Start by checking after a single step, then space the checks
+      // such that the slowest steps seen so far fill at most half of
+      // the remaining time.
+      size_t interval(1);
+      size_t countdown(1);
+      double step_time(0);
+      while (HaveWork()) {
+	if (stop_vertex && IsSettled(*stop_vertex))
+	  break;
+	DoComputeOne(kernel, slack);
+	if (0 == --countdown) {
+	  double const now(get_monotonic_time());
+	  if (now >= deadline) {
+	    progress.deadline_passed = true;
+	    break;
+	  }
+	  if ((now - last_check) / interval > step_time)
+	    step_time = (now - last_check) / interval;
+	  last_check = now;
+	  interval = check_interval;
+	  if (step_time * interval > (deadline - now) / 2) {
+	    interval = static_cast<size_t>((deadline - now) / (2 * step_time));
+	    if (interval < 1)
+	      interval = 1;
+	  }
+	  countdown = interval;
+	}
+      }
+    }
+    progress.nsteps = m_step - step0;
+    progress.settled = stop_vertex && IsSettled(*stop_vertex);
+    progress.have_work = HaveWork();
+    if ( ! m_queue.IsEmpty())
+      progress.top_key = m_queue.GetTopKey();
+    return progress;
+  }
+  
+  
+  bool Algorithm::
+  IsSettled(vertex_t vertex) const
+  {
+    if (m_pending_reset || ( ! m_removed_goal.empty())
+	|| ( ! m_meta_batch.empty()))
+      return false;
+    const flag_t flag(get(m_flag, vertex));
+    if (flag & OPEN)
+      return false;
+    if (flag & GOAL)
+      return true;
+    const double value(get(m_value, vertex));
+    if ((value > m_ceiling) || m_queue.IsBeyondHorizon(vertex, value))
+      return false;
+    if (m_queue.IsEmpty())
+      return true;
+    return value < m_queue.GetTopKey();
+  }
+  
+  
+  void Algorithm::
+  SetFocus(shared_ptr<Heuristic const> heuristic, vertex_t focus,
+	   double margin)
+  {
+    m_queue.SetFocus(heuristic, focus, margin, m_value, m_rhs);
+  }
+  
+  
   bool Algorithm::
   HaveWork() const
   {
-    return m_pending_reset || ( ! m_queue.IsEmpty());
+    return m_pending_reset || ( ! m_removed_goal.empty())
+      || ( ! m_meta_batch.empty())
+      || (( ! m_queue.IsEmpty()) && (m_queue.GetTopKey() <= m_ceiling))
+      || (0 < m_queue.GetParkedSize());
+  }
+  
+  
+  void Algorithm::
+  SetCeiling(double ceiling)
+  {
+    m_ceiling = ceiling;
   }
   
   
@@ -179,9 +486,23 @@ namespace estar {
       PVDEBUG("no change");
       return;
     }
+    if( ! (flag & GOAL)){
+      // A removed goal that comes back with its old value simply
+      // undoes the removal (its rhs is still the goal value).
+      goalset_t::iterator const ir(m_removed_goal.find(vertex));
+      if((m_removed_goal.end() != ir)
+	 && (absval(get(m_rhs, vertex) - value) < epsilon))
+	m_removed_goal.erase(ir);
+      else
+	m_added_goal.insert(vertex);
+    }
     put(m_rhs,   vertex, value);
     put(m_flag,  vertex, static_cast<flag_t>(flag | GOAL));
     m_goalset.insert(vertex);
+    // Goals do not depend on their neighbors, and stale upwind edges
+    // would make the neighbors look like they have a downwind cone
+    // (see PreferReset()).
+    m_upwind.RemoveIncoming(vertex);
     if(absval(get(m_value, vertex) - value) < epsilon){
       PVDEBUG("same value");
       return;
@@ -197,14 +518,16 @@ namespace estar {
   void Algorithm::
   RemoveGoal(vertex_t vertex)
   {
-    if(get(m_flag, vertex) & GOAL){
+    const flag_t flag(get(m_flag, vertex));
+    if(flag & GOAL){
       m_goalset.erase(vertex);
-      put(m_flag, vertex, NONE);
-      m_pending_reset = true;
-#ifndef WIN32
-# warning "could use m_pending_reset more to avoid work when not needed"
-#endif // WIN32
-	}
+      // keep the OPEN bit, the vertex might still be queued
+      put(m_flag, vertex, static_cast<flag_t>(flag & OPEN));
+      m_added_goal.erase(vertex);
+      m_removed_goal.insert(vertex);
+      if (m_auto_reset)
+	m_pending_reset = true;
+    }
   }
   
   
@@ -213,10 +536,28 @@ namespace estar {
   {
     if(m_goalset.empty())
       return;
-    for(goalset_t::iterator ig(m_goalset.begin()); ig != m_goalset.end(); ++ig)
-      put(m_flag, *ig, NONE);
+    for(goalset_t::iterator ig(m_goalset.begin()); ig != m_goalset.end(); ++ig){
+      put(m_flag, *ig, static_cast<flag_t>(get(m_flag, *ig) & OPEN));
+      m_removed_goal.insert(*ig);
+    }
     m_goalset.clear();
-    m_pending_reset = true;
+    m_added_goal.clear();
+    if (m_auto_reset)
+      m_pending_reset = true;
+  }
+  
+  
+  void Algorithm::
+  ReplaceGoals(goalmap_t const & goal)
+  {
+    goalset_t remove;
+    for(goalset_t::iterator ig(m_goalset.begin()); ig != m_goalset.end(); ++ig)
+      if(goal.end() == goal.find(*ig))
+	remove.insert(*ig);
+    for(goalset_t::iterator ir(remove.begin()); ir != remove.end(); ++ir)
+      RemoveGoal(*ir);
+    for(goalmap_t::const_iterator ig(goal.begin()); ig != goal.end(); ++ig)
+      AddGoal(ig->first, ig->second);
   }
   
   
@@ -234,30 +575,47 @@ namespace estar {
     // Note: obstacle information is not in the flag, but in the meta,
     // which doesn't get touched here.
     m_queue.Clear();
-    vertex_it iv, vend;
-    tie(iv, vend) = vertices(m_cspace_graph);
-    for(/**/; iv != vend; ++iv){
-
+    m_removed_goal.clear();
+    m_added_goal.clear();
+    m_pending_reset = false;
+    
+    // Starting a new epoch makes all values, rhs, and flags read as
+    // infinity, infinity, and NONE without visiting the vertices, so
+    // the goal rhs values have to be saved beforehand.
+    std::vector<std::pair<vertex_t, double> > goal;
+    goal.reserve(m_goalset.size());
+    for(goalset_t::const_iterator ig(m_goalset.begin());
+	ig != m_goalset.end(); ++ig)
+      goal.push_back(make_pair(*ig, static_cast<double>(get(m_rhs, *ig))));
+    m_cspace->NewEpoch();
+    
 #ifndef WIN32
 # warning Is it a waste of time to clear the upwind structure? Does it create or avoid inconsistencies?
 #endif // WIN32
-		//clear_vertex(get(m_upwind_v, *iv), m_upwind);
-
-      if(get(m_flag, *iv) & GOAL){
-	put(m_value, *iv, infinity);
-	put(m_flag,  *iv, GOAL);
-	
-	m_queue.Requeue(*iv, m_flag, m_value, m_rhs);
-      }
-      else{
-	put(m_value, *iv, infinity);
-	put(m_rhs,   *iv, infinity);
-	put(m_flag,  *iv, NONE);
-      }
+    
+    for(size_t ig(0); ig < goal.size(); ++ig){
+      put(m_value, goal[ig].first, infinity);
+      put(m_rhs,   goal[ig].first, goal[ig].second);
+      put(m_flag,  goal[ig].first, GOAL);
+      m_queue.Requeue(goal[ig].first, m_flag, m_value, m_rhs);
     }
   }
   
 
+  void Algorithm::
+  ImportVertex(vertex_t vertex, double value,
+	       vertex_t const * upwind, size_t nupwind)
+  {
+    put(m_value, vertex, value);
+    if( ! (get(m_flag, vertex) & GOAL))
+      put(m_rhs, vertex, value);
+    m_upwind.RemoveIncoming(vertex);
+    for(size_t iu(0); iu < nupwind; ++iu)
+      m_upwind.AddEdge(upwind[iu], vertex);
+    m_queue.Requeue(vertex, m_flag, m_value, m_rhs);
+  }
+  
+  
   void Algorithm::
   UpdateVertex(vertex_t vertex, const Kernel & kernel)
   {
@@ -267,27 +625,49 @@ namespace estar {
       return;
     }
     else{
-      scoped_ptr<Propagator> prop(m_propfactory->Create(vertex));
-      const double rhs(kernel.Compute(*prop));
-      put(m_rhs, vertex, rhs);
-
-      m_upwind.RemoveIncoming(vertex);
-      Propagator::backpointer_it ibp, bpend;
-      tie(ibp, bpend) = prop->GetBackpointers();
-      for(/**/; ibp != bpend; ++ibp)
-	m_upwind.AddEdge(*ibp, vertex);
-      
-      PVDEBUG("i: %lu f: %s v: %g rhs: %g\n",
-	      vertex, flag_name(flag), get(m_value, vertex), rhs);
-
-      m_queue.Requeue(vertex, m_flag, m_value, m_rhs);
+      Propagator prop;
+      m_propfactory->Create(vertex, prop);
+      SetRhs(vertex, kernel.Compute(prop), prop);
+    }
+  }
+  
+  
+  void Algorithm::
+  SetRhs(vertex_t vertex, double rhs, Propagator const & prop)
+  {
+    put(m_rhs, vertex, rhs);
+    
+    m_upwind.RemoveIncoming(vertex);
+    Propagator::backpointer_it ibp, bpend;
+    tie(ibp, bpend) = prop.GetBackpointers();
+    for(/**/; ibp != bpend; ++ibp)
+      m_upwind.AddEdge(*ibp, vertex);
+    
+    PVDEBUG("i: %lu f: %s v: %g rhs: %g\n",
+	    vertex, flag_name(get(m_flag, vertex)), get(m_value, vertex), rhs);
+    
+    m_queue.Requeue(vertex, m_flag, m_value, m_rhs);
+  }
+  
+  
+  void Algorithm::
+  SetBandExpansion(double delta, size_t nthreads)
+  {
+    if(delta <= 0){
+      m_band_delta = 0;
+      m_band_pool.reset();
+      return;
     }
+    m_band_delta = delta;
+    if(( ! m_band_pool) || (m_band_pool->GetNThreads() != nthreads))
+      m_band_pool.reset(new ThreadPool(nthreads));
   }
   
   
   void Algorithm::
   AddVertex(vertex_t vertex, const Kernel & kernel)
   {
+    m_queue.Reserve(vertex);
     m_cspace->SetValue(vertex, infinity);
     m_cspace->SetRhs(vertex, infinity);
     m_cspace->SetFlag(vertex, NONE);
@@ -295,10 +675,10 @@ namespace estar {
 #ifdef ALWAYS_UPDATE
     UpdateVertex(vertex, kernel);
 #else // ALWAYS_UPDATE
-    if (m_queue.Get().empty())
+    if (m_queue.IsEmpty())
       UpdateVertex(vertex, kernel);
     else {
-      double const thresh(m_queue.Get().begin()->first);
+      double const thresh(m_queue.GetTopKey());
       for (edge_read_iteration inbor(m_cspace->begin(vertex));
 	   inbor.not_at_end(); ++inbor) {
 	if (m_cspace->GetValue(*inbor) < thresh) {
@@ -310,4 +690,52 @@ namespace estar {
 #endif // ALWAYS_UPDATE
   }
   
+  
+  void Algorithm::
+  RemoveVertex(vertex_t vertex)
+  {
+    m_queue.Remove(vertex, m_flag);
+    m_goalset.erase(vertex);
+    m_added_goal.erase(vertex);
+    m_removed_goal.erase(vertex);
+    m_meta_batch.erase(vertex);
+    m_upwind.RemoveIncoming(vertex);
+    Upwind::downwind_it id, dend;
+    tie(id, dend) = m_upwind.GetDownwind(vertex);
+    for(/**/; id != dend; ++id)
+      m_upwind.RemoveEdge(vertex, *id);
+    m_cspace->SetValue(vertex, infinity);
+    m_cspace->SetRhs(vertex, infinity);
+    m_cspace->SetFlag(vertex, NONE);
+  }
+  
+  
+  static void renumber_goalset(std::set<vertex_t> & goalset,
+			       std::vector<vertex_t> const & newid)
+  {
+    std::set<vertex_t> old;
+    old.swap(goalset);
+    for (std::set<vertex_t>::const_iterator ig(old.begin());
+	 ig != old.end(); ++ig)
+      goalset.insert(newid[*ig]);
+  }
+  
+  
+  void Algorithm::
+  Renumber(std::vector<vertex_t> const & newid)
+  {
+    m_queue.Renumber(newid);
+    m_upwind.Renumber(newid);
+    renumber_goalset(m_goalset, newid);
+    renumber_goalset(m_removed_goal, newid);
+    renumber_goalset(m_added_goal, newid);
+    metabatch_t batch;
+    batch.swap(m_meta_batch);
+    for (metabatch_t::const_iterator ib(batch.begin());
+	 ib != batch.end(); ++ib)
+      m_meta_batch.insert(std::make_pair(newid[ib->first], ib->second));
+    if (m_last_computed_vertex < newid.size())
+      m_last_computed_vertex = newid[m_last_computed_vertex];
+  }
+  
 } // namespace estar
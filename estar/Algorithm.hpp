@@ -26,15 +26,48 @@
 #include <estar/Queue.hpp>
 #include <estar/Upwind.hpp>
 #include <estar/PropagatorFactory.hpp>
+#include <estar/Propagator.hpp>
+#include <estar/ThreadPool.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <map>
+#include <set>
+#include <vector>
 
 
 namespace estar {
   
   
   class Kernel;
+  class Heuristic;
+  
+  
+  /**
+     What Algorithm::ComputeUntil() has achieved by the time it
+     returned.
+  */
+  struct compute_progress {
+    compute_progress()
+      : nsteps(0), settled(false), deadline_passed(false),
+	have_work(false), top_key(infinity) {}
+    size_t nsteps;		/**< number of steps done, see GetStep() */
+    bool settled;		/**< the stop vertex is settled, see
+				   Algorithm::IsSettled() */
+    bool deadline_passed;	/**< stopped because of the deadline */
+    bool have_work;		/**< Algorithm::HaveWork() at return */
+    double top_key;		/**< lowest queue key at return, or
+				   infinity if the queue is empty */
+  };
+  
+  
+  /**
+     Callback for vertices that get lowered during propagation, see
+     Algorithm::SetLowerHook().
+  */
+  struct lower_hook {
+    virtual ~lower_hook() {}
+    virtual void operator () (vertex_t vertex) = 0;
+  };
   
   
   /**
@@ -56,7 +89,9 @@ namespace estar {
 	      bool check_local_consistency,
 	      /** Whether to check if a neighbor lies below the
 		  wavefront when computing the propagator set of a
-		  node. Use false to mimic old behavior */
+		  node. Use false to mimic old behavior. Ignored with
+		  Queue::BUCKET, which does not pop vertices in strict
+		  key order. */
 	      bool check_queue_key,
 	      /** Whether to automatically reset the whole E*
 		  computations when meta information changes. This is
@@ -66,7 +101,14 @@ namespace estar {
 		  queue has been emptied each time you call
 		  ComputeOne(). This is usually a waste of
 		  resources. */
-	      bool auto_flush);
+	      bool auto_flush,
+	      /** Which storage to use for the wavefront queue. All
+		  backends except Queue::BUCKET expand vertices in the
+		  same order, they only differ in speed. */
+	      Queue::backend_t queue_backend = Queue::FOUR_HEAP,
+	      /** Only used with Queue::BUCKET, see
+		  BucketQueueBackend for how to choose it. */
+	      double bucket_width = 1);
     
     /**
        For telling the algorithm that a vertex has been added to
@@ -87,6 +129,34 @@ namespace estar {
     */
     void AddVertex(vertex_t vertex, const Kernel & kernel);
     
+    /**
+       For telling the algorithm that a vertex is about to be taken
+       out of C-space, typically in order to be recycled for another
+       cell (see Grid::MoveWindow()). The vertex is taken off the
+       queue and out of the goal set (and of any pending goal change
+       or meta batch), its upwind and downwind edges are removed, and
+       its value, rhs, and flag are reset to infinity, infinity, and
+       NONE.
+       
+       \note The neighbors are not updated, they simply keep the
+       values that were computed using the removed vertex. For a
+       rolling window, this is what keeps the navigation function
+       pointing towards goals that have dropped out of the
+       window. Call this method before disconnecting the vertex from
+       its neighbors, and AddVertex() once it has been reconnected.
+    */
+    void RemoveVertex(vertex_t vertex);
+    
+    /**
+       Follow a renumbering of the C-space, which moves each vertex v
+       to newid[v] (see BaseCSpace::Renumber()): queued vertices,
+       upwind edges, goals, and an open meta batch are all carried
+       over, so propagation simply continues afterwards. This does
+       not renumber the C-space itself, which is usually done by
+       Grid::Renumber() right before calling this method.
+    */
+    void Renumber(std::vector<vertex_t> const & newid);
+    
     /**
        Declare a node to be a goal vertex, and fix its value. This
        only works as expected if the goal vertex is already connected
@@ -103,21 +173,49 @@ namespace estar {
     void AddGoal(vertex_t vertex, double value);
     
     /**
-       Declare that a node is not a goal anymore. This causes the
-       whole Algorithm to Reset() the next time you call
-       ComputeOne(). If the vertex was not a goal to begin with,
-       however, this expensive operation is not performed.
+       Declare that a node is not a goal anymore. This is treated
+       like any other change that can raise a value: the next
+       ComputeOne() recomputes the node's rhs from its neighbors, and
+       the resulting raise propagates along the upwind graph such
+       that only the nodes that depended on the removed goal get
+       repaired. If the vertex was not a goal to begin with, nothing
+       happens.
+       
+       Each node downwind of a removed goal gets raised and lowered
+       again, and any new goals lower yet more nodes. When too many
+       of the goals that values depend on (those with downwind
+       neighbors) are gone by the time of the next ComputeOne(), this
+       costs more than starting over, and ComputeOne() does a (cheap)
+       Reset() instead. That happens after moving a single goal, or
+       shifting a goal region by a few cells, but not after removing
+       goals from the inside of a region. See PreferReset() for the
+       thresholds.
     */
     void RemoveGoal(vertex_t vertex);
     
     /**
-       Flag all goal nodes as "normal" again, and request a Reset()
-       for the next ComputeOne(). Note, however, that ComputeOne()
-       will only do something useful if there is at least one goal
-       node.
+       Flag all goal nodes as "normal" again, just like calling
+       RemoveGoal() on each of them. Typically followed by AddGoal()
+       before the next ComputeOne(), which then only repairs the
+       difference between the old and the new goal set. Note,
+       however, that ComputeOne() will only do something useful if
+       there is at least one goal node.
     */
     void RemoveAllGoals();
     
+    /** Goal vertices and their values, see ReplaceGoals(). */
+    typedef std::map<vertex_t, double> goalmap_t;
+    
+    /**
+       Replace the current goal set by the given one. Goals that are
+       not in the new set are removed as in RemoveGoal(), the others
+       are added (or their value changed) as in AddGoal(). Vertices
+       that remain goals with the same value are not touched at all,
+       so ComputeOne() only has to deal with the difference, which it
+       either repairs or answers with a Reset() (see RemoveGoal()).
+    */
+    void ReplaceGoals(goalmap_t const & goal);
+    
     /**
        Reset the algorithm, preserving only goal information. This means:
        - clear the wavefront queue
@@ -128,11 +226,93 @@ namespace estar {
          preserved, which will make the original goal values reappear
          as soon as they have been popped off the queue and expanded)
        
+       The values, rhs, and flags are reset lazily by starting a new
+       epoch in the C-space (see BaseCSpace::NewEpoch()), so this costs
+       O(queue size + number of goals) instead of a sweep over all
+       vertices.
+       
        \note Automatically called from ComputeOne() if necessary (ie
-       after goal removal).
+       after removing the last goal).
     */
     void Reset();
     
+    /**
+       Set the value of a vertex that was computed elsewhere, for
+       instance by TiledAlgorithm, together with the neighbors it was
+       computed from. The rhs of non-goal vertices is set to the same
+       value, and the vertex is taken off the queue if it is
+       consistent. This is meant for replacing the entire navigation
+       function: call Reset() first, then import each vertex, after
+       which incremental repairs work as if the values had been
+       propagated here.
+    */
+    void ImportVertex(vertex_t vertex, double value,
+		      vertex_t const * upwind, size_t nupwind);
+    
+    /**
+       Expand whole bands of vertices per step instead of single
+       ones. Each step pops all vertices whose key lies within delta
+       of the top key (see Queue::PopBand()) and lowers them. Then the
+       kernel gets evaluated for all their neighbors on nthreads
+       threads, and the resulting rhs, upwind, and queue changes are
+       committed sequentially in order of vertex ID, so the outcome
+       does not depend on the number of threads. Raised vertices of
+       the band are handled one by one afterwards, as usual.
+       
+       The result is the same as with single expansions if delta is
+       below the smallest difference the kernel can produce between
+       neighboring values, because then no vertex of the band can
+       lower another one. For LSMKernel, half of scale over the
+       highest meta is on the safe side. Wider bands still converge,
+       but some vertices get expanded more than once. With a nonzero
+       slack, the values can differ from single expansions by up to
+       the slack per cell along the wavefront, because the order of
+       the updates is not the same.
+       
+       A delta of zero switches back to single expansions. Focused
+       queues (see SetFocus()) always expand single vertices.
+    */
+    void SetBandExpansion(double delta, size_t nthreads);
+    
+    /** \return The band width set with SetBandExpansion(), zero if
+	single vertices are expanded. */
+    double GetBandDelta() const { return m_band_delta; }
+    
+    /**
+       Focus the propagation on a vertex, typically the one under the
+       robot. The wavefront is still expanded in the order of
+       min(value, rhs), but vertices whose value plus the heuristic
+       estimate to the focus exceeds a horizon are set aside, and the
+       horizon is only widened (by the margin) when nothing else is
+       left, see Queue::SetFocus(). Instead of a disk around the goal,
+       the propagation then covers an ellipse-like area between the
+       goal and the focus, plus whatever IsSettled() needs around the
+       focus. Propagating until HaveWork() returns false still
+       computes everything, because all parked vertices eventually
+       come back.
+       
+       When the focus moves, call this method again with a heuristic
+       for the new focus vertex. As in D* Lite, the focus keys of the
+       parked vertices are not recomputed, a key modifier makes them
+       lower bounds that are checked lazily. For this to work, the
+       old and new heuristics have to fulfill the triangle
+       inequality, e.g. GridHeuristic instances with the same weight.
+       
+       Passing a null heuristic switches back to unfocused
+       propagation.
+       
+       \note Ordering the queue by value plus estimate, as A* and D*
+       Lite do, does not work well here: interpolating kernels need
+       the neighbors beside a vertex, which such an ordering expands
+       late, so values would keep creeping down in small corrections.
+    */
+    void SetFocus(boost::shared_ptr<Heuristic const> heuristic,
+		  /** ignored if heuristic is null */
+		  vertex_t focus,
+		  /** how far to widen the horizon at a time, in units of
+		      value */
+		  double margin);
+    
     /**
        \return True if the node is part of the goal set.
     */
@@ -157,12 +337,44 @@ namespace estar {
     */
     void SetMeta(vertex_t vertex, double meta, const Kernel & kernel);
     
+    /**
+       Start collecting SetMeta() calls instead of updating each
+       vertex right away. Only the meta is written, and each changed
+       vertex is updated once in CommitMetaBatch(), no matter how
+       often it was set in between. This is meant for sensor scans,
+       which typically touch the same cells several times. Vertices
+       that end up with the meta they had before the batch are not
+       updated at all.
+       
+       \note ComputeOne() and ComputeUntil() commit an open batch
+       before doing anything else, and HaveWork() is true as long as
+       uncommitted changes are pending.
+    */
+    void BeginMetaBatch();
+    
+    /**
+       Update each vertex whose meta was changed since
+       BeginMetaBatch(), and switch back to updating vertices
+       immediately in SetMeta().
+       
+       \return The number of vertex updates (kernel evaluations)
+       saved compared to updating the vertex on each SetMeta() call
+       that changed its meta.
+    */
+    size_t CommitMetaBatch(const Kernel & kernel);
+    
+    /** \return True between BeginMetaBatch() and CommitMetaBatch(). */
+    bool InMetaBatch() const { return m_meta_batch_open; }
+    
     /**
        Perform an elementary propagation (or "expansion") step. This
-       is a no-op if the queue is empty. If there is a pending
-       Reset(), such as after RemoveGoal() or any meta modification
-       with an enabled m_auto_reset option, the reset is performed
-       first. If m_auto_flush is set, the computation is iterated
+       is a no-op if the queue is empty or if its top key exceeds the
+       ceiling (see SetCeiling()). If there is a pending
+       Reset(), such as after removing the last goal or any meta
+       modification with an enabled m_auto_reset option, the reset is
+       performed first. Otherwise, goals that have been removed since
+       the last call are updated like ordinary vertices before
+       expanding anything. If m_auto_flush is set, the computation is iterated
        until the queue is empty.
        
        Node expansion means:
@@ -195,12 +407,94 @@ namespace estar {
 			so. */
 		    double slack);
     
+    /**
+       Repeatedly perform ComputeOne() steps until there is no work
+       left, or the stop vertex is settled, or the deadline has
+       passed. This is the anytime version of the usual "propagate
+       until the robot is UPWIND" loop. It avoids the per-step
+       overhead of that loop by not reading the clock after each
+       step. Instead, it measures the slowest steps so far and spaces
+       the clock reads such that they would fill at most half of the
+       remaining time, so the deadline is overrun by about the
+       duration of a single step. An open meta batch only gets
+       committed if the deadline has not passed yet, but the commit
+       itself is not interrupted. The m_auto_flush option is ignored
+       here.
+       
+       \return The number of steps done, whether the stop vertex is
+       settled, and the state of the queue at return.
+    */
+    compute_progress ComputeUntil(const Kernel & kernel,
+				  /** see ComputeOne() */
+				  double slack,
+				  /** Stop as soon as this vertex is
+				      settled (see IsSettled()). Pass
+				      null to only stop at the deadline
+				      or when there is no work left. */
+				  vertex_t const * stop_vertex,
+				  /** absolute time on the clock of
+				      get_monotonic_time(), use infinity
+				      for no deadline */
+				  double deadline,
+				  /** maximum number of steps between two
+				      looks at the clock */
+				  size_t check_interval = 64);
+    
     /**
        \return True if there is something to do, such as expanding a
-       node or re-initializing the algorithm after a goal removal.
+       node or handling a goal removal. Vertices whose key exceeds
+       the ceiling do not count, see SetCeiling().
     */
     bool HaveWork() const;
     
+    /**
+       Stop the propagation at a value ceiling. Vertices whose queue
+       key exceeds the ceiling are left on the queue, they are simply
+       not expanded, and HaveWork() returns false once nothing else
+       is left. This is useful for distance fields that are only
+       looked up up to a known distance, for instance a buffer zone
+       around obstacles. Incremental repairs are cut off in the same
+       way. Raising the ceiling later resumes the propagation where
+       it stopped, lowering it leaves existing values as they are.
+       
+       Vertices with a value above the ceiling are not settled, see
+       IsSettled(), and Facade::GetStatus() reports them as
+       BEYOND_HORIZON. Their value is either infinity or a stale
+       upper bound, so lookups should treat any value above the
+       ceiling as "far away".
+       
+       \note With the Queue::BUCKET backend, the propagation can stop
+       up to one bucket width below the ceiling.
+    */
+    void SetCeiling(/** use infinity to propagate everything */
+		    double ceiling);
+    
+    /** \return The value ceiling, see SetCeiling(). */
+    double GetCeiling() const { return m_ceiling; }
+    
+    /**
+       Call a hook for each vertex that ComputeOne() or
+       ComputeUntil() lowers, right after its neighbors have been
+       updated. The hook may add vertices to the C-space and register
+       them with AddVertex(), which is how a tiled Grid grows along
+       with the wavefront (see Grid::ExpandTiles()). Pass null to
+       remove the hook. The caller keeps ownership, and the hook has
+       to stay valid as long as it is set.
+    */
+    void SetLowerHook(lower_hook * hook) { m_lower_hook = hook; }
+    
+    /**
+       \return True if the value of the vertex will not change with
+       further propagation, because it is a goal or because it lies
+       below the wavefront. This corresponds to Facade::GetStatus()
+       returning GOAL or UPWIND (or OBSTACLE if the queue is empty).
+       Pending goal removals and resets count as unsettled, and so
+       do vertices beyond the horizon of a focused queue (see
+       SetFocus()) or with a value above the ceiling (see
+       SetCeiling()).
+    */
+    bool IsSettled(vertex_t vertex) const;
+    
     /** Read-only access to C-space. */
     boost::shared_ptr<BaseCSpace const> GetCSpace() const { return m_cspace; }
     
@@ -260,21 +554,49 @@ namespace estar {
     
   private:
     typedef std::set<vertex_t> goalset_t;
+    /** vertex and its meta before the batch */
+    typedef std::map<vertex_t, double> metabatch_t;
     
     
     void UpdateVertex(vertex_t vertex, const Kernel & kernel);
+    /** Store an rhs computed from the given propagator set. */
+    void SetRhs(vertex_t vertex, double rhs, Propagator const & prop);
+    void RaiseVertex(vertex_t vertex, const Kernel & kernel);
     void DoComputeOne(const Kernel & kernel, double slack);
+    void DoComputeBand(const Kernel & kernel, double slack);
+    /** \return true if repairing the goal changes since the last
+	DoComputeOne() would cost more than a Reset(). */
+    bool PreferReset() const;
     
     boost::shared_ptr<BaseCSpace> m_cspace;
     Queue m_queue;
     Upwind m_upwind;
     
     goalset_t m_goalset;
+    /** goals removed since the last DoComputeOne() */
+    goalset_t m_removed_goal;
+    /** goals added since the last DoComputeOne(), always a subset
+	of m_goalset */
+    goalset_t m_added_goal;
     
     size_t m_step;
     double m_last_computed_value;
     vertex_t m_last_computed_vertex;
     double m_last_popped_key;
+    double m_ceiling;
+    lower_hook * m_lower_hook;
+    
+    bool m_meta_batch_open;
+    metabatch_t m_meta_batch;
+    /** number of SetMeta() calls that changed a meta during the batch */
+    size_t m_meta_batch_nset;
+    
+    double m_band_delta;
+    boost::scoped_ptr<ThreadPool> m_band_pool;
+    /** scratch space for DoComputeBand() */
+    std::vector<vertex_t> m_band, m_band_raise, m_band_nbor;
+    std::vector<Propagator> m_band_prop;
+    std::vector<double> m_band_rhs;
     
     bool m_pending_reset;
     bool m_auto_reset;
@@ -43,7 +43,7 @@ namespace estar {
       PVDEBUG("OBSTACLE\n", meta);
       return infinity;
     }
-    const_queue_it iq, qend;
+    Propagator::nbor_it iq, qend;
     boost::tie(iq, qend) = propagator.GetUpwindNeighbors();
     propagator.AddBackpointer(iq->second);
     const double v1(iq->first);
@@ -0,0 +1,560 @@
+/* 
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+#ifndef ESTAR_BASIC_ALGORITHM_HPP
+#define ESTAR_BASIC_ALGORITHM_HPP
+
+
+#include <estar/QueueBackend.hpp>
+#include <estar/LSMKernel.hpp>
+#include <estar/NF1Kernel.hpp>
+#include <estar/AlphaKernel.hpp>
+#include <estar/numeric.hpp>
+#include <estar/util.hpp>
+#include <boost/assert.hpp>
+#include <vector>
+#include <set>
+#include <utility>
+#include <cmath>
+
+
+namespace estar {
+  
+  
+  /**
+     \name Neighborhoods for BasicAlgorithm.
+     
+     Each one lists the (dx, dy) offsets of the neighbors of a cell,
+     and which slot holds the opposite offset. The order is the one
+     that Grid ends up with in the adjacency lists of its C-space
+     graph, so that BasicAlgorithm expands cells and breaks ties in
+     the same order as an Algorithm running on a Grid of the same
+     neighborhood.
+  */
+  /*@{*/
+  
+  struct FourNeighborhood {
+    static size_t const size = 4;
+    static ssize_t dx(size_t slot)
+    { static ssize_t const d[] = { 0, -1, 0, 1 }; return d[slot]; }
+    static ssize_t dy(size_t slot)
+    { static ssize_t const d[] = { -1, 0, 1, 0 }; return d[slot]; }
+    static size_t opposite(size_t slot)
+    { static size_t const o[] = { 2, 3, 0, 1 }; return o[slot]; }
+  };
+  
+  /** Same as Grid::SIX, which effectively connects (ix, iy) with
+      (ix-1, iy+1) and (ix+1, iy-1) in addition to the four-connected
+      neighbors. */
+  struct SixNeighborhood {
+    static size_t const size = 6;
+    static ssize_t dx(size_t slot)
+    { static ssize_t const d[] = { 0, -1, -1, 0, 1, 1 }; return d[slot]; }
+    static ssize_t dy(size_t slot)
+    { static ssize_t const d[] = { -1, 0, 1, 1, -1, 0 }; return d[slot]; }
+    static size_t opposite(size_t slot)
+    { static size_t const o[] = { 3, 5, 4, 0, 2, 1 }; return o[slot]; }
+  };
+  
+  struct EightNeighborhood {
+    static size_t const size = 8;
+    static ssize_t dx(size_t slot)
+    { static ssize_t const d[] = { 0, -1, -1, -1, 0, 1, 1, 1 }; return d[slot]; }
+    static ssize_t dy(size_t slot)
+    { static ssize_t const d[] = { -1, 0, -1, 1, 1, -1, 0, 1 }; return d[slot]; }
+    static size_t opposite(size_t slot)
+    { static size_t const o[] = { 4, 6, 7, 5, 0, 3, 1, 2 }; return o[slot]; }
+  };
+  
+  /*@}*/
+  
+  
+  /**
+     \name Kernels for BasicAlgorithm.
+     
+     These implement the same math as LSMKernel, NF1Kernel, and
+     AlphaKernel, but they are not virtual and operate directly on the
+     candidate array built by CandidateList. Candidates are (value,
+     slot) pairs sorted by value, there is at least one of them, and
+     the chosen backpointers are written as slots into bp.
+  */
+  /*@{*/
+  
+  class BasicLSMKernel {
+  public:
+    typedef KernelTraits<LSMKernel> traits;
+    double const scale;
+    
+    explicit BasicLSMKernel(double _scale): scale(_scale) {}
+    
+    template<class NeighborhoodT>
+    double Compute(double meta,
+		   std::pair<double, size_t> const * cand, size_t ncand,
+		   size_t * bp, size_t & nbp) const
+    {
+      if (meta <= epsilon)
+	return infinity;
+      double const radius(scale / meta);
+      double const primary_value(cand[0].first);
+      bp[nbp++] = cand[0].second;
+      bool const primary_is_along_x(0 != NeighborhoodT::dx(cand[0].second));
+      size_t is(1);
+      for (/**/; is < ncand; ++is)
+	if (primary_is_along_x ^ (0 != NeighborhoodT::dx(cand[is].second)))
+	  break;
+      if (is == ncand)
+	return primary_value + radius;
+      double const secondary_value(cand[is].first);
+      if (radius <= secondary_value - primary_value)
+	return primary_value + radius;
+      bp[nbp++] = cand[is].second;
+      double const b(primary_value + secondary_value);
+      double const c((square(primary_value)
+		      + square(secondary_value)
+		      - square(radius)) / 2);
+      return (b + sqrt(square(b) - 4 * c)) / 2;
+    }
+  };
+  
+  
+  class BasicNF1Kernel {
+  public:
+    typedef KernelTraits<NF1Kernel> traits;
+    double const scale;
+    
+    BasicNF1Kernel(): scale(1) {}
+    
+    template<class NeighborhoodT>
+    double Compute(double meta,
+		   std::pair<double, size_t> const * cand, size_t,
+		   size_t * bp, size_t & nbp) const
+    {
+      bp[nbp++] = cand[0].second;
+      return cand[0].first + meta;
+    }
+  };
+  
+  
+  class BasicAlphaKernel {
+  public:
+    typedef KernelTraits<AlphaKernel> traits;
+    double const scale;
+    double const alpha;
+    
+    explicit BasicAlphaKernel(double _scale): scale(_scale), alpha(2.0) {}
+    
+    template<class NeighborhoodT>
+    double Compute(double meta,
+		   std::pair<double, size_t> const * cand, size_t ncand,
+		   size_t * bp, size_t & nbp) const
+    {
+      if (meta == infinity)
+	return infinity;
+      bp[nbp++] = cand[0].second;
+      double const v1(cand[0].first);
+      double const tmax(v1 + alpha * scale * meta);
+      if (1 == ncand)
+	return tmax;
+      double const v2(cand[1].first);
+      double const tnonfb(v1 + meta*meta * (2*scale+v2-v1) / (1+meta));
+      if (tnonfb > tmax)
+	return tmax;
+      bp[nbp++] = cand[1].second;
+      return tnonfb;
+    }
+  };
+  
+  /*@}*/
+  
+  
+  /**
+     The neighbors that may contribute to the value of a cell, sorted
+     by value as the Basic kernels want them, and the backpointers
+     that the kernel picks among them. Equal values stay in the order
+     in which they were added, which is how BasicAlgorithm,
+     TiledAlgorithm, and FastSweepSolver break ties the same way as
+     Algorithm does when they add the neighbors in slot order.
+  */
+  template<class NeighborhoodT>
+  struct CandidateList {
+    CandidateList(): ncand(0), nbp(0) {}
+    
+    void Add(double value, size_t slot)
+    {
+      size_t pos(ncand++);
+      for (/**/; (pos > 0) && (cand[pos - 1].first > value); --pos)
+	cand[pos] = cand[pos - 1];
+      cand[pos] = std::make_pair(value, slot);
+    }
+    
+    /** \return The kernel's value for the given meta, or infinity
+	if there are no candidates. */
+    template<class KernelT>
+    double Compute(KernelT const & kernel, double meta)
+    {
+      if (0 == ncand)
+	return infinity;
+      return kernel.template Compute<NeighborhoodT>(meta, cand, ncand,
+						    bp, nbp);
+    }
+    
+    /** \return The backpointers of the last Compute() as a bit mask
+	of slots. */
+    template<typename MaskT>
+    MaskT GetUpwindMask() const
+    {
+      MaskT mask(0);
+      for (size_t ib(0); ib < nbp; ++ib)
+	mask |= MaskT(1) << bp[ib];
+      return mask;
+    }
+    
+    std::pair<double, size_t> cand[NeighborhoodT::size];
+    size_t ncand;
+    size_t bp[NeighborhoodT::size];
+    size_t nbp;
+  };
+  
+  
+  /**
+     Compile-time specialized E* for rectangular grids. This is the
+     same algorithm as Algorithm with a Grid and a Kernel, but the
+     kernel and neighborhood are template parameters, and the cells
+     are kept in flat arrays instead of a boost::adjacency_list. Thus
+     the kernel math gets inlined, the neighbor loops have a fixed
+     trip count, and neighbors are found by adding a constant offset
+     to the cell index. The grid is padded with a border of cells
+     that never get expanded, so there are no bounds checks either.
+     
+     Values are identical to Algorithm on a Grid created with
+     Grid::Init() (the neighbor order is the same). Use Algorithm or
+     Facade if you need anything beyond a fixed-size grid, such as
+     Region goals, growing the grid, or runtime-selected kernels.
+     
+     \code
+     BasicAlgorithm<BasicLSMKernel, FourNeighborhood>
+       algo(xsize, ysize, BasicLSMKernel(scale));
+     algo.AddGoal(0, 0, 0);
+     while (algo.HaveWork())
+       algo.ComputeOne(scale / 10000);
+     \endcode
+  */
+  template<class KernelT, class NeighborhoodT>
+  class BasicAlgorithm {
+  public:
+    typedef KernelT kernel_t;
+    typedef NeighborhoodT neighborhood_t;
+    
+    BasicAlgorithm(ssize_t xsize, ssize_t ysize,
+		   KernelT const & kernel,
+		   /** see Algorithm::Algorithm() */
+		   bool check_upwind = false,
+		   /** see Algorithm::Algorithm() */
+		   bool check_local_consistency = false,
+		   /** see Algorithm::Algorithm() */
+		   bool check_queue_key = false)
+      : m_kernel(kernel),
+	m_xsize(xsize),
+	m_ysize(ysize),
+	m_ystride(ysize + 2),
+	m_check_upwind(check_upwind),
+	m_check_local_consistency(check_local_consistency),
+	m_check_queue_key(check_queue_key),
+	m_value((xsize + 2) * (ysize + 2), infinity),
+	m_rhs(m_value.size(), infinity),
+	m_meta(m_value.size(), KernelT::traits::obstacle_meta()),
+	m_flag(m_value.size(), GOAL),
+	m_downwind(m_value.size(), 0),
+	m_upwind(m_value.size(), 0),
+	m_step(0)
+    {
+      for (size_t slot(0); slot < NeighborhoodT::size; ++slot)
+	m_offset[slot] = NeighborhoodT::dx(slot) * m_ystride
+	  + NeighborhoodT::dy(slot);
+      // Border cells are flagged as goals so that UpdateVertex()
+      // skips them, but they are never queued and stay at infinity.
+      for (ssize_t ix(0); ix < xsize; ++ix)
+	for (ssize_t iy(0); iy < ysize; ++iy) {
+	  m_meta[Index(ix, iy)] = KernelT::traits::freespace_meta();
+	  m_flag[Index(ix, iy)] = NONE;
+	}
+    }
+    
+    ssize_t GetXSize() const { return m_xsize; }
+    ssize_t GetYSize() const { return m_ysize; }
+    
+    double GetValue(ssize_t ix, ssize_t iy) const
+    { return m_value[Index(ix, iy)]; }
+    
+    double GetRhs(ssize_t ix, ssize_t iy) const
+    { return m_rhs[Index(ix, iy)]; }
+    
+    double GetMeta(ssize_t ix, ssize_t iy) const
+    { return m_meta[Index(ix, iy)]; }
+    
+    flag_t GetFlag(ssize_t ix, ssize_t iy) const
+    { return m_flag[Index(ix, iy)]; }
+    
+    bool IsGoal(ssize_t ix, ssize_t iy) const
+    { return m_flag[Index(ix, iy)] & GOAL; }
+    
+    /** \return The number of times that ComputeOne() has actually
+	done something. */
+    size_t GetStep() const { return m_step; }
+    
+    size_t GetQueueSize() const { return m_queue.GetSize(); }
+    
+    bool HaveWork() const
+    {
+      return ( ! m_removed_goal.empty()) || ( ! m_queue.IsEmpty());
+    }
+    
+    /** Same as Algorithm::SetMeta(). */
+    void SetMeta(ssize_t ix, ssize_t iy, double meta)
+    {
+      size_t const cell(Index(ix, iy));
+      if (absval(m_meta[cell] - meta) < epsilon)
+	return;
+      m_meta[cell] = meta;
+      UpdateVertex(cell);
+    }
+    
+    /** Same as Algorithm::AddGoal(). */
+    void AddGoal(ssize_t ix, ssize_t iy, double value)
+    {
+      size_t const cell(Index(ix, iy));
+      flag_t const flag(m_flag[cell]);
+      if ((flag & GOAL) && (absval(m_rhs[cell] - value) < epsilon))
+	return;
+      if ( ! (flag & GOAL)) {
+	goalset_t::iterator const ir(m_removed_goal.find(cell));
+	if ((m_removed_goal.end() != ir)
+	    && (absval(m_rhs[cell] - value) < epsilon))
+	  m_removed_goal.erase(ir);
+	else
+	  m_added_goal.insert(cell);
+      }
+      m_rhs[cell] = value;
+      m_flag[cell] = static_cast<flag_t>(flag | GOAL);
+      m_goalset.insert(cell);
+      if (absval(m_value[cell] - value) < epsilon)
+	return;
+      m_value[cell] = infinity;
+      Requeue(cell);
+    }
+    
+    /** Same as Algorithm::RemoveGoal(). */
+    void RemoveGoal(ssize_t ix, ssize_t iy)
+    {
+      size_t const cell(Index(ix, iy));
+      flag_t const flag(m_flag[cell]);
+      if (flag & GOAL) {
+	m_goalset.erase(cell);
+	m_flag[cell] = static_cast<flag_t>(flag & OPEN);
+	m_added_goal.erase(cell);
+	m_removed_goal.insert(cell);
+      }
+    }
+    
+    /** Same as Algorithm::RemoveAllGoals(). */
+    void RemoveAllGoals()
+    {
+      if (m_goalset.empty())
+	return;
+      for (goalset_t::const_iterator ig(m_goalset.begin());
+	   ig != m_goalset.end(); ++ig) {
+	m_flag[*ig] = static_cast<flag_t>(m_flag[*ig] & OPEN);
+	m_removed_goal.insert(*ig);
+      }
+      m_goalset.clear();
+      m_added_goal.clear();
+    }
+    
+    /** Same as Algorithm::Reset(). */
+    void Reset()
+    {
+      m_queue.Clear();
+      m_removed_goal.clear();
+      m_added_goal.clear();
+      for (ssize_t ix(0); ix < m_xsize; ++ix)
+	for (ssize_t iy(0); iy < m_ysize; ++iy) {
+	  size_t const cell(Index(ix, iy));
+	  m_value[cell] = infinity;
+	  if (m_flag[cell] & GOAL) {
+	    m_flag[cell] = GOAL;
+	    Requeue(cell);
+	  }
+	  else {
+	    m_rhs[cell] = infinity;
+	    m_flag[cell] = NONE;
+	  }
+	}
+    }
+    
+    /** Same as Algorithm::ComputeOne() without auto_flush. */
+    void ComputeOne(double slack)
+    {
+      if (( ! m_removed_goal.empty())
+	  && (m_added_goal.size() == m_goalset.size()))
+	Reset();
+      else if ( ! m_removed_goal.empty()) {
+	for (goalset_t::const_iterator ig(m_removed_goal.begin());
+	     ig != m_removed_goal.end(); ++ig)
+	  UpdateVertex(*ig);
+	m_removed_goal.clear();
+      }
+      m_added_goal.clear();
+      if (m_queue.IsEmpty())
+	return;
+      ++m_step;
+      
+      size_t const cell(m_queue.PopTop());
+      m_flag[cell] = static_cast<flag_t>(m_flag[cell] ^ OPEN);
+      double const rhs(m_rhs[cell]);
+      double const val(m_value[cell]);
+      if (absval(val - rhs) <= slack)
+	return;
+      
+      if (val > rhs) {
+	m_value[cell] = rhs;
+	for (size_t slot(0); slot < NeighborhoodT::size; ++slot)
+	  UpdateVertex(cell + m_offset[slot]);
+      }
+      else {
+	m_value[cell] = infinity;
+	// work on a copy, UpdateVertex() modifies the downwind bits
+	for (mask_t downwind(m_downwind[cell]), slot(0);
+	     0 != downwind; downwind >>= 1, ++slot)
+	  if (downwind & 1)
+	    UpdateVertex(cell + m_offset[slot]);
+	UpdateVertex(cell);
+      }
+    }
+    
+  private:
+    typedef unsigned char mask_t;
+    typedef std::set<size_t> goalset_t;
+    
+    size_t Index(ssize_t ix, ssize_t iy) const
+    {
+      BOOST_ASSERT((ix >= 0) && (ix < m_xsize) && (iy >= 0) && (iy < m_ysize));
+      return (ix + 1) * m_ystride + iy + 1;
+    }
+    
+    /** Same as Queue::Requeue(). */
+    void Requeue(size_t cell)
+    {
+      double const value(m_value[cell]);
+      double const rhs(m_rhs[cell]);
+      flag_t const flag(m_flag[cell]);
+      if (absval(value - rhs) < epsilon) {
+	if (flag & OPEN) {
+	  m_queue.Remove(cell);
+	  m_flag[cell] = static_cast<flag_t>(flag ^ OPEN);
+	}
+	return;
+      }
+      double const key(minval(value, rhs));
+      if ( ! (flag & OPEN)) {
+	m_queue.Insert(cell, key);
+	m_flag[cell] = static_cast<flag_t>(flag | OPEN);
+	return;
+      }
+      double oldkey(infinity);
+      const bool found(m_queue.Find(cell, oldkey));
+      BOOST_ASSERT( found );
+      if (absval(oldkey - key) >= epsilon)
+	m_queue.Update(cell, key);
+    }
+    
+    /** Same as Algorithm::UpdateVertex() combined with
+	PropagatorFactory::Create() and Upwind. */
+    void UpdateVertex(size_t cell)
+    {
+      if (m_flag[cell] & GOAL)
+	return;
+      
+      double queue_bottom(infinity);
+      if (m_check_queue_key && ( ! m_queue.IsEmpty()))
+	queue_bottom = m_queue.GetTopKey();
+      CandidateList<NeighborhoodT> cand;
+      for (size_t slot(0); slot < NeighborhoodT::size; ++slot) {
+	if (m_check_upwind && (m_downwind[cell] & (mask_t(1) << slot)))
+	  continue;
+	size_t const nbor(cell + m_offset[slot]);
+	double const nbor_value(m_value[nbor]);
+	if (m_check_local_consistency && (nbor_value != m_rhs[nbor]))
+	  continue;
+	if (nbor_value >= queue_bottom)
+	  continue;
+	cand.Add(nbor_value, slot);
+      }
+      
+      m_rhs[cell] = cand.Compute(m_kernel, m_meta[cell]);
+      
+      // remove incoming upwind edges, then add the new ones
+      for (mask_t upwind(m_upwind[cell]), slot(0);
+	   0 != upwind; upwind >>= 1, ++slot)
+	if (upwind & 1)
+	  m_downwind[cell + m_offset[slot]]
+	    &= ~(mask_t(1) << NeighborhoodT::opposite(slot));
+      m_upwind[cell] = 0;
+      for (size_t ib(0); ib < cand.nbp; ++ib) {
+	size_t const slot(cand.bp[ib]);
+	size_t const from(cell + m_offset[slot]);
+	size_t const opposite(NeighborhoodT::opposite(slot));
+	if (m_downwind[cell] & (mask_t(1) << slot)) {
+	  m_downwind[cell] &= ~(mask_t(1) << slot);
+	  m_upwind[from] &= ~(mask_t(1) << opposite);
+	}
+	m_downwind[from] |= mask_t(1) << opposite;
+	m_upwind[cell] |= mask_t(1) << slot;
+      }
+      
+      Requeue(cell);
+    }
+    
+    KernelT const m_kernel;
+    ssize_t const m_xsize;
+    ssize_t const m_ysize;
+    ssize_t const m_ystride;
+    bool const m_check_upwind;
+    bool const m_check_local_consistency;
+    bool const m_check_queue_key;
+    ssize_t m_offset[NeighborhoodT::size];
+    
+    std::vector<double> m_value;
+    std::vector<double> m_rhs;
+    std::vector<double> m_meta;
+    std::vector<flag_t> m_flag;
+    std::vector<mask_t> m_downwind;
+    std::vector<mask_t> m_upwind;
+    HeapQueueBackend<4> m_queue;
+    goalset_t m_goalset;
+    goalset_t m_removed_goal;
+    goalset_t m_added_goal;
+    
+    size_t m_step;
+  };
+  
+} // namespace estar
+
+#endif // ESTAR_BASIC_ALGORITHM_HPP
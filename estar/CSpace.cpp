@@ -19,6 +19,8 @@
 
 
 #include "CSpace.hpp"
+#include <boost/assert.hpp>
+#include <algorithm>
 
 
 using namespace boost;
@@ -29,12 +31,14 @@ namespace estar {
   
   BaseCSpace::
   BaseCSpace()
-    : m_value(get(value_p(), m_cspace)),
-      m_meta(get(meta_p(), m_cspace)),
-      m_rhs(get(rhs_p(), m_cspace)),
-      m_flag(get(flag_p(), m_cspace)),
-      m_vertexid(get(vertex_index, m_cspace))
+    : m_value(&m_value_storage, &m_epoch, infinity),
+      m_meta(&m_meta_storage),
+      m_rhs(&m_rhs_storage, &m_epoch, infinity),
+      m_flag(&m_flag_storage, &m_epoch, NONE)
   {
+    m_epoch.value = &m_value_storage;
+    m_epoch.rhs = &m_rhs_storage;
+    m_epoch.flag = &m_flag_storage;
   }
   
   
@@ -94,24 +98,69 @@ namespace estar {
   }
 
   
+  void BaseCSpace::
+  NewEpoch()
+  {
+    ++m_epoch.current;
+    if (0 == m_epoch.current) {
+      // Wrapped around: stamps from 2^32 epochs ago would otherwise
+      // look current again. Invalidate them all, this happens rarely
+      // enough to not matter.
+      std::fill(m_epoch.stamp.begin(), m_epoch.stamp.end(), 0);
+      m_epoch.current = 1;
+    }
+  }
+
+  
   void BaseCSpace::
   AddNeighbor(vertex_t from, vertex_t to)
   {
     add_edge(from, to, m_cspace);
   }
 
-    
+  
+  void BaseCSpace::
+  Renumber(std::vector<vertex_t> const & newid)
+  {
+    m_cspace.Renumber(newid);
+    renumber_vertices(m_value_storage, newid);
+    renumber_vertices(m_meta_storage, newid);
+    renumber_vertices(m_rhs_storage, newid);
+    renumber_vertices(m_flag_storage, newid);
+    renumber_vertices(m_epoch.stamp, newid);
+  }
+  
+  
   vertex_t BaseCSpace::
   AddVertex(double value, double meta, double rhs, flag_t flag)
   {
     vertex_t cv(add_vertex(m_cspace));
-
-    put(m_value, cv, value);
-    put(m_meta,  cv, meta);
-    put(m_rhs,   cv, rhs);
-    put(m_flag,  cv, flag);
-
+    InitVertex(cv, value, meta, rhs, flag);
     return cv;
   }
   
+  
+  void BaseCSpace::
+  InitVertex(vertex_t vertex,
+	     double value, double meta, double rhs, flag_t flag)
+  {
+    BOOST_ASSERT( vertex == m_value_storage.size() );
+    m_value_storage.push_back(value);
+    m_meta_storage.push_back(meta);
+    m_rhs_storage.push_back(rhs);
+    m_flag_storage.push_back(flag);
+    m_epoch.stamp.push_back(m_epoch.current);
+  }
+  
+  
+  void BaseCSpace::
+  ReserveVertices(size_t nvertices)
+  {
+    m_value_storage.reserve(nvertices);
+    m_meta_storage.reserve(nvertices);
+    m_rhs_storage.reserve(nvertices);
+    m_flag_storage.reserve(nvertices);
+    m_epoch.stamp.reserve(nvertices);
+  }
+  
 } // namespace estar
@@ -33,7 +33,7 @@ namespace estar {
     vertex_it vi, vi_end;
     
     vertex_read_iteration(cspace_t const & cspace)
-    { boost::tie(vi, vi_end) = boost::vertices(cspace); }
+    { boost::tie(vi, vi_end) = vertices(cspace); }
     
     vertex_read_iteration & operator ++ () { ++vi; return *this; }
     
@@ -45,7 +45,10 @@ namespace estar {
     
     template<typename some_map_t>
     typename some_map_t::value_type get(some_map_t const & some_map) const
-    { return boost::get(some_map, *vi); }
+    {
+      using boost::get;
+      return get(some_map, *vi);
+    }
   };
   
   
@@ -54,7 +57,7 @@ namespace estar {
     adjacency_it ei, ei_end;
     
     edge_read_iteration(cspace_t const & cspace, vertex_t from)
-    { boost::tie(ei, ei_end) = boost::adjacent_vertices(from, cspace); }
+    { boost::tie(ei, ei_end) = adjacent_vertices(from, cspace); }
     
     edge_read_iteration & operator ++ () { ++ei; return *this; }
     
@@ -66,7 +69,10 @@ namespace estar {
     
     template<typename some_map_t>
     typename some_map_t::value_type get(some_map_t const & some_map) const
-    { return boost::get(some_map, *ei); }
+    {
+      using boost::get;
+      return get(some_map, *ei);
+    }
   };
   
   
@@ -105,6 +111,13 @@ namespace estar {
     void SetRhs(vertex_t vertex, double rhs);
     void SetFlag(vertex_t vertex, flag_t flag);
     
+    /**
+       Reset the value, rhs, and flag of all vertices to infinity,
+       infinity, and NONE in O(1), by starting a new epoch (see
+       cspace_epoch_state). The meta information is not affected.
+    */
+    void NewEpoch();
+    
     cspace_t & GetGraph() { return m_cspace; }
     value_map_t & GetValueMap() { return m_value; }
     meta_map_t & GetMetaMap() { return m_meta; }
@@ -120,9 +133,22 @@ namespace estar {
     */
     void AddNeighbor(vertex_t from, vertex_t to);
     
+    /**
+       Give each vertex the new ID newid[vertex], moving its
+       properties along, see CSpaceGraph::Renumber(). This is meant
+       for improving memory locality. Anything else that refers to
+       vertices (e.g. an Algorithm) has to be renumbered as well.
+    */
+    void Renumber(std::vector<vertex_t> const & newid);
+    
     
   protected:
     cspace_t m_cspace;
+    std::vector<cspace_real_t> m_value_storage;
+    std::vector<cspace_real_t> m_meta_storage;
+    std::vector<cspace_real_t> m_rhs_storage;
+    std::vector<flag_t> m_flag_storage;
+    cspace_epoch_state m_epoch;
     value_map_t m_value;
     meta_map_t m_meta;
     rhs_map_t m_rhs;
@@ -164,6 +190,17 @@ namespace estar {
 		  goal nor wavefront yet, it makes sense to use the
 		  default which is NONE. */
 	      flag_t flag);
+    
+    /**
+       Append the properties of a vertex that was just added to
+       m_cspace. Subclasses that create vertices via the
+       implicit-grid interface of CSpaceGraph use this directly.
+    */
+    void InitVertex(vertex_t vertex,
+		    double value, double meta, double rhs, flag_t flag);
+    
+    /** Preallocate property storage for nvertices vertices. */
+    void ReserveVertices(size_t nvertices);
   };
   
   
@@ -191,10 +228,10 @@ namespace estar {
     typedef custom_t vertex_data_t;
     
     custom_t & Lookup (vertex_t vertex)
-    { return boost::get(m_custom_map, vertex); }
+    { return m_custom_vector[vertex]; }
     
     custom_t const & Lookup (vertex_t vertex) const
-    { return boost::get(m_custom_map, vertex); }
+    { return m_custom_vector[vertex]; }
     
     vertex_t AddVertex(custom_t custom,
 		       double value = infinity,
@@ -204,18 +241,13 @@ namespace estar {
     {
       vertex_t const vertex(BaseCSpace::AddVertex(value, meta, rhs, flag));
       m_custom_vector.push_back(custom);
-      m_custom_map = custom_map_t(m_custom_vector.begin(), m_vertexid);
       return vertex;
     }
     
   protected:
     typedef std::vector<custom_t> custom_vector_t;
-    typedef typename custom_vector_t::iterator custom_iterator_t;
-    typedef boost::iterator_property_map<custom_iterator_t,
-					 vertexid_map_t> custom_map_t;
     
     custom_vector_t m_custom_vector;
-    custom_map_t m_custom_map;
   };
   
   
@@ -0,0 +1,512 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+#include "CSpaceGraph.hpp"
+#include "pdebug.hpp"
+#include <stdexcept>
+#include <algorithm>
+
+
+namespace estar {
+
+
+  CSpaceGraph::vertex_descriptor const CSpaceGraph::null_vertex;
+
+
+  CSpaceGraph::
+  CSpaceGraph()
+    : m_nvertices(0),
+      m_pad(0),
+      m_x0(0),
+      m_y0(0),
+      m_xsize(0),
+      m_ysize(0),
+      m_rolling(false),
+      m_wxbegin(0),
+      m_wxsize(0),
+      m_wybegin(0),
+      m_wysize(0),
+      m_tiled(false),
+      m_tsize(0),
+      m_tshift(0),
+      m_tstride(0)
+  {
+  }
+
+
+  std::pair<CSpaceGraph::adjacency_iterator, CSpaceGraph::adjacency_iterator>
+  CSpaceGraph::
+  GetNeighbors(vertex_descriptor vertex) const
+  {
+    if (m_tiled) {
+      size_t const local(vertex & ((size_t(1) << (2 * m_tshift)) - 1));
+      vertex_descriptor const *
+	cell(m_tile_base[vertex >> (2 * m_tshift)]
+	     + ((local >> m_tshift) + m_pad) * m_tstride
+	     + (local & (m_tsize - 1)) + m_pad);
+      if (vertex != *cell)	// beyond the end of the range
+	return std::make_pair(adjacency_iterator(), adjacency_iterator());
+      ssize_t const * offset(&m_offset[0]);
+      size_t const nslots(m_offset.size());
+      return std::make_pair(adjacency_iterator(cell, offset, 0, nslots),
+			    adjacency_iterator(cell, offset, nslots, nslots));
+    }
+    if (IsGrid()) {
+      vertex_descriptor const * cell(&m_cell[m_cellpos[vertex]]);
+      ssize_t const * offset(&m_offset[0]);
+      size_t const nslots(m_offset.size());
+      return std::make_pair(adjacency_iterator(cell, offset, 0, nslots),
+			    adjacency_iterator(cell, offset, nslots, nslots));
+    }
+    nbor_list_t const & nbor(m_nbor[vertex]);
+    if (nbor.empty())
+      return std::make_pair(adjacency_iterator(), adjacency_iterator());
+    return std::make_pair(adjacency_iterator(&nbor[0], 0, 0, nbor.size()),
+			  adjacency_iterator(&nbor[0], 0, nbor.size(),
+					     nbor.size()));
+  }
+
+
+  CSpaceGraph::vertex_descriptor CSpaceGraph::
+  AddVertex()
+  {
+    if (IsGrid())
+      throw std::logic_error("estar::CSpaceGraph::AddVertex() in grid mode");
+    m_nbor.push_back(nbor_list_t());
+    return m_nvertices++;
+  }
+
+
+  void CSpaceGraph::
+  AddEdge(vertex_descriptor from, vertex_descriptor to)
+  {
+    if (IsGrid())
+      throw std::logic_error("estar::CSpaceGraph::AddEdge() in grid mode");
+    m_nbor[from].push_back(to);
+    if (from != to)
+      m_nbor[to].push_back(from);
+  }
+
+
+  void CSpaceGraph::
+  InitGrid(neighborhood_t const & neighborhood)
+  {
+    if (0 != m_nvertices)
+      throw std::logic_error("estar::CSpaceGraph::InitGrid() on non-empty"
+			     " graph");
+    m_neighborhood = neighborhood;
+    m_offset.resize(neighborhood.size());
+    m_pad = 0;
+    for (size_t ii(0); ii < neighborhood.size(); ++ii) {
+      m_pad = std::max(m_pad, std::max(neighborhood[ii].first,
+				       -neighborhood[ii].first));
+      m_pad = std::max(m_pad, std::max(neighborhood[ii].second,
+				       -neighborhood[ii].second));
+    }
+    m_cell.clear();
+    m_cellpos.clear();
+    m_x0 = 0;
+    m_y0 = 0;
+    m_xsize = 0;
+    m_ysize = 0;
+    m_rolling = false;
+    m_tiled = false;
+    m_tile_cell.clear();
+    m_tile_base.clear();
+    m_tile_origin.clear();
+    m_tile_index.clear();
+  }
+
+
+  void CSpaceGraph::
+  ReserveGrid(ssize_t xbegin, ssize_t xend, ssize_t ybegin, ssize_t yend)
+  {
+    if (m_rolling || m_tiled)
+      return;
+    if ((xbegin < xend) && (ybegin < yend))
+      GrowGrid(xbegin, xend, ybegin, yend, true);
+    m_cellpos.reserve(m_nvertices + (xend - xbegin) * (yend - ybegin));
+  }
+
+
+  CSpaceGraph::vertex_descriptor CSpaceGraph::
+  AddGridVertex(ssize_t ix, ssize_t iy)
+  {
+    if ( ! IsGrid())
+      throw std::logic_error("estar::CSpaceGraph::AddGridVertex() not in"
+			     " grid mode");
+    if (m_tiled)
+      throw std::logic_error("estar::CSpaceGraph::AddGridVertex() in tiled"
+			     " mode");
+    if (m_rolling) {
+      if (null_vertex == FindGridVertex(ix, iy)) {
+	m_cellpos.push_back(0);
+	AttachGridVertex(m_nvertices, ix, iy);
+	return m_nvertices++;
+      }
+      throw std::logic_error("estar::CSpaceGraph::AddGridVertex() cell"
+			     " already occupied");
+    }
+    GrowGrid(ix, ix + 1, iy, iy + 1, false);
+    size_t const pos((ix - m_x0) * m_ysize + iy - m_y0);
+    if (null_vertex != m_cell[pos])
+      throw std::logic_error("estar::CSpaceGraph::AddGridVertex() cell"
+			     " already occupied");
+    m_cell[pos] = m_nvertices;
+    m_cellpos.push_back(pos);
+    return m_nvertices++;
+  }
+
+
+  CSpaceGraph::vertex_descriptor CSpaceGraph::
+  FindGridVertex(ssize_t ix, ssize_t iy) const
+  {
+    if (m_tiled) {
+      if ((ix < m_wxbegin) || (ix >= m_wxbegin + m_wxsize)
+	  || (iy < m_wybegin) || (iy >= m_wybegin + m_wysize))
+	return null_vertex;
+      tile_index_t::const_iterator const
+	it(m_tile_index.find(TileKey(ix, iy)));
+      if (m_tile_index.end() == it)
+	return null_vertex;
+      return (it->second << (2 * m_tshift))
+	+ (((ix - m_wxbegin) & (m_tsize - 1)) << m_tshift)
+	+ ((iy - m_wybegin) & (m_tsize - 1));
+    }
+    if (m_rolling) {
+      if ((ix < m_wxbegin) || (ix >= m_wxbegin + m_wxsize)
+	  || (iy < m_wybegin) || (iy >= m_wybegin + m_wysize))
+	return null_vertex;
+      return m_cell[RollingPos(ix, iy)];
+    }
+    if ((ix < m_x0) || (ix >= m_x0 + m_xsize)
+	|| (iy < m_y0) || (iy >= m_y0 + m_ysize))
+      return null_vertex;
+    return m_cell[(ix - m_x0) * m_ysize + iy - m_y0];
+  }
+
+
+  void CSpaceGraph::
+  GrowGrid(ssize_t xbegin, ssize_t xend, ssize_t ybegin, ssize_t yend,
+	   bool exact)
+  {
+    xbegin -= m_pad;
+    xend += m_pad;
+    ybegin -= m_pad;
+    yend += m_pad;
+    ssize_t x0(xbegin);
+    ssize_t x1(xend);
+    ssize_t y0(ybegin);
+    ssize_t y1(yend);
+    if ( ! m_cell.empty()) {
+      if ((xbegin >= m_x0) && (xend <= m_x0 + m_xsize)
+	  && (ybegin >= m_y0) && (yend <= m_y0 + m_ysize))
+	return;
+      ssize_t const xslack(exact ? 0 : m_xsize / 2);
+      ssize_t const yslack(exact ? 0 : m_ysize / 2);
+      x0 = (xbegin < m_x0) ? std::min(xbegin, m_x0 - xslack) : m_x0;
+      x1 = (xend > m_x0 + m_xsize)
+	? std::max(xend, m_x0 + m_xsize + xslack) : m_x0 + m_xsize;
+      y0 = (ybegin < m_y0) ? std::min(ybegin, m_y0 - yslack) : m_y0;
+      y1 = (yend > m_y0 + m_ysize)
+	? std::max(yend, m_y0 + m_ysize + yslack) : m_y0 + m_ysize;
+    }
+    PVDEBUG("[%ld, %ld[ x [%ld, %ld[\n", x0, x1, y0, y1);
+
+    std::vector<vertex_descriptor> cell((x1 - x0) * (y1 - y0), null_vertex);
+    for (vertex_descriptor vv(0); vv < m_nvertices; ++vv) {
+      size_t const oldpos(m_cellpos[vv]);
+      ssize_t const ix(m_x0 + static_cast<ssize_t>(oldpos) / m_ysize);
+      ssize_t const iy(m_y0 + static_cast<ssize_t>(oldpos) % m_ysize);
+      size_t const pos((ix - x0) * (y1 - y0) + iy - y0);
+      cell[pos] = vv;
+      m_cellpos[vv] = pos;
+    }
+    m_cell.swap(cell);
+    m_x0 = x0;
+    m_y0 = y0;
+    m_xsize = x1 - x0;
+    m_ysize = y1 - y0;
+
+    for (size_t ii(0); ii < m_neighborhood.size(); ++ii)
+      m_offset[ii] = m_neighborhood[ii].first * m_ysize
+	+ m_neighborhood[ii].second;
+  }
+
+
+
+  void CSpaceGraph::
+  InitRollingGrid(ssize_t xbegin, ssize_t xsize,
+		  ssize_t ybegin, ssize_t ysize)
+  {
+    if ( ! IsGrid())
+      throw std::logic_error("estar::CSpaceGraph::InitRollingGrid() not in"
+			     " grid mode");
+    if (0 != m_nvertices)
+      throw std::logic_error("estar::CSpaceGraph::InitRollingGrid() on"
+			     " non-empty graph");
+    if ((xsize < 1) || (ysize < 1))
+      throw std::logic_error("estar::CSpaceGraph::InitRollingGrid() empty"
+			     " window");
+    m_rolling = true;
+    m_tiled = false;
+    m_wxbegin = xbegin;
+    m_wxsize = xsize;
+    m_wybegin = ybegin;
+    m_wysize = ysize;
+    // The period of the array is the window plus a gap of m_pad
+    // empty cells, and it gets mirrored m_pad cells beyond each end.
+    m_x0 = 0;
+    m_y0 = 0;
+    m_xsize = xsize + 3 * m_pad;
+    m_ysize = ysize + 3 * m_pad;
+    m_cell.assign(m_xsize * m_ysize, null_vertex);
+    for (size_t ii(0); ii < m_neighborhood.size(); ++ii)
+      m_offset[ii] = m_neighborhood[ii].first * m_ysize
+	+ m_neighborhood[ii].second;
+  }
+
+
+  void CSpaceGraph::
+  SetGridWindow(ssize_t xbegin, ssize_t ybegin)
+  {
+    if ( ! m_rolling)
+      throw std::logic_error("estar::CSpaceGraph::SetGridWindow() not in"
+			     " rolling mode");
+    m_wxbegin = xbegin;
+    m_wybegin = ybegin;
+  }
+
+
+  void CSpaceGraph::
+  DetachGridVertex(vertex_descriptor vertex)
+  {
+    if ( ! m_rolling)
+      throw std::logic_error("estar::CSpaceGraph::DetachGridVertex() not in"
+			     " rolling mode");
+    if (vertex == m_cell[m_cellpos[vertex]])
+      SetRollingCell(m_cellpos[vertex], null_vertex);
+  }
+
+
+  void CSpaceGraph::
+  AttachGridVertex(vertex_descriptor vertex, ssize_t ix, ssize_t iy)
+  {
+    if ( ! m_rolling)
+      throw std::logic_error("estar::CSpaceGraph::AttachGridVertex() not in"
+			     " rolling mode");
+    if ((ix < m_wxbegin) || (ix >= m_wxbegin + m_wxsize)
+	|| (iy < m_wybegin) || (iy >= m_wybegin + m_wysize))
+      throw std::logic_error("estar::CSpaceGraph::AttachGridVertex() cell"
+			     " outside of window");
+    size_t const pos(RollingPos(ix, iy));
+    if (null_vertex != m_cell[pos])
+      throw std::logic_error("estar::CSpaceGraph::AttachGridVertex() cell"
+			     " already occupied");
+    SetRollingCell(pos, vertex);
+    m_cellpos[vertex] = pos;
+  }
+
+
+  size_t CSpaceGraph::
+  RollingPos(ssize_t ix, ssize_t iy) const
+  {
+    ssize_t const xperiod(m_xsize - 2 * m_pad);
+    ssize_t const yperiod(m_ysize - 2 * m_pad);
+    ssize_t px(ix % xperiod);
+    if (px < 0)
+      px += xperiod;
+    ssize_t py(iy % yperiod);
+    if (py < 0)
+      py += yperiod;
+    return (px + m_pad) * m_ysize + py + m_pad;
+  }
+
+
+  void CSpaceGraph::
+  SetRollingCell(size_t pos, vertex_descriptor vertex)
+  {
+    ssize_t const xperiod(m_xsize - 2 * m_pad);
+    ssize_t const yperiod(m_ysize - 2 * m_pad);
+    ssize_t const px(static_cast<ssize_t>(pos) / m_ysize);
+    ssize_t const py(static_cast<ssize_t>(pos) % m_ysize);
+    for (ssize_t mx(px % xperiod); mx < m_xsize; mx += xperiod)
+      for (ssize_t my(py % yperiod); my < m_ysize; my += yperiod)
+	m_cell[mx * m_ysize + my] = vertex;
+  }
+
+
+
+  void CSpaceGraph::
+  InitTiledGrid(ssize_t xbegin, ssize_t xsize,
+		ssize_t ybegin, ssize_t ysize,
+		ssize_t tilesize)
+  {
+    if ( ! IsGrid())
+      throw std::logic_error("estar::CSpaceGraph::InitTiledGrid() not in"
+			     " grid mode");
+    if (0 != m_nvertices)
+      throw std::logic_error("estar::CSpaceGraph::InitTiledGrid() on"
+			     " non-empty graph");
+    if ((xsize < 1) || (ysize < 1))
+      throw std::logic_error("estar::CSpaceGraph::InitTiledGrid() empty"
+			     " range");
+    if ((tilesize < 1) || (tilesize < m_pad)
+	|| (0 != (tilesize & (tilesize - 1))))
+      throw std::logic_error("estar::CSpaceGraph::InitTiledGrid() invalid"
+			     " tile size");
+    m_tiled = true;
+    m_rolling = false;
+    m_wxbegin = xbegin;
+    m_wxsize = xsize;
+    m_wybegin = ybegin;
+    m_wysize = ysize;
+    m_tsize = tilesize;
+    for (m_tshift = 0; (ssize_t(1) << m_tshift) < tilesize; ++m_tshift)
+      /* nop */;
+    m_tstride = tilesize + 2 * m_pad;
+    m_tile_cell.clear();
+    m_tile_base.clear();
+    m_tile_origin.clear();
+    m_tile_index.clear();
+    for (size_t ii(0); ii < m_neighborhood.size(); ++ii)
+      m_offset[ii] = m_neighborhood[ii].first * m_tstride
+	+ m_neighborhood[ii].second;
+  }
+
+
+  CSpaceGraph::vertex_descriptor CSpaceGraph::
+  AddGridTile(ssize_t ix, ssize_t iy)
+  {
+    if ( ! m_tiled)
+      throw std::logic_error("estar::CSpaceGraph::AddGridTile() not in"
+			     " tiled mode");
+    if ((ix < m_wxbegin) || (ix >= m_wxbegin + m_wxsize)
+	|| (iy < m_wybegin) || (iy >= m_wybegin + m_wysize))
+      throw std::logic_error("estar::CSpaceGraph::AddGridTile() cell"
+			     " outside of range");
+    tile_key_t const key(TileKey(ix, iy));
+    if (m_tile_index.end() != m_tile_index.find(key))
+      throw std::logic_error("estar::CSpaceGraph::AddGridTile() tile"
+			     " already exists");
+    size_t const tile(m_tile_origin.size());
+    ssize_t const x0(m_wxbegin + (key.first << m_tshift));
+    ssize_t const y0(m_wybegin + (key.second << m_tshift));
+    m_tile_cell.push_back(nbor_list_t(m_tstride * m_tstride, null_vertex));
+    m_tile_base.push_back(&m_tile_cell.back()[0]);
+    m_tile_origin.push_back(offset_t(x0, y0));
+    m_tile_index.insert(std::make_pair(key, tile));
+    
+    vertex_descriptor const first(m_nvertices);
+    ssize_t const xsize(std::min(m_tsize, m_wxbegin + m_wxsize - x0));
+    ssize_t const ysize(std::min(m_tsize, m_wybegin + m_wysize - y0));
+    vertex_descriptor * const base(m_tile_base[tile]);
+    for (ssize_t jx(0); jx < xsize; ++jx)
+      for (ssize_t jy(0); jy < ysize; ++jy)
+	base[(jx + m_pad) * m_tstride + jy + m_pad]
+	  = first + (jx << m_tshift) + jy;
+    
+    for (ssize_t dx(-1); dx <= 1; ++dx)
+      for (ssize_t dy(-1); dy <= 1; ++dy) {
+	if ((0 == dx) && (0 == dy))
+	  continue;
+	tile_index_t::const_iterator const
+	  it(m_tile_index.find(tile_key_t(key.first + dx, key.second + dy)));
+	if (m_tile_index.end() == it)
+	  continue;
+	CopyTileCells(tile, it->second);
+	CopyTileCells(it->second, tile);
+      }
+    
+    m_nvertices += m_tsize * m_tsize;
+    return first;
+  }
+
+
+  bool CSpaceGraph::
+  HaveGridTile(ssize_t ix, ssize_t iy) const
+  {
+    if (( ! m_tiled)
+	|| (ix < m_wxbegin) || (ix >= m_wxbegin + m_wxsize)
+	|| (iy < m_wybegin) || (iy >= m_wybegin + m_wysize))
+      return false;
+    return m_tile_index.end() != m_tile_index.find(TileKey(ix, iy));
+  }
+
+
+  void CSpaceGraph::
+  GetGridTile(size_t tile, ssize_t & x0, ssize_t & y0) const
+  {
+    x0 = m_tile_origin[tile].first;
+    y0 = m_tile_origin[tile].second;
+  }
+
+
+  void CSpaceGraph::
+  Renumber(std::vector<vertex_descriptor> const & newid)
+  {
+    if (newid.size() != m_nvertices)
+      throw std::logic_error("estar::CSpaceGraph::Renumber() wrong number"
+			     " of vertices");
+    if (m_tiled)
+      throw std::logic_error("estar::CSpaceGraph::Renumber() in tiled"
+			     " mode");
+    if (IsGrid()) {
+      // This includes the mirrored cells of rolling grids.
+      for (size_t ii(0); ii < m_cell.size(); ++ii)
+	if (null_vertex != m_cell[ii])
+	  m_cell[ii] = newid[m_cell[ii]];
+      std::vector<size_t> cellpos(m_cellpos.size());
+      for (size_t ii(0); ii < m_cellpos.size(); ++ii)
+	cellpos[newid[ii]] = m_cellpos[ii];
+      m_cellpos.swap(cellpos);
+      return;
+    }
+    std::vector<nbor_list_t> nbor(m_nbor.size());
+    for (size_t ii(0); ii < m_nbor.size(); ++ii) {
+      nbor_list_t & nn(nbor[newid[ii]]);
+      nn.swap(m_nbor[ii]);
+      for (size_t jj(0); jj < nn.size(); ++jj)
+	nn[jj] = newid[nn[jj]];
+    }
+    m_nbor.swap(nbor);
+  }
+
+
+  void CSpaceGraph::
+  CopyTileCells(size_t to, size_t from)
+  {
+    offset_t const & ot(m_tile_origin[to]);
+    offset_t const & of(m_tile_origin[from]);
+    ssize_t const xbegin(std::max(ot.first - m_pad, of.first));
+    ssize_t const xend(std::min(ot.first + m_tsize + m_pad,
+				of.first + m_tsize));
+    ssize_t const ybegin(std::max(ot.second - m_pad, of.second));
+    ssize_t const yend(std::min(ot.second + m_tsize + m_pad,
+				of.second + m_tsize));
+    vertex_descriptor * const tbase(m_tile_base[to]);
+    vertex_descriptor const * const fbase(m_tile_base[from]);
+    for (ssize_t ix(xbegin); ix < xend; ++ix)
+      for (ssize_t iy(ybegin); iy < yend; ++iy)
+	tbase[(ix - ot.first + m_pad) * m_tstride + iy - ot.second + m_pad]
+	  = fbase[(ix - of.first + m_pad) * m_tstride + iy - of.second + m_pad];
+  }
+
+} // namespace estar
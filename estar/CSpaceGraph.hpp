@@ -0,0 +1,386 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+#ifndef ESTAR_CSPACE_GRAPH_HPP
+#define ESTAR_CSPACE_GRAPH_HPP
+
+
+#include <boost/iterator/counting_iterator.hpp>
+#include <vector>
+#include <deque>
+#include <map>
+#include <iterator>
+#include <utility>
+#include <cstddef>
+
+#ifdef WIN32
+# include <estar/win32.hpp>
+#else
+# include <sys/types.h>
+#endif // WIN32
+
+
+namespace estar {
+
+
+  /**
+     Topology of the C-space, i.e. which vertices exist and which of
+     them are neighbors. This used to be a boost::adjacency_list, and
+     the free functions below provide the subset of the Boost Graph
+     Library interface that we rely on (vertices(),
+     adjacent_vertices(), num_vertices(), add_vertex(), and
+     add_edge()).
+
+     There are two modes of operation:
+
+     - Explicit: vertices are created with add_vertex() and linked
+       with add_edge(). Each vertex stores its own list of neighbors,
+       in the order in which the edges were added. This is what
+       BaseCSpace::AddNeighbor() uses.
+
+     - Implicit grid: after InitGrid(), vertices are created with
+       AddGridVertex() at integer indices (ix, iy), and the neighbors
+       are derived from a fixed set of index offsets. All we store is
+       a padded array that maps cells to vertices, plus the position
+       of each vertex in that array. There are no per-edge or
+       per-vertex heap objects, and a neighbor lookup is a single
+       indexed load.
+
+     An implicit grid can also be rolling (see InitRollingGrid()):
+     the cell array then has a fixed size and wraps around like a
+     torus, such that only a window of cells can be occupied at a
+     time. Moving the window re-indexes the array instead of copying
+     it, and vertices that drop out of the window are recycled for
+     the cells that enter it (see DetachGridVertex() and
+     AttachGridVertex()).
+
+     An implicit grid can be tiled instead (see InitTiledGrid()):
+     the cells are then grouped into square tiles that get created
+     as a whole with AddGridTile(), each with its own small cell
+     array whose padding duplicates the border cells of the
+     neighboring tiles. The vertices of a tile are numbered
+     consecutively, so their properties are contiguous as well, and
+     memory only grows with the number of tiles that are actually
+     used.
+
+     In all modes, the adjacency_iterator knows the "slot" of each
+     neighbor: its position in the explicit neighbor list, or the
+     index of its offset in the grid neighborhood. Slots are stable,
+     they do not change when vertices or edges are added, which is
+     what Upwind relies on.
+  */
+  class CSpaceGraph
+  {
+  public:
+    typedef size_t vertex_descriptor;
+    typedef boost::counting_iterator<vertex_descriptor> vertex_iterator;
+
+    /** Grid index offset (dx, dy) of a neighbor. */
+    typedef std::pair<ssize_t, ssize_t> offset_t;
+    typedef std::vector<offset_t> neighborhood_t;
+
+    static vertex_descriptor const null_vertex
+    = static_cast<vertex_descriptor>(-1);
+
+    class adjacency_iterator
+    {
+    public:
+      typedef std::forward_iterator_tag iterator_category;
+      typedef vertex_descriptor value_type;
+      typedef std::ptrdiff_t difference_type;
+      typedef vertex_descriptor const * pointer;
+      typedef vertex_descriptor reference;
+
+      adjacency_iterator()
+	: m_cell(0), m_offset(0), m_slot(0), m_nslots(0) {}
+
+      /** If offset is non-zero, the neighbor in a given slot is
+	  cell[offset[slot]], otherwise it is cell[slot]. Empty grid
+	  cells (null_vertex) are skipped. */
+      adjacency_iterator(vertex_descriptor const * cell,
+			 ssize_t const * offset,
+			 size_t slot, size_t nslots)
+	: m_cell(cell), m_offset(offset), m_slot(slot), m_nslots(nslots)
+      { Skip(); }
+
+      vertex_descriptor operator * () const
+      { return m_offset ? m_cell[m_offset[m_slot]] : m_cell[m_slot]; }
+
+      adjacency_iterator & operator ++ ()
+      { ++m_slot; Skip(); return *this; }
+
+      adjacency_iterator operator ++ (int)
+      { adjacency_iterator tmp(*this); ++(*this); return tmp; }
+
+      bool operator == (adjacency_iterator const & rhs) const
+      { return (m_slot == rhs.m_slot) && (m_cell == rhs.m_cell); }
+
+      bool operator != (adjacency_iterator const & rhs) const
+      { return ! (*this == rhs); }
+
+      /** \return The stable slot index of the current neighbor. */
+      size_t GetSlot() const { return m_slot; }
+
+    private:
+      void Skip() {
+	if (m_offset)
+	  while ((m_slot < m_nslots) && (null_vertex == m_cell[m_offset[m_slot]]))
+	    ++m_slot;
+      }
+
+      vertex_descriptor const * m_cell;
+      ssize_t const * m_offset;
+      size_t m_slot;
+      size_t m_nslots;
+    };
+
+    CSpaceGraph();
+
+    size_t GetNVertices() const { return m_nvertices; }
+
+    std::pair<adjacency_iterator, adjacency_iterator>
+    GetNeighbors(vertex_descriptor vertex) const;
+
+    /** Create a vertex without neighbors. Throws std::logic_error in
+	implicit grid mode. */
+    vertex_descriptor AddVertex();
+
+    /** Append an undirected edge to the neighbor lists of both
+	vertices. Throws std::logic_error in implicit grid mode, where
+	the edges are implied by the neighborhood. */
+    void AddEdge(vertex_descriptor from, vertex_descriptor to);
+
+    /**
+       Switch to implicit grid mode. The order of the offsets
+       determines the order (and the slots) of the neighbors. Throws
+       std::logic_error if vertices have already been added.
+    */
+    void InitGrid(neighborhood_t const & neighborhood);
+
+    bool IsGrid() const { return ! m_neighborhood.empty(); }
+
+    /** Make sure that cells in the given range can be added without
+	reallocation. The ends are one past the last index. */
+    void ReserveGrid(ssize_t xbegin, ssize_t xend,
+		     ssize_t ybegin, ssize_t yend);
+
+    /** Create a vertex at (ix, iy), growing the cell array if
+	required. Throws std::logic_error if not in grid mode, if the
+	cell is already occupied, or in tiled mode (where vertices
+	are created with AddGridTile()). */
+    vertex_descriptor AddGridVertex(ssize_t ix, ssize_t iy);
+
+    /** \return The vertex at (ix, iy), or null_vertex if there is
+	none. */
+    vertex_descriptor FindGridVertex(ssize_t ix, ssize_t iy) const;
+
+    /**
+       Switch an empty implicit grid to rolling mode, with a window of
+       xsize times ysize cells starting at (xbegin, ybegin). The cell
+       array is allocated once and addressed modulo its dimensions,
+       with a gap of empty cells between the two ends of the window
+       (so that cells on opposite borders do not become neighbors)
+       and mirrored padding around the whole array (so that the usual
+       offsets work across its seams). Throws std::logic_error if not
+       in grid mode or if vertices have already been added.
+    */
+    void InitRollingGrid(ssize_t xbegin, ssize_t xsize,
+			 ssize_t ybegin, ssize_t ysize);
+
+    bool IsRollingGrid() const { return m_rolling; }
+
+    /**
+       Move the window of a rolling grid to start at (xbegin,
+       ybegin). All vertices that lie outside the new window must
+       have been detached beforehand. Throws std::logic_error if not
+       in rolling mode.
+    */
+    void SetGridWindow(ssize_t xbegin, ssize_t ybegin);
+
+    /**
+       Empty the cell of a vertex in a rolling grid. The vertex keeps
+       its ID, but must not be used (its neighbors are undefined)
+       until it gets attached to another cell with
+       AttachGridVertex(). Throws std::logic_error if not in rolling
+       mode.
+    */
+    void DetachGridVertex(vertex_descriptor vertex);
+
+    /**
+       Put a detached vertex into the (empty) cell at (ix, iy) of a
+       rolling grid. Throws std::logic_error if not in rolling mode,
+       or if the cell lies outside the window or is already
+       occupied.
+    */
+    void AttachGridVertex(vertex_descriptor vertex, ssize_t ix, ssize_t iy);
+
+    /**
+       Switch an empty implicit grid to tiled mode. Only cells within
+       [xbegin, xbegin+xsize[ x [ybegin, ybegin+ysize[ can be
+       occupied, and they are grouped into tiles of tilesize times
+       tilesize cells starting at (xbegin, ybegin). Throws
+       std::logic_error if not in grid mode, if vertices have already
+       been added, or if tilesize is not a power of two or smaller
+       than the largest neighbor offset.
+    */
+    void InitTiledGrid(ssize_t xbegin, ssize_t xsize,
+		       ssize_t ybegin, ssize_t ysize,
+		       ssize_t tilesize);
+
+    bool IsTiledGrid() const { return m_tiled; }
+
+    /** \return The tile size, or zero if not in tiled mode. */
+    ssize_t GetGridTileSize() const { return m_tiled ? m_tsize : 0; }
+
+    /**
+       Create the tile that contains the cell (ix, iy) and link it
+       to the existing neighboring tiles. It gets tilesize^2
+       consecutive vertices, starting at the returned one, with the
+       vertex of cell (x0+jx, y0+jy) at offset jx*tilesize+jy (see
+       GetGridTile() for x0 and y0). Vertices of cells that lie
+       beyond the end of the range given to InitTiledGrid() exist,
+       but they do not occupy any cell and thus have no neighbors.
+       Throws std::logic_error if not in tiled mode, if (ix, iy) lies
+       outside the range, or if the tile exists already.
+    */
+    vertex_descriptor AddGridTile(ssize_t ix, ssize_t iy);
+
+    /** \return true if the tile containing (ix, iy) has been
+	created. */
+    bool HaveGridTile(ssize_t ix, ssize_t iy) const;
+
+    /** \return The number of tiles created with AddGridTile(). */
+    size_t GetNGridTiles() const { return m_tile_origin.size(); }
+
+    /** Retrieve the index (x0, y0) of the lower left cell of a tile,
+	in order of creation. */
+    void GetGridTile(size_t tile, ssize_t & x0, ssize_t & y0) const;
+
+    /**
+       Give each vertex the new ID newid[vertex], which must be a
+       permutation of all vertices. Neighbors keep their slots. In
+       grid mode this only rewrites the cell array, the cells
+       themselves do not move. Throws std::logic_error if newid has
+       the wrong size, or in tiled mode, where the vertex IDs are
+       implied by the tiles.
+    */
+    void Renumber(std::vector<vertex_descriptor> const & newid);
+
+    /** \return The offsets that were given to InitGrid(). */
+    neighborhood_t const & GetNeighborhood() const
+    { return m_neighborhood; }
+
+  private:
+    typedef std::vector<vertex_descriptor> nbor_list_t;
+    typedef std::pair<ssize_t, ssize_t> tile_key_t;
+    typedef std::map<tile_key_t, size_t> tile_index_t;
+
+    /** Make the cell array cover the given range plus padding. Unless
+	exact is true, growing sides get extra room proportional to
+	the current size, so that adding cells one by one has
+	amortized constant cost. */
+    void GrowGrid(ssize_t xbegin, ssize_t xend,
+		  ssize_t ybegin, ssize_t yend, bool exact);
+
+    size_t m_nvertices;
+
+    // explicit mode
+    std::vector<nbor_list_t> m_nbor;
+
+    // implicit grid mode
+    neighborhood_t m_neighborhood;
+    /** cell array position offsets, one per slot */
+    std::vector<ssize_t> m_offset;
+    /** cell array, X-major with m_pad cells of padding on each side */
+    std::vector<vertex_descriptor> m_cell;
+    /** position of each vertex in the cell array */
+    std::vector<size_t> m_cellpos;
+    /** largest absolute offset, i.e. required padding */
+    ssize_t m_pad;
+    /** index of the first (padding) cell */
+    ssize_t m_x0, m_y0;
+    /** dimensions of the cell array, including padding */
+    ssize_t m_xsize, m_ysize;
+
+    // rolling grid mode
+    bool m_rolling;
+    /** window of cells that can be occupied (also in tiled mode) */
+    ssize_t m_wxbegin, m_wxsize, m_wybegin, m_wysize;
+
+    // tiled grid mode
+    bool m_tiled;
+    /** tile size, its base two logarithm, and the size of the
+	padded tile cell array along each axis */
+    ssize_t m_tsize, m_tshift, m_tstride;
+    /** padded cell array of each tile, never reallocated */
+    std::deque<nbor_list_t> m_tile_cell;
+    /** first element of each tile cell array */
+    std::vector<vertex_descriptor *> m_tile_base;
+    /** lower left cell of each tile */
+    std::vector<offset_t> m_tile_origin;
+    /** tile index by tile coordinates */
+    tile_index_t m_tile_index;
+
+    /** \return The tile coordinates of (ix, iy), which must lie in
+	the window. */
+    tile_key_t TileKey(ssize_t ix, ssize_t iy) const
+    { return tile_key_t((ix - m_wxbegin) >> m_tshift,
+			(iy - m_wybegin) >> m_tshift); }
+
+    /** Copy the cells of tile "from" into the padding of tile "to",
+	where they overlap. */
+    void CopyTileCells(size_t to, size_t from);
+
+    /** \return The position of (ix, iy) in the rolling cell array,
+	inside the mirrored padding. */
+    size_t RollingPos(ssize_t ix, ssize_t iy) const;
+
+    /** Write a cell of the rolling array and its mirror images. */
+    void SetRollingCell(size_t pos, vertex_descriptor vertex);
+  };
+
+
+  inline std::pair<CSpaceGraph::vertex_iterator, CSpaceGraph::vertex_iterator>
+  vertices(CSpaceGraph const & graph)
+  {
+    return std::make_pair(CSpaceGraph::vertex_iterator(0),
+			  CSpaceGraph::vertex_iterator(graph.GetNVertices()));
+  }
+
+  inline size_t num_vertices(CSpaceGraph const & graph)
+  { return graph.GetNVertices(); }
+
+  inline std::pair<CSpaceGraph::adjacency_iterator,
+		   CSpaceGraph::adjacency_iterator>
+  adjacent_vertices(CSpaceGraph::vertex_descriptor vertex,
+		    CSpaceGraph const & graph)
+  { return graph.GetNeighbors(vertex); }
+
+  inline CSpaceGraph::vertex_descriptor add_vertex(CSpaceGraph & graph)
+  { return graph.AddVertex(); }
+
+  inline void add_edge(CSpaceGraph::vertex_descriptor from,
+		       CSpaceGraph::vertex_descriptor to,
+		       CSpaceGraph & graph)
+  { graph.AddEdge(from, to); }
+
+} // namespace estar
+
+#endif // ESTAR_CSPACE_GRAPH_HPP
@@ -25,8 +25,14 @@
 #include "LSMKernel.hpp"
 #include "dump.hpp"
 #include "Region.hpp"
+#include "Heuristic.hpp"
+#include "TiledAlgorithm.hpp"
+#include "FastSweepSolver.hpp"
+#include "TileStore.hpp"
 #include "pdebug.hpp"
 #include "CSpace.hpp"
+#include "numeric.hpp"
+#include "util.hpp"
 
 #include <iostream>		// rfct
 
@@ -41,12 +47,18 @@ namespace estar {
   GridOptions::
   GridOptions(ssize_t _xbegin, ssize_t _xend,
 	      ssize_t _ybegin, ssize_t _yend,
-	      Grid::neighborhood_t _neighborhood)
+	      Grid::neighborhood_t _neighborhood,
+	      bool _rolling,
+	      ssize_t _tile_size,
+	      Grid::vertex_order_t _vertex_order)
     : xbegin(_xbegin),
       xend(_xend),
       ybegin(_ybegin),
       yend(_yend),
-      neighborhood(_neighborhood)
+      neighborhood(_neighborhood),
+      rolling(_rolling),
+      tile_size(_tile_size),
+      vertex_order(_vertex_order)
   {
   }
   
@@ -57,7 +69,9 @@ namespace estar {
       check_local_consistency(false),
       check_queue_key(false),
       auto_reset(false),
-      auto_flush(false)
+      auto_flush(false),
+      queue_backend(Queue::FOUR_HEAP),
+      bucket_width(1)
   {
   }
   
@@ -67,16 +81,37 @@ namespace estar {
 		   bool _check_local_consistency,
 		   bool _check_queue_key,
 		   bool _auto_reset,
-		   bool _auto_flush)
+		   bool _auto_flush,
+		   Queue::backend_t _queue_backend,
+		   double _bucket_width)
     : check_upwind(_check_upwind),
       check_local_consistency(_check_local_consistency),
       check_queue_key(_check_queue_key),
       auto_reset(_auto_reset),
-      auto_flush(_auto_flush)
+      auto_flush(_auto_flush),
+      queue_backend(_queue_backend),
+      bucket_width(_bucket_width)
   {
   }
   
   
+  /** Creates the tiles next to each lowered vertex. */
+  struct tile_expansion_hook
+    : public lower_hook
+  {
+    tile_expansion_hook(Grid & _grid, Algorithm & _algo,
+			Kernel const & _kernel)
+      : grid(_grid), algo(_algo), kernel(_kernel) {}
+    
+    virtual void operator () (vertex_t vertex)
+    { grid.ExpandTiles(vertex, algo, kernel); }
+    
+    Grid & grid;
+    Algorithm & algo;
+    Kernel const & kernel;
+  };
+  
+  
   Facade::
   Facade(shared_ptr<Algorithm> algo,
 	 shared_ptr<Grid> grid,
@@ -87,6 +122,20 @@ namespace estar {
       m_grid(grid),
       m_kernel(kernel)
   {
+    if (grid->IsTiled()) {
+      m_tile_hook.reset(new tile_expansion_hook(*grid, *algo, *kernel));
+      algo->SetLowerHook(m_tile_hook.get());
+    }
+  }
+  
+  
+  Facade::
+  ~Facade()
+  {
+    if (m_tile_hook)
+      m_algo->SetLowerHook(0);
+    if (m_tile_store)
+      m_grid->SetTileSource(0);
   }
   
   
@@ -114,20 +163,20 @@ namespace estar {
       return 0;
     }
     
-    shared_ptr<Grid>
-      grid(new Grid(grid_options.xbegin,
-		    grid_options.xend,
-		    grid_options.ybegin,
-		    grid_options.yend,
-		    grid_options.neighborhood,
-		    init_meta));
-    shared_ptr<Algorithm>
-      algo(new Algorithm(grid->GetCSpace(),
-			 algo_options.check_upwind,
-			 algo_options.check_local_consistency,
-			 algo_options.check_queue_key,
-			 algo_options.auto_reset,
-			 algo_options.auto_flush));
+    shared_ptr<Grid> grid(new Grid(grid_options.neighborhood));
+    grid->SetVertexOrder(grid_options.vertex_order);
+    if (grid_options.rolling)
+      grid->InitRolling(grid_options.xbegin, grid_options.xend,
+			grid_options.ybegin, grid_options.yend,
+			init_meta);
+    else if (0 != grid_options.tile_size)
+      grid->InitTiled(grid_options.xbegin, grid_options.xend,
+		      grid_options.ybegin, grid_options.yend,
+		      grid_options.tile_size, init_meta);
+    else
+      grid->Init(grid_options.xbegin, grid_options.xend,
+		 grid_options.ybegin, grid_options.yend,
+		 init_meta);
     shared_ptr<Kernel> kernel;
     if (kernel_name == "nf1")
       kernel.reset(new NF1Kernel());
@@ -144,6 +193,18 @@ namespace estar {
 		__FUNCTION__, kernel_name.c_str());
       return 0;
     }
+    double const bucket_width(algo_options.bucket_width > 0
+			      ? algo_options.bucket_width
+			      : kernel->scale);
+    shared_ptr<Algorithm>
+      algo(new Algorithm(grid->GetCSpace(),
+			 algo_options.check_upwind,
+			 algo_options.check_local_consistency,
+			 algo_options.check_queue_key,
+			 algo_options.auto_reset,
+			 algo_options.auto_flush,
+			 algo_options.queue_backend,
+			 bucket_width));
     
     return new Facade(algo, grid, kernel);
   }
@@ -169,7 +230,9 @@ namespace estar {
 			 algo_options.check_local_consistency,
 			 algo_options.check_queue_key,
 			 algo_options.auto_reset,
-			 algo_options.auto_flush));
+			 algo_options.auto_flush,
+			 algo_options.queue_backend,
+			 scale));
     shared_ptr<Kernel>
       kernel(new LSMKernel(grid->GetCSpace(), scale));
     return new Facade(algo, grid, kernel);
@@ -208,27 +271,51 @@ namespace estar {
     const
   {
     shared_ptr<GridNode const> node(m_grid->GetNode(ix, iy));
-    if ( ! node)
-      return m_kernel->obstacle_meta;
-    return m_cspace->GetMeta(node->vertex);
+    if (node)
+      return m_cspace->GetMeta(node->vertex);
+    if (m_grid->IsTiled()
+	&& (ix >= m_grid->GetXBegin()) && (ix < m_grid->GetXEnd())
+	&& (iy >= m_grid->GetYBegin()) && (iy < m_grid->GetYEnd()))
+      return m_grid->GetTileMeta(ix, iy);
+    return m_kernel->obstacle_meta;
   }
   
   
   bool Facade::
   SetMeta(ssize_t ix, ssize_t iy, double meta)
   {
+    if (m_tile_store && m_tile_store->IsWritable()
+	&& m_tile_store->IsValidIndex(ix, iy))
+      m_tile_store->SetMeta(ix, iy, meta);
     shared_ptr<GridNode const> node(m_grid->GetNode(ix, iy));
-    if ( ! node)
+    if ( ! node) {
+      if (m_grid->IsTiled())
+	return m_grid->AddNode(ix, iy, meta, *m_algo, *m_kernel);
       return false;		// automatic growing strategy?
+    }
     m_algo->SetMeta(node->vertex, meta, *(m_kernel));
     return true;
   }
   
   
+  void Facade::
+  BeginMetaBatch()
+  {
+    m_algo->BeginMetaBatch();
+  }
+  
+  
+  size_t Facade::
+  CommitMetaBatch()
+  {
+    return m_algo->CommitMetaBatch(*m_kernel);
+  }
+  
+  
   bool Facade::
   AddGoal(ssize_t ix, ssize_t iy, double value)
   {
-    shared_ptr<GridNode const> node(m_grid->GetNode(ix, iy));
+    shared_ptr<GridNode const> node(TouchNode(ix, iy));
     if ( ! node)
       return false;		// automatic growing strategy?
     m_algo->AddGoal(node->vertex, value);
@@ -277,6 +364,33 @@ namespace estar {
   }
   
   
+  bool Facade::
+  MoveGoal(ssize_t ix, ssize_t iy, double value)
+  {
+    shared_ptr<GridNode const> node(TouchNode(ix, iy));
+    if ( ! node)
+      return false;
+    Algorithm::goalmap_t goal;
+    goal.insert(make_pair(node->vertex, value));
+    m_algo->ReplaceGoals(goal);
+    return true;
+  }
+  
+  
+  void Facade::
+  ReplaceGoals(const Region & goal)
+  {
+    Algorithm::goalmap_t goalmap;
+    for (Region::indexlist_t::const_iterator in(goal.GetArea().begin());
+	 in != goal.GetArea().end(); ++in) {
+      shared_ptr<GridNode const> node(m_grid->GetNode(in->x, in->y));
+      if (node && (m_cspace->GetMeta(node->vertex) != m_kernel->obstacle_meta))
+	goalmap.insert(make_pair(node->vertex, in->r));
+    }
+    m_algo->ReplaceGoals(goalmap);
+  }
+  
+  
   bool Facade::
   IsGoal(ssize_t ix, ssize_t iy)
     const
@@ -303,6 +417,188 @@ namespace estar {
   }
   
   
+  compute_progress Facade::
+  ComputeUntil(ssize_t robot_ix, ssize_t robot_iy, double budget)
+  {
+    double const deadline(get_monotonic_time() + budget);
+    shared_ptr<GridNode const> node(TouchNode(robot_ix, robot_iy));
+    if ( ! node)
+      return m_algo->ComputeUntil(*m_kernel, scale / 10000, 0, deadline);
+    return m_algo->ComputeUntil(*m_kernel, scale / 10000, &node->vertex,
+				deadline);
+  }
+  
+  
+  /** \return false if the grid has holes. */
+  static bool is_complete(Grid const & grid)
+  {
+    if ((grid.GetXEnd() <= grid.GetXBegin())
+	|| (grid.GetYEnd() <= grid.GetYBegin()))
+      return false;
+    for (ssize_t ix(grid.GetXBegin()); ix < grid.GetXEnd(); ++ix)
+      for (ssize_t iy(grid.GetYBegin()); iy < grid.GetYEnd(); ++iy)
+	if ( ! grid.GetNode(ix, iy))
+	  return false;
+    return true;
+  }
+  
+  
+  /** Copy the metas and goals into a solver like TiledAlgorithm or
+      FastSweepSolver, whose indices start at zero. */
+  template<class SolverT>
+  static void export_grid(Grid const & grid, Algorithm const & algo,
+			  SolverT & solver)
+  {
+    ssize_t const xbegin(grid.GetXBegin());
+    ssize_t const ybegin(grid.GetYBegin());
+    for (ssize_t ix(0); ix < solver.GetXSize(); ++ix)
+      for (ssize_t iy(0); iy < solver.GetYSize(); ++iy) {
+	vertex_t const vertex(grid.GetNode(ix + xbegin, iy + ybegin)->vertex);
+	solver.SetMeta(ix, iy, get(algo.GetMetaMap(), vertex));
+	if (algo.IsGoal(vertex))
+	  solver.AddGoal(ix, iy, get(algo.GetRhsMap(), vertex));
+      }
+  }
+  
+  
+  /** Replace the navigation function of the Algorithm with the
+      values and backpointers of the solver. */
+  template<class NeighborhoodT, class SolverT>
+  static void import_grid(Grid const & grid, Algorithm & algo,
+			  SolverT const & solver)
+  {
+    ssize_t const xbegin(grid.GetXBegin());
+    ssize_t const ybegin(grid.GetYBegin());
+    algo.Reset();
+    vertex_t upwind[NeighborhoodT::size];
+    for (ssize_t ix(0); ix < solver.GetXSize(); ++ix)
+      for (ssize_t iy(0); iy < solver.GetYSize(); ++iy) {
+	size_t nupwind(0);
+	typename SolverT::mask_t const mask(solver.GetUpwind(ix, iy));
+	for (size_t slot(0); slot < NeighborhoodT::size; ++slot)
+	  if (mask & (1 << slot))
+	    upwind[nupwind++] =
+	      grid.GetNode(ix + xbegin + NeighborhoodT::dx(slot),
+			   iy + ybegin + NeighborhoodT::dy(slot))->vertex;
+	algo.ImportVertex(grid.GetNode(ix + xbegin, iy + ybegin)->vertex,
+			  solver.GetValue(ix, iy), upwind, nupwind);
+      }
+  }
+  
+  
+  template<class BasicKernelT, class NeighborhoodT>
+  static bool compute_tiled(Grid const & grid, Algorithm & algo,
+			    BasicKernelT const & kernel,
+			    size_t nthreads, ssize_t tile_size, double slack)
+  {
+    if ( ! is_complete(grid))
+      return false;
+    TiledAlgorithm<BasicKernelT, NeighborhoodT>
+      tiled(grid.GetXEnd() - grid.GetXBegin(),
+	    grid.GetYEnd() - grid.GetYBegin(), kernel, tile_size);
+    export_grid(grid, algo, tiled);
+    tiled.Compute(nthreads, slack);
+    import_grid<NeighborhoodT>(grid, algo, tiled);
+    return true;
+  }
+  
+  
+  template<class BasicKernelT>
+  static bool compute_tiled(Grid const & grid, Algorithm & algo,
+			    BasicKernelT const & kernel,
+			    size_t nthreads, ssize_t tile_size, double slack)
+  {
+    switch (grid.GetNeighborhood()) {
+    case Grid::FOUR:
+      return compute_tiled<BasicKernelT, FourNeighborhood>
+	(grid, algo, kernel, nthreads, tile_size, slack);
+    case Grid::SIX:
+      return compute_tiled<BasicKernelT, SixNeighborhood>
+	(grid, algo, kernel, nthreads, tile_size, slack);
+    case Grid::EIGHT:
+      return compute_tiled<BasicKernelT, EightNeighborhood>
+	(grid, algo, kernel, nthreads, tile_size, slack);
+    }
+    return false;
+  }
+  
+  
+  bool Facade::
+  ComputeParallel(size_t nthreads, ssize_t tile_size)
+  {
+    if (m_algo->InMetaBatch())
+      m_algo->CommitMetaBatch(*m_kernel);
+    Kernel const * kernel(m_kernel.get());
+    if (dynamic_cast<LSMKernel const *>(kernel))
+      return compute_tiled(*m_grid, *m_algo, BasicLSMKernel(scale),
+			   nthreads, tile_size, scale / 10000);
+    if (dynamic_cast<NF1Kernel const *>(kernel))
+      return compute_tiled(*m_grid, *m_algo, BasicNF1Kernel(),
+			   nthreads, tile_size, scale / 10000);
+    if (dynamic_cast<AlphaKernel const *>(kernel))
+      return compute_tiled(*m_grid, *m_algo, BasicAlphaKernel(scale),
+			   nthreads, tile_size, scale / 10000);
+    return false;
+  }
+  
+  
+  void Facade::
+  SetBandExpansion(size_t nthreads, double width)
+  {
+    if (0 == nthreads)
+      m_algo->SetBandExpansion(0, 1);
+    else
+      m_algo->SetBandExpansion(width * scale, nthreads);
+  }
+  
+  
+  bool Facade::
+  ComputeFastSweep()
+  {
+    if ((0 == dynamic_cast<LSMKernel const *>(m_kernel.get()))
+	|| (Grid::FOUR != m_grid->GetNeighborhood())
+	|| ( ! is_complete(*m_grid)))
+      return false;
+    if (m_algo->InMetaBatch())
+      m_algo->CommitMetaBatch(*m_kernel);
+    FastSweepSolver solver(m_grid->GetXEnd() - m_grid->GetXBegin(),
+			   m_grid->GetYEnd() - m_grid->GetYBegin(), scale);
+    export_grid(*m_grid, *m_algo, solver);
+    solver.Compute(scale / 10000);
+    import_grid<FourNeighborhood>(*m_grid, *m_algo, solver);
+    return true;
+  }
+  
+  
+  bool Facade::
+  SetFocus(ssize_t robot_ix, ssize_t robot_iy, double margin)
+  {
+    shared_ptr<GridNode const> node(TouchNode(robot_ix, robot_iy));
+    if ( ! node)
+      return false;
+    shared_ptr<Heuristic const>
+      heuristic(new GridHeuristic(m_grid->GetCSpace(), robot_ix, robot_iy,
+				  m_kernel->GetHeuristicWeight()));
+    m_algo->SetFocus(heuristic, node->vertex, margin * scale);
+    return true;
+  }
+  
+  
+  void Facade::
+  ClearFocus()
+  {
+    m_algo->SetFocus(shared_ptr<Heuristic const>(), CSpaceGraph::null_vertex,
+		     0);
+  }
+  
+  
+  void Facade::
+  SetCeiling(double ceiling)
+  {
+    m_algo->SetCeiling(ceiling);
+  }
+  
+  
   void Facade::
   DumpGrid(FILE * stream)
     const
@@ -319,6 +615,14 @@ namespace estar {
   }
   
 
+  void Facade::
+  DumpTiles(FILE * stream)
+    const
+  {
+    dump_tiles(*m_grid, stream);
+  }
+  
+  
   void Facade::
   DumpPointers(FILE * stream)
     const
@@ -348,18 +652,26 @@ namespace estar {
     flag_t const flag(m_cspace->GetFlag(vertex));
     if (estar::GOAL == flag)
       return GOAL;
-    if ((OPEN == flag) || (OPNG == flag))
+    double const value(m_cspace->GetValue(vertex));
+    double const ceiling(m_algo->GetCeiling());
+    if ((OPEN == flag) || (OPNG == flag)) {
+      if (minval(value, m_cspace->GetRhs(vertex)) > ceiling)
+	return BEYOND_HORIZON;
       return WAVEFRONT;
+    }
     // could be paranoid and assert (NONE == flag) here
     if (m_cspace->GetMeta(vertex) == m_kernel->obstacle_meta)
       return OBSTACLE;
-    const queue_t & queue(m_algo->GetQueue().Get());
-    if (queue.empty())
+    if (value > ceiling)
+      return BEYOND_HORIZON;
+    Queue const & queue(m_algo->GetQueue());
+    if (queue.IsBeyondHorizon(vertex, value))
+      return DOWNWIND;
+    if (queue.IsEmpty())
       return UPWIND;
-    double const value(m_cspace->GetValue(vertex));
-    if (value < queue.begin()->first)
+    if (value < queue.GetTopKey())
       return UPWIND;
-    if (value >= queue.rbegin()->first)
+    if (value >= queue.GetBottomKey())
       return DOWNWIND;
     return WAVEFRONT;
   }
@@ -368,10 +680,10 @@ namespace estar {
   bool Facade::
   GetLowestInconsistentValue(double & value) const
   {
-    queue_t const & queue(m_algo->GetQueue().Get());
-    if (queue.empty())
+    Queue const & queue(m_algo->GetQueue());
+    if (queue.IsEmpty())
       return false;
-    value = queue.begin()->first;
+    value = queue.GetTopKey();
     return true;
   }
   
@@ -553,6 +865,70 @@ namespace estar {
   }
   
   
+  size_t Facade::
+  MoveWindow(ssize_t xbegin, ssize_t ybegin, double meta)
+  {
+    return m_grid->MoveWindow(xbegin, ybegin, meta, *m_algo, *m_kernel);
+  }
+  
+  
+  size_t Facade::
+  MoveWindow(ssize_t xbegin, ssize_t ybegin, Grid::get_meta const * gm)
+  {
+    return m_grid->MoveWindow(xbegin, ybegin, gm, *m_algo, *m_kernel);
+  }
+  
+  
+  bool Facade::
+  SetTileStore(shared_ptr<TileStore> store)
+  {
+    if ( ! m_grid->IsTiled())
+      return false;
+    m_tile_store = store;
+    m_grid->SetTileSource(store.get());
+    return true;
+  }
+  
+  
+  size_t Facade::
+  SaveValues()
+  {
+    if (( ! m_tile_store) || ( ! m_tile_store->IsWritable())
+	|| ( ! m_tile_store->HaveValues()))
+      return 0;
+    size_t count(0);
+    ssize_t const tsize(m_grid->GetTileSize());
+    for (size_t it(0); it < m_cspace->GetNTiles(); ++it) {
+      ssize_t x0, y0;
+      m_cspace->GetTile(it, x0, y0);
+      ssize_t const x1(minval(x0 + tsize, m_grid->GetXEnd()));
+      ssize_t const y1(minval(y0 + tsize, m_grid->GetYEnd()));
+      for (ssize_t ix(x0); ix < x1; ++ix)
+	for (ssize_t iy(y0); iy < y1; ++iy)
+	  if (m_tile_store->SetValue(ix, iy, m_cspace->GetValue
+				     (m_cspace->FindVertex(ix, iy))))
+	    ++count;
+    }
+    return count;
+  }
+  
+  
+  size_t Facade::
+  Renumber()
+  {
+    return m_grid->Renumber(*m_algo);
+  }
+  
+  
+  shared_ptr<GridNode const> Facade::
+  TouchNode(ssize_t ix, ssize_t iy)
+  {
+    if (m_grid->IsTiled())
+      m_grid->AddTile(ix, iy, *m_algo, *m_kernel);
+    return m_grid->GetNode(ix, iy);
+  }
+  
+  
   bool Facade::
   HaveGoal() const
   {
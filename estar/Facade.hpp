@@ -26,6 +26,8 @@
 #include <estar/FacadeReadInterface.hpp>
 #include <estar/CSpace.hpp>
 #include <estar/Grid.hpp>
+#include <estar/Queue.hpp>
+#include <estar/Algorithm.hpp>
 #include <boost/shared_ptr.hpp>
 #include <string>
 #include <iosfwd>
@@ -40,6 +42,7 @@ namespace estar {
   
   
   class Region;
+  class TileStore;
   
   
   class GridOptions
@@ -47,13 +50,33 @@ namespace estar {
   public:
     GridOptions(ssize_t xbegin, ssize_t xend,
 		ssize_t ybegin, ssize_t yend,
-		Grid::neighborhood_t neighborhood = Grid::FOUR);
+		Grid::neighborhood_t neighborhood = Grid::FOUR,
+		bool rolling = false,
+		ssize_t tile_size = 0,
+		Grid::vertex_order_t vertex_order = Grid::COLUMN_ORDER);
     
     ssize_t xbegin, xend, ybegin, yend;
     
     /** For the preferred LSMKernel, you should set this to
 	Grid::FOUR. */
     Grid::neighborhood_t neighborhood;
+    
+    /** Whether the range is a fixed-size window that gets moved
+	with Facade::MoveWindow() instead of grown with AddRange(), see
+	Grid::InitRolling(). */
+    bool rolling;
+    
+    /** If non-zero, the range is only the extent of a sparse grid
+	whose tiles of tile_size times tile_size cells (a power of
+	two) get created as they are needed, see Grid::InitTiled().
+	The Facade then creates tiles when the wavefront reaches them,
+	and for cells that are passed to SetMeta(), AddGoal(),
+	MoveGoal(), SetFocus(), or ComputeUntil(). */
+    ssize_t tile_size;
+    
+    /** Order of the vertex IDs of a grid that is neither rolling nor
+	tiled, see Grid::SetVertexOrder() and Facade::Renumber(). */
+    Grid::vertex_order_t vertex_order;
   };
   
   
@@ -61,14 +84,16 @@ namespace estar {
   {
   public:
     /** Default: no special propagator checks, no
-	automatic resets or flushing. */
+	automatic resets or flushing, 4-ary heap queue. */
     AlgorithmOptions();
     
     AlgorithmOptions(bool check_upwind,
 		     bool check_local_consistency,
 		     bool check_queue_key,
 		     bool auto_reset,
-		     bool auto_flush);
+		     bool auto_flush,
+		     Queue::backend_t queue_backend = Queue::FOUR_HEAP,
+		     double bucket_width = 1);
     
     /** Whether to check the upwind structure when computing the
 	propagator set of a node. Passed to PropagatorFactory ctor via
@@ -84,7 +109,7 @@ namespace estar {
     /** Whether to check if a neighbor lies below the wavefront when
 	computing the propagator set of a node. Passed to
 	PropagatorFactory ctor via Algorithm ctor. Use false to mimic
-	old behavior */
+	old behavior. Ignored with Queue::BUCKET, see Algorithm. */
     bool check_queue_key;
     
     /** Whether to automatically reset the whole E* computations when
@@ -103,6 +128,20 @@ namespace estar {
 	can be checked by calling Facade::GetStatus(). Use false
 	unless you have a good reason for wasting processing power */
     bool auto_flush;
+    
+    /** Which storage to use for the wavefront Queue. Passed to
+	Algorithm ctor. The indexed heaps are much faster than the
+	original Queue::MULTIMAP on large wavefronts, and they all
+	expand vertices in the same order. */
+    Queue::backend_t queue_backend;
+    
+    /** Bucket width for queue_backend == Queue::BUCKET, ignored
+	otherwise. Defaults to one, like for Algorithm and Queue.
+	Values smaller than or equal to zero mean "use the Kernel's
+	scale", which is exact for NF1Kernel with integer meta. For LSMKernel, something around scale/10 gives a good
+	compromise between bucket overhead and re-expansions, see
+	BucketQueueBackend for details. Passed to Algorithm ctor. */
+    double bucket_width;
   };
   
   
@@ -200,6 +239,8 @@ namespace estar {
 	   boost::shared_ptr<Grid> grid,
 	   boost::shared_ptr<Kernel> kernel);
     
+    virtual ~Facade();
+    
     
     /**
        Implements FacadeReadInterface::GetScale().
@@ -233,6 +274,23 @@ namespace estar {
     */
     virtual bool SetMeta(ssize_t ix, ssize_t iy, double meta);
     
+    /**
+       Collect subsequent SetMeta() calls, for instance all the cells
+       of a sensor scan, and update each changed cell only once when
+       CommitMetaBatch() is called. See Algorithm::BeginMetaBatch().
+       
+       \note GetStatus() does not know about uncommitted changes.
+    */
+    void BeginMetaBatch();
+    
+    /**
+       Update the cells changed since BeginMetaBatch(). This also
+       happens automatically in ComputeOne() and ComputeUntil().
+       
+       \return The number of kernel evaluations saved by batching.
+    */
+    size_t CommitMetaBatch();
+    
     /**
        Implements FacadeWriteInterface::AddGoal().
        
@@ -252,10 +310,9 @@ namespace estar {
     void AddGoal(const Region & goal);
     
     /**
-       Revert a goal cell to normal status. Unless the cell happens to
-       be non-goal before calling this method, this sets a flag which
-       causes the next call to ComputeOne() to reinitialize the
-       navigation function and wavefront.
+       Revert a goal cell to normal status. The next call to
+       ComputeOne() repairs the cells that depended on it, see
+       Algorithm::RemoveGoal().
     */
     void RemoveGoal(ssize_t ix, ssize_t iy);
     
@@ -271,6 +328,24 @@ namespace estar {
     */
     virtual void RemoveAllGoals();
     
+    /**
+       Make (ix, iy) the only goal cell, with the given value. Unlike
+       RemoveAllGoals() followed by AddGoal(), a goal that stays where
+       it is does not get touched at all. See
+       Algorithm::ReplaceGoals().
+       
+       \return true if the index was valid, otherwise the goals are
+       left unchanged.
+    */
+    bool MoveGoal(ssize_t ix, ssize_t iy, double value);
+    
+    /**
+       Make the cells of a Region the new goal set, ignoring obstacle
+       cells as in AddGoal(const Region &). Only the difference to
+       the current goal set is applied, see Algorithm::ReplaceGoals().
+    */
+    void ReplaceGoals(const Region & goal);
+    
     /**
        Implements FacadeReadInterface::IsGoal().
     */
@@ -286,6 +361,100 @@ namespace estar {
     */
     virtual void ComputeOne();
     
+    /**
+       Propagate until the cell under the robot is settled (GOAL or
+       UPWIND, see Algorithm::IsSettled()), or there is no work left,
+       or the time budget is used up. This replaces the loop over
+       HaveWork(), GetStatus(), and ComputeOne() that clients used to
+       write, and avoids its per-step overhead. If (robot_ix,
+       robot_iy) is not a valid index, it just propagates until the
+       budget is used up or the queue is empty.
+       
+       \return See Algorithm::ComputeUntil().
+    */
+    compute_progress ComputeUntil(ssize_t robot_ix, ssize_t robot_iy,
+				  /** seconds */
+				  double budget);
+    
+    /**
+       Recompute the whole navigation function with a
+       TiledAlgorithm running on several threads, and hand the
+       result over to the Algorithm, so that later changes get
+       repaired incrementally as usual. This only pays off for full
+       replans on large grids, e.g. right after creation or when
+       most of the environment changed. The ceiling and focus are
+       ignored, all reachable cells end up with their final value.
+       
+       \return false if the kernel is not one of LSMKernel,
+       NF1Kernel, or AlphaKernel, or if the grid has holes, in which
+       case nothing changes.
+    */
+    bool ComputeParallel(size_t nthreads,
+			 /** edge length of the tiles, in cells */
+			 ssize_t tile_size = 64);
+    
+    /**
+       Recompute the whole navigation function with a
+       FastSweepSolver and hand the result over to the Algorithm, so
+       that later changes get repaired incrementally as usual. Use
+       this instead of propagating from scratch, e.g. for the initial
+       plan or after moving the goal far away. The ceiling and focus
+       are ignored.
+       
+       \return false if the kernel is not LSMKernel, the grid is not
+       four-connected, or it has holes, in which case nothing
+       changes.
+    */
+    bool ComputeFastSweep();
+    
+    /**
+       Let ComputeOne() and ComputeUntil() expand a band of cells at
+       a time and update their neighbors on several threads, see
+       Algorithm::SetBandExpansion(). The width of the band is given
+       in cells, the default of half a cell keeps the values the same
+       as with single expansions for LSMKernel, up to the effects of
+       the slack. Pass zero threads to
+       switch back to single expansions.
+    */
+    void SetBandExpansion(size_t nthreads, double width = 0.5);
+    
+    /**
+       Focus the propagation on the robot, see
+       Algorithm::SetFocus(). Call this again whenever the robot has
+       moved to a different cell, and keep checking GetStatus() (or
+       use ComputeUntil()) as usual: the robot cell becomes UPWIND
+       after far fewer expansions, especially if the goal is far
+       away. The GridHeuristic is weighted with
+       Kernel::GetHeuristicWeight(), kernels that return zero there
+       gain nothing from focusing.
+       
+       A margin of 5 to 10 cells is a good start. Smaller margins
+       save more expansions but unpark more often, and the robot
+       value can be slightly less accurate because its neighbors
+       are not all settled yet.
+       
+       \note Cells whose focus key lies beyond the horizon are
+       reported as DOWNWIND by GetStatus(), even if their value
+       would already be low enough.
+       
+       \return false if the index is invalid, in which case nothing
+       changes.
+    */
+    bool SetFocus(ssize_t robot_ix, ssize_t robot_iy,
+		  /** horizon margin, in cells */
+		  double margin);
+    
+    /** Unpark everything and switch back to unfocused propagation. */
+    void ClearFocus();
+    
+    /**
+       Stop propagating beyond the given value, see
+       Algorithm::SetCeiling(). Cells beyond it get the status
+       BEYOND_HORIZON, and HaveWork() returns false as soon as only
+       such cells are left.
+    */
+    void SetCeiling(double ceiling);
+    
     /**
        Implements FacadeWriteInterface::Reset().
     */
@@ -307,6 +476,53 @@ namespace estar {
     */
     virtual bool AddNode(ssize_t ix, ssize_t iy, double meta);
     
+    /**
+       Move the window of a rolling grid (see GridOptions::rolling)
+       to start at (xbegin, ybegin), for instance to keep it centered
+       on the robot. See Grid::MoveWindow() for the details.
+       
+       \note Vertices get recycled, so call SetFocus() again if the
+       focus vertex might have left the window.
+       
+       \return The number of cells that entered the window.
+    */
+    size_t MoveWindow(ssize_t xbegin, ssize_t ybegin, double meta);
+    
+    size_t MoveWindow(ssize_t xbegin, ssize_t ybegin,
+		      Grid::get_meta const * gm);
+    
+    /**
+       Keep the map of a tiled grid (see GridOptions::tile_size) in a
+       TileStore, which can be much larger than memory: tiles that get
+       created from now on read their metas from the store (see
+       Grid::SetTileSource()), and SetMeta() writes through to it
+       unless it has been opened read-only, in which case changed
+       metas only live in the grid. Pass null to detach the store.
+       
+       \return false if the grid is not tiled.
+    */
+    bool SetTileStore(boost::shared_ptr<TileStore> store);
+    
+    /**
+       Write the values of all cells that exist in the grid to the
+       value channel of the TileStore (see SetTileStore()), for
+       example before shutting down.
+       
+       \return The number of written cells, zero if there is no store,
+       it is read-only, or it has no values.
+    */
+    size_t SaveValues();
+    
+    /**
+       Renumber the vertices of the grid so that their IDs follow
+       GridOptions::vertex_order again, for instance after the grid
+       has grown through a series of AddRange() calls. Propagation
+       continues where it left off, see Grid::Renumber().
+       
+       \return The number of vertices that got a new ID.
+    */
+    size_t Renumber();
+    
     /**
        Implements FacadeReadInterface::GetStatus().
     */
@@ -345,6 +561,13 @@ namespace estar {
 		       medium-sized grids) */
 		   size_t limit) const;
     
+    /**
+       Write which tiles of a tiled grid (see GridOptions::tile_size)
+       have been created so far. Actually just calls dump_tiles() in
+       dump.hpp.
+    */
+    void DumpTiles(FILE * stream) const;
+    
     /**
        Write the addresses of the Algorithm, Grid, and Kernel
        instances. This is mostly for debugging, for moments when
@@ -359,6 +582,7 @@ namespace estar {
     
   protected:
     friend class pnf::Flow;
+    friend class HierarchicalFacade;
     
     /**
        \note this is a hack for legacy code, don't rely on it
@@ -412,6 +636,14 @@ namespace estar {
     boost::shared_ptr<Algorithm> m_algo;
     boost::shared_ptr<Grid> m_grid;
     boost::shared_ptr<Kernel> m_kernel;
+    /** creates tiles along the wavefront, null unless tiled */
+    boost::shared_ptr<lower_hook> m_tile_hook;
+    /** backs the tiled grid, see SetTileStore() */
+    boost::shared_ptr<TileStore> m_tile_store;
+    
+    /** Like Grid::GetNode(), but creates the tile of (ix, iy) if the
+	grid is tiled. */
+    boost::shared_ptr<GridNode const> TouchNode(ssize_t ix, ssize_t iy);
     
     node_status_t DoGetStatus(ssize_t ix, ssize_t iy, vertex_t vertex) const;
   };
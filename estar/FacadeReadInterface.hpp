@@ -81,7 +81,10 @@ namespace estar {
       /** the node is in a goal region */
       GOAL,
       /** the node is in an obstacle */
-      OBSTACLE
+      OBSTACLE,
+      /** the node lies beyond the value ceiling, its value will not
+	  be computed (see Algorithm::SetCeiling()) */
+      BEYOND_HORIZON
     } node_status_t;
     
     /**
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+#include "FastSweepSolver.hpp"
+#include <cmath>
+
+
+namespace estar {
+  
+  
+  FastSweepSolver::
+  FastSweepSolver(ssize_t xsize, ssize_t ysize, double scale)
+    : m_scale(scale),
+      m_xsize(xsize),
+      m_ysize(ysize),
+      m_ystride(ysize + 2),
+      m_value((xsize + 2) * (ysize + 2), infinity),
+      m_meta(m_value.size(), KernelTraits<LSMKernel>::freespace_meta()),
+      m_goal_value(m_value.size(), infinity),
+      m_goal(m_value.size(), 0),
+      m_radius(m_value.size(), infinity),
+      m_nsweeps(0)
+  {
+  }
+  
+  
+  void FastSweepSolver::
+  AddGoal(ssize_t ix, ssize_t iy, double value)
+  {
+    size_t const cell(Index(ix, iy));
+    m_goal[cell] = 1;
+    m_goal_value[cell] = value;
+  }
+  
+  
+  void FastSweepSolver::
+  RemoveGoal(ssize_t ix, ssize_t iy)
+  {
+    size_t const cell(Index(ix, iy));
+    m_goal[cell] = 0;
+    m_goal_value[cell] = infinity;
+  }
+  
+  
+  FastSweepSolver::mask_t FastSweepSolver::
+  GetUpwind(ssize_t ix, ssize_t iy) const
+  {
+    size_t const cell(Index(ix, iy));
+    if (m_goal[cell] || (infinity == m_value[cell]))
+      return 0;
+    // Same candidate order as BasicAlgorithm, so that ties get
+    // broken the same way.
+    CandidateList<FourNeighborhood> cand;
+    for (size_t slot(0); slot < FourNeighborhood::size; ++slot)
+      cand.Add(m_value[cell
+		       + FourNeighborhood::dx(slot) * m_ystride
+		       + FourNeighborhood::dy(slot)], slot);
+    cand.Compute(BasicLSMKernel(m_scale), m_meta[cell]);
+    return cand.GetUpwindMask<mask_t>();
+  }
+  
+  
+  size_t FastSweepSolver::
+  Compute(double tolerance)
+  {
+    for (ssize_t ix(0); ix < m_xsize; ++ix)
+      for (ssize_t iy(0); iy < m_ysize; ++iy) {
+	size_t const cell(Index(ix, iy));
+	if (m_goal[cell]) {
+	  m_value[cell] = m_goal_value[cell];
+	  m_radius[cell] = -1;
+	}
+	else {
+	  m_value[cell] = infinity;
+	  if (m_meta[cell] <= epsilon)
+	    m_radius[cell] = infinity;
+	  else
+	    m_radius[cell] = m_scale / m_meta[cell];
+	}
+      }
+    
+    m_nsweeps = 0;
+    for (;;) {
+      bool changed;
+      switch (m_nsweeps % 4) {
+      case 0:
+	changed = Sweep(0, m_xsize, 1, 0, m_ysize, 1, tolerance);
+	break;
+      case 1:
+	changed = Sweep(m_xsize - 1, -1, -1, 0, m_ysize, 1, tolerance);
+	break;
+      case 2:
+	changed = Sweep(m_xsize - 1, -1, -1, m_ysize - 1, -1, -1, tolerance);
+	break;
+      default:
+	changed = Sweep(0, m_xsize, 1, m_ysize - 1, -1, -1, tolerance);
+      }
+      ++m_nsweeps;
+      // A pass without changes has seen the final value of each
+      // neighbor, so all cells are consistent.
+      if ( ! changed)
+	break;
+    }
+    return m_nsweeps;
+  }
+  
+  
+  bool FastSweepSolver::
+  Sweep(ssize_t xfirst, ssize_t xlast, ssize_t xstep,
+	ssize_t yfirst, ssize_t ylast, ssize_t ystep,
+	double tolerance)
+  {
+    bool changed(false);
+    double * const value(&m_value[0]);
+    double const * const radius(&m_radius[0]);
+    for (ssize_t ix(xfirst); ix != xlast; ix += xstep) {
+      size_t cell(Index(ix, yfirst));
+      for (ssize_t iy(yfirst); iy != ylast; iy += ystep, cell += ystep) {
+	double const rr(radius[cell]);
+	if ((rr < 0) || (infinity == rr))
+	  continue;
+	double const vx(minval(value[cell - m_ystride],
+			       value[cell + m_ystride]));
+	double const vy(minval(value[cell - 1], value[cell + 1]));
+	double const primary(minval(vx, vy));
+	if (infinity == primary)
+	  continue;
+	double const secondary(maxval(vx, vy));
+	double candidate;
+	if (rr <= secondary - primary)
+	  candidate = primary + rr;
+	else
+	  candidate = (primary + secondary
+		       + sqrt(2 * square(rr) - square(secondary - primary)))
+	    / 2;
+	if (candidate < value[cell]) {
+	  if (value[cell] - candidate > tolerance)
+	    changed = true;
+	  value[cell] = candidate;
+	}
+      }
+    }
+    return changed;
+  }
+  
+} // namespace estar
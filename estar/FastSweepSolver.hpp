@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+#ifndef ESTAR_FAST_SWEEP_SOLVER_HPP
+#define ESTAR_FAST_SWEEP_SOLVER_HPP
+
+
+#include <estar/BasicAlgorithm.hpp>
+#include <vector>
+
+
+namespace estar {
+  
+  
+  /**
+     Computes the LSMKernel navigation function of a four-connected
+     grid from scratch with the fast sweeping method: Gauss-Seidel
+     passes over the whole grid, alternating between the four
+     diagonal orders (increasing or decreasing x, increasing or
+     decreasing y), until a pass changes no value by more than the
+     tolerance. There is no queue and no upwind bookkeeping, which is
+     what makes this faster than E* when nothing is being repaired.
+     
+     The update is the same as the one of LSMKernel, so the result is
+     the same as what Algorithm computes, up to the slack. Each pass
+     propagates along all paths that do not turn back against its
+     order, so the number of passes grows with the number of turns
+     around obstacles, not with the size of the grid.
+     
+     The layout is the same as in BasicAlgorithm: columns are
+     contiguous, and a ring of padding cells avoids border checks.
+     Facade::ComputeFastSweep() uses this to seed an Algorithm, which
+     can then do incremental repairs as usual.
+  */
+  class FastSweepSolver {
+  public:
+    typedef FourNeighborhood neighborhood_t;
+    typedef unsigned char mask_t;
+    
+    FastSweepSolver(ssize_t xsize, ssize_t ysize, double scale);
+    
+    ssize_t GetXSize() const { return m_xsize; }
+    ssize_t GetYSize() const { return m_ysize; }
+    
+    double GetValue(ssize_t ix, ssize_t iy) const
+    { return m_value[Index(ix, iy)]; }
+    
+    double GetMeta(ssize_t ix, ssize_t iy) const
+    { return m_meta[Index(ix, iy)]; }
+    
+    bool IsGoal(ssize_t ix, ssize_t iy) const
+    { return m_goal[Index(ix, iy)]; }
+    
+    /** \return The neighbors (as bits of FourNeighborhood slots)
+	that LSMKernel would use as backpointers for the cell, zero
+	for goals and cells that were not reached. */
+    mask_t GetUpwind(ssize_t ix, ssize_t iy) const;
+    
+    /** \return The number of passes done by the last Compute(). */
+    size_t GetNSweeps() const { return m_nsweeps; }
+    
+    /** Takes effect at the next Compute(). */
+    void SetMeta(ssize_t ix, ssize_t iy, double meta)
+    { m_meta[Index(ix, iy)] = meta; }
+    
+    void AddGoal(ssize_t ix, ssize_t iy, double value);
+    void RemoveGoal(ssize_t ix, ssize_t iy);
+    
+    /**
+       Compute all values from scratch.
+       
+       \return The number of passes, same as GetNSweeps().
+    */
+    size_t Compute(/** stop after the first pass that changes no
+		       value by more than this */
+		   double tolerance);
+    
+  private:
+    size_t Index(ssize_t ix, ssize_t iy) const
+    { return (ix + 1) * m_ystride + iy + 1; }
+    
+    /** \return true if some value dropped by more than the
+	tolerance. */
+    bool Sweep(ssize_t xfirst, ssize_t xlast, ssize_t xstep,
+	       ssize_t yfirst, ssize_t ylast, ssize_t ystep,
+	       double tolerance);
+    
+    double const m_scale;
+    ssize_t const m_xsize;
+    ssize_t const m_ysize;
+    ssize_t const m_ystride;
+    std::vector<double> m_value;
+    std::vector<double> m_meta;
+    std::vector<double> m_goal_value;
+    std::vector<unsigned char> m_goal;
+    /** scale / meta, infinity for obstacles, negative for goals */
+    std::vector<double> m_radius;
+    size_t m_nsweeps;
+  };
+  
+} // namespace estar
+
+#endif // ESTAR_FAST_SWEEP_SOLVER_HPP
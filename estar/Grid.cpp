@@ -21,8 +21,10 @@
 #include "Grid.hpp"
 #include "Algorithm.hpp"
 #include "Kernel.hpp"
-#include "flexgrid.hpp"
 #include "numeric.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <stdint.h>
 
 
 using namespace boost;
@@ -77,6 +79,53 @@ namespace local {
     estar::Grid const * grid;
   };  
   
+  typedef std::vector<std::pair<ssize_t, ssize_t> > cell_list_t;
+  
+  /** Edge length of the blocks of BLOCK_ORDER is 2^block_shift. */
+  static const unsigned int block_shift(4);
+  
+  /** Sort key of cell (jx, jy) relative to the start of a range
+      that is ysize cells high. */
+  static uint64_t order_key(estar::Grid::vertex_order_t order,
+			    uint64_t jx, uint64_t jy, uint64_t ysize)
+  {
+    switch (order) {
+    case estar::Grid::BLOCK_ORDER: {
+      uint64_t const nby((ysize + (1 << block_shift) - 1) >> block_shift);
+      uint64_t const mask((1 << block_shift) - 1);
+      return ((((jx >> block_shift) * nby + (jy >> block_shift))
+	       << (2 * block_shift))
+	      | ((jx & mask) << block_shift) | (jy & mask));
+    }
+    default:
+      return jx * ysize + jy;
+    }
+  }
+  
+  /** Append the cells of [xbegin, xend[ x [ybegin, yend[ that lie
+      outside of [oxbegin, oxend[ x [oybegin, oyend[. */
+  static void cell_difference(ssize_t xbegin, ssize_t xend,
+			      ssize_t ybegin, ssize_t yend,
+			      ssize_t oxbegin, ssize_t oxend,
+			      ssize_t oybegin, ssize_t oyend,
+			      cell_list_t & cell)
+  {
+    for (ssize_t ix(xbegin); ix < xend; ++ix) {
+      if ((ix < oxbegin) || (ix >= oxend)) {
+	for (ssize_t iy(ybegin); iy < yend; ++iy)
+	  cell.push_back(make_pair(ix, iy));
+	continue;
+      }
+      for (ssize_t iy(ybegin); iy < yend; ++iy) {
+	if ((iy >= oybegin) && (iy < oyend))
+	  iy = oyend;		// skip the overlap
+	if (iy >= yend)
+	  break;
+	cell.push_back(make_pair(ix, iy));
+      }
+    }
+  }
+  
 }
 
 using namespace local;
@@ -85,9 +134,89 @@ using namespace local;
 namespace estar {
 
 
+  GridCSpace::
+  GridCSpace(CSpaceGraph::neighborhood_t const & neighborhood,
+	     shared_ptr<grid_postransform const> postransform,
+	     shared_ptr<grid_bbox_compute const> bbox_compute)
+    : m_node(new deque<GridNode>()),
+      m_postransform(postransform),
+      m_bbox_compute(bbox_compute)
+  {
+    m_cspace.InitGrid(neighborhood);
+  }
+  
+  
+  vertex_t GridCSpace::
+  AddVertex(ssize_t ix, ssize_t iy, double meta)
+  {
+    vertex_t const vertex(m_cspace.AddGridVertex(ix, iy));
+    InitVertex(vertex, infinity, meta, infinity, NONE);
+    m_node->push_back(GridNode(ix, iy, vertex));
+    return vertex;
+  }
+  
+  
+  void GridCSpace::
+  AttachVertex(vertex_t vertex, ssize_t ix, ssize_t iy, double meta)
+  {
+    m_cspace.AttachGridVertex(vertex, ix, iy);
+    SetMeta(vertex, meta);
+    GridNode & node((*m_node)[vertex]);
+    node.ix = ix;
+    node.iy = iy;
+  }
+  
+  
+  vertex_t GridCSpace::
+  AddTile(ssize_t ix, ssize_t iy, double meta)
+  {
+    vertex_t const first(m_cspace.AddGridTile(ix, iy));
+    ssize_t x0, y0;
+    m_cspace.GetGridTile(m_cspace.GetNGridTiles() - 1, x0, y0);
+    ssize_t const tsize(m_cspace.GetGridTileSize());
+    vertex_t vertex(first);
+    for (ssize_t jx(0); jx < tsize; ++jx)
+      for (ssize_t jy(0); jy < tsize; ++jy, ++vertex) {
+	InitVertex(vertex, infinity, meta, infinity, NONE);
+	m_node->push_back(GridNode(x0 + jx, y0 + jy, vertex));
+      }
+    return first;
+  }
+  
+  
+  void GridCSpace::
+  Renumber(std::vector<vertex_t> const & newid)
+  {
+    BaseCSpace::Renumber(newid);
+    std::vector<GridNode> const old(m_node->begin(), m_node->end());
+    for (size_t ii(0); ii < old.size(); ++ii) {
+      GridNode & node((*m_node)[newid[ii]]);
+      node = old[ii];
+      node.vertex = newid[ii];
+    }
+  }
+  
+  
+  void GridCSpace::
+  Reserve(ssize_t xbegin, ssize_t xend, ssize_t ybegin, ssize_t yend)
+  {
+    m_cspace.ReserveGrid(xbegin, xend, ybegin, yend);
+    if ((xbegin < xend) && (ybegin < yend))
+      ReserveVertices(m_value_storage.size()
+		      + (xend - xbegin) * (yend - ybegin));
+  }
+  
+  
   Grid::
   Grid(neighborhood_t neighborhood)
-    : m_neighborhood(neighborhood)
+    : m_neighborhood(neighborhood),
+      m_xbegin(0),
+      m_xend(0),
+      m_ybegin(0),
+      m_yend(0),
+      m_tile_meta(0),
+      m_tile_source(0),
+      m_vertex_order(COLUMN_ORDER)
   {
     InitNborStuff();
   }
@@ -98,7 +227,14 @@ namespace estar {
        ssize_t ybegin, ssize_t yend,
        neighborhood_t neighborhood,
        double meta)
-    : m_neighborhood(neighborhood)
+    : m_neighborhood(neighborhood),
+      m_xbegin(0),
+      m_xend(0),
+      m_ybegin(0),
+      m_yend(0),
+      m_tile_meta(0),
+      m_tile_source(0),
+      m_vertex_order(COLUMN_ORDER)
   {
     InitNborStuff();
     Init(xbegin, xend, ybegin, yend, meta);
@@ -110,31 +246,251 @@ namespace estar {
        ssize_t ybegin, ssize_t yend,
        double meta)
   {
-    m_flexgrid.reset(new flexgrid_t());
-    m_flexgrid->resize(xbegin, xend, ybegin, yend);
+    GrowRange(xbegin, xend, ybegin, yend);
+    m_cspace->Reserve(xbegin, xend, ybegin, yend);
+    if (COLUMN_ORDER == m_vertex_order) {
+      for (ssize_t ix(xbegin); ix < xend; ++ix)
+	for (ssize_t iy(ybegin); iy < yend; ++iy)
+	  DoAddNode(ix, iy, meta);
+      return;
+    }
+    cell_list_t cells;
+    cell_difference(xbegin, xend, ybegin, yend, 0, 0, 0, 0, cells);
+    SortCells(cells);
+    for (size_t ii(0); ii < cells.size(); ++ii)
+      DoAddNode(cells[ii].first, cells[ii].second, meta);
+  }
+  
+  
+  size_t Grid::
+  Renumber(Algorithm & algo)
+  {
+    if (IsRolling() || IsTiled())
+      return 0;
+    
+    vector<pair<uint64_t, vertex_t> > order;
+    order.reserve(num_vertices(m_cspace->GetGraph()));
+    for (ssize_t ix(m_xbegin); ix < m_xend; ++ix)
+      for (ssize_t iy(m_ybegin); iy < m_yend; ++iy) {
+	vertex_t const vertex(m_cspace->FindVertex(ix, iy));
+	if (CSpaceGraph::null_vertex != vertex)
+	  order.push_back(make_pair(order_key(m_vertex_order, ix - m_xbegin,
+					      iy - m_ybegin, m_yend - m_ybegin),
+				    vertex));
+      }
+    if (order.size() != num_vertices(m_cspace->GetGraph()))
+      throw logic_error("estar::Grid::Renumber() vertices outside range");
+    sort(order.begin(), order.end());
+    
+    vector<vertex_t> newid(order.size());
+    size_t count(0);
+    for (size_t ii(0); ii < order.size(); ++ii) {
+      newid[order[ii].second] = ii;
+      if (order[ii].second != ii)
+	++count;
+    }
+    if (0 == count)
+      return 0;
+    m_cspace->Renumber(newid);
+    algo.Renumber(newid);
+    return count;
+  }
+  
+  
+  void Grid::
+  SortCells(cell_list_t & cells) const
+  {
+    vector<pair<uint64_t, size_t> > order(cells.size());
+    for (size_t ii(0); ii < cells.size(); ++ii)
+      order[ii] = make_pair(order_key(m_vertex_order,
+				      cells[ii].first - m_xbegin,
+				      cells[ii].second - m_ybegin,
+				      m_yend - m_ybegin), ii);
+    sort(order.begin(), order.end());
+    cell_list_t sorted(cells.size());
+    for (size_t ii(0); ii < order.size(); ++ii)
+      sorted[ii] = cells[order[ii].second];
+    cells.swap(sorted);
+  }
+  
+  
+  size_t Grid::
+  AddSortedRange(ssize_t xbegin, ssize_t xend,
+		 ssize_t ybegin, ssize_t yend,
+		 double meta, get_meta const * gm,
+		 Algorithm & algo, Kernel const & kernel)
+  {
+    cell_list_t cells;
     for (ssize_t ix(xbegin); ix < xend; ++ix)
       for (ssize_t iy(ybegin); iy < yend; ++iy)
-	DoAddNode(ix, iy, meta);
+	if (CSpaceGraph::null_vertex == m_cspace->FindVertex(ix, iy))
+	  cells.push_back(make_pair(ix, iy));
+    SortCells(cells);
+    for (size_t ii(0); ii < cells.size(); ++ii) {
+      ssize_t const ix(cells[ii].first);
+      ssize_t const iy(cells[ii].second);
+      algo.AddVertex(DoAddNode(ix, iy, gm ? (*gm)(ix, iy) : meta), kernel);
+    }
+    return cells.size();
   }
   
   
   void Grid::
-  InitNborStuff()
+  InitRolling(ssize_t xbegin, ssize_t xend,
+	      ssize_t ybegin, ssize_t yend,
+	      double meta)
   {
-    m_nbor_offset.push_back(offset( 0, -1));
-    m_nbor_offset.push_back(offset( 0,  1));
-    m_nbor_offset.push_back(offset(-1,  0));
-    m_nbor_offset.push_back(offset( 1,  0));
-    if (SIX == m_neighborhood) {
-      m_nbor_offset.push_back(offset(-1,  1));
-      m_nbor_offset.push_back(offset( 1,  1));
+    m_cspace->InitRolling(xbegin, xend - xbegin, ybegin, yend - ybegin);
+    Init(xbegin, xend, ybegin, yend, meta);
+  }
+  
+  
+  bool Grid::
+  IsRolling() const
+  {
+    return m_cspace->IsRolling();
+  }
+  
+  
+  void Grid::
+  InitTiled(ssize_t xbegin, ssize_t xend,
+	    ssize_t ybegin, ssize_t yend,
+	    ssize_t tilesize, double meta)
+  {
+    m_cspace->InitTiled(xbegin, xend - xbegin, ybegin, yend - ybegin,
+			tilesize);
+    GrowRange(xbegin, xend, ybegin, yend);
+    m_tile_meta = meta;
+  }
+  
+  
+  bool Grid::
+  IsTiled() const
+  {
+    return m_cspace->IsTiled();
+  }
+  
+  
+  ssize_t Grid::
+  GetTileSize() const
+  {
+    return m_cspace->GetTileSize();
+  }
+  
+  
+  size_t Grid::
+  AddTile(ssize_t ix, ssize_t iy, Algorithm & algo, Kernel const & kernel)
+  {
+    if ( ! IsTiled())
+      return 0;
+    return DoAddTile(ix, iy, 0, 0, 0, 0, m_tile_meta, 0, algo, kernel);
+  }
+  
+  
+  size_t Grid::
+  ExpandTiles(vertex_t vertex, Algorithm & algo, Kernel const & kernel)
+  {
+    if ( ! IsTiled())
+      return 0;
+    // All our neighborhoods reach one cell far, so only the
+    // outermost cells of a tile can have neighbors in other tiles.
+    GridNode const & node(m_cspace->LookupNode(vertex));
+    ssize_t const tmask(m_cspace->GetTileSize() - 1);
+    ssize_t const jx((node.ix - m_xbegin) & tmask);
+    ssize_t const jy((node.iy - m_ybegin) & tmask);
+    if ((jx > 0) && (jx < tmask) && (jy > 0) && (jy < tmask))
+      return 0;
+    size_t count(0);
+    CSpaceGraph::neighborhood_t const &
+      nbor(m_cspace->GetGraph().GetNeighborhood());
+    for (size_t ii(0); ii < nbor.size(); ++ii) {
+      ssize_t const ix(node.ix + nbor[ii].first);
+      ssize_t const iy(node.iy + nbor[ii].second);
+      if ( ! m_cspace->HaveTile(ix, iy))
+	count += DoAddTile(ix, iy, 0, 0, 0, 0, m_tile_meta, 0, algo, kernel);
     }
+    return count;
+  }
+  
+  
+  size_t Grid::
+  DoAddTile(ssize_t ix, ssize_t iy,
+	    ssize_t xbegin, ssize_t xend,
+	    ssize_t ybegin, ssize_t yend,
+	    double meta, get_meta const * gm,
+	    Algorithm & algo, Kernel const & kernel)
+  {
+    if ((ix < m_xbegin) || (ix >= m_xend) || (iy < m_ybegin) || (iy >= m_yend)
+	|| m_cspace->HaveTile(ix, iy))
+      return 0;
+    
+    // Set all metas before telling the algorithm about any of the
+    // vertices, so that they see their final neighborhood.
+    vertex_t const first(m_cspace->AddTile(ix, iy, m_tile_meta));
+    ssize_t x0, y0;
+    m_cspace->GetTile(m_cspace->GetNTiles() - 1, x0, y0);
+    ssize_t const tsize(m_cspace->GetTileSize());
+    ssize_t const x1(minval(x0 + tsize, m_xend));
+    ssize_t const y1(minval(y0 + tsize, m_yend));
+    if (m_tile_source)
+      for (ssize_t jx(x0); jx < x1; ++jx)
+	for (ssize_t jy(y0); jy < y1; ++jy)
+	  m_cspace->SetMeta(first + (jx - x0) * tsize + jy - y0,
+			    (*m_tile_source)(jx, jy));
+    for (ssize_t jx(maxval(x0, xbegin)); jx < minval(x1, xend); ++jx)
+      for (ssize_t jy(maxval(y0, ybegin)); jy < minval(y1, yend); ++jy)
+	m_cspace->SetMeta(first + (jx - x0) * tsize + jy - y0,
+			  gm ? (*gm)(jx, jy) : meta);
+    for (ssize_t jx(x0); jx < x1; ++jx)
+      for (ssize_t jy(y0); jy < y1; ++jy)
+	algo.AddVertex(first + (jx - x0) * tsize + jy - y0, kernel);
+    return (x1 - x0) * (y1 - y0);
+  }
+  
+  
+  size_t Grid::
+  AddTileRange(ssize_t xbegin, ssize_t xend,
+	       ssize_t ybegin, ssize_t yend,
+	       double meta, get_meta const * gm,
+	       Algorithm & algo, Kernel const & kernel)
+  {
+    ssize_t const tmask(m_cspace->GetTileSize() - 1);
+    ssize_t const x0(maxval(xbegin, m_xbegin));
+    ssize_t const x1(minval(xend, m_xend));
+    ssize_t const y0(maxval(ybegin, m_ybegin));
+    ssize_t const y1(minval(yend, m_yend));
+    size_t count(0);
+    for (ssize_t tx(x0 - ((x0 - m_xbegin) & tmask)); tx < x1; tx += tmask + 1)
+      for (ssize_t ty(y0 - ((y0 - m_ybegin) & tmask)); ty < y1;
+	   ty += tmask + 1)
+	count += DoAddTile(tx, ty, xbegin, xend, ybegin, yend, meta, gm,
+			   algo, kernel);
+    return count;
+  }
+  
+  
+  void Grid::
+  InitNborStuff()
+  {
+    // The order of the offsets defines the order of the neighbors in
+    // the C-space graph. This one corresponds to what we used to get
+    // by adding edges while filling the grid X-major: first the
+    // already existing neighbors, then the ones added later.
+    CSpaceGraph::neighborhood_t nbor;
+    nbor.push_back(make_pair( 0, -1));
+    nbor.push_back(make_pair(-1,  0));
+    if (SIX == m_neighborhood)
+      nbor.push_back(make_pair(-1,  1));
     else if (EIGHT == m_neighborhood) {
-      m_nbor_offset.push_back(offset(-1, -1));
-      m_nbor_offset.push_back(offset(-1,  1));
-      m_nbor_offset.push_back(offset( 1, -1));
-      m_nbor_offset.push_back(offset( 1,  1));
+      nbor.push_back(make_pair(-1, -1));
+      nbor.push_back(make_pair(-1,  1));
     }
+    nbor.push_back(make_pair( 0,  1));
+    if (FOUR != m_neighborhood)
+      nbor.push_back(make_pair( 1, -1));
+    nbor.push_back(make_pair( 1,  0));
+    if (EIGHT == m_neighborhood)
+      nbor.push_back(make_pair( 1,  1));
     
     shared_ptr<grid_postransform const> postransform;
     shared_ptr<grid_bbox_compute const> bbox_compute;
@@ -146,7 +502,25 @@ namespace estar {
       postransform.reset(new postransform_cartesian());
       bbox_compute.reset(new bbox_cartesian(this));
     }
-    m_cspace.reset(new GridCSpace(postransform, bbox_compute));
+    m_cspace.reset(new GridCSpace(nbor, postransform, bbox_compute));
+  }
+  
+  
+  void Grid::
+  GrowRange(ssize_t xbegin, ssize_t xend,
+	    ssize_t ybegin, ssize_t yend)
+  {
+    if ((m_xbegin >= m_xend) || (m_ybegin >= m_yend)) {
+      m_xbegin = xbegin;
+      m_xend = xend;
+      m_ybegin = ybegin;
+      m_yend = yend;
+      return;
+    }
+    m_xbegin = minval(m_xbegin, xbegin);
+    m_xend = maxval(m_xend, xend);
+    m_ybegin = minval(m_ybegin, ybegin);
+    m_yend = maxval(m_yend, yend);
   }
   
   
@@ -156,30 +530,21 @@ namespace estar {
 	   double meta,
 	   Algorithm & algo, Kernel const & kernel)
   {
+    if (IsRolling())
+      return 0;
+    if (IsTiled())
+      return AddTileRange(xbegin, xend, ybegin, yend, meta, 0, algo, kernel);
+    GrowRange(xbegin, xend, ybegin, yend);
+    if (COLUMN_ORDER != m_vertex_order)
+      return AddSortedRange(xbegin, xend, ybegin, yend, meta, 0,
+			    algo, kernel);
     size_t count(0);
-    
-    // Grow the flexgrid if necessary. Do NOT simply call
-    // flexgrid::resize() because that could end up removing cells,
-    // which we do not support (yet?).
-    if (xbegin < m_flexgrid->xbegin())
-      m_flexgrid->resize_xbegin(xbegin);
-    if (xend > m_flexgrid->xend())
-      m_flexgrid->resize_xend(xend);
-    if (ybegin < m_flexgrid->ybegin())
-      m_flexgrid->resize_ybegin(ybegin);
-    if (yend > m_flexgrid->yend())
-      m_flexgrid->resize_yend(yend);
-    
     for (ssize_t ix(xbegin); ix < xend; ++ix)
-      for (ssize_t iy(ybegin); iy < yend; ++iy) {
-	vertex_data_t node(m_flexgrid->at(ix, iy));
-	if ( ! node) {
-	  node = DoAddNode(ix, iy, meta);
-	  algo.AddVertex(node->vertex, kernel);
+      for (ssize_t iy(ybegin); iy < yend; ++iy)
+	if (CSpaceGraph::null_vertex == m_cspace->FindVertex(ix, iy)) {
+	  algo.AddVertex(DoAddNode(ix, iy, meta), kernel);
 	  ++count;
 	}
-      }
-    
     return count;
   }
   
@@ -191,30 +556,20 @@ namespace estar {
 	   get_meta const * gm,
 	   Algorithm & algo, Kernel const & kernel)
   {
+    if (IsRolling())
+      return 0;
+    if (IsTiled())
+      return AddTileRange(xbegin, xend, ybegin, yend, 0, gm, algo, kernel);
+    GrowRange(xbegin, xend, ybegin, yend);
+    if (COLUMN_ORDER != m_vertex_order)
+      return AddSortedRange(xbegin, xend, ybegin, yend, 0, gm, algo, kernel);
     size_t count(0);
-    
-    // Grow the flexgrid if necessary. Do NOT simply call
-    // flexgrid::resize() because that could end up removing cells,
-    // which we do not support (yet?).
-    if (xbegin < m_flexgrid->xbegin())
-      m_flexgrid->resize_xbegin(xbegin);
-    if (xend > m_flexgrid->xend())
-      m_flexgrid->resize_xend(xend);
-    if (ybegin < m_flexgrid->ybegin())
-      m_flexgrid->resize_ybegin(ybegin);
-    if (yend > m_flexgrid->yend())
-      m_flexgrid->resize_yend(yend);
-    
     for (ssize_t ix(xbegin); ix < xend; ++ix)
-      for (ssize_t iy(ybegin); iy < yend; ++iy) {
-	vertex_data_t node(m_flexgrid->at(ix, iy));
-	if ( ! node) {
-	  node = DoAddNode(ix, iy, (*gm)(ix, iy));
-	  algo.AddVertex(node->vertex, kernel);
+      for (ssize_t iy(ybegin); iy < yend; ++iy)
+	if (CSpaceGraph::null_vertex == m_cspace->FindVertex(ix, iy)) {
+	  algo.AddVertex(DoAddNode(ix, iy, (*gm)(ix, iy)), kernel);
 	  ++count;
 	}
-      }
-    
     return count;
   }
   
@@ -223,75 +578,127 @@ namespace estar {
   AddNode(ssize_t ix, ssize_t iy, double meta,
 	  Algorithm & algo, Kernel const & kernel)
   {
-    vertex_data_t node(m_flexgrid->smart_at(ix, iy));
-    if (node)
+    if (IsRolling())
+      return false;
+    if (IsTiled())
+      return 0 < DoAddTile(ix, iy, ix, ix + 1, iy, iy + 1, meta, 0,
+			   algo, kernel);
+    GrowRange(ix, ix + 1, iy, iy + 1);
+    if (CSpaceGraph::null_vertex != m_cspace->FindVertex(ix, iy))
       return false;
-    node = DoAddNode(ix, iy, meta);
-    algo.AddVertex(node->vertex, kernel);
+    algo.AddVertex(DoAddNode(ix, iy, meta), kernel);
     return true;
   }
   
   
+  size_t Grid::
+  MoveWindow(ssize_t xbegin, ssize_t ybegin, double meta,
+	     Algorithm & algo, Kernel const & kernel)
+  {
+    return DoMoveWindow(xbegin, ybegin, meta, 0, algo, kernel);
+  }
+  
+  
+  size_t Grid::
+  MoveWindow(ssize_t xbegin, ssize_t ybegin, get_meta const * gm,
+	     Algorithm & algo, Kernel const & kernel)
+  {
+    return DoMoveWindow(xbegin, ybegin, 0, gm, algo, kernel);
+  }
+  
+  
+  size_t Grid::
+  DoMoveWindow(ssize_t xbegin, ssize_t ybegin,
+	       double meta, get_meta const * gm,
+	       Algorithm & algo, Kernel const & kernel)
+  {
+    if ( ! IsRolling())
+      throw logic_error("estar::Grid::MoveWindow() on non-rolling grid");
+    ssize_t const xend(xbegin + m_xend - m_xbegin);
+    ssize_t const yend(ybegin + m_yend - m_ybegin);
+    
+    // Take the leaving vertices out of the algorithm while they are
+    // still connected, then out of the cell array.
+    cell_list_t leaving;
+    cell_difference(m_xbegin, m_xend, m_ybegin, m_yend,
+		    xbegin, xend, ybegin, yend, leaving);
+    vector<vertex_t> recycled;
+    recycled.reserve(leaving.size());
+    for (size_t ii(0); ii < leaving.size(); ++ii) {
+      vertex_t const vertex(m_cspace->FindVertex(leaving[ii].first,
+						 leaving[ii].second));
+      algo.RemoveVertex(vertex);
+      recycled.push_back(vertex);
+    }
+    for (size_t ii(0); ii < recycled.size(); ++ii)
+      m_cspace->DetachVertex(recycled[ii]);
+    
+    // Same window size, so there are as many entering as leaving
+    // cells. Algorithm::AddVertex() wants the neighbors to be in
+    // place, so attach all of them first.
+    cell_list_t entering;
+    entering.reserve(recycled.size());
+    cell_difference(xbegin, xend, ybegin, yend,
+		    m_xbegin, m_xend, m_ybegin, m_yend, entering);
+    m_cspace->SetWindow(xbegin, ybegin);
+    m_xbegin = xbegin;
+    m_xend = xend;
+    m_ybegin = ybegin;
+    m_yend = yend;
+    for (size_t ii(0); ii < entering.size(); ++ii) {
+      ssize_t const ix(entering[ii].first);
+      ssize_t const iy(entering[ii].second);
+      m_cspace->AttachVertex(recycled[ii], ix, iy, gm ? (*gm)(ix, iy) : meta);
+    }
+    for (size_t ii(0); ii < recycled.size(); ++ii)
+      algo.AddVertex(recycled[ii], kernel);
+    
+    return recycled.size();
+  }
+  
+  
   ssize_t Grid::
   GetXBegin() const
   {
-    return m_flexgrid->xbegin();
+    return m_xbegin;
   }
   
   
   ssize_t Grid::
   GetXEnd() const
   {
-    return m_flexgrid->xend();
+    return m_xend;
   }
   
   
   ssize_t Grid::
   GetYBegin() const
   {
-    return m_flexgrid->ybegin();
+    return m_ybegin;
   }
   
   
   ssize_t Grid::
   GetYEnd() const
   {
-    return m_flexgrid->yend();
+    return m_yend;
   }
   
   
   boost::shared_ptr<GridNode const> Grid::
   GetNode(ssize_t ix, ssize_t iy) const
   {
-    vertex_data_t node;
-    if (m_flexgrid->valid(ix, iy))
-      node = m_flexgrid->at(ix, iy);
-    return node;
+    vertex_t const vertex(m_cspace->FindVertex(ix, iy));
+    if (CSpaceGraph::null_vertex == vertex)
+      return shared_ptr<GridNode const>();
+    return m_cspace->Lookup(vertex);
   }
   
   
-  Grid::vertex_data_t Grid::
+  vertex_t Grid::
   DoAddNode(ssize_t ix, ssize_t iy, double meta)
   {
-    vertex_data_t node(new GridNode());
-    node->ix = ix;
-    node->iy = iy;
-    node->vertex = m_cspace->AddVertex(node);
-    m_flexgrid->at(ix, iy) = node;
-    m_cspace->SetMeta(node->vertex, meta);
-    
-    for (nbor_offset_t::const_iterator in(m_nbor_offset.begin());
-	 in != m_nbor_offset.end(); ++in) {
-      ssize_t const nx(ix + in->dx);
-      ssize_t const ny(iy + in->dy);
-      if (m_flexgrid->valid(nx, ny)) {
-	vertex_data_t const nbor(m_flexgrid->at(nx, ny));
-	if (nbor)
-	  m_cspace->AddNeighbor(node->vertex, nbor->vertex);
-      }
-    }
-    
-    return node;
+    return m_cspace->AddVertex(ix, iy, meta);
   }
   
   
@@ -322,7 +729,7 @@ namespace estar {
     // this will compute garbage.
     for (edge_read_iteration iedge(m_cspace->begin(node->vertex));
 	 iedge.not_at_end(); ++iedge) {
-      shared_ptr<GridNode const> const nbor(m_cspace->Lookup(*iedge));
+      GridNode const * const nbor(&m_cspace->LookupNode(*iedge));
       if (node->ix == nbor->ix) {
 	if (node->iy > nbor->iy) {
 	  const double
@@ -31,7 +31,6 @@ namespace estar {
   
   class Algorithm;
   class Kernel;
-  template<typename value_t> class flexgrid;
   
   
   class Grid
@@ -43,6 +42,22 @@ namespace estar {
       SIX
     } neighborhood_t;
     
+    /** Order in which Init(), AddRange(), and Renumber() hand out
+	vertex IDs, see SetVertexOrder(). */
+    typedef enum {
+      /** X-major, the cells of a column get consecutive IDs */
+      COLUMN_ORDER,
+      /** blocks of 16x16 cells, X-major among and within blocks */
+      BLOCK_ORDER
+    } vertex_order_t;
+    
+    /** Provides the metas of cells, see AddRange(), MoveWindow(), and
+	SetTileSource(). */
+    struct get_meta {
+      virtual ~get_meta() {}
+      virtual double operator () (ssize_t ix, ssize_t iy) const = 0;
+    };
+    
     /** You have to call Init() before actually using the Grid
 	instance, otherwise you'll get segfaults. */
     explicit Grid(neighborhood_t neighborhood);
@@ -62,6 +77,114 @@ namespace estar {
 	      ssize_t ybegin, ssize_t yend,
 	      double meta);
     
+    /**
+       Like Init(), but the grid becomes a rolling window of fixed
+       size: instead of growing it with AddRange(), you move it
+       around with MoveWindow(), e.g. to keep it centered on the
+       robot. Memory and the cost of moving the window do not depend
+       on how far the window has travelled in total. Must be called
+       on a freshly constructed (empty) Grid.
+    */
+    void InitRolling(ssize_t xbegin, ssize_t xend,
+		     ssize_t ybegin, ssize_t yend,
+		     double meta);
+    
+    /**
+       Choose the order of vertex IDs for the cells that get created
+       from now on by Init() or AddRange() (which orders the cells
+       that it adds among themselves), and for Renumber(). The
+       default COLUMN_ORDER numbers the cells of each column
+       consecutively, so neighbors along X are a whole column apart
+       in the property arrays. BLOCK_ORDER keeps cells that are
+       close in the grid close in memory as well. With ComputeOne(),
+       the queue decides the order of the memory accesses, so this
+       only pays off on grids that do not fit into the cache, see
+       test_vertex_order. Tiled grids (see InitTiled()) always number
+       their vertices per tile.
+    */
+    void SetVertexOrder(vertex_order_t order) { m_vertex_order = order; }
+    
+    vertex_order_t GetVertexOrder() const { return m_vertex_order; }
+    
+    /**
+       Give all vertices new IDs that follow the order given to
+       SetVertexOrder() across the whole current range, and adapt the
+       Algorithm (queue, upwind edges, goals) accordingly, see
+       BaseCSpace::Renumber() and Algorithm::Renumber(). This undoes
+       the fragmentation that accumulates when the grid grows with
+       AddRange() or AddNode(). Vertex IDs and GridNode pointers that
+       have been obtained beforehand become meaningless.
+       
+       \return The number of vertices whose ID changed, which is
+       always zero for rolling and tiled grids.
+    */
+    size_t Renumber(Algorithm & algo);
+    
+    /** \return true if InitRolling() has been used. */
+    bool IsRolling() const;
+    
+    /**
+       Like Init(), but the grid is sparse: the given range only
+       limits which cells can exist, and they get created in square
+       tiles of tilesize times tilesize cells (a power of two) when
+       they are first needed, by AddRange(), AddNode(), AddTile(), or
+       ExpandTiles(). Cells of tiles that do not exist yet are
+       considered to have the given meta, but GetNode() returns null
+       for them. This is meant for maps that are too large to
+       allocate up front, where the wavefront between goal and robot
+       only covers a small part. Must be called on a freshly
+       constructed (empty) Grid.
+    */
+    void InitTiled(ssize_t xbegin, ssize_t xend,
+		   ssize_t ybegin, ssize_t yend,
+		   ssize_t tilesize, double meta);
+    
+    /** \return true if InitTiled() has been used. */
+    bool IsTiled() const;
+    
+    /** \return The tile size, or zero if the grid is not tiled. */
+    ssize_t GetTileSize() const;
+    
+    /**
+       Make the cells of tiles that get created from now on take
+       their metas from gm instead of the meta given to InitTiled(),
+       e.g. from a TileStore. This does not apply to the cells whose
+       meta is passed to AddRange() or AddNode() explicitly. Pass null
+       to go back to the meta given to InitTiled(). The source has to
+       outlive the grid or be removed before it is destroyed.
+    */
+    void SetTileSource(get_meta const * gm) { m_tile_source = gm; }
+    
+    /** \return The meta of (ix, iy) for when its tile does not exist
+	yet, see InitTiled() and SetTileSource(). */
+    double GetTileMeta(ssize_t ix, ssize_t iy) const
+    { return m_tile_source ? (*m_tile_source)(ix, iy) : m_tile_meta; }
+    
+    /**
+       Create the tile that contains (ix, iy) of a tiled grid (see
+       InitTiled()). Its cells get their meta from GetTileMeta() and
+       are registered with Algorithm::AddVertex().
+       
+       \return The number of added vertices, zero if the grid is not
+       tiled, if (ix, iy) lies outside the range, or if the tile
+       already exists.
+    */
+    size_t AddTile(ssize_t ix, ssize_t iy,
+		   Algorithm & algo, Kernel const & kernel);
+    
+    /**
+       Create the missing tiles (see AddTile()) that contain
+       neighbors of the given vertex. Facade calls this for each
+       vertex that the propagation lowers (see
+       Algorithm::SetLowerHook()), such that tiles get created when
+       the wavefront reaches them. This costs next to nothing for
+       vertices that do not lie on the border of their tile.
+       
+       \return The number of added vertices.
+    */
+    size_t ExpandTiles(vertex_t vertex,
+		       Algorithm & algo, Kernel const & kernel);
+    
     /**
        Makes sure that the required range of indices is available,
        where (xend, yend) is the ONE-PAST-end marker for the X- and Y-
@@ -76,6 +199,14 @@ namespace estar {
        \note This method calls Algorithm::AddVertex() in order to
        properly register any new nodes with the wavefront queue.
        
+       \note A rolling grid (see InitRolling()) is always complete,
+       so this method does nothing in that case.
+       
+       \note A tiled grid (see InitTiled()) gets all missing tiles
+       that overlap with the range. Their cells outside of the range
+       get their meta from GetTileMeta(), and they are included in
+       the returned count.
+       
        \return The number of added vertices.
     */
     size_t AddRange(ssize_t xbegin, ssize_t xend,
@@ -83,11 +214,6 @@ namespace estar {
 		    double meta,
 		    Algorithm & algo, Kernel const & kernel);
     
-    struct get_meta {
-      virtual ~get_meta() {}
-      virtual double operator () (ssize_t ix, ssize_t iy) const = 0;
-    };
-    
     size_t AddRange(ssize_t xbegin, ssize_t xend,
 		    ssize_t ybegin, ssize_t yend,
 		    get_meta const * gm,
@@ -100,12 +226,41 @@ namespace estar {
        
        \note All freshly added nodes get assigned a value of infinity.
        
+       \note In a tiled grid, this creates the whole tile, see
+       AddTile().
+       
        \return true if a new GridNode was allocated and inserted into
        the grid.
     */
     bool AddNode(ssize_t ix, ssize_t iy, double meta,
 		 Algorithm & algo, Kernel const & kernel);
     
+    /**
+       Move the window of a rolling grid (see InitRolling()) such that
+       it starts at (xbegin, ybegin). The vertices of the cells that
+       leave the window are taken out of the algorithm with
+       Algorithm::RemoveVertex() and recycled for the cells that enter
+       it, which get the given meta and are registered with
+       Algorithm::AddVertex(). The other cells keep their vertex,
+       value, and upwind edges among each other, so the wavefront
+       only has to cover the new cells. Throws std::logic_error if
+       the grid is not rolling.
+       
+       \note Goals that leave the window are dropped. The values
+       computed from them stay in the remaining cells though, and
+       keep propagating into the new ones. A raise (e.g. from
+       SetMeta()) that reaches cells whose upwind neighbors have left
+       the window can not be repaired correctly though, because the
+       information it would need is gone.
+       
+       \return The number of recycled vertices.
+    */
+    size_t MoveWindow(ssize_t xbegin, ssize_t ybegin, double meta,
+		      Algorithm & algo, Kernel const & kernel);
+    
+    size_t MoveWindow(ssize_t xbegin, ssize_t ybegin, get_meta const * gm,
+		      Algorithm & algo, Kernel const & kernel);
+    
     
     ssize_t GetXBegin() const;
     
@@ -178,28 +333,66 @@ namespace estar {
     neighborhood_t GetNeighborhood() const { return m_neighborhood; }
     
   private:
-    typedef GridCSpace::vertex_data_t vertex_data_t;
-    typedef flexgrid<vertex_data_t> flexgrid_t;
-
-    struct offset {
-      offset(ssize_t _dx, ssize_t _dy): dx(_dx), dy(_dy) {}
-      ssize_t dx, dy;
-    };
-    
-    typedef std::vector<offset> nbor_offset_t;
-    
     neighborhood_t const m_neighborhood;
-    nbor_offset_t m_nbor_offset;
     
-    boost::shared_ptr<flexgrid_t> m_flexgrid;
+    /** Range of indices, grown by Init(), AddRange(), and AddNode(),
+	or moved by MoveWindow(). */
+    ssize_t m_xbegin, m_xend, m_ybegin, m_yend;
+    
     boost::shared_ptr<GridCSpace> m_cspace;
     
+    /** meta of cells in missing tiles, see InitTiled() */
+    double m_tile_meta;
+    
+    /** overrides m_tile_meta unless null, see SetTileSource() */
+    get_meta const * m_tile_source;
+    
+    vertex_order_t m_vertex_order;
+    
     
     /**
-       Blindly allocate a new node and add it to the flexgrid, hooking
-       it up with its neighbors and initializing its meta.
+       Blindly add a new node to the C-space and initialize its
+       meta. The neighbors are implied by the grid topology.
     */
-    vertex_data_t DoAddNode(ssize_t ix, ssize_t iy, double meta);
+    vertex_t DoAddNode(ssize_t ix, ssize_t iy, double meta);
+    
+    /** Extend the index range to include [xbegin, xend[ x [ybegin,
+	yend[. */
+    void GrowRange(ssize_t xbegin, ssize_t xend,
+		   ssize_t ybegin, ssize_t yend);
+    
+    /** Implements both MoveWindow() methods, gm overrides meta
+	unless it is null. */
+    size_t DoMoveWindow(ssize_t xbegin, ssize_t ybegin,
+			double meta, get_meta const * gm,
+			Algorithm & algo, Kernel const & kernel);
+    
+    /** Create the tile that contains (ix, iy) unless it exists or
+	lies outside the range. Its cells within [xbegin, xend[ x
+	[ybegin, yend[ get gm or meta (gm overrides meta unless it is
+	null), the others GetTileMeta(). */
+    size_t DoAddTile(ssize_t ix, ssize_t iy,
+		     ssize_t xbegin, ssize_t xend,
+		     ssize_t ybegin, ssize_t yend,
+		     double meta, get_meta const * gm,
+		     Algorithm & algo, Kernel const & kernel);
+    
+    /** Sort cells of the current range by the order given to
+	SetVertexOrder(). */
+    void SortCells(std::vector<std::pair<ssize_t, ssize_t> > & cells) const;
+    
+    /** Implements AddRange() for orders other than COLUMN_ORDER, gm
+	overrides meta unless it is null. */
+    size_t AddSortedRange(ssize_t xbegin, ssize_t xend,
+			  ssize_t ybegin, ssize_t yend,
+			  double meta, get_meta const * gm,
+			  Algorithm & algo, Kernel const & kernel);
+    
+    /** Implements AddRange() for tiled grids. */
+    size_t AddTileRange(ssize_t xbegin, ssize_t xend,
+			ssize_t ybegin, ssize_t yend,
+			double meta, get_meta const * gm,
+			Algorithm & algo, Kernel const & kernel);
     
     void InitNborStuff();
   };
@@ -24,6 +24,7 @@
 
 #include <estar/CSpace.hpp>
 #include <boost/shared_ptr.hpp>
+#include <deque>
 
 #ifdef WIN32
 # include <estar/win32.hpp>
@@ -71,25 +72,111 @@ namespace estar {
   
   
   /**
+     C-space of a Grid. The topology is implicit (see
+     CSpaceGraph::InitGrid()), and the GridNode instances live in a
+     single shared pool instead of being allocated one by one.
+     
      \todo Move this somewhere else?
   */
   class GridCSpace
-    : public CustomCSpace<boost::shared_ptr<GridNode> >
+    : public BaseCSpace
   {
   public:
-    GridCSpace(boost::shared_ptr<grid_postransform const> postransform,
-	       boost::shared_ptr<grid_bbox_compute const> bbox_compute)
-      : m_postransform(postransform), m_bbox_compute(bbox_compute) {}
+    GridCSpace(CSpaceGraph::neighborhood_t const & neighborhood,
+	       boost::shared_ptr<grid_postransform const> postransform,
+	       boost::shared_ptr<grid_bbox_compute const> bbox_compute);
+    
+    /** Create a vertex at (ix, iy), which must not exist yet. */
+    vertex_t AddVertex(ssize_t ix, ssize_t iy, double meta);
+    
+    /** Preallocate a range of indices, see CSpaceGraph::ReserveGrid(). */
+    void Reserve(ssize_t xbegin, ssize_t xend, ssize_t ybegin, ssize_t yend);
+    
+    /** Switch to a fixed-size window that can be moved around, see
+	CSpaceGraph::InitRollingGrid(). Must be called before adding
+	any vertices. */
+    void InitRolling(ssize_t xbegin, ssize_t xsize,
+		     ssize_t ybegin, ssize_t ysize)
+    { m_cspace.InitRollingGrid(xbegin, xsize, ybegin, ysize); }
+    
+    bool IsRolling() const { return m_cspace.IsRollingGrid(); }
+    
+    /** See CSpaceGraph::SetGridWindow(). */
+    void SetWindow(ssize_t xbegin, ssize_t ybegin)
+    { m_cspace.SetGridWindow(xbegin, ybegin); }
+    
+    /** See CSpaceGraph::DetachGridVertex(). */
+    void DetachVertex(vertex_t vertex)
+    { m_cspace.DetachGridVertex(vertex); }
+    
+    /**
+       Recycle a detached vertex for the cell at (ix, iy), see
+       CSpaceGraph::AttachGridVertex(). Its GridNode gets the new
+       indices, which is also visible through any pointer obtained
+       from Lookup() beforehand.
+    */
+    void AttachVertex(vertex_t vertex, ssize_t ix, ssize_t iy, double meta);
+    
+    /** Switch to tiles that get created on demand, see
+	CSpaceGraph::InitTiledGrid(). Must be called before adding
+	any vertices. */
+    void InitTiled(ssize_t xbegin, ssize_t xsize,
+		   ssize_t ybegin, ssize_t ysize, ssize_t tilesize)
+    { m_cspace.InitTiledGrid(xbegin, xsize, ybegin, ysize, tilesize); }
+    
+    bool IsTiled() const { return m_cspace.IsTiledGrid(); }
+    
+    /** \return The tile size, or zero if not tiled. */
+    ssize_t GetTileSize() const { return m_cspace.GetGridTileSize(); }
+    
+    /**
+       Create the tile that contains (ix, iy), see
+       CSpaceGraph::AddGridTile(). All of its vertices get the given
+       meta, including those beyond the end of the range.
+       
+       \return The first vertex of the tile.
+    */
+    vertex_t AddTile(ssize_t ix, ssize_t iy, double meta);
+    
+    bool HaveTile(ssize_t ix, ssize_t iy) const
+    { return m_cspace.HaveGridTile(ix, iy); }
+    
+    size_t GetNTiles() const { return m_cspace.GetNGridTiles(); }
+    
+    /** See CSpaceGraph::GetGridTile(). */
+    void GetTile(size_t tile, ssize_t & x0, ssize_t & y0) const
+    { m_cspace.GetGridTile(tile, x0, y0); }
+    
+    /**
+       Like BaseCSpace::Renumber(), but also moves the GridNode
+       instances along. Pointers obtained from Lookup() stay valid,
+       but then refer to whatever vertex got their old ID. Throws
+       std::logic_error in tiled mode.
+    */
+    void Renumber(std::vector<vertex_t> const & newid);
+    
+    /** \return The vertex at (ix, iy), or CSpaceGraph::null_vertex. */
+    vertex_t FindVertex(ssize_t ix, ssize_t iy) const
+    { return m_cspace.FindGridVertex(ix, iy); }
+    
+    /** Shares ownership of the node pool, it does not allocate. Use
+	LookupNode() in tight loops to avoid the reference counting. */
+    boost::shared_ptr<GridNode const> Lookup(vertex_t vertex) const
+    { return boost::shared_ptr<GridNode const>(m_node, &(*m_node)[vertex]); }
+    
+    GridNode const & LookupNode(vertex_t vertex) const
+    { return (*m_node)[vertex]; }
     
     std::pair<double, double> ComputePosition(vertex_t vertex) const {
-      boost::shared_ptr<GridNode const> const gg(Lookup(vertex));
-      return (*m_postransform)(gg->ix, gg->iy);
+      GridNode const & gg(LookupNode(vertex));
+      return (*m_postransform)(gg.ix, gg.iy);
     }
     
     void ComputeBBox(double & x0, double & y0, double & x1, double & y1) const
     { (*m_bbox_compute)(x0, y0, x1, y1); }
     
   protected:
+    boost::shared_ptr<std::deque<GridNode> > m_node;
     boost::shared_ptr<grid_postransform const> m_postransform;
     boost::shared_ptr<grid_bbox_compute const> m_bbox_compute;
   };
@@ -0,0 +1,63 @@
+/* 
+ * Copyright (C) 2005 Roland Philippsen <roland dot philippsen at gmx net>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+#include "Heuristic.hpp"
+#include "GridNode.hpp"
+#include <cmath>
+
+
+namespace estar {
+  
+  
+  Heuristic::
+  ~Heuristic()
+  {
+  }
+  
+  
+  double Heuristic::
+  GetTriangleSlack() const
+  {
+    return 0;
+  }
+  
+  
+  GridHeuristic::
+  GridHeuristic(boost::shared_ptr<GridCSpace const> cspace,
+		ssize_t _focus_ix, ssize_t _focus_iy, double _weight)
+    : focus_ix(_focus_ix),
+      focus_iy(_focus_iy),
+      weight(_weight),
+      m_cspace(cspace)
+  {
+  }
+  
+  
+  double GridHeuristic::
+  Estimate(vertex_t vertex) const
+  {
+    GridNode const & node(m_cspace->LookupNode(vertex));
+    const double dx(static_cast<double>(node.ix - focus_ix));
+    const double dy(static_cast<double>(node.iy - focus_iy));
+    return weight * sqrt(dx * dx + dy * dy);
+  }
+  
+} // namespace estar
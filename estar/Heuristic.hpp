@@ -0,0 +1,85 @@
+/* 
+ * Copyright (C) 2005 Roland Philippsen <roland dot philippsen at gmx net>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+#ifndef ESTAR_HEURISTIC_HPP
+#define ESTAR_HEURISTIC_HPP
+
+
+#include <estar/base.hpp>
+#include <boost/shared_ptr.hpp>
+
+
+namespace estar {
+  
+  
+  class GridCSpace;
+  
+  
+  /**
+     Estimate of the cost between a vertex and a fixed focus vertex
+     (typically the robot), used by Queue to focus the propagation on
+     the robot. The estimate must never exceed the value difference
+     that the Kernel would produce between the two vertices
+     (admissibility), and it should fulfill the triangle inequality
+     such that moving the focus can be handled with a key modifier,
+     see Algorithm::SetFocus().
+  */
+  class Heuristic
+  {
+  public:
+    virtual ~Heuristic();
+    
+    /** \return The estimated cost between vertex and the focus. */
+    virtual double Estimate(vertex_t vertex) const = 0;
+    
+    /** \return How much the estimates of this heuristic and the one
+	for a new focus can miss the triangle inequality, see
+	Queue::SetFocus(). The default is zero. */
+    virtual double GetTriangleSlack() const;
+  };
+  
+  
+  /**
+     Euclidean distance to a grid cell, in cell units, multiplied by a
+     weight. For LSMKernel with meta values no larger than the
+     freespace meta, a weight of Kernel::GetHeuristicWeight() is
+     admissible.
+  */
+  class GridHeuristic
+    : public Heuristic
+  {
+  public:
+    GridHeuristic(boost::shared_ptr<GridCSpace const> cspace,
+		  ssize_t focus_ix, ssize_t focus_iy, double weight);
+    
+    virtual double Estimate(vertex_t vertex) const;
+    
+    const ssize_t focus_ix;
+    const ssize_t focus_iy;
+    const double weight;
+    
+  protected:
+    boost::shared_ptr<GridCSpace const> m_cspace;
+  };
+  
+} // namespace estar
+
+#endif // ESTAR_HEURISTIC_HPP
@@ -0,0 +1,463 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+#include "HierarchicalFacade.hpp"
+#include "Facade.hpp"
+#include "Heuristic.hpp"
+#include "Grid.hpp"
+#include "Kernel.hpp"
+#include "numeric.hpp"
+#include <cmath>
+
+
+using namespace boost;
+using namespace std;
+
+
+namespace estar {
+  
+  
+  /**
+     Cost-to-robot estimate for the fine level: the larger of the
+     weighted Euclidean distance and the value of the coarse block
+     (lowered by the slack), where the coarse level has one.
+  */
+  class CoarseHeuristic
+    : public Heuristic
+  {
+  public:
+    CoarseHeuristic(shared_ptr<GridCSpace const> cspace,
+		    ssize_t _focus_ix, ssize_t _focus_iy, double _weight,
+		    ssize_t _xbegin, ssize_t _ybegin, size_t _shift,
+		    ssize_t _ysize, shared_ptr<vector<double> const> coarse,
+		    double _slack)
+      : focus_ix(_focus_ix), focus_iy(_focus_iy), weight(_weight),
+	xbegin(_xbegin), ybegin(_ybegin), shift(_shift), ysize(_ysize),
+	slack(_slack), m_cspace(cspace), m_coarse(coarse) {}
+    
+    virtual double Estimate(vertex_t vertex) const
+    {
+      GridNode const & node(m_cspace->LookupNode(vertex));
+      const double dx(static_cast<double>(node.ix - focus_ix));
+      const double dy(static_cast<double>(node.iy - focus_iy));
+      const double euclid(weight * sqrt(dx * dx + dy * dy));
+      const double coarse((*m_coarse)[((node.ix - xbegin) >> shift) * ysize
+				       + ((node.iy - ybegin) >> shift)]);
+      if ((infinity == coarse) || (coarse - slack < euclid))
+	return euclid;
+      return coarse - slack;
+    }
+    
+    /** Lowering the coarse values by the slack can break the
+	triangle inequality by as much again, on top of the
+	discretization error of the coarse level. */
+    virtual double GetTriangleSlack() const { return 2 * slack; }
+    
+    const ssize_t focus_ix, focus_iy;
+    const double weight;
+    const ssize_t xbegin, ybegin;
+    const size_t shift;
+    const ssize_t ysize;
+    const double slack;
+    
+  protected:
+    shared_ptr<GridCSpace const> m_cspace;
+    shared_ptr<vector<double> const> m_coarse;
+  };
+  
+  
+  HierarchicalFacade::
+  HierarchicalFacade(shared_ptr<Facade> fine,
+		     shared_ptr<Facade> coarse,
+		     ssize_t xbegin, ssize_t ybegin,
+		     size_t _nlevels)
+    : nlevels(_nlevels),
+      factor(static_cast<ssize_t>(1) << _nlevels),
+      m_fine(fine),
+      m_coarse(coarse),
+      m_xbegin(xbegin),
+      m_ybegin(ybegin),
+      m_have_robot(false),
+      m_robot_ix(0),
+      m_robot_iy(0),
+      m_margin(0),
+      m_focus_ix(0),
+      m_focus_iy(0),
+      m_dirty(false),
+      m_coarse_dirty(false)
+  {
+    shared_ptr<Grid const> grid(fine->GetGrid());
+    ssize_t xsize(grid->GetXEnd() - grid->GetXBegin());
+    ssize_t ysize(grid->GetYEnd() - grid->GetYBegin());
+    for (size_t ii(0); ii < nlevels; ++ii) {
+      xsize = (xsize + 1) / 2;
+      ysize = (ysize + 1) / 2;
+      m_level.push_back(level(xsize, ysize, fine->GetFreespaceMeta()));
+    }
+  }
+  
+  
+  HierarchicalFacade * HierarchicalFacade::
+  Create(const std::string & kernel_name,
+	 double scale,
+	 GridOptions const & grid_options,
+	 AlgorithmOptions const & algo_options,
+	 size_t nlevels,
+	 FILE * dbgstream)
+  {
+    if (0 == nlevels) {
+      if (0 != dbgstream)
+	fprintf(dbgstream, "ERROR in %s(): nlevels must be positive\n",
+		__FUNCTION__);
+      return 0;
+    }
+    shared_ptr<Facade> fine(Facade::Create(kernel_name, scale, grid_options,
+					   algo_options, dbgstream));
+    if ( ! fine) {
+      if (0 != dbgstream)
+	fprintf(dbgstream,
+		"ERROR in %s(): Facade::Create() failed for fine level\n",
+		__FUNCTION__);
+      return 0;
+    }
+    ssize_t const factor(static_cast<ssize_t>(1) << nlevels);
+    ssize_t const
+      xsize((grid_options.xend - grid_options.xbegin + factor - 1) / factor);
+    ssize_t const
+      ysize((grid_options.yend - grid_options.ybegin + factor - 1) / factor);
+    shared_ptr<Facade>
+      coarse(Facade::Create(kernel_name, scale * factor,
+			    GridOptions(0, xsize, 0, ysize,
+					grid_options.neighborhood),
+			    algo_options, dbgstream));
+    if ( ! coarse) {
+      if (0 != dbgstream)
+	fprintf(dbgstream,
+		"ERROR in %s(): Facade::Create() failed for coarse level\n",
+		__FUNCTION__);
+      return 0;
+    }
+    return new HierarchicalFacade(fine, coarse, grid_options.xbegin,
+				  grid_options.ybegin, nlevels);
+  }
+  
+  
+  double HierarchicalFacade::
+  GetLevelMeta(size_t lvl, ssize_t ix, ssize_t iy) const
+  {
+    if (0 == lvl)
+      return m_fine->GetMeta(ix + m_xbegin, iy + m_ybegin);
+    level const & lv(m_level[lvl - 1]);
+    return lv.meta[ix * lv.ysize + iy];
+  }
+  
+  
+  bool HierarchicalFacade::
+  SetMeta(ssize_t ix, ssize_t iy, double meta)
+  {
+    if (m_fine->GetMeta(ix, iy) == meta)
+      return m_fine->IsValidIndex(ix, iy);
+    if ( ! m_fine->SetMeta(ix, iy, meta))
+      return false;
+    
+    // Walk up the pyramid, re-combining the children of each block,
+    // until a block does not change.
+    double const obstacle(m_fine->GetObstacleMeta());
+    ssize_t cx(ix - m_xbegin);
+    ssize_t cy(iy - m_ybegin);
+    ssize_t cxsize(m_fine->GetGrid()->GetXEnd() - m_xbegin);
+    ssize_t cysize(m_fine->GetGrid()->GetYEnd() - m_ybegin);
+    for (size_t lvl(1); lvl <= nlevels; ++lvl) {
+      cx /= 2;
+      cy /= 2;
+      double best(GetLevelMeta(lvl - 1, 2 * cx, 2 * cy));
+      for (ssize_t jx(2 * cx); (jx < 2 * cx + 2) && (jx < cxsize); ++jx)
+	for (ssize_t jy(2 * cy); (jy < 2 * cy + 2) && (jy < cysize); ++jy) {
+	  double const child(GetLevelMeta(lvl - 1, jx, jy));
+	  if (absval(child - obstacle) > absval(best - obstacle))
+	    best = child;
+	}
+      level & lv(m_level[lvl - 1]);
+      double & old(lv.meta[cx * lv.ysize + cy]);
+      if (old == best)
+	break;
+      old = best;
+      if (nlevels == lvl) {
+	m_coarse->SetMeta(cx, cy, best);
+	m_dirty = true;
+	m_coarse_dirty = true;
+      }
+      cxsize = lv.xsize;
+      cysize = lv.ysize;
+    }
+    return true;
+  }
+  
+  
+  bool HierarchicalFacade::
+  AddGoal(ssize_t ix, ssize_t iy, double value)
+  {
+    return m_fine->AddGoal(ix, iy, value);
+  }
+  
+  
+  void HierarchicalFacade::
+  RemoveAllGoals()
+  {
+    m_fine->RemoveAllGoals();
+  }
+  
+  
+  bool HierarchicalFacade::
+  SetRobot(ssize_t robot_ix, ssize_t robot_iy, double margin)
+  {
+    if ( ! m_fine->IsValidIndex(robot_ix, robot_iy))
+      return false;
+    // Moving the focus along with the robot would raise the key
+    // modifier of the fine queue each time, which unparks vertices
+    // and pushes even settled cells beyond the horizon. The focus
+    // stays put instead, which IsSettled() tolerates as long as the
+    // heuristic fulfills the triangle inequality.
+    if (( ! m_heuristic) || (margin != m_margin))
+      m_dirty = true;
+    m_have_robot = true;
+    m_robot_ix = robot_ix;
+    m_robot_iy = robot_iy;
+    m_margin = margin;
+    return true;
+  }
+  
+  
+  void HierarchicalFacade::
+  ClearRobot()
+  {
+    m_have_robot = false;
+    m_dirty = false;
+    m_coarse_dirty = false;
+    m_heuristic.reset();
+    m_fine->ClearFocus();
+  }
+  
+  
+  void HierarchicalFacade::
+  UpdateFocus()
+  {
+    if ( ! (m_have_robot && m_dirty))
+      return;
+    m_dirty = false;
+    
+    ssize_t const cx((m_robot_ix - m_xbegin) / factor);
+    ssize_t const cy((m_robot_iy - m_ybegin) / factor);
+    if (( ! m_heuristic) || ((m_focus_ix - m_xbegin) / factor != cx)
+	|| ((m_focus_iy - m_ybegin) / factor != cy))
+      m_coarse->MoveGoal(cx, cy, 0);
+    m_focus_ix = m_robot_ix;
+    m_focus_iy = m_robot_iy;
+    while (m_coarse->HaveWork())
+      m_coarse->ComputeOne();
+    level const & top(m_level.back());
+    shared_ptr<vector<double> > coarse(new vector<double>(top.meta.size()));
+    for (ssize_t ix(0); ix < top.xsize; ++ix)
+      for (ssize_t iy(0); iy < top.ysize; ++iy)
+	(*coarse)[ix * top.ysize + iy] = m_coarse->GetValue(ix, iy);
+    
+    // When only the margin changed, the old and new heuristics
+    // fulfill the triangle inequality up to GetTriangleSlack(), and
+    // the parked vertices can stay where they are. After a change of
+    // the coarse metas they cannot, see Algorithm::SetFocus().
+    if (m_coarse_dirty) {
+      m_coarse_dirty = false;
+      m_fine->ClearFocus();
+    }
+    m_heuristic.reset(new CoarseHeuristic(m_fine->GetCSpace(),
+					  m_focus_ix, m_focus_iy,
+					  m_fine->GetKernel().
+					  GetHeuristicWeight(),
+					  m_xbegin, m_ybegin, nlevels,
+					  top.ysize, coarse,
+					  3 * m_coarse->GetScale()));
+    shared_ptr<GridNode const>
+      node(m_fine->GetGrid()->GetNode(m_focus_ix, m_focus_iy));
+    m_fine->GetAlgorithm().SetFocus(m_heuristic, node->vertex,
+				    m_margin * m_fine->GetScale());
+  }
+  
+  
+  void HierarchicalFacade::
+  ComputeOne()
+  {
+    UpdateFocus();
+    m_fine->ComputeOne();
+  }
+  
+  
+  compute_progress HierarchicalFacade::
+  ComputeUntil(double budget)
+  {
+    UpdateFocus();
+    if (m_have_robot)
+      return m_fine->ComputeUntil(m_robot_ix, m_robot_iy, budget);
+    // an invalid index makes Facade::ComputeUntil() propagate until
+    // the budget is used up or there is no work left
+    return m_fine->ComputeUntil(m_xbegin - 1, m_ybegin - 1, budget);
+  }
+  
+  
+  bool HierarchicalFacade::
+  GetFocus(ssize_t & ix, ssize_t & iy) const
+  {
+    if ( ! m_heuristic)
+      return false;
+    ix = m_focus_ix;
+    iy = m_focus_iy;
+    return true;
+  }
+  
+  
+  double HierarchicalFacade::
+  GetEstimate(ssize_t ix, ssize_t iy) const
+  {
+    if ( ! m_heuristic)
+      return 0;
+    shared_ptr<GridNode const> node(m_fine->GetGrid()->GetNode(ix, iy));
+    if ( ! node)
+      return infinity;
+    return m_heuristic->Estimate(node->vertex);
+  }
+  
+  
+  double HierarchicalFacade::
+  GetScale() const
+  {
+    return m_fine->GetScale();
+  }
+  
+  
+  double HierarchicalFacade::
+  GetFreespaceMeta() const
+  {
+    return m_fine->GetFreespaceMeta();
+  }
+  
+  
+  double HierarchicalFacade::
+  GetObstacleMeta() const
+  {
+    return m_fine->GetObstacleMeta();
+  }
+  
+  
+  double HierarchicalFacade::
+  GetValue(ssize_t ix, ssize_t iy) const
+  {
+    return m_fine->GetValue(ix, iy);
+  }
+  
+  
+  double HierarchicalFacade::
+  GetMeta(ssize_t ix, ssize_t iy) const
+  {
+    return m_fine->GetMeta(ix, iy);
+  }
+  
+  
+  bool HierarchicalFacade::
+  IsGoal(ssize_t ix, ssize_t iy) const
+  {
+    return m_fine->IsGoal(ix, iy);
+  }
+  
+  
+  bool HierarchicalFacade::
+  HaveWork() const
+  {
+    return m_fine->HaveWork();
+  }
+  
+  
+  HierarchicalFacade::node_status_t HierarchicalFacade::
+  GetStatus(ssize_t ix, ssize_t iy) const
+  {
+    return m_fine->GetStatus(ix, iy);
+  }
+  
+  
+  HierarchicalFacade::node_status_t HierarchicalFacade::
+  GetStatus(vertex_t vertex) const
+  {
+    return m_fine->GetStatus(vertex);
+  }
+  
+  
+  bool HierarchicalFacade::
+  IsValidIndex(ssize_t ix, ssize_t iy) const
+  {
+    return m_fine->IsValidIndex(ix, iy);
+  }
+  
+  
+  bool HierarchicalFacade::
+  GetLowestInconsistentValue(double & value) const
+  {
+    return m_fine->GetLowestInconsistentValue(value);
+  }
+  
+  
+  const Algorithm & HierarchicalFacade::
+  GetAlgorithm() const
+  {
+    return m_fine->GetAlgorithm();
+  }
+  
+  
+  const Kernel & HierarchicalFacade::
+  GetKernel() const
+  {
+    return m_fine->GetKernel();
+  }
+  
+  
+  int HierarchicalFacade::
+  TraceCarrot(double robot_x, double robot_y,
+	      double distance, double stepsize,
+	      size_t maxsteps,
+	      carrot_trace & trace,
+	      std::ostream * err_os) const
+  {
+    return m_fine->TraceCarrot(robot_x, robot_y, distance, stepsize,
+			       maxsteps, trace, err_os);
+  }
+  
+  
+  shared_ptr<GridCSpace const> HierarchicalFacade::
+  GetCSpace() const
+  {
+    return m_fine->GetCSpace();
+  }
+  
+  
+  shared_ptr<Grid const> HierarchicalFacade::
+  GetGrid() const
+  {
+    return m_fine->GetGrid();
+  }
+  
+} // namespace estar
@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+#ifndef ESTAR_HIERARCHICAL_FACADE_HPP
+#define ESTAR_HIERARCHICAL_FACADE_HPP
+
+
+#include <estar/FacadeReadInterface.hpp>
+#include <estar/Algorithm.hpp>
+#include <boost/shared_ptr.hpp>
+#include <vector>
+#include <stdio.h>
+
+
+namespace estar {
+  
+  
+  class Facade;
+  class Heuristic;
+  class GridOptions;
+  class AlgorithmOptions;
+  
+  
+  /**
+     Coarse-to-fine planner for large grids. Next to the full
+     resolution Facade, it maintains a pyramid of downsampled metas,
+     each level halving the resolution of the one below. A block
+     takes the meta of its child farthest from the obstacle meta
+     (the maximum for LSMKernel), so the coarse levels never make
+     anything more expensive than it is at the fine level: obstacles
+     that are thinner than a block vanish, thick ones remain.
+     
+     The coarsest level is itself a Facade, propagated from the
+     block of the robot (see SetRobot() for when it follows the
+     robot). Its values estimate the cost of getting from
+     any cell to the robot around the thick obstacles, and serve as
+     the Heuristic that focuses the fine propagation (see
+     Algorithm::SetFocus()). The fine wavefront then stays in a
+     corridor around the coarse path instead of the ellipse that the
+     Euclidean GridHeuristic of Facade::SetFocus() covers, and the
+     robot cell gets settled with a fraction of the expansions when
+     the path has to go around large obstacles.
+     
+     The coarse values are lowered by a slack of three coarse cells,
+     which covers the offsets between cells and block centers and the
+     discretization error of the coarse propagation, so that the
+     estimate stays admissible. The Euclidean distance is used
+     wherever it is larger or the coarse level has no value. As with
+     Facade::SetFocus(), the robot value can be slightly too high if
+     the margin is small, and the narrower corridor makes this a bit
+     more likely: a margin of 20 cells is a good start. Propagating
+     until HaveWork() returns false still computes the whole
+     navigation function.
+     
+     All reads go to the fine level, which is what the
+     FacadeReadInterface implementation forwards to.
+  */
+  class HierarchicalFacade
+    : public FacadeReadInterface
+  {
+  private:
+    HierarchicalFacade(boost::shared_ptr<Facade> fine,
+		       boost::shared_ptr<Facade> coarse,
+		       ssize_t xbegin, ssize_t ybegin,
+		       size_t nlevels);
+    
+  public:
+    /**
+       Uses Facade::Create() to initialize the fine level and the
+       coarsest level of the pyramid, which has
+       2<sup>nlevels</sup> times fewer cells along each axis.
+       
+       \return A fresh HierarchicalFacade instance, or null if
+       Facade::Create() failed or nlevels is zero.
+    */
+    static HierarchicalFacade *
+    Create(const std::string & kernel_name,
+	   double scale,
+	   GridOptions const & grid_options,
+	   AlgorithmOptions const & algo_options,
+	   /** number of downsampling steps, e.g. 4 for blocks of
+	       16x16 cells */
+	   size_t nlevels,
+	   FILE * dbgstream);
+    
+    const size_t nlevels;
+    /** edge length of a coarse block, in fine cells */
+    const ssize_t factor;
+    
+    /** Set the meta of a fine cell and update the pyramid above
+	it. */
+    bool SetMeta(ssize_t ix, ssize_t iy, double meta);
+    
+    bool AddGoal(ssize_t ix, ssize_t iy, double value);
+    void RemoveAllGoals();
+    
+    /**
+       Focus the fine propagation on the robot. Call this again
+       whenever the robot has moved to a different cell, so that
+       ComputeUntil() settles the right cell. The focus itself, and
+       with it the heuristic, only moves to the robot when the coarse
+       metas or the margin have changed: refocusing on every move
+       would push cells beyond the horizon that have long been
+       settled, see GetFocus(). The coarse level is repaired and the
+       focus is set up again lazily, at the next ComputeOne() or
+       ComputeUntil().
+       
+       \return false if the index is invalid, in which case nothing
+       changes.
+    */
+    bool SetRobot(ssize_t robot_ix, ssize_t robot_iy,
+		  /** horizon margin, in cells, see Facade::SetFocus() */
+		  double margin);
+    
+    /** Forget about the robot and propagate without focus. */
+    void ClearRobot();
+    
+    void ComputeOne();
+    
+    /**
+       Propagate the fine level until the robot cell is settled, see
+       Facade::ComputeUntil(). Without a robot, this propagates until
+       the budget is used up or there is no work left.
+    */
+    compute_progress ComputeUntil(/** seconds */
+				  double budget);
+    
+    /** \return The fine level. */
+    Facade const & GetFine() const { return * m_fine; }
+    
+    /** \return The coarsest level of the pyramid, whose goal is the
+	block of the focus, see GetFocus(). */
+    Facade const & GetCoarse() const { return * m_coarse; }
+    
+    /** Retrieve the fine cell that the heuristic estimates the cost
+	to. This is where the robot was at the latest focus update,
+	see SetRobot(). \return false if there is no focus. */
+    bool GetFocus(ssize_t & ix, ssize_t & iy) const;
+    
+    /** \return The heuristic estimate of the cost between a fine
+	cell and the focus, see GetFocus(), or zero if there is no
+	focus. */
+    double GetEstimate(ssize_t ix, ssize_t iy) const;
+    
+    virtual double GetScale() const;
+    virtual double GetFreespaceMeta() const;
+    virtual double GetObstacleMeta() const;
+    virtual double GetValue(ssize_t ix, ssize_t iy) const;
+    virtual double GetMeta(ssize_t ix, ssize_t iy) const;
+    virtual bool IsGoal(ssize_t ix, ssize_t iy) const;
+    virtual bool HaveWork() const;
+    virtual node_status_t GetStatus(ssize_t ix, ssize_t iy) const;
+    virtual node_status_t GetStatus(vertex_t vertex) const;
+    virtual bool IsValidIndex(ssize_t ix, ssize_t iy) const;
+    virtual bool GetLowestInconsistentValue(double & value) const;
+    virtual const Algorithm & GetAlgorithm() const;
+    virtual const Kernel & GetKernel() const;
+    virtual int TraceCarrot(double robot_x, double robot_y,
+			    double distance, double stepsize,
+			    size_t maxsteps,
+			    carrot_trace & trace,
+			    std::ostream * err_os) const;
+    virtual boost::shared_ptr<GridCSpace const> GetCSpace() const;
+    
+  protected:
+    virtual boost::shared_ptr<Grid const> GetGrid() const;
+    
+  private:
+    /** metas of one level of the pyramid, column-major */
+    struct level {
+      level(ssize_t _xsize, ssize_t _ysize, double meta)
+	: xsize(_xsize), ysize(_ysize), meta(_xsize * _ysize, meta) {}
+      ssize_t xsize, ysize;
+      std::vector<double> meta;
+    };
+    
+    /** \return The meta of a cell of the given level, where level
+	zero is the fine Facade. */
+    double GetLevelMeta(size_t lvl, ssize_t ix, ssize_t iy) const;
+    
+    /** Repair the coarse level and refocus the fine level if
+	anything changed since the last call. */
+    void UpdateFocus();
+    
+    boost::shared_ptr<Facade> m_fine;
+    boost::shared_ptr<Facade> m_coarse;
+    ssize_t const m_xbegin, m_ybegin;
+    /** m_level[ii] holds the metas downsampled ii+1 times, the last
+	one is mirrored in m_coarse */
+    std::vector<level> m_level;
+    bool m_have_robot;
+    ssize_t m_robot_ix, m_robot_iy;
+    double m_margin;
+    /** where the robot was at the latest focus update */
+    ssize_t m_focus_ix, m_focus_iy;
+    /** set when the focus has to be updated */
+    bool m_dirty;
+    /** set when the coarse metas changed */
+    bool m_coarse_dirty;
+    /** null unless the fine level is focused on the robot */
+    boost::shared_ptr<Heuristic const> m_heuristic;
+  };
+  
+} // namespace estar
+
+#endif // ESTAR_HIERARCHICAL_FACADE_HPP
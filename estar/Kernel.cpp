@@ -48,4 +48,11 @@ namespace estar {
   }
   
   
+  double Kernel::
+  GetHeuristicWeight() const
+  {
+    return 0;
+  }
+  
+  
 } // namespace estar
@@ -71,6 +71,16 @@ namespace estar {
     */
     virtual bool ChangeWouldRaise(double oldmeta, double newmeta) const;
     
+    /**
+       \return A lower bound on the value increase per cell of
+       (Euclidean) distance, assuming no meta is more favorable than
+       freespace_meta. Used as the weight of a GridHeuristic when
+       focusing the propagation on the robot, see
+       Facade::SetFocus(). The default implementation returns zero,
+       which is always admissible but does not focus anything.
+    */
+    virtual double GetHeuristicWeight() const;
+    
   protected:
     virtual
     double DoCompute(Propagator & propagator) const = 0;
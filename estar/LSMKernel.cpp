@@ -47,6 +47,13 @@ namespace estar {
   }
   
   
+  double LSMKernel::
+  GetHeuristicWeight() const
+  {
+    return scale / freespace_meta;
+  }
+  
+  
   double LSMKernel::
   DoCompute(Propagator & propagator) const
   {
@@ -61,16 +68,16 @@ namespace estar {
     // radius of the LSM's geometric interpretation
     double const radius(scale / target_meta);
     
-    const_queue_it iq, qend;
+    Propagator::nbor_it iq, qend;
     tie(iq, qend) = propagator.GetUpwindNeighbors();
     
     // There's always a primary propagator and thus at least one
     // backpointer. This is ensured by Kernel::Compute() before
     // calling this method.
-    const_queue_it const primary(iq);
+    Propagator::nbor_it const primary(iq);
     propagator.AddBackpointer(primary->second);
-    shared_ptr<GridNode const> const
-      primary_node(m_cspace->Lookup(primary->second));
+    GridNode const * const
+      primary_node(&m_cspace->LookupNode(primary->second));
     double const primary_value(primary->first);
     
     dbg << "\n  target_meta: " << target_meta
@@ -81,12 +88,12 @@ namespace estar {
     // Search for a secondary backpointer, which has to lie along
     // another axis than the primary. Use the fallback solution if no
     // such upwind neighbor exists.
-    shared_ptr<GridNode const> const
-      target_node(m_cspace->Lookup(propagator.GetTargetVertex()));
+    GridNode const * const
+      target_node(&m_cspace->LookupNode(propagator.GetTargetVertex()));
     bool const primary_is_along_x(target_node->ix != primary_node->ix);
     for (++iq; iq != qend; ++iq) {
-      shared_ptr<GridNode const> const
-	secondary_node(m_cspace->Lookup(iq->second));
+      GridNode const * const
+	secondary_node(&m_cspace->LookupNode(iq->second));
       bool const secondary_is_along_x(target_node->ix != secondary_node->ix);
       if(primary_is_along_x ^ secondary_is_along_x)
 	break;
@@ -97,7 +104,7 @@ namespace estar {
 	      dbg.str().c_str());
       return primary_value + radius;
     }
-    const_queue_it const secondary(iq);
+    Propagator::nbor_it const secondary(iq);
     double const secondary_value(secondary->first);
     dbg	<< "\n  secondary_node: " << secondary->second
 	<< "\n  secondary_value: " << secondary_value;
@@ -42,6 +42,10 @@ namespace estar {
     
     virtual bool ChangeWouldRaise(double oldmeta, double newmeta) const;
     
+    /** \return scale / freespace_meta, the distance a wave crosses
+	in one cell of freespace. */
+    virtual double GetHeuristicWeight() const;
+    
   protected:
     virtual double DoCompute(Propagator & propagator) const;
     
@@ -38,7 +38,7 @@ namespace estar {
   double NF1Kernel::
   DoCompute(Propagator & propagator) const
   {
-    const_queue_it iq, qend;
+    Propagator::nbor_it iq, qend;
     tie(iq, qend) = propagator.GetUpwindNeighbors();
     propagator.AddBackpointer(iq->second);
     return iq->first + propagator.GetTargetMeta();
@@ -19,7 +19,9 @@
 
 
 #include "Propagator.hpp"
+#include "pdebug.hpp"
 //#include "util.hpp"
+#include <boost/assert.hpp>
 
 
 using namespace std;
@@ -29,11 +31,23 @@ namespace estar {
   
   
   Propagator::
-  Propagator(vertex_t target_vertex, double target_meta)
-    : m_target_vertex(target_vertex),
-      m_target_meta(target_meta)
+  Propagator()
+    : m_target_vertex(0),
+      m_target_meta(0),
+      m_n_nbor(0),
+      m_n_bp(0)
   {
   }
+  
+  
+  void Propagator::
+  Reset(vertex_t target_vertex, double target_meta)
+  {
+    m_target_vertex = target_vertex;
+    m_target_meta = target_meta;
+    m_n_nbor = 0;
+    m_n_bp = 0;
+  }
 
 
   double Propagator::
@@ -43,39 +57,62 @@ namespace estar {
   }
   
   
-  std::pair<const_queue_it, const_queue_it> Propagator::
+  std::pair<Propagator::nbor_it, Propagator::nbor_it> Propagator::
   GetUpwindNeighbors() const
   {
-    return make_pair(m_nbor.begin(), m_nbor.end());
+    return make_pair(m_nbor, m_nbor + m_n_nbor);
+  }
+  
+  
+  void Propagator::
+  AddUpwindNeighbor(double value, vertex_t vertex)
+  {
+    // Same as std::multimap::insert(): equal values end up after the
+    // ones that are already there.
+    size_t pos(m_n_nbor);
+    while ((pos > 0) && (m_nbor[pos - 1].first > value))
+      --pos;
+    if (pos >= capacity) {
+      PDEBUG("dropping neighbor %lu, more than %lu candidates\n",
+	     vertex, capacity);
+      return;
+    }
+    if (m_n_nbor < capacity)
+      ++m_n_nbor;
+    for (size_t ii(m_n_nbor - 1); ii > pos; --ii)
+      m_nbor[ii] = m_nbor[ii - 1];
+    m_nbor[pos] = make_pair(value, vertex);
   }
   
   
   void Propagator::
   AddBackpointer(vertex_t cell)
   {
-    m_bp.push_back(cell);
+    BOOST_ASSERT(m_n_bp < capacity);
+    if (m_n_bp < capacity)
+      m_bp[m_n_bp++] = cell;
   }
   
   
   std::pair<Propagator::backpointer_it, Propagator::backpointer_it>
   Propagator::
-  GetBackpointers()
+  GetBackpointers() const
   {
-    return make_pair(m_bp.begin(), m_bp.end());
+    return make_pair(m_bp, m_bp + m_n_bp);
   }
   
   
   std::size_t Propagator::
   GetNBackpointers() const
   {
-    return m_bp.size();
+    return m_n_bp;
   }
   
   
   std::size_t Propagator::
   GetNUpwindNeighbors() const
   {
-    return m_nbor.size();
+    return m_n_nbor;
   }
   
   
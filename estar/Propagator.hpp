@@ -23,48 +23,70 @@
 
 
 #include <estar/base.hpp>
-#include <estar/Queue.hpp>
-#include <list>
+#include <estar/Upwind.hpp>
+#include <utility>
 
 
 namespace estar {
   
   
-  class Upwind;
   class Algorithm;
   
   
   /**
      Propagator set of a node. Used for filtering the neighborhood of
      a node before passing it to a specific Kernel subtype for
-     interpolation. To create a Propagator instance, use a
+     interpolation. To fill a Propagator instance, use a
      PropagatorFactory. This allows us to easily experiment with
      alternative formulations of how to compute the propagator set.
+     
+     Storage is a fixed-capacity array inside the object, so a
+     Propagator can live on the stack and be refilled without ever
+     touching the heap. The capacity matches the maximum number of
+     neighbors supported by Upwind.
   */
   class Propagator
   {
   private:
     friend class PropagatorFactory;
-    Propagator(vertex_t target_vertex, double target_meta);
     
   public:
-    typedef std::list<vertex_t> backpointer_t;
-    typedef backpointer_t::iterator backpointer_it;
+    static size_t const capacity = Upwind::nslots;
+    
+    /** (value, vertex) of an upwind neighbor */
+    typedef std::pair<double, vertex_t> nbor_t;
+    typedef nbor_t const * nbor_it;
+    typedef vertex_t const * backpointer_it;
+    
+    /** Creates an empty propagator set, use
+	PropagatorFactory::Create() to fill it. */
+    Propagator();
     
     double GetTargetMeta() const;
     vertex_t GetTargetVertex() const;
-    std::pair<const_queue_it, const_queue_it> GetUpwindNeighbors() const;
+    
+    /** \return The upwind neighbors, sorted by increasing value
+	(neighbors with the same value stay in insertion order). */
+    std::pair<nbor_it, nbor_it> GetUpwindNeighbors() const;
     std::size_t GetNUpwindNeighbors() const;
     
     void AddBackpointer(vertex_t vertex);
-    std::pair<backpointer_it, backpointer_it> GetBackpointers();
+    std::pair<backpointer_it, backpointer_it> GetBackpointers() const;
     std::size_t GetNBackpointers() const;
     
   private:
-    const vertex_t m_target_vertex;
-    const double m_target_meta;
-    queue_t m_nbor;
-    backpointer_t m_bp;
+    void Reset(vertex_t target_vertex, double target_meta);
+    
+    /** Insert a neighbor, keeping the array sorted. If it is full,
+	the candidate with the highest value gets dropped. */
+    void AddUpwindNeighbor(double value, vertex_t vertex);
+    
+    vertex_t m_target_vertex;
+    double m_target_meta;
+    nbor_t m_nbor[capacity];
+    std::size_t m_n_nbor;
+    vertex_t m_bp[capacity];
+    std::size_t m_n_bp;
   };
   
 } // namespace estar
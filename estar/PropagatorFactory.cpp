@@ -57,17 +57,16 @@ namespace estar {
   }
   
   
-  Propagator * PropagatorFactory::
-  Create(vertex_t target)
+  void PropagatorFactory::
+  Create(vertex_t target, Propagator & prop) const
+  {
+    Create(target, GetQueueBottom(), prop);
+  }
+  
+  
+  double PropagatorFactory::
+  GetQueueBottom() const
   {
-    Propagator * prop(new Propagator(target, get(m_meta, target)));
-    
-    // Goal nodes never get expanded, so this check "should not" be
-    // necessary, but in case we get here make sure that there are no
-    // neighbors to interpolate from.
-    if (get(m_flag, target) & GOAL)
-      return prop;
-    
     // This threshold fullfills two checks:
     // * if m_check_queue_key is false, it reverts to checking that a
     //   candidate neighbor is at least not an obstacle or un-computed
@@ -76,15 +75,28 @@ namespace estar {
     //   propagate from neighbors that lie below the current queue
     // * if m_check_queue_key is true but the queue is empty, we
     //   revert to the infinity check
-    double queue_bottom(infinity);
     if (m_check_queue_key && ( ! m_queue.IsEmpty()))
-      queue_bottom = m_queue.Get().begin()->first;
+      return m_queue.GetTopKey();
+    return infinity;
+  }
+  
+  
+  void PropagatorFactory::
+  Create(vertex_t target, double queue_bottom, Propagator & prop) const
+  {
+    prop.Reset(target, get(m_meta, target));
+    
+    // Goal nodes never get expanded, so this check "should not" be
+    // necessary, but in case we get here make sure that there are no
+    // neighbors to interpolate from.
+    if (get(m_flag, target) & GOAL)
+      return;
     
     // Loop over all neighbors, applying a configurable set of checks
     // on them.
     adjacency_it i_nbor;
     adjacency_it end_nbor;
-    tie(i_nbor, end_nbor) = adjacent_vertices(target, m_cspace);
+    boost::tie(i_nbor, end_nbor) = adjacent_vertices(target, m_cspace);
     for (/**/; i_nbor != end_nbor; ++i_nbor) {
       // If the target has been used to compute the neighbor's value,
       // then do not use the neighbor to compute ours as that would
@@ -114,10 +126,8 @@ namespace estar {
       if (nbor_value >= queue_bottom)
 	continue;
       
-      prop->m_nbor.insert(make_pair(nbor_value, *i_nbor));
+      prop.AddUpwindNeighbor(nbor_value, *i_nbor);
     }
-    
-    return prop;
   }
 
 
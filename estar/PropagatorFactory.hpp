@@ -51,7 +51,22 @@ namespace estar {
 		      /** use false to mimic old behavior */
 		      bool check_queue_key);
     
-    Propagator * Create(vertex_t target);
+    /** Refill prop with the propagator set of target. This does
+	not allocate, so prop can be a local variable or reused. */
+    void Create(vertex_t target, Propagator & prop) const;
+    
+    /** Like Create(target, prop), but with a queue bottom that has
+	been computed beforehand with GetQueueBottom(). This does not
+	touch the queue, which is not thread-safe even for const
+	methods, so it can be called from several threads at once as
+	long as nobody modifies the C-space or the upwind graph. */
+    void Create(vertex_t target, double queue_bottom,
+		Propagator & prop) const;
+    
+    /** \return The threshold below which the values of neighbors
+	are accepted by Create(), which is the top key of the queue if
+	check_queue_key is set and infinity otherwise. */
+    double GetQueueBottom() const;
     
   private:
     Queue const & m_queue;
@@ -0,0 +1,301 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+#include "QuadtreeCSpace.hpp"
+#include <stdexcept>
+
+
+using namespace std;
+
+
+namespace estar {
+  
+  
+  static ssize_t floor_power_of_two(ssize_t size)
+  {
+    ssize_t result(1);
+    while (2 * result <= size)
+      result *= 2;
+    return result;
+  }
+  
+  
+  QuadtreeCSpace::
+  QuadtreeCSpace(ssize_t _xsize, ssize_t _ysize, ssize_t _maxsize,
+		 double meta)
+    : xsize(_xsize),
+      ysize(_ysize),
+      maxsize(floor_power_of_two(_maxsize)),
+      m_fine_meta(_xsize * _ysize, meta)
+  {
+    Init();
+  }
+  
+  
+  QuadtreeCSpace::
+  QuadtreeCSpace(ssize_t _xsize, ssize_t _ysize, ssize_t _maxsize,
+		 vector<double> const & meta)
+    : xsize(_xsize),
+      ysize(_ysize),
+      maxsize(floor_power_of_two(_maxsize)),
+      m_fine_meta(meta)
+  {
+    if (static_cast<ssize_t>(meta.size()) != xsize * ysize)
+      throw invalid_argument("estar::QuadtreeCSpace: meta size mismatch");
+    Init();
+  }
+  
+  
+  void QuadtreeCSpace::
+  Init()
+  {
+    if ((xsize <= 0) || (ysize <= 0))
+      throw invalid_argument("estar::QuadtreeCSpace: empty map");
+    
+    ssize_t const nroots_x((xsize + maxsize - 1) / maxsize);
+    m_nroots_y = (ysize + maxsize - 1) / maxsize;
+    for (ssize_t bx(0); bx < nroots_x; ++bx)
+      for (ssize_t by(0); by < m_nroots_y; ++by)
+	m_block.push_back(block(bx * maxsize, by * maxsize, maxsize));
+    
+    // Top-down: split blocks that stick out of the map or whose meta
+    // varies. The loop also visits the children appended meanwhile.
+    for (size_t ib(0); ib < m_block.size(); ++ib) {
+      block const bb(m_block[ib]);
+      if ( ! IsInside(bb))
+	continue;
+      if ((bb.ix + bb.size > xsize) || (bb.iy + bb.size > ysize)
+	  || ( ! IsHomogeneous(bb)))
+	MakeChildren(ib);
+    }
+    
+    // Balance the tree. Splitting only ever makes the neighbors of a
+    // block smaller, and the new blocks get appended, so a single
+    // pass suffices.
+    m_nleaves = 0;
+    vertex_list_t retired;
+    vector<size_t> fresh;
+    vector<size_t> nbor;
+    for (size_t ib(0); ib < m_block.size(); ++ib) {
+      if ((0 != m_block[ib].child) || ( ! IsInside(m_block[ib])))
+	continue;
+      for (bool split(true); split; /**/) {
+	split = false;
+	nbor.clear();
+	GetFaceNeighbors(ib, nbor);
+	for (size_t in(0); in < nbor.size(); ++in)
+	  if (m_block[nbor[in]].size > 2 * m_block[ib].size) {
+	    Split(nbor[in], retired, fresh);
+	    split = true;
+	    break;
+	  }
+      }
+    }
+    
+    fresh.clear();
+    for (size_t ib(0); ib < m_block.size(); ++ib)
+      if (IsInside(m_block[ib]))
+	fresh.push_back(ib);
+    vertex_list_t added;
+    Connect(fresh, added);
+  }
+  
+  
+  vertex_t QuadtreeCSpace::
+  FindVertex(ssize_t ix, ssize_t iy) const
+  {
+    if ( ! IsValidIndex(ix, iy))
+      return cspace_t::null_vertex;
+    return m_block[FindBlock(ix, iy)].vertex;
+  }
+  
+  
+  double QuadtreeCSpace::
+  GetFineMeta(ssize_t ix, ssize_t iy) const
+  {
+    if ( ! IsValidIndex(ix, iy))
+      return 0;
+    return m_fine_meta[ix * ysize + iy];
+  }
+  
+  
+  void QuadtreeCSpace::
+  SetFineMeta(ssize_t ix, ssize_t iy, double meta)
+  {
+    if (IsValidIndex(ix, iy))
+      m_fine_meta[ix * ysize + iy] = meta;
+  }
+  
+  
+  vertex_t QuadtreeCSpace::
+  Refine(ssize_t ix, ssize_t iy, ssize_t size,
+	 vertex_list_t & retired, vertex_list_t & added)
+  {
+    if ( ! IsValidIndex(ix, iy))
+      return cspace_t::null_vertex;
+    vector<size_t> fresh;
+    size_t ib(FindBlock(ix, iy));
+    while (m_block[ib].size > size) {
+      Split(ib, retired, fresh);
+      ib = FindBlock(ix, iy);
+    }
+    Connect(fresh, added);
+    return m_block[ib].vertex;
+  }
+  
+  
+  size_t QuadtreeCSpace::
+  FindBlock(ssize_t ix, ssize_t iy) const
+  {
+    size_t ib((ix / maxsize) * m_nroots_y + iy / maxsize);
+    while (0 != m_block[ib].child) {
+      block const & bb(m_block[ib]);
+      ssize_t const half(bb.size / 2);
+      ib = bb.child;
+      if (ix >= bb.ix + half)
+	ib += 2;
+      if (iy >= bb.iy + half)
+	ib += 1;
+    }
+    return ib;
+  }
+  
+  
+  void QuadtreeCSpace::
+  GetFaceNeighbors(size_t ib, vector<size_t> & nbor) const
+  {
+    block const & bb(m_block[ib]);
+    ssize_t const xend(bb.ix + bb.size);
+    ssize_t const yend(bb.iy + bb.size);
+    if (bb.ix > 0)
+      for (ssize_t iy(bb.iy); iy < yend; /**/) {
+	size_t const in(FindBlock(bb.ix - 1, iy));
+	nbor.push_back(in);
+	iy = m_block[in].iy + m_block[in].size;
+      }
+    if (xend < xsize)
+      for (ssize_t iy(bb.iy); iy < yend; /**/) {
+	size_t const in(FindBlock(xend, iy));
+	nbor.push_back(in);
+	iy = m_block[in].iy + m_block[in].size;
+      }
+    if (bb.iy > 0)
+      for (ssize_t ix(bb.ix); ix < xend; /**/) {
+	size_t const in(FindBlock(ix, bb.iy - 1));
+	nbor.push_back(in);
+	ix = m_block[in].ix + m_block[in].size;
+      }
+    if (yend < ysize)
+      for (ssize_t ix(bb.ix); ix < xend; /**/) {
+	size_t const in(FindBlock(ix, yend));
+	nbor.push_back(in);
+	ix = m_block[in].ix + m_block[in].size;
+      }
+  }
+  
+  
+  void QuadtreeCSpace::
+  MakeChildren(size_t ib)
+  {
+    block const bb(m_block[ib]);
+    ssize_t const half(bb.size / 2);
+    m_block[ib].child = m_block.size();
+    m_block.push_back(block(bb.ix,        bb.iy,        half));
+    m_block.push_back(block(bb.ix,        bb.iy + half, half));
+    m_block.push_back(block(bb.ix + half, bb.iy,        half));
+    m_block.push_back(block(bb.ix + half, bb.iy + half, half));
+  }
+  
+  
+  void QuadtreeCSpace::
+  Split(size_t ib, vertex_list_t & retired, vector<size_t> & fresh)
+  {
+    // Neighbors larger than this block would end up four times as
+    // large as the children, so split them first. This recursion
+    // terminates because the tree is balanced before the split.
+    vector<size_t> nbor;
+    GetFaceNeighbors(ib, nbor);
+    for (size_t in(0); in < nbor.size(); ++in)
+      if ((0 == m_block[nbor[in]].child)
+	  && (m_block[nbor[in]].size > m_block[ib].size))
+	Split(nbor[in], retired, fresh);
+    
+    vertex_t const vertex(m_block[ib].vertex);
+    if (cspace_t::null_vertex != vertex) {
+      retired.push_back(vertex);
+      m_leaf[vertex] = false;
+      --m_nleaves;
+    }
+    MakeChildren(ib);
+    for (size_t ic(m_block[ib].child); ic < m_block[ib].child + 4; ++ic)
+      if (IsInside(m_block[ic]))
+	fresh.push_back(ic);
+  }
+  
+  
+  void QuadtreeCSpace::
+  Connect(vector<size_t> const & fresh, vertex_list_t & added)
+  {
+    vertex_t const first(num_vertices(m_cspace));
+    for (size_t ii(0); ii < fresh.size(); ++ii) {
+      block & bb(m_block[fresh[ii]]);
+      if ((0 != bb.child) || (cspace_t::null_vertex != bb.vertex))
+	continue;
+      bb.vertex = AddVertex(QuadtreeNode(bb.ix, bb.iy, bb.size),
+			    infinity, m_fine_meta[bb.ix * ysize + bb.iy]);
+      m_leaf.push_back(true);
+      ++m_nleaves;
+      added.push_back(bb.vertex);
+    }
+    
+    // Link the new vertices with all their neighbors. Edges between
+    // two new vertices get added only once, from the lower one.
+    vector<size_t> nbor;
+    for (size_t ii(0); ii < fresh.size(); ++ii) {
+      block const & bb(m_block[fresh[ii]]);
+      if ((0 != bb.child) || (bb.vertex < first))
+	continue;
+      nbor.clear();
+      GetFaceNeighbors(fresh[ii], nbor);
+      for (size_t in(0); in < nbor.size(); ++in) {
+	vertex_t const other(m_block[nbor[in]].vertex);
+	if ((other < first) || (other > bb.vertex))
+	  AddNeighbor(bb.vertex, other);
+      }
+    }
+  }
+  
+  
+  bool QuadtreeCSpace::
+  IsHomogeneous(block const & bb) const
+  {
+    double const meta(m_fine_meta[bb.ix * ysize + bb.iy]);
+    for (ssize_t ix(bb.ix); ix < bb.ix + bb.size; ++ix) {
+      vector<double>::const_iterator im(m_fine_meta.begin()
+					 + ix * ysize + bb.iy);
+      for (ssize_t iy(0); iy < bb.size; ++iy, ++im)
+	if (*im != meta)
+	  return false;
+    }
+    return true;
+  }
+  
+} // namespace estar
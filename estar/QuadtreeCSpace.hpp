@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+#ifndef ESTAR_QUADTREE_CSPACE_HPP
+#define ESTAR_QUADTREE_CSPACE_HPP
+
+
+#include <estar/CSpace.hpp>
+#include <vector>
+
+#ifdef WIN32
+# include <estar/win32.hpp>
+#endif // WIN32
+
+
+namespace estar {
+  
+  
+  /**
+     Square block of fine cells that is represented by a single vertex
+     of a QuadtreeCSpace. The lower left fine cell is (ix, iy), the
+     size is a power of two.
+  */
+  class QuadtreeNode
+  {
+  public:
+    QuadtreeNode() {}
+    
+    QuadtreeNode(ssize_t _ix, ssize_t _iy, ssize_t _size)
+      : ix(_ix), iy(_iy), size(_size) {}
+    
+    /** \return The X-coordinate of the center, in fine cells. */
+    double GetCenterX() const { return ix + 0.5 * (size - 1); }
+    
+    /** \return The Y-coordinate of the center, in fine cells. */
+    double GetCenterY() const { return iy + 0.5 * (size - 1); }
+    
+    ssize_t ix, iy, size;
+  };
+  
+  
+  /**
+     C-space for large maps with few details. The fine cells of an
+     xsize times ysize grid are covered by square blocks of at most
+     maxsize cells, and a block of homogeneous meta becomes a single
+     vertex. Blocks are split where the meta varies, down to single
+     cells. Vertices are linked to the blocks they share a face with,
+     and the tree is kept balanced such that neighboring blocks differ
+     in size by at most a factor of two, which limits the number of
+     neighbors of a vertex.
+     
+     Refine() splits blocks after the fact, e.g. when SetMeta
+     introduces detail into a large block. The vertex of a split
+     block is retired: it keeps its edges but no longer belongs to
+     any fine cell, and callers are expected to turn it into an
+     obstacle so that the propagation forgets about it. This way,
+     edges only ever get appended and the slots stay stable (see
+     Upwind). Blocks are merged only when the tree is built.
+     
+     Use QuadtreeLSMKernel to interpolate across blocks of different
+     sizes, and QuadtreeFacade for reading values at fine indices.
+  */
+  class QuadtreeCSpace
+    : public CustomCSpace<QuadtreeNode>
+  {
+  public:
+    typedef std::vector<vertex_t> vertex_list_t;
+    
+    /** Build a tree for a map of uniform meta. */
+    QuadtreeCSpace(ssize_t xsize, ssize_t ysize,
+		   /** largest block size, rounded down to a power of
+		       two */
+		   ssize_t maxsize,
+		   double meta);
+    
+    /** Build a tree from the metas of all fine cells, stored
+	column-major (at index ix * ysize + iy). */
+    QuadtreeCSpace(ssize_t xsize, ssize_t ysize, ssize_t maxsize,
+		   std::vector<double> const & meta);
+    
+    const ssize_t xsize, ysize, maxsize;
+    
+    bool IsValidIndex(ssize_t ix, ssize_t iy) const
+    { return (ix >= 0) && (ix < xsize) && (iy >= 0) && (iy < ysize); }
+    
+    /** \return The vertex of the block that contains the fine cell
+	(ix, iy), or cspace_t::null_vertex if the index is invalid. */
+    vertex_t FindVertex(ssize_t ix, ssize_t iy) const;
+    
+    /** \return The meta of a fine cell (not of the block it lies
+	in), or zero for invalid indices. */
+    double GetFineMeta(ssize_t ix, ssize_t iy) const;
+    
+    /**
+       Store the meta of a fine cell, without touching any
+       vertex. Call Refine() afterwards to make sure that the cell
+       lies in a block of its own. Invalid indices are ignored.
+    */
+    void SetFineMeta(ssize_t ix, ssize_t iy, double meta);
+    
+    /**
+       Split blocks until the fine cell (ix, iy) lies in a block of
+       at most the given size, splitting neighbors as required to keep
+       the tree balanced. The new vertices are already linked to
+       their neighbors and take their meta from the fine cells.
+       
+       \return The vertex of the block containing (ix, iy), or
+       cspace_t::null_vertex if the index is invalid.
+    */
+    vertex_t Refine(ssize_t ix, ssize_t iy, ssize_t size,
+		    /** vertices of blocks that got split are appended
+			here */
+		    vertex_list_t & retired,
+		    /** vertices of new blocks are appended here */
+		    vertex_list_t & added);
+    
+    /** \return true unless the vertex has been retired by
+	Refine(). */
+    bool IsLeaf(vertex_t vertex) const { return m_leaf[vertex]; }
+    
+    /** \return The number of vertices that have not been retired. */
+    size_t GetNLeaves() const { return m_nleaves; }
+    
+  private:
+    /** a block of the tree, the leaves have a vertex unless they lie
+	outside the map */
+    struct block {
+      block(ssize_t _ix, ssize_t _iy, ssize_t _size)
+	: ix(_ix), iy(_iy), size(_size), child(0),
+	  vertex(cspace_t::null_vertex) {}
+      ssize_t ix, iy, size;
+      /** index of the first of four children, zero for leaves */
+      size_t child;
+      vertex_t vertex;
+    };
+    
+    /** Build the tree from m_fine_meta. */
+    void Init();
+    
+    /** Append the four children of a leaf block. */
+    void MakeChildren(size_t ib);
+    
+    /** \return The leaf block that contains the (valid) fine cell
+	(ix, iy). */
+    size_t FindBlock(ssize_t ix, ssize_t iy) const;
+    
+    /** Append the leaf blocks that share a face with the given leaf
+	block. */
+    void GetFaceNeighbors(size_t ib, std::vector<size_t> & nbor) const;
+    
+    /** Split the given leaf block into four, after first splitting
+	any neighbors that would otherwise become unbalanced. The
+	vertex of the block (if any) is appended to retired, and the
+	children that lie within the map to fresh. */
+    void Split(size_t ib, vertex_list_t & retired,
+	       std::vector<size_t> & fresh);
+    
+    /** Create and link the vertices of those fresh blocks that are
+	still leaves. */
+    void Connect(std::vector<size_t> const & fresh, vertex_list_t & added);
+    
+    bool IsInside(block const & bb) const
+    { return (bb.ix < xsize) && (bb.iy < ysize); }
+    
+    bool IsHomogeneous(block const & bb) const;
+    
+    std::vector<double> m_fine_meta;
+    std::vector<block> m_block;
+    /** number of root blocks along Y */
+    ssize_t m_nroots_y;
+    std::vector<bool> m_leaf;
+    size_t m_nleaves;
+  };
+  
+} // namespace estar
+
+#endif // ESTAR_QUADTREE_CSPACE_HPP
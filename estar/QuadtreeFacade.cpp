@@ -0,0 +1,415 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+#include "QuadtreeFacade.hpp"
+#include "QuadtreeLSMKernel.hpp"
+#include "Facade.hpp"
+#include "Algorithm.hpp"
+#include "numeric.hpp"
+#include <iostream>
+#include <cmath>
+
+
+using namespace boost;
+using namespace std;
+
+
+namespace estar {
+  
+  
+  QuadtreeFacade::
+  QuadtreeFacade(shared_ptr<Algorithm> algo,
+		 shared_ptr<QuadtreeCSpace> cspace,
+		 shared_ptr<QuadtreeLSMKernel> kernel)
+    : scale(kernel->scale),
+      m_algo(algo),
+      m_cspace(cspace),
+      m_kernel(kernel)
+  {
+  }
+  
+  
+  QuadtreeFacade * QuadtreeFacade::
+  Create(shared_ptr<QuadtreeCSpace> cspace, double scale,
+	 AlgorithmOptions const & algo_options)
+  {
+    shared_ptr<QuadtreeLSMKernel> kernel(new QuadtreeLSMKernel(cspace, scale));
+    double const bucket_width(algo_options.bucket_width > 0
+			      ? algo_options.bucket_width
+			      : scale);
+    shared_ptr<Algorithm>
+      algo(new Algorithm(cspace,
+			 algo_options.check_upwind,
+			 algo_options.check_local_consistency,
+			 algo_options.check_queue_key,
+			 algo_options.auto_reset,
+			 algo_options.auto_flush,
+			 algo_options.queue_backend,
+			 bucket_width));
+    return new QuadtreeFacade(algo, cspace, kernel);
+  }
+  
+  
+  QuadtreeFacade * QuadtreeFacade::
+  Create(double scale, ssize_t xsize, ssize_t ysize, ssize_t maxsize,
+	 AlgorithmOptions const & algo_options)
+  {
+    shared_ptr<QuadtreeCSpace>
+      cspace(new QuadtreeCSpace(xsize, ysize, maxsize,
+				KernelTraits<QuadtreeLSMKernel>::
+				freespace_meta()));
+    return Create(cspace, scale, algo_options);
+  }
+  
+  
+  QuadtreeFacade * QuadtreeFacade::
+  Create(double scale, ssize_t xsize, ssize_t ysize, ssize_t maxsize,
+	 vector<double> const & meta,
+	 AlgorithmOptions const & algo_options)
+  {
+    shared_ptr<QuadtreeCSpace>
+      cspace(new QuadtreeCSpace(xsize, ysize, maxsize, meta));
+    return Create(cspace, scale, algo_options);
+  }
+  
+  
+  /** Blocks within this many times their size of a goal get split,
+      which keeps the discretization error around the goals in check,
+      where the relative error matters most. */
+  static ssize_t const goal_grading(8);
+  
+  
+  vertex_t QuadtreeFacade::
+  Refine(ssize_t ix, ssize_t iy, ssize_t size)
+  {
+    QuadtreeCSpace::vertex_list_t retired, added;
+    vertex_t const vertex(m_cspace->Refine(ix, iy, size, retired, added));
+    // Retired vertices become obstacles, which raises them and
+    // everything that was computed from them. The new vertices are
+    // not linked to the retired ones, so they only see valid values
+    // or values that are about to be raised.
+    for (size_t ii(0); ii < retired.size(); ++ii)
+      m_algo->SetMeta(retired[ii], m_kernel->obstacle_meta, *m_kernel);
+    for (size_t ii(0); ii < added.size(); ++ii)
+      m_algo->AddVertex(added[ii], *m_kernel);
+    return vertex;
+  }
+  
+  
+  bool QuadtreeFacade::
+  SetMeta(ssize_t ix, ssize_t iy, double meta)
+  {
+    if ( ! m_cspace->IsValidIndex(ix, iy))
+      return false;
+    if (absval(m_cspace->GetFineMeta(ix, iy) - meta) < epsilon)
+      return true;
+    m_cspace->SetFineMeta(ix, iy, meta);
+    // A fresh vertex already has the new meta, in which case
+    // Algorithm::SetMeta() does nothing.
+    m_algo->SetMeta(Refine(ix, iy, 1), meta, *m_kernel);
+    return true;
+  }
+  
+  
+  bool QuadtreeFacade::
+  AddGoal(ssize_t ix, ssize_t iy, double value)
+  {
+    if ( ! m_cspace->IsValidIndex(ix, iy))
+      return false;
+    vertex_t const vertex(Refine(ix, iy, 1));
+    for (ssize_t size(1); 2 * size <= m_cspace->maxsize; size *= 2) {
+      ssize_t const radius(goal_grading * size);
+      for (ssize_t dx(-radius); dx <= radius; dx += size)
+	for (ssize_t dy(-radius); dy <= radius; dy += size)
+	  if ((dx * dx + dy * dy <= radius * radius)
+	      && m_cspace->IsValidIndex(ix + dx, iy + dy))
+	    Refine(ix + dx, iy + dy, size);
+    }
+    m_algo->AddGoal(vertex, value);
+    return true;
+  }
+  
+  
+  void QuadtreeFacade::
+  RemoveAllGoals()
+  {
+    m_algo->RemoveAllGoals();
+  }
+  
+  
+  void QuadtreeFacade::
+  ComputeOne()
+  {
+    m_algo->ComputeOne(*m_kernel, scale / 10000);
+  }
+  
+  
+  double QuadtreeFacade::
+  GetScale() const
+  {
+    return scale;
+  }
+  
+  
+  double QuadtreeFacade::
+  GetFreespaceMeta() const
+  {
+    return m_kernel->freespace_meta;
+  }
+  
+  
+  double QuadtreeFacade::
+  GetObstacleMeta() const
+  {
+    return m_kernel->obstacle_meta;
+  }
+  
+  
+  double QuadtreeFacade::
+  ComputeGradient(vertex_t vertex, double & gx, double & gy) const
+  {
+    gx = 0;
+    gy = 0;
+    double const value(m_cspace->GetValue(vertex));
+    if (infinity == value)
+      return value;
+    
+    // Least-squares fit of a plane through the center of the block
+    // and the centers of its neighbors.
+    QuadtreeNode const & node(m_cspace->Lookup(vertex));
+    double const cx(node.GetCenterX());
+    double const cy(node.GetCenterY());
+    double sxx(0), sxy(0), syy(0), sxv(0), syv(0);
+    for (edge_read_iteration in(m_cspace->begin(vertex));
+	 in.not_at_end(); ++in) {
+      if ( ! m_cspace->IsLeaf(*in))
+	continue;
+      double const nval(m_cspace->GetValue(*in));
+      if (infinity == nval)
+	continue;
+      QuadtreeNode const & nbor(m_cspace->Lookup(*in));
+      double const dx(nbor.GetCenterX() - cx);
+      double const dy(nbor.GetCenterY() - cy);
+      sxx += dx * dx;
+      sxy += dx * dy;
+      syy += dy * dy;
+      sxv += dx * (nval - value);
+      syv += dy * (nval - value);
+    }
+    double const det(sxx * syy - sxy * sxy);
+    if (det > epsilon) {
+      gx = (syy * sxv - sxy * syv) / det;
+      gy = (sxx * syv - sxy * sxv) / det;
+    }
+    else {
+      // all neighbors along a single axis (or none at all)
+      if (sxx > epsilon)
+	gx = sxv / sxx;
+      if (syy > epsilon)
+	gy = syv / syy;
+    }
+    return value;
+  }
+  
+  
+  double QuadtreeFacade::
+  GetValue(ssize_t ix, ssize_t iy) const
+  {
+    vertex_t const vertex(m_cspace->FindVertex(ix, iy));
+    if (cspace_t::null_vertex == vertex)
+      return infinity;
+    QuadtreeNode const & node(m_cspace->Lookup(vertex));
+    if (1 == node.size)
+      return m_cspace->GetValue(vertex);
+    double gx, gy;
+    double const value(ComputeGradient(vertex, gx, gy));
+    if (infinity == value)
+      return value;
+    return value
+      + gx * (ix - node.GetCenterX())
+      + gy * (iy - node.GetCenterY());
+  }
+  
+  
+  double QuadtreeFacade::
+  GetMeta(ssize_t ix, ssize_t iy) const
+  {
+    if ( ! m_cspace->IsValidIndex(ix, iy))
+      return m_kernel->obstacle_meta;
+    return m_cspace->GetFineMeta(ix, iy);
+  }
+  
+  
+  bool QuadtreeFacade::
+  IsGoal(ssize_t ix, ssize_t iy) const
+  {
+    vertex_t const vertex(m_cspace->FindVertex(ix, iy));
+    if (cspace_t::null_vertex == vertex)
+      return false;
+    return m_algo->IsGoal(vertex);
+  }
+  
+  
+  bool QuadtreeFacade::
+  HaveWork() const
+  {
+    return m_algo->HaveWork();
+  }
+  
+  
+  QuadtreeFacade::node_status_t QuadtreeFacade::
+  GetStatus(ssize_t ix, ssize_t iy) const
+  {
+    vertex_t const vertex(m_cspace->FindVertex(ix, iy));
+    if (cspace_t::null_vertex == vertex)
+      return OUT_OF_GRID;
+    return GetStatus(vertex);
+  }
+  
+  
+  QuadtreeFacade::node_status_t QuadtreeFacade::
+  GetStatus(vertex_t vertex) const
+  {
+    flag_t const flag(m_cspace->GetFlag(vertex));
+    if (estar::GOAL == flag)
+      return GOAL;
+    double const value(m_cspace->GetValue(vertex));
+    double const ceiling(m_algo->GetCeiling());
+    if ((OPEN == flag) || (OPNG == flag)) {
+      if (minval(value, m_cspace->GetRhs(vertex)) > ceiling)
+	return BEYOND_HORIZON;
+      return WAVEFRONT;
+    }
+    if (m_cspace->GetMeta(vertex) == m_kernel->obstacle_meta)
+      return OBSTACLE;
+    if (value > ceiling)
+      return BEYOND_HORIZON;
+    Queue const & queue(m_algo->GetQueue());
+    if (queue.IsBeyondHorizon(vertex, value))
+      return DOWNWIND;
+    if (queue.IsEmpty())
+      return UPWIND;
+    if (value < queue.GetTopKey())
+      return UPWIND;
+    if (value >= queue.GetBottomKey())
+      return DOWNWIND;
+    return WAVEFRONT;
+  }
+  
+  
+  bool QuadtreeFacade::
+  IsValidIndex(ssize_t ix, ssize_t iy) const
+  {
+    return m_cspace->IsValidIndex(ix, iy);
+  }
+  
+  
+  bool QuadtreeFacade::
+  GetLowestInconsistentValue(double & value) const
+  {
+    Queue const & queue(m_algo->GetQueue());
+    if (queue.IsEmpty())
+      return false;
+    value = queue.GetTopKey();
+    return true;
+  }
+  
+  
+  const Algorithm & QuadtreeFacade::
+  GetAlgorithm() const
+  {
+    return * m_algo;
+  }
+  
+  
+  const Kernel & QuadtreeFacade::
+  GetKernel() const
+  {
+    return * m_kernel;
+  }
+  
+  
+  int QuadtreeFacade::
+  TraceCarrot(double robot_x, double robot_y,
+	      double distance, double stepsize,
+	      size_t maxsteps,
+	      carrot_trace & trace,
+	      std::ostream * err_os) const
+  {
+    robot_x /= scale;
+    robot_y /= scale;
+    distance /= scale;
+    double const unscaled_stepsize(stepsize);
+    stepsize /= scale;
+    
+    trace.clear();
+    double cx(robot_x);		// carrot
+    double cy(robot_y);
+    size_t ii;
+    for (ii = 0; ii < maxsteps; ++ii) {
+      ssize_t const ix(static_cast<ssize_t>(rint(cx)));
+      ssize_t const iy(static_cast<ssize_t>(rint(cy)));
+      if ( ! m_cspace->IsValidIndex(ix, iy)) {
+	if (err_os)
+	  (*err_os) << "ERROR (-1) in estar::QuadtreeFacade::TraceCarrot():\n"
+		    << "  no node at [" << ix << "  " << iy << "]\n";
+	return -1;
+      }
+      double gx, gy;
+      ComputeGradient(m_cspace->FindVertex(ix, iy), gx, gy);
+      double const value(GetValue(ix, iy));
+      double const gnorm(sqrt(square(gx) + square(gy)));
+      if ((infinity == value) || (gnorm < epsilon)) {
+	if (err_os)
+	  (*err_os) << "ERROR (-2) in estar::QuadtreeFacade::TraceCarrot():\n"
+		    << "  no gradient at [" << ix << "  " << iy << "]\n";
+	return -2;
+      }
+      trace.push_back(carrot_item(cx * scale, cy * scale,
+				  gx / scale, gy / scale, value, false));
+      cx -= stepsize * gx / gnorm;
+      cy -= stepsize * gy / gnorm;
+      if (sqrt(square(robot_x - cx) + square(robot_y - cy)) >= distance)
+	break;
+      if ((value <= unscaled_stepsize) || IsGoal(ix, iy))
+	break;
+    }
+    
+    if (ii >= maxsteps)
+      return 1;
+    return 0;
+  }
+  
+  
+  shared_ptr<GridCSpace const> QuadtreeFacade::
+  GetCSpace() const
+  {
+    return shared_ptr<GridCSpace const>();
+  }
+  
+  
+  shared_ptr<Grid const> QuadtreeFacade::
+  GetGrid() const
+  {
+    return shared_ptr<Grid const>();
+  }
+  
+} // namespace estar
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+#ifndef ESTAR_QUADTREE_FACADE_HPP
+#define ESTAR_QUADTREE_FACADE_HPP
+
+
+#include <estar/FacadeReadInterface.hpp>
+#include <estar/QuadtreeCSpace.hpp>
+#include <boost/shared_ptr.hpp>
+#include <vector>
+#include <stdio.h>
+
+
+namespace estar {
+  
+  
+  class AlgorithmOptions;
+  class QuadtreeLSMKernel;
+  
+  
+  /**
+     Facade for planning on a QuadtreeCSpace with the
+     QuadtreeLSMKernel. It speaks in terms of fine cells, just like
+     Facade does for a Grid: SetMeta() splits blocks as required so
+     that the changed cell gets a vertex of its own, and AddGoal()
+     does the same for goal cells. Reading the value of a fine cell
+     that lies in a larger block extrapolates from the block center,
+     see GetValue().
+     
+     There is no Grid and no GridCSpace behind this facade, so
+     GetCSpace() returns null and the dump and graphics functions
+     that need a Grid do not work with it.
+  */
+  class QuadtreeFacade
+    : public FacadeReadInterface
+  {
+  private:
+    QuadtreeFacade(boost::shared_ptr<Algorithm> algo,
+		   boost::shared_ptr<QuadtreeCSpace> cspace,
+		   boost::shared_ptr<QuadtreeLSMKernel> kernel);
+    
+    static QuadtreeFacade *
+    Create(boost::shared_ptr<QuadtreeCSpace> cspace, double scale,
+	   AlgorithmOptions const & algo_options);
+    
+  public:
+    /** \return A fresh QuadtreeFacade for an xsize times ysize map of
+	freespace, with blocks of at most maxsize cells. */
+    static QuadtreeFacade *
+    Create(double scale, ssize_t xsize, ssize_t ysize, ssize_t maxsize,
+	   AlgorithmOptions const & algo_options);
+    
+    /** \return A fresh QuadtreeFacade whose tree is built from the
+	metas of all cells (column-major, see QuadtreeCSpace). */
+    static QuadtreeFacade *
+    Create(double scale, ssize_t xsize, ssize_t ysize, ssize_t maxsize,
+	   std::vector<double> const & meta,
+	   AlgorithmOptions const & algo_options);
+    
+    const double scale;
+    
+    /** Set the meta of a fine cell, splitting its block if needed.
+	\return false if the index is invalid. */
+    bool SetMeta(ssize_t ix, ssize_t iy, double meta);
+    
+    /** Make the fine cell a goal, splitting its block if needed.
+	Blocks around the goal are split as well, such that their size
+	grows at most linearly with the distance from the goal.
+	\return false if the index is invalid. */
+    bool AddGoal(ssize_t ix, ssize_t iy, double value);
+    
+    void RemoveAllGoals();
+    
+    void ComputeOne();
+    
+    /** \return The underlying quadtree, e.g. for counting blocks. */
+    QuadtreeCSpace const & GetQuadtree() const { return * m_cspace; }
+    
+    virtual double GetScale() const;
+    virtual double GetFreespaceMeta() const;
+    virtual double GetObstacleMeta() const;
+    
+    /**
+       \return The value of the block containing (ix, iy), corrected
+       for the offset between the cell and the block center along
+       the gradient of a plane fitted to the values of the block and
+       its neighbors. This is exact for blocks of a single cell.
+    */
+    virtual double GetValue(ssize_t ix, ssize_t iy) const;
+    
+    /** \return The meta of the fine cell. */
+    virtual double GetMeta(ssize_t ix, ssize_t iy) const;
+    
+    virtual bool IsGoal(ssize_t ix, ssize_t iy) const;
+    virtual bool HaveWork() const;
+    virtual node_status_t GetStatus(ssize_t ix, ssize_t iy) const;
+    virtual node_status_t GetStatus(vertex_t vertex) const;
+    virtual bool IsValidIndex(ssize_t ix, ssize_t iy) const;
+    virtual bool GetLowestInconsistentValue(double & value) const;
+    virtual const Algorithm & GetAlgorithm() const;
+    virtual const Kernel & GetKernel() const;
+    
+    /** Follows the gradient of GetValue(), which is constant within
+	each block. See FacadeReadInterface::TraceCarrot(). */
+    virtual int TraceCarrot(double robot_x, double robot_y,
+			    double distance, double stepsize,
+			    size_t maxsteps,
+			    carrot_trace & trace,
+			    std::ostream * err_os) const;
+    
+    /** \return null, as there is no GridCSpace. */
+    virtual boost::shared_ptr<GridCSpace const> GetCSpace() const;
+    
+  protected:
+    /** \return null, as there is no Grid. */
+    virtual boost::shared_ptr<Grid const> GetGrid() const;
+    
+  private:
+    /** Split blocks until the one containing (ix, iy) is no larger
+	than size, and tell the Algorithm about the retired and added
+	vertices. */
+    vertex_t Refine(ssize_t ix, ssize_t iy, ssize_t size);
+    
+    /** \return The value of a vertex, along with the gradient per
+	fine cell that best fits the values of its neighbors. */
+    double ComputeGradient(vertex_t vertex, double & gx, double & gy) const;
+    
+    boost::shared_ptr<Algorithm> m_algo;
+    boost::shared_ptr<QuadtreeCSpace> m_cspace;
+    boost::shared_ptr<QuadtreeLSMKernel> m_kernel;
+  };
+  
+} // namespace estar
+
+#endif // ESTAR_QUADTREE_FACADE_HPP
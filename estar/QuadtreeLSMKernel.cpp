@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+#include "QuadtreeLSMKernel.hpp"
+#include "QuadtreeCSpace.hpp"
+#include "Propagator.hpp"
+#include "numeric.hpp"
+#include "util.hpp"
+#include "pdebug.hpp"
+
+
+using namespace boost;
+
+
+namespace estar {
+  
+  
+  QuadtreeLSMKernel::
+  QuadtreeLSMKernel(shared_ptr<QuadtreeCSpace const> cspace, double scale)
+    : SubKernel<QuadtreeLSMKernel>(scale),
+      m_cspace(cspace)
+  {
+  }
+  
+  
+  bool QuadtreeLSMKernel::
+  ChangeWouldRaise(double oldmeta, double newmeta) const
+  {
+    return newmeta < oldmeta;
+  }
+  
+  
+  double QuadtreeLSMKernel::
+  GetHeuristicWeight() const
+  {
+    return scale / freespace_meta;
+  }
+  
+  
+  double QuadtreeLSMKernel::
+  DoCompute(Propagator & propagator) const
+  {
+    double const target_meta(propagator.GetTargetMeta());
+    if(target_meta <= epsilon){	// Check for obstacles (numeric stability)!
+      PVDEBUG("OBSTACLE: target_meta == %g <= epsilon\n", target_meta);
+      return infinity;
+    }
+    
+    // radius of the LSM's geometric interpretation, per fine cell
+    double const radius(scale / target_meta);
+    
+    QuadtreeNode const & target(m_cspace->Lookup(propagator.GetTargetVertex()));
+    double const tx(target.GetCenterX());
+    double const ty(target.GetCenterY());
+    
+    // Sort the upwind neighbors by the axis of the face they share
+    // with the target. Blocks that do not overlap the target along X
+    // share a face along X.
+    Propagator::nbor_it iq, qend;
+    tie(iq, qend) = propagator.GetUpwindNeighbors();
+    Propagator::nbor_t xnbor[Propagator::capacity];
+    Propagator::nbor_t ynbor[Propagator::capacity];
+    double xdist[Propagator::capacity];
+    double ydist[Propagator::capacity];
+    size_t nx(0), ny(0);
+    for (/**/; iq != qend; ++iq) {
+      QuadtreeNode const & nbor(m_cspace->Lookup(iq->second));
+      if ((nbor.ix >= target.ix + target.size)
+	  || (nbor.ix + nbor.size <= target.ix)) {
+	xnbor[nx] = *iq;
+	xdist[nx++] = absval(nbor.GetCenterX() - tx);
+      }
+      else {
+	ynbor[ny] = *iq;
+	ydist[ny++] = absval(nbor.GetCenterY() - ty);
+      }
+    }
+    
+    // Take the lowest of all one-sided and two-sided updates. Picking
+    // the candidates per axis beforehand would be cheaper, but then
+    // lowering a neighbor could raise the result (by changing which
+    // pair gets combined), and the propagation could oscillate.
+    double result(infinity);
+    vertex_t bp1(0), bp2(0);
+    bool two_sided(false);
+    for (size_t ix(0); ix < nx; ++ix)
+      if (xnbor[ix].first + xdist[ix] * radius < result) {
+	result = xnbor[ix].first + xdist[ix] * radius;
+	bp1 = xnbor[ix].second;
+      }
+    for (size_t iy(0); iy < ny; ++iy)
+      if (ynbor[iy].first + ydist[iy] * radius < result) {
+	result = ynbor[iy].first + ydist[iy] * radius;
+	bp1 = ynbor[iy].second;
+      }
+    
+    // Solve a (T-T_A)^2 + b (T-T_B)^2 = radius^2 with a = 1/dx^2 and
+    // b = 1/dy^2, taking the higher of the two solutions, which is
+    // valid if it lies above T_A and T_B.
+    for (size_t ix(0); ix < nx; ++ix)
+      for (size_t iy(0); iy < ny; ++iy) {
+	double const ta(xnbor[ix].first);
+	double const tb(ynbor[iy].first);
+	double const aa(1 / square(xdist[ix]));
+	double const bb(1 / square(ydist[iy]));
+	double const root((aa + bb) * square(radius)
+			  - aa * bb * square(ta - tb));
+	if (root < 0)
+	  continue;
+	double const tt((aa * ta + bb * tb + sqrt(root)) / (aa + bb));
+	if ((tt >= maxval(ta, tb)) && (tt < result)) {
+	  result = tt;
+	  bp1 = xnbor[ix].second;
+	  bp2 = ynbor[iy].second;
+	  two_sided = true;
+	}
+      }
+    
+    // Kernel::Compute() ensures there is at least one upwind
+    // neighbor, so there is at least one backpointer.
+    propagator.AddBackpointer(bp1);
+    if (two_sided)
+      propagator.AddBackpointer(bp2);
+    PVDEBUG("%s %g\n", two_sided ? "TWO-SIDED" : "ONE-SIDED", result);
+    return result;
+  }
+  
+} // namespace estar
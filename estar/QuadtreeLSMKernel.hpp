@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+#ifndef ESTAR_QUADTREE_LSM_KERNEL_HPP
+#define ESTAR_QUADTREE_LSM_KERNEL_HPP
+
+
+#include <estar/Kernel.hpp>
+#include <boost/shared_ptr.hpp>
+
+
+namespace estar {
+  
+  
+  class QuadtreeCSpace;
+  
+  
+  /**
+     Variant of LSMKernel for the blocks of a QuadtreeCSpace. The
+     distances between the target and its neighbors are taken along
+     the axis of the face they share, from center to center, so they
+     vary with the block sizes. Each upwind neighbor along X
+     (distance dx, value T_A) is combined with each one along Y (dy,
+     T_B) by solving ((T-T_A)/dx)^2 + ((T-T_B)/dy)^2 = (scale/F)^2,
+     where F is the meta of the target. The result is the lowest
+     solution that lies above both T_A and T_B, or the lowest
+     propagation from a single neighbor if that is lower. On a tree
+     of single cells, this reproduces LSMKernel.
+     
+     The lateral offset between the centers of blocks of different
+     sizes is ignored, which is a first-order error that is confined
+     to the transitions between block sizes.
+  */
+  class QuadtreeLSMKernel
+    : public SubKernel<QuadtreeLSMKernel>
+  {
+  public:
+    QuadtreeLSMKernel(boost::shared_ptr<QuadtreeCSpace const> cspace,
+		      double scale);
+    
+    virtual bool ChangeWouldRaise(double oldmeta, double newmeta) const;
+    
+    /** \return scale / freespace_meta, the distance a wave crosses
+	in one fine cell of freespace. */
+    virtual double GetHeuristicWeight() const;
+    
+  protected:
+    virtual double DoCompute(Propagator & propagator) const;
+    
+    boost::shared_ptr<QuadtreeCSpace const> m_cspace;
+  };
+
+  
+  template<>
+  class KernelTraits<QuadtreeLSMKernel> {
+  public:
+    static double freespace_meta() { return 1; }
+    static double obstacle_meta() { return 0; }
+  };
+  
+  
+} // namespace estar
+
+#endif // ESTAR_QUADTREE_LSM_KERNEL_HPP
@@ -19,6 +19,8 @@
 
 
 #include "Queue.hpp"
+#include "QueueBackend.hpp"
+#include "Heuristic.hpp"
 #include "numeric.hpp"
 #include "util.hpp"
 #include "pdebug.hpp"
@@ -29,21 +31,107 @@ using std::make_pair;
 
 namespace estar {
   
+  
+  Queue::
+  Queue(backend_t backend, double bucket_width)
+    : m_backend_type(backend),
+      m_parked(new HeapQueueBackend<4>()),
+      m_margin(0),
+      m_horizon(infinity),
+      m_key_modifier(0)
+  {
+    switch (backend) {
+    case MULTIMAP:
+      m_backend.reset(new MultimapQueueBackend());
+      break;
+    case BINARY_HEAP:
+      m_backend.reset(new HeapQueueBackend<2>());
+      break;
+    case BUCKET:
+      m_backend.reset(new BucketQueueBackend(bucket_width));
+      break;
+    default:
+      m_backend.reset(new HeapQueueBackend<4>());
+    }
+  }
+  
+  
+  Queue::
+  ~Queue()
+  {
+  }
+  
+  
+  bool Queue::
+  IsEmpty() const
+  {
+    return m_backend->IsEmpty();
+  }
+  
+  
+  size_t Queue::
+  GetSize() const
+  {
+    return m_backend->GetSize();
+  }
+  
+  
+  double Queue::
+  GetTopKey() const
+  {
+    return m_backend->GetTopKey();
+  }
+  
+  
+  double Queue::
+  GetBottomKey() const
+  {
+    return m_backend->GetBottomKey();
+  }
+  
 
   vertex_t Queue::
   Pop(flag_map_t & flag_map)
   {
-    BOOST_ASSERT( ! m_queue.empty() );
-    queue_it iq(m_queue.begin());
-    const vertex_t vertex(iq->second);
-    m_queue.erase(iq);
-    m_map.erase(vertex);
+    BOOST_ASSERT( ! m_backend->IsEmpty() );
+    const vertex_t vertex(m_backend->PopTop());
     put(flag_map, vertex, static_cast<flag_t>(get(flag_map, vertex) ^ OPEN));
     PVDEBUG("f: %s i: %lu\n", flag_name(get(flag_map, vertex)), vertex);
     return vertex;
   }
   
   
+  size_t Queue::
+  PopBand(double delta, double ceiling, flag_map_t & flag_map,
+	  std::vector<vertex_t> & band)
+  {
+    const double bound(m_backend->GetTopKey() + delta);
+    size_t count(0);
+    do {
+      band.push_back(Pop(flag_map));
+      ++count;
+    } while(( ! m_backend->IsEmpty())
+	    && (m_backend->GetTopKey() < bound)
+	    && (m_backend->GetTopKey() <= ceiling));
+    return count;
+  }
+  
+  
+  void Queue::
+  Remove(vertex_t vertex, flag_map_t & flag_map)
+  {
+    const flag_t flag(get(flag_map, vertex));
+    if( ! (flag & OPEN))
+      return;
+    double parked_key;
+    if(m_parked->Find(vertex, parked_key))
+      m_parked->Remove(vertex);
+    else
+      m_backend->Remove(vertex);
+    put(flag_map, vertex, static_cast<flag_t>(flag ^ OPEN));
+  }
+  
+  
   void Queue::
   Requeue(vertex_t vertex,
 	  flag_map_t & flag_map,
@@ -52,14 +140,22 @@ namespace estar {
   {
     const double value(get(value_map, vertex));
     const double rhs(get(rhs_map, vertex));
-    const flag_t flag(get(flag_map, vertex));
+    flag_t flag(get(flag_map, vertex));
+    
+    // Parked vertices go back to the active queue whenever they
+    // change, ParkTop() will take care of them again if necessary.
+    double parked_key;
+    if((flag & OPEN) && m_parked->Find(vertex, parked_key)){
+      m_parked->Remove(vertex);
+      flag = static_cast<flag_t>(flag ^ OPEN);
+      put(flag_map, vertex, flag);
+    }
     
     if(absval(value - rhs) < epsilon){
       PVDEBUG("CONSISTENT f: %s i: %lu v: %g rhs: %g\n",
 	      flag_name(flag), vertex, value, rhs);
       if(flag & OPEN){
-	DoDequeue(vertex, m_queue.begin());
-	m_map.erase(vertex);
+	m_backend->Remove(vertex);
 	put(flag_map, vertex, static_cast<flag_t>(flag ^ OPEN));
       }
       return;
@@ -67,68 +163,201 @@ namespace estar {
     
     const double key(minval(value, rhs));
     if( ! (flag & OPEN)){
-      m_queue.insert(make_pair(key, vertex));
-      m_map.insert(make_pair(vertex, key));
+      m_backend->Insert(vertex, key);
       put(flag_map, vertex, static_cast<flag_t>(flag | OPEN));
       PVDEBUG("ENQUEUE f: %s i: %lu v: %g rhs: %g\n",
 	      flag_name(flag), vertex, value, rhs);
       return;
     }
     
-    queue_map_t::iterator im(m_map.find(vertex));
-    BOOST_ASSERT( im != m_map.end() );
-    if(absval(im->second - key) < epsilon){
+    double oldkey;
+    const bool found(m_backend->Find(vertex, oldkey));
+    BOOST_ASSERT( found );
+    if(absval(oldkey - key) < epsilon){
       PVDEBUG("KEEP f: %s i: %lu v: %g rhs: %g (absval(%g) < %g)\n",
-	      flag_name(flag), vertex, value, rhs, im->second - key, epsilon);
+	      flag_name(flag), vertex, value, rhs, oldkey - key, epsilon);
       return;
     }
     
     PVDEBUG("REQUEUE f: %s i: %lu v: %g rhs: %g\n",
 	    flag_name(flag), vertex, value, rhs);
-    DoDequeue(vertex, m_queue.find(im->second));
-    m_queue.insert(make_pair(key, vertex));
-    im->second = key;
+    m_backend->Update(vertex, key);
   }
   
   
   void Queue::
   Clear()
   {
-    m_queue.clear();
-    m_map.clear();
+    m_backend->Clear();
+    m_parked->Clear();
+    if(m_heuristic)
+      m_horizon = 0;
+    m_key_modifier = 0;
+  }
+  
+  
+  void Queue::
+  Reserve(vertex_t vertex)
+  {
+    m_backend->Reserve(vertex);
   }
   
   
   void Queue::
-  DoDequeue(vertex_t vertex, queue_t::iterator iq)
+  Renumber(std::vector<vertex_t> const & newid)
   {
-    for(/**/; iq != m_queue.end(); ++iq){
-      if(iq->second == vertex)
-	break;
+    QueueBackend * const backend[2] = { m_backend.get(), m_parked.get() };
+    for (size_t ii(0); ii < 2; ++ii) {
+      queue_t queue;
+      backend[ii]->Snapshot(queue);
+      backend[ii]->Clear();
+      for (const_queue_it iq(queue.begin()); iq != queue.end(); ++iq)
+	backend[ii]->Insert(newid[iq->second], iq->first);
     }
-    if(iq == m_queue.end()){
-      PVDEBUG("WARNING search again!\n");
-      for(iq = m_queue.begin(); iq != m_queue.end(); ++iq){
-	if(iq->second == vertex)
-	  break;
+  }
+  
+  
+  void Queue::
+  SetFocus(boost::shared_ptr<Heuristic const> heuristic,
+	   vertex_t focus,
+	   double margin,
+	   const value_map_t & value_map,
+	   const rhs_map_t & rhs_map)
+  {
+    if( ! heuristic){
+      m_heuristic.reset();
+      m_horizon = infinity;
+      m_key_modifier = 0;
+      while( ! m_parked->IsEmpty()){
+	const vertex_t vertex(m_parked->PopTop());
+	m_backend->Insert(vertex, minval(get(value_map, vertex),
+					 get(rhs_map, vertex)));
       }
+      return;
     }
-    BOOST_ASSERT( iq != m_queue.end() );
-    m_queue.erase(iq);
+    
+    if( ! m_heuristic)
+      m_horizon = 0;
+    else if( ! m_parked->IsEmpty())
+      m_key_modifier += m_heuristic->Estimate(focus)
+	+ m_heuristic->GetTriangleSlack();
+    m_heuristic = heuristic;
+    m_margin = margin;
+  }
+  
+  
+  double Queue::
+  ComputeFocusKey(vertex_t vertex, double value) const
+  {
+    if(( ! m_heuristic) || (value == infinity))
+      return value;
+    return value + m_heuristic->Estimate(vertex) + m_key_modifier;
+  }
+  
+  
+  double Queue::
+  GetHorizon() const
+  {
+    return m_horizon;
+  }
+  
+  
+  bool Queue::
+  IsBeyondHorizon(vertex_t vertex, double value) const
+  {
+    return ( ! m_parked->IsEmpty())
+      && (ComputeFocusKey(vertex, value) > m_horizon);
+  }
+  
+  
+  bool Queue::
+  ParkTop(const value_map_t & value_map, const rhs_map_t & rhs_map)
+  {
+    if(( ! m_heuristic) || m_backend->IsEmpty())
+      return false;
+    const vertex_t vertex(m_backend->GetTopVertex());
+    const double key(ComputeFocusKey(vertex, minval(get(value_map, vertex),
+						    get(rhs_map, vertex))));
+    if(key <= m_horizon)
+      return false;
+    PVDEBUG("PARK i: %lu focus key: %g horizon: %g\n",
+	    vertex, key, m_horizon);
+    m_backend->PopTop();
+    m_parked->Insert(vertex, key);
+    return true;
+  }
+  
+  
+  bool Queue::
+  Unpark(const value_map_t & value_map, const rhs_map_t & rhs_map)
+  {
+    if(( ! m_heuristic) || m_parked->IsEmpty())
+      return false;
+    m_horizon = maxval(m_horizon, m_parked->GetTopKey()) + m_margin;
+    PVDEBUG("horizon: %g\n", m_horizon);
+    bool moved(false);
+    while(( ! m_parked->IsEmpty()) && (m_parked->GetTopKey() <= m_horizon)){
+      const vertex_t vertex(m_parked->PopTop());
+      const double value(minval(get(value_map, vertex),
+				get(rhs_map, vertex)));
+      // The stored key is a lower bound if the focus has moved.
+      const double key(ComputeFocusKey(vertex, value));
+      if(key > m_horizon)
+	m_parked->Insert(vertex, key);
+      else{
+	m_backend->Insert(vertex, value);
+	moved = true;
+      }
+    }
+    return moved;
+  }
+  
+  
+  size_t Queue::
+  GetParkedSize() const
+  {
+    return m_parked->GetSize();
+  }
+  
+  
+  bool Queue::
+  IsParked(vertex_t vertex) const
+  {
+    double key;
+    return m_parked->Find(vertex, key);
   }
   
   
   bool Queue::
   VitaminB(vertex_t vertex)
   {
-    queue_map_t::iterator im(m_map.find(vertex));
-    if(im == m_map.end())
+    double key;
+    if( ! m_backend->Find(vertex, key))
       return false;
-    DoDequeue(vertex, m_queue.find(im->second));
-    const double key(m_queue.begin()->second - 1);
-    m_queue.insert(make_pair(key, vertex));
-    im->second = key;
+    m_backend->Update(vertex, m_backend->GetTopKey() - 1);
     return true;
   }
   
+  
+  queue_t Queue::
+  Get() const
+  {
+    queue_t queue;
+    m_backend->Snapshot(queue);
+    return queue;
+  }
+  
+  
+  queue_map_t Queue::
+  GetMap() const
+  {
+    queue_t queue;
+    m_backend->Snapshot(queue);
+    queue_map_t map;
+    for(const_queue_it iq(queue.begin()); iq != queue.end(); ++iq)
+      map.insert(make_pair(iq->second, iq->first));
+    return map;
+  }
+  
+  
 } // namespace estar
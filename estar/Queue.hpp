@@ -23,7 +23,10 @@
 
 
 #include <estar/base.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 #include <map>
+#include <vector>
 
 
 namespace estar {
@@ -36,21 +39,154 @@ namespace estar {
   typedef std::map<vertex_t, double> queue_map_t;
   
   
+  class QueueBackend;
+  class Heuristic;
+  
+  
   /** Wavefront propagation queue. Sorted by ascending key, used
-      (mainly) by Algorithm. */
+      (mainly) by Algorithm. The actual storage is delegated to a
+      QueueBackend, which is chosen at construction time.
+      
+      The queue can be focused on a vertex (typically the robot) with
+      SetFocus(). The key of a vertex stays min(value, rhs), but
+      vertices whose focus key, see ComputeFocusKey(), lies beyond a
+      horizon get parked on a separate heap by ParkTop(), where they
+      wait until Unpark() widens the horizon. Parked vertices keep
+      their OPEN flag, but they are not counted by IsEmpty(),
+      GetSize(), GetTopKey(), and so on, which only concern the
+      active part of the queue. */
   class Queue {
   public:
-    bool IsEmpty() const { return m_queue.empty(); }
+    typedef enum {
+      /** std::multimap, the original implementation */
+      MULTIMAP,
+      /** indexed binary heap */
+      BINARY_HEAP,
+      /** indexed 4-ary heap */
+      FOUR_HEAP,
+      /** monotone bucket queue, only approximately sorted, see
+	  BucketQueueBackend */
+      BUCKET
+    } backend_t;
+    
+    /** The bucket_width is ignored unless backend is BUCKET. */
+    explicit Queue(backend_t backend = FOUR_HEAP, double bucket_width = 1);
+    ~Queue();
+    
+    bool IsEmpty() const;
+    size_t GetSize() const;
+    
+    /** \return The key of the next vertex to be popped. This is the
+	lowest key, except for the BUCKET backend where it can exceed
+	the lowest key by up to one bucket width. \pre ! IsEmpty() */
+    double GetTopKey() const;
+    
+    /** \return The highest key in the queue. \pre ! IsEmpty() */
+    double GetBottomKey() const;
     
     vertex_t Pop(flag_map_t & flag_map);
+    
+    /**
+       Pop the top vertex and all others whose key lies below the top
+       key plus delta, as long as their key does not exceed the
+       ceiling. They are appended to band in the order in which Pop()
+       would have returned them. Parked vertices are not considered.
+       
+       \return The number of popped vertices. \pre ! IsEmpty()
+    */
+    size_t PopBand(double delta, double ceiling, flag_map_t & flag_map,
+		   std::vector<vertex_t> & band);
 
     /** \note flag_map has to reflect the actual presence of vertex in queue */
     void Requeue(vertex_t vertex,
 		 flag_map_t & flag_map,
 		 const value_map_t & value_map,
 		 const rhs_map_t & rhs_map);
+    
+    /** Take a vertex off the (active or parked) queue, if it is on
+	it. \note flag_map has to reflect the actual presence of
+	vertex in queue */
+    void Remove(vertex_t vertex, flag_map_t & flag_map);
+    
+    /** Remove all active and parked vertices. If the queue is
+	focused, the horizon and the key modifier are reset to zero,
+	see SetFocus(). */
     void Clear();
     
+    /** Make room for the vertex in the active backend, see
+	QueueBackend::Reserve(). The parked heap is only used when
+	focused and grows on demand. */
+    void Reserve(vertex_t vertex);
+    
+    /** Move each active and parked vertex v to newid[v], keeping its
+	key, see Algorithm::Renumber(). */
+    void Renumber(std::vector<vertex_t> const & newid);
+    
+    /**
+       Start parking vertices whose focus key exceeds the horizon. The
+       horizon starts at zero and is widened by Unpark() whenever the
+       active queue runs empty.
+       
+       Calling this again with a heuristic for a new focus vertex does
+       not touch the parked vertices. Instead, as in D* Lite, the old
+       heuristic's estimate at the new focus is added to a key
+       modifier, which turns the stored focus keys into lower bounds
+       that Unpark() checks lazily. This requires both heuristics to
+       fulfill the triangle inequality, up to the old heuristic's
+       Heuristic::GetTriangleSlack(), which is added to the key
+       modifier as well.
+       
+       Passing a null heuristic moves all parked vertices back into
+       the active queue, keyed on min(value, rhs), and switches back
+       to normal operation.
+    */
+    void SetFocus(boost::shared_ptr<Heuristic const> heuristic,
+		  /** ignored if heuristic is null */
+		  vertex_t focus,
+		  /** how far beyond the lowest parked focus key Unpark()
+		      moves the horizon, must be positive */
+		  double margin,
+		  const value_map_t & value_map,
+		  const rhs_map_t & rhs_map);
+    
+    bool IsFocused() const { return 0 != m_heuristic.get(); }
+    
+    /** \return value + heuristic estimate + key modifier, or simply
+	value if the queue is not focused. */
+    double ComputeFocusKey(vertex_t vertex, double value) const;
+    
+    /** \return The highest focus key that does not get parked, or
+	infinity if the queue is not focused. */
+    double GetHorizon() const;
+    
+    /** \return True if some vertices are parked and the focus key of
+	the given value exceeds the horizon, in which case the value
+	might still change due to a parked vertex. */
+    bool IsBeyondHorizon(vertex_t vertex, double value) const;
+    
+    /**
+       If the top vertex lies beyond the horizon, move it to the
+       parked heap. Call this until it returns false (or the active
+       queue is empty) before Pop(). Always false if the queue is not
+       focused.
+    */
+    bool ParkTop(const value_map_t & value_map, const rhs_map_t & rhs_map);
+    
+    /**
+       Widen the horizon to the lowest parked focus key plus the
+       margin, and move all parked vertices that are now within the
+       horizon back to the active queue.
+       
+       \return true if at least one vertex was moved, which is not
+       guaranteed because the stored focus keys are only lower bounds
+       after the focus has moved.
+    */
+    bool Unpark(const value_map_t & value_map, const rhs_map_t & rhs_map);
+    
+    size_t GetParkedSize() const;
+    
+    bool IsParked(vertex_t vertex) const;
+    
     /**
        For debugging: Puts the vertex (if present) to the top of the
        queue, returns true on success. If you then call check_queue(),
@@ -58,15 +194,24 @@ namespace estar {
     */
     bool VitaminB(vertex_t vertex);
     
-    const queue_t &     Get() const    { return m_queue; }
-    const queue_map_t & GetMap() const { return m_map; }
+    /** \return A copy of the active queue contents, sorted by
+	key. Meant for debugging, dumping, and drawing: use
+	GetTopKey() and friends in tight loops. */
+    queue_t Get() const;
     
-  private:
-    queue_t m_queue;
-    queue_map_t m_map;
+    /** \return A copy of the vertex-to-key mapping, see Get(). */
+    queue_map_t GetMap() const;
+    
+    backend_t GetBackend() const { return m_backend_type; }
     
-    /** \note WARNING doesn't update m_map. */
-    void DoDequeue(vertex_t vertex, queue_t::iterator iq);
+  private:
+    backend_t const m_backend_type;
+    boost::scoped_ptr<QueueBackend> m_backend;
+    boost::scoped_ptr<QueueBackend> m_parked;
+    boost::shared_ptr<Heuristic const> m_heuristic;
+    double m_margin;
+    double m_horizon;
+    double m_key_modifier;
   };
   
 } // namespace estar
@@ -0,0 +1,330 @@
+/* 
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+#include "QueueBackend.hpp"
+#include "pdebug.hpp"
+
+
+using std::make_pair;
+
+
+namespace estar {
+  
+  
+  bool MultimapQueueBackend::
+  Find(vertex_t vertex, double & key) const
+  {
+    queue_map_t::const_iterator im(m_map.find(vertex));
+    if(im == m_map.end())
+      return false;
+    key = im->second;
+    return true;
+  }
+  
+  
+  void MultimapQueueBackend::
+  Insert(vertex_t vertex, double key)
+  {
+    m_queue.insert(make_pair(key, vertex));
+    m_map.insert(make_pair(vertex, key));
+  }
+  
+  
+  void MultimapQueueBackend::
+  Update(vertex_t vertex, double key)
+  {
+    queue_map_t::iterator im(m_map.find(vertex));
+    BOOST_ASSERT( im != m_map.end() );
+    DoDequeue(vertex, m_queue.find(im->second));
+    m_queue.insert(make_pair(key, vertex));
+    im->second = key;
+  }
+  
+  
+  void MultimapQueueBackend::
+  Remove(vertex_t vertex)
+  {
+    DoDequeue(vertex, m_queue.begin());
+    m_map.erase(vertex);
+  }
+  
+  
+  vertex_t MultimapQueueBackend::
+  PopTop()
+  {
+    queue_it iq(m_queue.begin());
+    const vertex_t vertex(iq->second);
+    m_queue.erase(iq);
+    m_map.erase(vertex);
+    return vertex;
+  }
+  
+  
+  void MultimapQueueBackend::
+  Clear()
+  {
+    m_queue.clear();
+    m_map.clear();
+  }
+  
+  
+  void MultimapQueueBackend::
+  DoDequeue(vertex_t vertex, queue_t::iterator iq)
+  {
+    for(/**/; iq != m_queue.end(); ++iq){
+      if(iq->second == vertex)
+	break;
+    }
+    if(iq == m_queue.end()){
+      PVDEBUG("WARNING search again!\n");
+      for(iq = m_queue.begin(); iq != m_queue.end(); ++iq){
+	if(iq->second == vertex)
+	  break;
+      }
+    }
+    BOOST_ASSERT( iq != m_queue.end() );
+    m_queue.erase(iq);
+  }
+  
+  
+  BucketQueueBackend::
+  BucketQueueBackend(double bucket_width)
+    : m_width(bucket_width),
+      m_base(0),
+      m_low(0),
+      m_high(0),
+      m_size(0)
+  {
+    BOOST_ASSERT( m_width > 0 );
+  }
+  
+  
+  ssize_t BucketQueueBackend::
+  ComputeBucket(double key) const
+  {
+    return static_cast<ssize_t>(floor(key / m_width));
+  }
+  
+  
+  void BucketQueueBackend::
+  SkipEmpty() const
+  {
+    BOOST_ASSERT( 0 != m_size );
+    while (0 == m_bucket[m_low].head)
+      ++m_low;
+  }
+  
+  
+  void BucketQueueBackend::
+  Link(vertex_t vertex)
+  {
+    node & nn(m_node[vertex]);
+    if (0 == m_size) {
+      // All buckets are empty, so we can simply move the window. Put
+      // the vertex in the middle, otherwise the next slightly lower
+      // key would grow the array each time the queue runs empty.
+      if (m_bucket.empty())
+	m_bucket.resize(1);
+      m_low = m_bucket.size() / 2;
+      m_high = m_low;
+      m_base = nn.bucket - static_cast<ssize_t>(m_low);
+    }
+    else if (nn.bucket < m_base) {
+      // grow towards lower keys, geometrically to amortize the shift
+      size_t shift(m_base - nn.bucket);
+      if (shift < m_bucket.size())
+	shift = m_bucket.size();
+      m_bucket.insert(m_bucket.begin(), shift, bucket());
+      m_base -= shift;
+      m_low += shift;
+      m_high += shift;
+    }
+    size_t const ib(nn.bucket - m_base);
+    if (ib >= m_bucket.size()) {
+      size_t size(2 * m_bucket.size());
+      if (size <= ib)
+	size = ib + 1;
+      m_bucket.resize(size);
+    }
+    
+    bucket & bb(m_bucket[ib]);
+    nn.prev = bb.tail;
+    nn.next = 0;
+    if (0 == bb.tail)
+      bb.head = vertex + 1;
+    else
+      m_node[bb.tail - 1].next = vertex + 1;
+    bb.tail = vertex + 1;
+    
+    if ((0 == m_size) || (ib < m_low))
+      m_low = ib;
+    if ((0 == m_size) || (ib > m_high))
+      m_high = ib;
+    ++m_size;
+  }
+  
+  
+  void BucketQueueBackend::
+  Unlink(vertex_t vertex)
+  {
+    node & nn(m_node[vertex]);
+    bucket & bb(m_bucket[nn.bucket - m_base]);
+    if (0 == nn.prev)
+      bb.head = nn.next;
+    else
+      m_node[nn.prev - 1].next = nn.next;
+    if (0 == nn.next)
+      bb.tail = nn.prev;
+    else
+      m_node[nn.next - 1].prev = nn.prev;
+    --m_size;
+  }
+  
+  
+  double BucketQueueBackend::
+  GetTopKey() const
+  {
+    return m_node[GetTopVertex()].key;
+  }
+  
+  
+  vertex_t BucketQueueBackend::
+  GetTopVertex() const
+  {
+    SkipEmpty();
+    return m_bucket[m_low].head - 1;
+  }
+  
+  
+  double BucketQueueBackend::
+  GetBottomKey() const
+  {
+    BOOST_ASSERT( 0 != m_size );
+    while (0 == m_bucket[m_high].head)
+      --m_high;
+    size_t iv(m_bucket[m_high].head);
+    double key(m_node[iv - 1].key);
+    for (iv = m_node[iv - 1].next; 0 != iv; iv = m_node[iv - 1].next)
+      if (m_node[iv - 1].key > key)
+	key = m_node[iv - 1].key;
+    return key;
+  }
+  
+  
+  bool BucketQueueBackend::
+  Find(vertex_t vertex, double & key) const
+  {
+    if ((vertex >= m_node.size()) || ( ! m_node[vertex].queued))
+      return false;
+    key = m_node[vertex].key;
+    return true;
+  }
+  
+  
+  void BucketQueueBackend::
+  Reserve(vertex_t vertex)
+  {
+    if (vertex >= m_node.size()) {
+      size_t size(2 * m_node.size());
+      if (size <= vertex)
+	size = vertex + 1;
+      m_node.resize(size);
+    }
+  }
+  
+  
+  void BucketQueueBackend::
+  Insert(vertex_t vertex, double key)
+  {
+    Reserve(vertex);
+    node & nn(m_node[vertex]);
+    BOOST_ASSERT( ! nn.queued );
+    nn.key = key;
+    nn.bucket = ComputeBucket(key);
+    nn.queued = true;
+    Link(vertex);
+  }
+  
+  
+  void BucketQueueBackend::
+  Update(vertex_t vertex, double key)
+  {
+    BOOST_ASSERT( (vertex < m_node.size()) && m_node[vertex].queued );
+    Unlink(vertex);
+    node & nn(m_node[vertex]);
+    nn.key = key;
+    nn.bucket = ComputeBucket(key);
+    Link(vertex);
+  }
+  
+  
+  void BucketQueueBackend::
+  Remove(vertex_t vertex)
+  {
+    BOOST_ASSERT( (vertex < m_node.size()) && m_node[vertex].queued );
+    Unlink(vertex);
+    m_node[vertex].queued = false;
+  }
+  
+  
+  vertex_t BucketQueueBackend::
+  PopTop()
+  {
+    vertex_t const vertex(GetTopVertex());
+    Remove(vertex);
+    // Drop the empty buckets below the wavefront once they make up
+    // most of the array, otherwise memory would grow with the total
+    // key range instead of with the width of the wavefront.
+    if ((m_low > 1024) && (2 * m_low > m_bucket.size())) {
+      m_bucket.erase(m_bucket.begin(), m_bucket.begin() + m_low);
+      m_base += m_low;
+      m_high -= m_low;
+      m_low = 0;
+    }
+    return vertex;
+  }
+  
+  
+  void BucketQueueBackend::
+  Clear()
+  {
+    if (0 != m_size)
+      for (size_t ib(m_low); ib <= m_high; ++ib) {
+	for (size_t iv(m_bucket[ib].head); 0 != iv; iv = m_node[iv - 1].next)
+	  m_node[iv - 1].queued = false;
+	m_bucket[ib] = bucket();
+      }
+    m_size = 0;
+  }
+  
+  
+  void BucketQueueBackend::
+  Snapshot(queue_t & queue) const
+  {
+    queue.clear();
+    if (0 == m_size)
+      return;
+    for (size_t ib(m_low); ib <= m_high; ++ib)
+      for (size_t iv(m_bucket[ib].head); 0 != iv; iv = m_node[iv - 1].next)
+	queue.insert(make_pair(m_node[iv - 1].key, iv - 1));
+  }
+  
+} // namespace estar
@@ -0,0 +1,421 @@
+/* 
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+#ifndef ESTAR_QUEUE_BACKEND_HPP
+#define ESTAR_QUEUE_BACKEND_HPP
+
+
+#include <estar/Queue.hpp>
+#include <boost/assert.hpp>
+#include <algorithm>
+#include <vector>
+
+
+namespace estar {
+  
+  
+  /**
+     Storage interface behind Queue. A backend only knows about
+     (vertex, key) pairs, the OPEN flag bookkeeping and the decision
+     of when to (re)queue a vertex remain in Queue. Each vertex is
+     stored at most once. Ties between equal keys are broken in
+     insertion order (first in, first out), which is what the original
+     std::multimap implementation did. This keeps the expansion order,
+     and thus the resulting navigation function, independent of the
+     chosen backend. BucketQueueBackend is the exception, it trades
+     exact ordering for speed.
+  */
+  class QueueBackend
+  {
+  public:
+    virtual ~QueueBackend() {}
+    
+    virtual bool IsEmpty() const = 0;
+    virtual size_t GetSize() const = 0;
+    
+    /** \return The key of GetTopVertex(). \pre ! IsEmpty() */
+    virtual double GetTopKey() const = 0;
+    
+    /** \pre ! IsEmpty() */
+    virtual vertex_t GetTopVertex() const = 0;
+    
+    /** \return The highest key in the queue. \pre ! IsEmpty() */
+    virtual double GetBottomKey() const = 0;
+    
+    /** \return true if the vertex is queued, in which case its key
+	is written to the key parameter. */
+    virtual bool Find(vertex_t vertex, double & key) const = 0;
+    
+    /** Make room for the vertex in the per-vertex index, if the
+	backend has one, so that a later Insert() does not have to
+	grow the index in the middle of a propagation. */
+    virtual void Reserve(vertex_t vertex) = 0;
+    
+    /** \pre the vertex is not yet queued */
+    virtual void Insert(vertex_t vertex, double key) = 0;
+    
+    /** Change the key of a queued vertex, which also puts it behind
+	any other vertices with the same key. \pre the vertex is
+	queued */
+    virtual void Update(vertex_t vertex, double key) = 0;
+    
+    /** \pre the vertex is queued */
+    virtual void Remove(vertex_t vertex) = 0;
+    
+    /** \pre ! IsEmpty() */
+    virtual vertex_t PopTop() = 0;
+    
+    virtual void Clear() = 0;
+    
+    /** Copy the contents into a (cleared) queue_t. */
+    virtual void Snapshot(queue_t & queue) const = 0;
+  };
+  
+  
+  /**
+     The original Queue implementation: a std::multimap sorted by key
+     plus a std::map from vertex to key. Removing an arbitrary vertex
+     requires a linear search among the multimap entries, which makes
+     this backend slow on large wavefronts. It is kept for reference
+     and comparison.
+  */
+  class MultimapQueueBackend
+    : public QueueBackend
+  {
+  public:
+    virtual bool IsEmpty() const { return m_queue.empty(); }
+    virtual size_t GetSize() const { return m_queue.size(); }
+    virtual double GetTopKey() const { return m_queue.begin()->first; }
+    virtual vertex_t GetTopVertex() const { return m_queue.begin()->second; }
+    virtual double GetBottomKey() const { return m_queue.rbegin()->first; }
+    virtual bool Find(vertex_t vertex, double & key) const;
+    virtual void Reserve(vertex_t) {}
+    virtual void Insert(vertex_t vertex, double key);
+    virtual void Update(vertex_t vertex, double key);
+    virtual void Remove(vertex_t vertex);
+    virtual vertex_t PopTop();
+    virtual void Clear();
+    virtual void Snapshot(queue_t & queue) const { queue = m_queue; }
+    
+  private:
+    queue_t m_queue;
+    queue_map_t m_map;
+    
+    /** \note WARNING doesn't update m_map. */
+    void DoDequeue(vertex_t vertex, queue_t::iterator iq);
+  };
+  
+  
+  /**
+     Indexed d-ary min-heap. The position of each vertex inside the
+     heap is stored in a dense array indexed by vertex_t (which is
+     just an integer index for our vecS-based C-space graph), so
+     finding, re-keying, and removing an arbitrary vertex costs
+     O(log n) instead of a linear search. Use arity 2 for a binary
+     heap, 4 is usually a bit faster because the tree is shallower and
+     the children of a node share cache lines.
+  */
+  template<size_t arity>
+  class HeapQueueBackend
+    : public QueueBackend
+  {
+  public:
+    HeapQueueBackend(): m_sequence(0), m_bottom_valid(true), m_bottom(0) {}
+    
+    virtual bool IsEmpty() const { return m_heap.empty(); }
+    
+    virtual size_t GetSize() const { return m_heap.size(); }
+    
+    virtual double GetTopKey() const {
+      BOOST_ASSERT( ! m_heap.empty() );
+      return m_heap[0].key;
+    }
+    
+    virtual vertex_t GetTopVertex() const {
+      BOOST_ASSERT( ! m_heap.empty() );
+      return m_heap[0].vertex;
+    }
+    
+    /** The maximum is cached and only recomputed (by scanning the
+	leaves of the heap) after the vertex holding it has been
+	removed or lowered. */
+    virtual double GetBottomKey() const {
+      BOOST_ASSERT( ! m_heap.empty() );
+      if ( ! m_bottom_valid) {
+	size_t ii(m_heap.size() > 1 ? Parent(m_heap.size() - 1) + 1 : 0);
+	m_bottom = m_heap[ii].key;
+	for (++ii; ii < m_heap.size(); ++ii)
+	  if (m_heap[ii].key > m_bottom)
+	    m_bottom = m_heap[ii].key;
+	m_bottom_valid = true;
+      }
+      return m_bottom;
+    }
+    
+    virtual bool Find(vertex_t vertex, double & key) const {
+      if ((vertex >= m_pos.size()) || (0 == m_pos[vertex]))
+	return false;
+      key = m_heap[m_pos[vertex] - 1].key;
+      return true;
+    }
+    
+    virtual void Reserve(vertex_t vertex) {
+      if (vertex >= m_pos.size()) {
+	size_t size(2 * m_pos.size());
+	if (size <= vertex)
+	  size = vertex + 1;
+	m_pos.resize(size, 0);
+      }
+    }
+    
+    virtual void Insert(vertex_t vertex, double key) {
+      Reserve(vertex);
+      BOOST_ASSERT( 0 == m_pos[vertex] );
+      if (m_heap.empty()) {
+	m_bottom = key;
+	m_bottom_valid = true;
+      }
+      else if (m_bottom_valid && (key > m_bottom))
+	m_bottom = key;
+      m_heap.push_back(entry(key, m_sequence++, vertex));
+      SiftUp(m_heap.size() - 1);
+    }
+    
+    virtual void Update(vertex_t vertex, double key) {
+      BOOST_ASSERT( (vertex < m_pos.size()) && (0 != m_pos[vertex]) );
+      size_t const ii(m_pos[vertex] - 1);
+      entry & ee(m_heap[ii]);
+      if (m_bottom_valid) {
+	if (key >= m_bottom)
+	  m_bottom = key;
+	else if (ee.key == m_bottom)
+	  m_bottom_valid = false;
+      }
+      bool const up(key < ee.key);
+      ee.key = key;
+      ee.sequence = m_sequence++;
+      if (up)
+	SiftUp(ii);
+      else
+	SiftDown(ii);
+    }
+    
+    virtual void Remove(vertex_t vertex) {
+      BOOST_ASSERT( (vertex < m_pos.size()) && (0 != m_pos[vertex]) );
+      size_t const ii(m_pos[vertex] - 1);
+      if (m_heap[ii].key == m_bottom)
+	m_bottom_valid = false;
+      m_pos[vertex] = 0;
+      size_t const last(m_heap.size() - 1);
+      if (ii == last) {
+	m_heap.pop_back();
+	return;
+      }
+      m_heap[ii] = m_heap[last];
+      m_heap.pop_back();
+      m_pos[m_heap[ii].vertex] = ii + 1;
+      if ((ii > 0) && Less(m_heap[ii], m_heap[Parent(ii)]))
+	SiftUp(ii);
+      else
+	SiftDown(ii);
+    }
+    
+    virtual vertex_t PopTop() {
+      vertex_t const vertex(GetTopVertex());
+      Remove(vertex);
+      return vertex;
+    }
+    
+    virtual void Clear() {
+      // m_pos is kept allocated, we just zero the entries in use
+      for (size_t ii(0); ii < m_heap.size(); ++ii)
+	m_pos[m_heap[ii].vertex] = 0;
+      m_heap.clear();
+      m_bottom_valid = true;
+    }
+    
+    virtual void Snapshot(queue_t & queue) const {
+      std::vector<entry> sorted(m_heap);
+      std::sort(sorted.begin(), sorted.end(), Less);
+      queue.clear();
+      for (size_t ii(0); ii < sorted.size(); ++ii)
+	queue.insert(queue.end(),
+		     std::make_pair(sorted[ii].key, sorted[ii].vertex));
+    }
+    
+  private:
+    struct entry {
+      entry(double _key, size_t _sequence, vertex_t _vertex)
+	: key(_key), sequence(_sequence), vertex(_vertex) {}
+      double key;
+      size_t sequence;
+      vertex_t vertex;
+    };
+    
+    static bool Less(entry const & lhs, entry const & rhs) {
+      if (lhs.key < rhs.key)
+	return true;
+      if (rhs.key < lhs.key)
+	return false;
+      return lhs.sequence < rhs.sequence;
+    }
+    
+    static size_t Parent(size_t ii) { return (ii - 1) / arity; }
+    
+    void SiftUp(size_t ii) {
+      entry const ee(m_heap[ii]);
+      while (ii > 0) {
+	size_t const parent(Parent(ii));
+	if ( ! Less(ee, m_heap[parent]))
+	  break;
+	m_heap[ii] = m_heap[parent];
+	m_pos[m_heap[ii].vertex] = ii + 1;
+	ii = parent;
+      }
+      m_heap[ii] = ee;
+      m_pos[ee.vertex] = ii + 1;
+    }
+    
+    void SiftDown(size_t ii) {
+      entry const ee(m_heap[ii]);
+      size_t const size(m_heap.size());
+      while (true) {
+	size_t const first(arity * ii + 1);
+	if (first >= size)
+	  break;
+	size_t const end(first + arity < size ? first + arity : size);
+	size_t best(first);
+	for (size_t child(first + 1); child < end; ++child)
+	  if (Less(m_heap[child], m_heap[best]))
+	    best = child;
+	if ( ! Less(m_heap[best], ee))
+	  break;
+	m_heap[ii] = m_heap[best];
+	m_pos[m_heap[ii].vertex] = ii + 1;
+	ii = best;
+      }
+      m_heap[ii] = ee;
+      m_pos[ee.vertex] = ii + 1;
+    }
+    
+    std::vector<entry> m_heap;
+    /** one-based position in m_heap, zero means "not queued" */
+    std::vector<size_t> m_pos;
+    size_t m_sequence;
+    mutable bool m_bottom_valid;
+    mutable double m_bottom;
+  };
+  
+  
+  /**
+     Bucket queue (a la Dial) that sorts vertices into buckets of
+     floor(key / bucket_width), each bucket being a FIFO list. Pop,
+     insert, re-key, and remove are O(1), plus the amortized cost of
+     advancing over empty buckets. The lists are threaded through a
+     dense per-vertex array, so there is no allocation per queue
+     operation.
+     
+     The price is that vertices inside the same bucket are popped in
+     insertion order, not in key order: the wavefront can be
+     expanded out of order by up to one bucket width. E* still ends
+     up with a consistent navigation function because any vertex that
+     was expanded too early gets lowered and re-queued later, but
+     this costs extra expansions, and while propagation is under way
+     Facade::GetStatus() can declare a node UPWIND up to one bucket
+     width too early. The trade-off works out well when keys are
+     quantized:
+     - NF1Kernel with integer meta and bucket_width=1 (or smaller)
+       puts only equal keys into the same bucket, so the result is
+       exactly that of the heap backends.
+     - LSMKernel keys advance in steps of at least scale/meta between
+       neighbors. With bucket_width at or below the slack passed to
+       Algorithm::ComputeOne(), out-of-order expansions are
+       indistinguishable from slack. Larger widths (up to about the
+       scale) give bigger buckets and fewer empty buckets to skip,
+       at the cost of more re-expansions.
+     
+     Memory for bucket heads is proportional to the key range of the
+     queued vertices divided by bucket_width, so very small widths on
+     large maps are not a good idea. The same goes for time during
+     repairs: each vertex that gets queued below the lowest non-empty
+     bucket makes the next pops skip over all the empty buckets up to
+     the rest of the wavefront again.
+  */
+  class BucketQueueBackend
+    : public QueueBackend
+  {
+  public:
+    explicit BucketQueueBackend(double bucket_width);
+    
+    virtual bool IsEmpty() const { return 0 == m_size; }
+    virtual size_t GetSize() const { return m_size; }
+    virtual double GetTopKey() const;
+    virtual vertex_t GetTopVertex() const;
+    virtual double GetBottomKey() const;
+    virtual bool Find(vertex_t vertex, double & key) const;
+    virtual void Reserve(vertex_t vertex);
+    virtual void Insert(vertex_t vertex, double key);
+    virtual void Update(vertex_t vertex, double key);
+    virtual void Remove(vertex_t vertex);
+    virtual vertex_t PopTop();
+    virtual void Clear();
+    virtual void Snapshot(queue_t & queue) const;
+    
+    double GetBucketWidth() const { return m_width; }
+    
+  private:
+    /** Per-vertex list node, prev and next are one-based vertex
+	indices (zero marks the end of a list). */
+    struct node {
+      node(): key(0), bucket(0), prev(0), next(0), queued(false) {}
+      double key;
+      ssize_t bucket;
+      size_t prev, next;
+      bool queued;
+    };
+    
+    /** Head and tail of a FIFO bucket, again one-based. */
+    struct bucket {
+      bucket(): head(0), tail(0) {}
+      size_t head, tail;
+    };
+    
+    double const m_width;
+    std::vector<node> m_node;
+    /** m_bucket[ii] holds the vertices with floor(key / m_width) ==
+	m_base + ii */
+    std::vector<bucket> m_bucket;
+    ssize_t m_base;
+    /** no non-empty bucket below this (relative) index */
+    mutable size_t m_low;
+    /** no non-empty bucket above this (relative) index */
+    mutable size_t m_high;
+    size_t m_size;
+    
+    ssize_t ComputeBucket(double key) const;
+    void Link(vertex_t vertex);
+    void Unlink(vertex_t vertex);
+    void SkipEmpty() const;
+  };
+  
+} // namespace estar
+
+#endif // ESTAR_QUEUE_BACKEND_HPP
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+#include "ThreadPool.hpp"
+
+
+namespace estar {
+  
+  
+  ThreadPool::
+  ThreadPool(size_t nthreads)
+    : m_nthreads(nthreads < 1 ? 1 : nthreads),
+      m_thread(m_nthreads),
+      m_worker(m_nthreads),
+      m_generation(0),
+      m_nbusy(0),
+      m_quit(false),
+      m_job(0),
+      m_arg(0),
+      m_njobs(0)
+  {
+    pthread_mutex_init(&m_mutex, 0);
+    pthread_cond_init(&m_start, 0);
+    pthread_cond_init(&m_done, 0);
+    for (size_t iw(1); iw < m_nthreads; ++iw) {
+      m_worker[iw].pool = this;
+      m_worker[iw].id = iw;
+      pthread_create(&m_thread[iw], 0, Work, &m_worker[iw]);
+    }
+  }
+  
+  
+  ThreadPool::
+  ~ThreadPool()
+  {
+    pthread_mutex_lock(&m_mutex);
+    m_quit = true;
+    pthread_cond_broadcast(&m_start);
+    pthread_mutex_unlock(&m_mutex);
+    for (size_t iw(1); iw < m_nthreads; ++iw)
+      pthread_join(m_thread[iw], 0);
+    pthread_cond_destroy(&m_done);
+    pthread_cond_destroy(&m_start);
+    pthread_mutex_destroy(&m_mutex);
+  }
+  
+  
+  void ThreadPool::
+  Run(job_t job, void * arg, size_t njobs)
+  {
+    if ((1 == m_nthreads) || (njobs < m_nthreads)) {
+      job(arg, 0, njobs);
+      return;
+    }
+    pthread_mutex_lock(&m_mutex);
+    m_job = job;
+    m_arg = arg;
+    m_njobs = njobs;
+    m_nbusy = m_nthreads - 1;
+    ++m_generation;
+    pthread_cond_broadcast(&m_start);
+    pthread_mutex_unlock(&m_mutex);
+    
+    RunChunk(0);
+    
+    pthread_mutex_lock(&m_mutex);
+    while (m_nbusy > 0)
+      pthread_cond_wait(&m_done, &m_mutex);
+    pthread_mutex_unlock(&m_mutex);
+  }
+  
+  
+  void ThreadPool::
+  RunChunk(size_t id) const
+  {
+    size_t const first(id * m_njobs / m_nthreads);
+    size_t const last((id + 1) * m_njobs / m_nthreads);
+    if (first < last)
+      m_job(m_arg, first, last);
+  }
+  
+  
+  void * ThreadPool::
+  Work(void * arg)
+  {
+    worker_s const & worker(*reinterpret_cast<worker_s*>(arg));
+    ThreadPool & pool(*worker.pool);
+    // Workers are started before the first Run(), so they must not
+    // read the generation here: it might already have moved on.
+    size_t generation(0);
+    pthread_mutex_lock(&pool.m_mutex);
+    for (;;) {
+      while ((generation == pool.m_generation) && ( ! pool.m_quit))
+	pthread_cond_wait(&pool.m_start, &pool.m_mutex);
+      if (pool.m_quit)
+	break;
+      generation = pool.m_generation;
+      pthread_mutex_unlock(&pool.m_mutex);
+      pool.RunChunk(worker.id);
+      pthread_mutex_lock(&pool.m_mutex);
+      if (0 == --pool.m_nbusy)
+	pthread_cond_signal(&pool.m_done);
+    }
+    pthread_mutex_unlock(&pool.m_mutex);
+    return 0;
+  }
+  
+} // namespace estar
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+#ifndef ESTAR_THREAD_POOL_HPP
+#define ESTAR_THREAD_POOL_HPP
+
+
+#include <vector>
+#include <unistd.h>
+#include <pthread.h>
+
+
+namespace estar {
+  
+  
+  /**
+     A fixed set of worker threads that split index ranges among
+     themselves. The calling thread of Run() does its share of the
+     work too, so a pool of N threads starts N-1 workers, and a pool
+     of one thread just calls the job directly.
+  */
+  class ThreadPool {
+  public:
+    /** Process the indices [first, last[ of a job. */
+    typedef void (*job_t)(void * arg, size_t first, size_t last);
+    
+    explicit ThreadPool(size_t nthreads);
+    ~ThreadPool();
+    
+    size_t GetNThreads() const { return m_nthreads; }
+    
+    /**
+       Split [0, njobs[ into one contiguous chunk per thread, call the
+       job on each chunk, and return when all of them are done. The
+       job must not call Run() on the same pool.
+    */
+    void Run(job_t job, void * arg, size_t njobs);
+    
+  private:
+    struct worker_s {
+      ThreadPool * pool;
+      size_t id;
+    };
+    
+    static void * Work(void * arg);
+    void RunChunk(size_t id) const;
+    
+    size_t const m_nthreads;
+    std::vector<pthread_t> m_thread;
+    std::vector<worker_s> m_worker;
+    pthread_mutex_t m_mutex;
+    pthread_cond_t m_start;
+    pthread_cond_t m_done;
+    /** incremented for each Run(), tells the workers to start */
+    size_t m_generation;
+    /** number of workers still busy with the current Run() */
+    size_t m_nbusy;
+    bool m_quit;
+    job_t m_job;
+    void * m_arg;
+    size_t m_njobs;
+  };
+  
+} // namespace estar
+
+#endif // ESTAR_THREAD_POOL_HPP
@@ -0,0 +1,632 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+#include "TileStore.hpp"
+#include "numeric.hpp"
+#include "util.hpp"
+#include <boost/scoped_ptr.hpp>
+#include <fstream>
+#include <sstream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <float.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+
+using boost::scoped_ptr;
+using std::string;
+using std::vector;
+using std::runtime_error;
+using std::logic_error;
+
+
+namespace {
+  
+  
+  char const magic[8] = { 'E', 'S', 'T', 'A', 'R', 'T', 'S', '\0' };
+  uint32_t const version(1);
+  uint32_t const byte_order_mark(0x01020304);
+  size_t const header_fields(80);
+  size_t const alignment(4096);
+  
+  
+  string syserr(string const & what, string const & path)
+  {
+    return what + "(" + path + "): " + strerror(errno);
+  }
+  
+  
+  void write_all(int fd, char const * buf, size_t len, string const & path)
+  {
+    while (len > 0) {
+      ssize_t const nn(write(fd, buf, len));
+      if (nn < 0) {
+	if (EINTR == errno)
+	  continue;
+	throw runtime_error(syserr("estar::TileStore::Create(): write",
+				   path));
+      }
+      buf += nn;
+      len -= nn;
+    }
+  }
+  
+  
+  template<typename T>
+  void put(char * header, size_t offset, T value)
+  { memcpy(header + offset, &value, sizeof(value)); }
+  
+  
+  template<typename T>
+  T get(char const * header, size_t offset)
+  {
+    T value;
+    memcpy(&value, header + offset, sizeof(value));
+    return value;
+  }
+  
+  
+  size_t round_up(size_t value, size_t multiple)
+  { return ((value + multiple - 1) / multiple) * multiple; }
+  
+  
+  /** Maps costs to metas like the NHPRiskmap of test_estar_gfx. */
+  struct cost_to_meta {
+    explicit cost_to_meta(double maxcost)
+      : scale(maxcost > 0 ? 1 / maxcost : 0) {}
+    
+    double operator () (double cost) const {
+      if (cost < 0)
+	return 0;
+      return estar::boundval(0.0, 1 - cost * scale, 1.0);
+    }
+    
+    double scale;
+  };
+  
+  
+  /** Enough tiles to write a grid row by row without thrashing. */
+  size_t row_capacity(ssize_t xsize, ssize_t tilesize)
+  { return (xsize + tilesize - 1) / tilesize + 1; }
+  
+  
+  /** Reads the header and then the gray levels of a P2 or P5 file. */
+  class pgm_reader {
+  public:
+    pgm_reader(string const & infile, std::ostream * err_os)
+      : is(infile.c_str(), std::ios::binary), width(0), height(0),
+	maxgray(0), raw(false)
+    {
+      if ( ! is) {
+	if (err_os)
+	  *err_os << "estar::convert_pgm(): couldn't open \""
+		  << infile << "\"\n";
+	return;
+      }
+      char pp(0), format(0);
+      is.get(pp).get(format);
+      raw = ('5' == format);
+      if (('P' != pp) || (('2' != format) && ('5' != format))
+	  || ( ! Number(width)) || ( ! Number(height))
+	  || ( ! Number(maxgray))
+	  || (width < 1) || (height < 1) || (maxgray < 1)
+	  || (maxgray > 65535)) {
+	if (err_os)
+	  *err_os << "estar::convert_pgm(): \"" << infile
+		  << "\" is not a valid P2 or P5 file\n";
+	width = 0;
+	return;
+      }
+      if (raw)
+	is.get();		// the single whitespace after maxgray
+    }
+    
+    bool Ok() const { return width > 0; }
+    
+    bool Gray(long & gray) {
+      if ( ! raw)
+	return Number(gray);
+      int const hi(is.get());
+      if (maxgray < 256) {
+	gray = hi;
+	return hi != std::char_traits<char>::eof();
+      }
+      int const lo(is.get());
+      gray = (hi << 8) | lo;
+      return lo != std::char_traits<char>::eof();
+    }
+    
+    std::ifstream is;
+    long width, height, maxgray;
+    bool raw;
+    
+  private:
+    /** Skips whitespace and comments. */
+    bool Number(long & number) {
+      for (int cc(is.peek()); is; cc = is.peek()) {
+	if ('#' == cc)
+	  is.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+	else if (isspace(cc))
+	  is.get();
+	else
+	  break;
+      }
+      return static_cast<bool>(is >> number);
+    }
+  };
+  
+  
+}
+
+
+namespace estar {
+  
+  
+  TileStore::
+  TileStore(string const & path, bool writable, size_t capacity)
+    : m_path(path),
+      m_writable(writable),
+      m_capacity(maxval(static_cast<size_t>(1), capacity)),
+      m_fd(-1),
+      m_xbegin(0),
+      m_xend(0),
+      m_ybegin(0),
+      m_yend(0),
+      m_tsize(0),
+      m_tshift(0),
+      m_nchannels(0),
+      m_ntiles_y(0),
+      m_stride(0),
+      m_header_size(0),
+      m_ntiles(0),
+      m_pagesize(sysconf(_SC_PAGESIZE)),
+      m_last(0),
+      m_npageins(0),
+      m_nevictions(0),
+      m_nwritebacks(0)
+  {
+  }
+  
+  
+  TileStore * TileStore::
+  Create(string const & path,
+	 ssize_t xbegin, ssize_t xend,
+	 ssize_t ybegin, ssize_t yend,
+	 ssize_t tilesize, bool with_values,
+	 double meta, size_t capacity)
+  {
+    if ((xend <= xbegin) || (yend <= ybegin))
+      throw logic_error("estar::TileStore::Create(): empty range");
+    if ((tilesize < 1) || (0 != (tilesize & (tilesize - 1))))
+      throw logic_error("estar::TileStore::Create(): invalid tilesize");
+    
+    ssize_t const nchannels(with_values ? 2 : 1);
+    size_t const ncells(tilesize * tilesize);
+    size_t const stride(round_up(nchannels * ncells * sizeof(float),
+				 alignment));
+    size_t const ntiles(((xend - xbegin + tilesize - 1) / tilesize)
+			* ((yend - ybegin + tilesize - 1) / tilesize));
+    
+    vector<char> buf(maxval(alignment, stride), 0);
+    memcpy(&buf[0], magic, sizeof(magic));
+    put<uint32_t>(&buf[0],  8, version);
+    put<uint32_t>(&buf[0], 12, byte_order_mark);
+    put<int64_t>(&buf[0], 16, xbegin);
+    put<int64_t>(&buf[0], 24, xend - xbegin);
+    put<int64_t>(&buf[0], 32, ybegin);
+    put<int64_t>(&buf[0], 40, yend - ybegin);
+    put<int64_t>(&buf[0], 48, tilesize);
+    put<int64_t>(&buf[0], 56, nchannels);
+    put<int64_t>(&buf[0], 64, stride);
+    put<int64_t>(&buf[0], 72, alignment);
+    
+    int const fd(open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644));
+    if (fd < 0)
+      throw runtime_error(syserr("estar::TileStore::Create(): open", path));
+    try {
+      write_all(fd, &buf[0], alignment, path);
+      
+      // All tiles look the same initially.
+      memset(&buf[0], 0, buf.size());
+      float * const data(reinterpret_cast<float *>(&buf[0]));
+      for (size_t ii(0); ii < ncells; ++ii)
+	data[ii] = meta;
+      if (with_values)
+	for (size_t ii(0); ii < ncells; ++ii)
+	  data[ncells + ii] = std::numeric_limits<float>::infinity();
+      for (size_t it(0); it < ntiles; ++it)
+	write_all(fd, &buf[0], stride, path);
+    }
+    catch (...) {
+      close(fd);
+      throw;
+    }
+    if (0 != close(fd))
+      throw runtime_error(syserr("estar::TileStore::Create(): close", path));
+    
+    return Open(path, true, capacity);
+  }
+  
+  
+  TileStore * TileStore::
+  Open(string const & path, bool writable, size_t capacity)
+  {
+    std::auto_ptr<TileStore> store(new TileStore(path, writable, capacity));
+    store->m_fd = open(path.c_str(), writable ? O_RDWR : O_RDONLY);
+    if (store->m_fd < 0)
+      throw runtime_error(syserr("estar::TileStore::Open(): open", path));
+    store->ReadHeader();
+    return store.release();
+  }
+  
+  
+  TileStore::
+  ~TileStore()
+  {
+    while ( ! m_lru.empty()) {
+      slot_s * const slot(m_lru.back());
+      if (slot->dirty)
+	Writeback(slot, true);
+      Unmap(slot);
+    }
+    if (m_fd >= 0)
+      close(m_fd);
+  }
+  
+  
+  void TileStore::
+  ReadHeader()
+  {
+    char header[header_fields];
+    if (static_cast<ssize_t>(header_fields)
+	!= pread(m_fd, header, header_fields, 0))
+      throw runtime_error("estar::TileStore::Open(" + m_path
+			  + "): short header");
+    if ((0 != memcmp(header, magic, sizeof(magic)))
+	|| (version != get<uint32_t>(header, 8)))
+      throw runtime_error("estar::TileStore::Open(" + m_path
+			  + "): not a version 1 tile store");
+    if (byte_order_mark != get<uint32_t>(header, 12))
+      throw runtime_error("estar::TileStore::Open(" + m_path
+			  + "): wrong byte order");
+    
+    int64_t const xsize(get<int64_t>(header, 24));
+    int64_t const ysize(get<int64_t>(header, 40));
+    int64_t const stride(get<int64_t>(header, 64));
+    int64_t const hsize(get<int64_t>(header, 72));
+    m_xbegin = get<int64_t>(header, 16);
+    m_xend = m_xbegin + xsize;
+    m_ybegin = get<int64_t>(header, 32);
+    m_yend = m_ybegin + ysize;
+    m_tsize = get<int64_t>(header, 48);
+    m_nchannels = get<int64_t>(header, 56);
+    if ((xsize < 1) || (ysize < 1)
+	|| (m_tsize < 1) || (0 != (m_tsize & (m_tsize - 1)))
+	|| (m_nchannels < 1) || (m_nchannels > 2)
+	|| (stride < static_cast<int64_t>(m_nchannels * m_tsize * m_tsize
+					   * sizeof(float)))
+	|| (0 != stride % sizeof(float))
+	|| (hsize < static_cast<int64_t>(header_fields))
+	|| (0 != hsize % sizeof(float)))
+      throw runtime_error("estar::TileStore::Open(" + m_path
+			  + "): invalid header");
+    for (m_tshift = 0; (1 << m_tshift) < m_tsize; ++m_tshift)
+      /* nop */;
+    m_ntiles_y = (ysize + m_tsize - 1) / m_tsize;
+    m_ntiles = ((xsize + m_tsize - 1) / m_tsize) * m_ntiles_y;
+    m_stride = stride;
+    m_header_size = hsize;
+    
+    struct stat st;
+    if (0 != fstat(m_fd, &st))
+      throw runtime_error(syserr("estar::TileStore::Open(): fstat", m_path));
+    if (static_cast<size_t>(st.st_size) < GetFileSize())
+      throw runtime_error("estar::TileStore::Open(" + m_path
+			  + "): truncated file");
+  }
+  
+  
+  size_t TileStore::
+  GetFileSize() const
+  {
+    return m_header_size + m_ntiles * m_stride;
+  }
+  
+  
+  size_t TileStore::
+  GetWorkingSetSize() const
+  {
+    return minval(m_capacity, m_ntiles) * m_stride;
+  }
+  
+  
+  double TileStore::
+  GetMeta(ssize_t ix, ssize_t iy) const
+  {
+    if ( ! IsValidIndex(ix, iy))
+      return 0;
+    return *Cell(ix, iy, 0, false);
+  }
+  
+  
+  bool TileStore::
+  SetMeta(ssize_t ix, ssize_t iy, double meta)
+  {
+    if ( ! m_writable)
+      throw logic_error("estar::TileStore::SetMeta() on read-only store");
+    if ( ! IsValidIndex(ix, iy))
+      return false;
+    *Cell(ix, iy, 0, true) = meta;
+    return true;
+  }
+  
+  
+  double TileStore::
+  GetValue(ssize_t ix, ssize_t iy) const
+  {
+    if (( ! HaveValues()) || ( ! IsValidIndex(ix, iy)))
+      return infinity;
+    float const value(*Cell(ix, iy, 1, false));
+    if (value > FLT_MAX)
+      return infinity;
+    return value;
+  }
+  
+  
+  bool TileStore::
+  SetValue(ssize_t ix, ssize_t iy, double value)
+  {
+    if ( ! m_writable)
+      throw logic_error("estar::TileStore::SetValue() on read-only store");
+    if (( ! HaveValues()) || ( ! IsValidIndex(ix, iy)))
+      return false;
+    if (value >= infinity)
+      *Cell(ix, iy, 1, true) = std::numeric_limits<float>::infinity();
+    else
+      *Cell(ix, iy, 1, true) = value;
+    return true;
+  }
+  
+  
+  void TileStore::
+  Flush()
+  {
+    for (std::list<slot_s *>::iterator il(m_lru.begin());
+	 il != m_lru.end(); ++il)
+      if ((*il)->dirty && ( ! Writeback(*il, true)))
+	throw runtime_error(syserr("estar::TileStore::Flush(): msync",
+				   m_path));
+  }
+  
+  
+  float * TileStore::
+  Cell(ssize_t ix, ssize_t iy, ssize_t channel, bool modify) const
+  {
+    size_t const jx(ix - m_xbegin);
+    size_t const jy(iy - m_ybegin);
+    size_t const tile((jx >> m_tshift) * m_ntiles_y + (jy >> m_tshift));
+    slot_s * slot(m_last);
+    if ((0 == slot) || (tile != slot->tile))
+      slot = MapTile(tile);
+    if (modify)
+      slot->dirty = true;
+    size_t const mask(m_tsize - 1);
+    return slot->data + (channel << (2 * m_tshift))
+      + ((jx & mask) << m_tshift) + (jy & mask);
+  }
+  
+  
+  TileStore::slot_s * TileStore::
+  MapTile(size_t tile) const
+  {
+    slot_map_t::iterator is(m_slot.find(tile));
+    if (m_slot.end() != is) {
+      m_lru.splice(m_lru.begin(), m_lru, is->second.lru);
+      m_last = &is->second;
+      return m_last;
+    }
+    
+    if (m_slot.size() >= m_capacity) {
+      Unmap(m_lru.back());
+      ++m_nevictions;
+    }
+    
+    // Respect the page size of this machine even if the file was
+    // written on one with bigger pages.
+    off_t const offset(m_header_size + tile * m_stride);
+    off_t const aligned(offset - offset % static_cast<off_t>(m_pagesize));
+    size_t const maplen(m_stride + offset - aligned);
+    void * const map(mmap(0, maplen,
+			  m_writable ? PROT_READ | PROT_WRITE : PROT_READ,
+			  MAP_SHARED, m_fd, aligned));
+    if (MAP_FAILED == map)
+      throw runtime_error(syserr("estar::TileStore: mmap", m_path));
+    
+    slot_s & slot(m_slot[tile]);
+    slot.tile = tile;
+    slot.map = map;
+    slot.maplen = maplen;
+    slot.data = reinterpret_cast<float *>(static_cast<char *>(map)
+					  + (offset - aligned));
+    slot.dirty = false;
+    m_lru.push_front(&slot);
+    slot.lru = m_lru.begin();
+    ++m_npageins;
+    m_last = &slot;
+    return m_last;
+  }
+  
+  
+  void TileStore::
+  Unmap(slot_s * slot) const
+  {
+    if (slot->dirty)
+      Writeback(slot, false);
+    munmap(slot->map, slot->maplen);
+    m_lru.erase(slot->lru);
+    if (m_last == slot)
+      m_last = 0;
+    m_slot.erase(slot->tile);
+  }
+  
+  
+  bool TileStore::
+  Writeback(slot_s * slot, bool sync) const
+  {
+    slot->dirty = false;
+    ++m_nwritebacks;
+    return 0 == msync(slot->map, slot->maplen, sync ? MS_SYNC : MS_ASYNC);
+  }
+  
+  
+  TileStore *
+  convert_ascii_grid(string const & infile, string const & outfile,
+		     ssize_t tilesize, bool with_values,
+		     size_t capacity, std::ostream * err_os)
+  {
+    // First pass: size and maximum cost.
+    ssize_t xsize(0);
+    ssize_t ysize(0);
+    double maxcost(0);
+    {
+      std::ifstream is(infile.c_str());
+      if ( ! is) {
+	if (err_os)
+	  *err_os << "estar::convert_ascii_grid(): couldn't open \""
+		  << infile << "\"\n";
+	return 0;
+      }
+      string textline;
+      while (getline(is, textline)) {
+	if (( ! textline.empty()) && ('#' == textline[0]))
+	  continue;
+	++ysize;
+	std::istringstream tls(textline);
+	ssize_t ncols(0);
+	double cost;
+	while (tls >> cost) {
+	  ++ncols;
+	  if (cost > maxcost)
+	    maxcost = cost;
+	}
+	xsize = maxval(xsize, ncols);
+      }
+    }
+    if ((xsize < 1) || (ysize < 1)) {
+      if (err_os)
+	*err_os << "estar::convert_ascii_grid(): \"" << infile
+		<< "\" has size " << xsize << " x " << ysize << "\n";
+      return 0;
+    }
+    
+    // Second pass: the metas, missing cells keep those of cost zero.
+    {
+      scoped_ptr<TileStore>
+	store(TileStore::Create(outfile, 0, xsize, 0, ysize, tilesize,
+				with_values, 1,
+				row_capacity(xsize, tilesize)));
+      cost_to_meta const c2m(maxcost);
+      std::ifstream is(infile.c_str());
+      string textline;
+      ssize_t iy(ysize - 1);
+      while (getline(is, textline) && (iy >= 0)) {
+	if (( ! textline.empty()) && ('#' == textline[0]))
+	  continue;
+	std::istringstream tls(textline);
+	double cost;
+	for (ssize_t ix(0); tls >> cost; ++ix)
+	  store->SetMeta(ix, iy, c2m(cost));
+	--iy;
+      }
+      if (iy >= 0) {
+	if (err_os)
+	  *err_os << "estar::convert_ascii_grid(): \"" << infile
+		  << "\" changed while reading it\n";
+	return 0;
+      }
+    }
+    
+    return TileStore::Open(outfile, true, capacity);
+  }
+  
+  
+  TileStore *
+  convert_pgm(string const & infile, string const & outfile,
+	      ssize_t tilesize, bool with_values,
+	      size_t capacity, std::ostream * err_os)
+  {
+    // First pass: maximum cost, i.e. the highest non-obstacle gray.
+    long maxcost(0);
+    long xsize, ysize;
+    {
+      pgm_reader pgm(infile, err_os);
+      if ( ! pgm.Ok())
+	return 0;
+      xsize = pgm.width;
+      ysize = pgm.height;
+      long gray;
+      for (long ii(0); ii < xsize * ysize; ++ii) {
+	if ( ! pgm.Gray(gray)) {
+	  if (err_os)
+	    *err_os << "estar::convert_pgm(): \"" << infile
+		    << "\" is truncated\n";
+	  return 0;
+	}
+	if ((gray < pgm.maxgray) && (gray > maxcost))
+	  maxcost = gray;
+      }
+    }
+    
+    // Second pass: the metas, top row first.
+    {
+      scoped_ptr<TileStore>
+	store(TileStore::Create(outfile, 0, xsize, 0, ysize, tilesize,
+				with_values, 1,
+				row_capacity(xsize, tilesize)));
+      cost_to_meta const c2m(maxcost);
+      pgm_reader pgm(infile, err_os);
+      long gray(0);
+      for (ssize_t iy(ysize - 1); iy >= 0; --iy)
+	for (ssize_t ix(0); ix < xsize; ++ix) {
+	  if ( ! pgm.Gray(gray)) {
+	    if (err_os)
+	      *err_os << "estar::convert_pgm(): \"" << infile
+		      << "\" changed while reading it\n";
+	    return 0;
+	  }
+	  store->SetMeta(ix, iy, c2m(gray < pgm.maxgray ? gray : -1));
+	}
+    }
+    
+    return TileStore::Open(outfile, true, capacity);
+  }
+  
+}
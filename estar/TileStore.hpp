@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+#ifndef ESTAR_TILE_STORE_HPP
+#define ESTAR_TILE_STORE_HPP
+
+
+#include <estar/Grid.hpp>
+#include <list>
+#include <map>
+#include <string>
+#include <iosfwd>
+
+
+namespace estar {
+  
+  
+  /**
+     Out-of-core storage for the metas, and optionally the values, of
+     grids that are too large to keep in memory. The cells live in a
+     file of fixed-size square tiles, which get memory-mapped one by
+     one when they are accessed. At most GetCapacity() tiles are
+     mapped at any time: when a new tile is needed and the working set
+     is full, the least recently used tile gets unmapped, and written
+     back first if it has been modified.
+     
+     A TileStore is a Grid::get_meta, so it can serve as the meta
+     source of a tiled grid (see Grid::SetTileSource() and
+     Facade::SetTileStore()). Tiles of the C-space then read their
+     metas from the file when the wavefront reaches them.
+     
+     \note Only the map is out of core. The C-space tiles that the
+     planner has created stay in memory, so this helps when the
+     wavefront covers a small part of a large map.
+     
+     \note This uses POSIX mmap(), it is not available on WIN32.
+     
+     The file format, version 1, starts with a header. All numbers
+     are in the byte order of the machine that wrote the file, and
+     files with a different byte order are rejected.
+     
+     \verbatim
+     offset  type     field
+          0  char[8]  magic "ESTARTS" followed by a zero byte
+          8  uint32   version, 1
+         12  uint32   byte order mark 0x01020304
+         16  int64    xbegin
+         24  int64    xsize
+         32  int64    ybegin
+         40  int64    ysize
+         48  int64    tile size T, a power of two
+         56  int64    number of channels C, 1 (meta) or 2 (meta and value)
+         64  int64    tile stride S, in bytes
+         72  int64    header size H, the offset of the first tile
+     \endverbatim
+     
+     The tiles follow the header, in X-major order: with NY =
+     ceil(ysize / T), tile (tx, ty) starts at byte H + (tx * NY + ty)
+     * S. A tile consists of C channels of T * T float32 each, one
+     after the other. Within a channel, cell (ix, iy) is at index (ix
+     - x0) * T + iy - y0, where (x0, y0) is the first cell of the tile
+     (the same order as the vertices of Grid tiles). Infinite values
+     are stored as IEEE infinity. Cells beyond the range and the
+     padding after the header and the channels are unused. The files
+     written by Create() have H and S rounded up to multiples of 4096
+     bytes so that tiles map onto whole pages.
+  */
+  class TileStore
+    : public Grid::get_meta
+  {
+  public:
+    /**
+       Create a new store file, replacing any existing one, with all
+       metas set to the given value and all values (if with_values)
+       to infinity. At most capacity tiles are kept mapped. Throws
+       std::runtime_error if the file can not be written, and
+       std::logic_error for an invalid range or tilesize.
+    */
+    static TileStore * Create(std::string const & path,
+			      ssize_t xbegin, ssize_t xend,
+			      ssize_t ybegin, ssize_t yend,
+			      ssize_t tilesize, bool with_values,
+			      double meta, size_t capacity);
+    
+    /**
+       Open an existing store file. Throws std::runtime_error if it
+       can not be opened or is not a valid store.
+    */
+    static TileStore * Open(std::string const & path, bool writable,
+			    size_t capacity);
+    
+    /** Writes back all modified tiles and closes the file. */
+    virtual ~TileStore();
+    
+    ssize_t GetXBegin() const { return m_xbegin; }
+    ssize_t GetXEnd() const { return m_xend; }
+    ssize_t GetYBegin() const { return m_ybegin; }
+    ssize_t GetYEnd() const { return m_yend; }
+    ssize_t GetTileSize() const { return m_tsize; }
+    bool HaveValues() const { return 1 < m_nchannels; }
+    bool IsWritable() const { return m_writable; }
+    
+    bool IsValidIndex(ssize_t ix, ssize_t iy) const {
+      return (ix >= m_xbegin) && (ix < m_xend)
+	&& (iy >= m_ybegin) && (iy < m_yend);
+    }
+    
+    /** \return The meta of (ix, iy), or zero if it lies outside the
+	range. */
+    double GetMeta(ssize_t ix, ssize_t iy) const;
+    
+    /** \return false if (ix, iy) lies outside the range. Throws
+	std::logic_error if the store is not writable. */
+    bool SetMeta(ssize_t ix, ssize_t iy, double meta);
+    
+    /** \return The value of (ix, iy), or infinity if it lies outside
+	the range or the store has no values. */
+    double GetValue(ssize_t ix, ssize_t iy) const;
+    
+    /** \return false if (ix, iy) lies outside the range or the store
+	has no values. Throws std::logic_error if the store is not
+	writable. */
+    bool SetValue(ssize_t ix, ssize_t iy, double value);
+    
+    /** Implements Grid::get_meta by calling GetMeta(). */
+    virtual double operator () (ssize_t ix, ssize_t iy) const
+    { return GetMeta(ix, iy); }
+    
+    /** Synchronously write all modified tiles back to the file. They
+	stay mapped. */
+    void Flush();
+    
+    /** \return The maximum number of tiles that are mapped at once. */
+    size_t GetCapacity() const { return m_capacity; }
+    
+    /** \return The number of tiles that are currently mapped. */
+    size_t GetNMapped() const { return m_slot.size(); }
+    
+    /** \return How many times a tile has been mapped so far. */
+    size_t GetNPageins() const { return m_npageins; }
+    
+    /** \return How many times a tile has been unmapped to make room
+	for another one. */
+    size_t GetNEvictions() const { return m_nevictions; }
+    
+    /** \return How many times a modified tile has been written
+	back. */
+    size_t GetNWritebacks() const { return m_nwritebacks; }
+    
+    /** \return The number of bytes in the file. */
+    size_t GetFileSize() const;
+    
+    /** \return The number of bytes that are mapped when the working
+	set is full. */
+    size_t GetWorkingSetSize() const;
+    
+  private:
+    struct slot_s {
+      size_t tile;
+      void * map;
+      size_t maplen;
+      float * data;
+      bool dirty;
+      std::list<slot_s *>::iterator lru;
+    };
+    typedef std::map<size_t, slot_s> slot_map_t;
+    
+    std::string const m_path;
+    bool const m_writable;
+    size_t const m_capacity;
+    int m_fd;
+    ssize_t m_xbegin, m_xend, m_ybegin, m_yend;
+    ssize_t m_tsize, m_tshift, m_nchannels, m_ntiles_y;
+    size_t m_stride, m_header_size, m_ntiles, m_pagesize;
+    
+    mutable slot_map_t m_slot;
+    /** most recently used first */
+    mutable std::list<slot_s *> m_lru;
+    /** shortcut for runs of accesses to the same tile */
+    mutable slot_s * m_last;
+    mutable size_t m_npageins, m_nevictions, m_nwritebacks;
+    
+    TileStore(std::string const & path, bool writable, size_t capacity);
+    TileStore(TileStore const &);
+    TileStore & operator = (TileStore const &);
+    
+    /** Read and check the header, throws std::runtime_error. */
+    void ReadHeader();
+    
+    /** \return The cell of (ix, iy) in the given channel, mapping its
+	tile as needed. The index must be valid. */
+    float * Cell(ssize_t ix, ssize_t iy, ssize_t channel,
+		 bool modify) const;
+    
+    slot_s * MapTile(size_t tile) const;
+    void Unmap(slot_s * slot) const;
+    /** \return false if msync() failed. */
+    bool Writeback(slot_s * slot, bool sync) const;
+  };
+  
+  
+  /**
+     Convert a grid in the ASCII format of the test_estar_gfx program
+     into a new TileStore file. Each line holds the costs of one row,
+     the first line being the highest Y index, and lines that start
+     with '#' are comments (test_estar_gfx uses "#goal", "#robot", and
+     "#hexgrid"). Costs are turned into metas the same way as
+     test_estar_gfx does: negative costs become obstacles (meta zero),
+     the others get 1 - cost / maxcost, and missing cells at the end
+     of short lines get meta one. The range starts at (0, 0). The
+     input has to be a regular file because it is read twice.
+     
+     \return The new store, or null after writing an explanation to
+     err_os (unless it is null). Errors while writing the store
+     result in std::runtime_error.
+  */
+  TileStore * convert_ascii_grid(std::string const & infile,
+				 std::string const & outfile,
+				 ssize_t tilesize, bool with_values,
+				 size_t capacity, std::ostream * err_os);
+  
+  /**
+     Convert a PGM map (plain P2 or raw P5) into a new TileStore
+     file. Gray levels are treated the way pgm2ascii followed by
+     convert_ascii_grid() would: the maximum gray level denotes
+     obstacles, the others are costs, and the first row of the image
+     is the highest Y index. Unlike pgm2ascii, the last row of the
+     image is kept as well. Reports errors like
+     convert_ascii_grid().
+  */
+  TileStore * convert_pgm(std::string const & infile,
+			  std::string const & outfile,
+			  ssize_t tilesize, bool with_values,
+			  size_t capacity, std::ostream * err_os);
+  
+} // namespace estar
+
+#endif // ESTAR_TILE_STORE_HPP
@@ -0,0 +1,418 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+#ifndef ESTAR_TILED_ALGORITHM_HPP
+#define ESTAR_TILED_ALGORITHM_HPP
+
+
+#include <estar/BasicAlgorithm.hpp>
+#include <estar/ThreadPool.hpp>
+#include <vector>
+
+
+namespace estar {
+
+
+  /**
+     Multi-threaded full replanning on rectangular grids. The grid is
+     cut into square tiles, and each tile is owned by one worker
+     thread (tiles are dealt out round-robin, so the wavefront
+     usually spans all workers). A tile stores its cells with a ring
+     of halo cells around them, has its own wavefront queue, and only
+     ever writes to its own cells. The workers proceed in rounds:
+
+     -# Find the lowest key over all tile queues.
+     -# Expand the cells of their tiles whose key lies within a band
+        above that lower bound. Halo cells hold the neighbors' values
+        from the end of the previous round.
+     -# Copy the neighboring tiles' border values into their halo
+        cells, and update the cells next to each halo cell that got
+        lowered.
+
+     The workers are those of a ThreadPool, the calling thread finds
+     the lowest key, and the other two steps are separate calls to
+     ThreadPool::Run(), so nobody reads a cell while its owner writes
+     it. Propagation stops when all queues are empty.
+
+     Cells can only get lowered here, which is why this only does
+     full replans (use Algorithm or BasicAlgorithm for incremental
+     repairs). A cell that gets expanded with a value that is later
+     improved through a halo is simply expanded again, so the band
+     trades the number of rounds against wasted expansions. The
+     kernels are monotone, so the values converge to the same fixed
+     point as with sequential E*, and they agree with BasicAlgorithm
+     within a few times the slack.
+
+     Kernels and neighborhoods are the same as for BasicAlgorithm.
+     After Compute(), GetUpwind() tells which neighbors each value was
+     computed from, which is what Facade::ComputeParallel() uses to
+     hand the result over to an Algorithm.
+
+     \code
+     TiledAlgorithm<BasicLSMKernel, FourNeighborhood>
+       algo(xsize, ysize, BasicLSMKernel(scale));
+     algo.AddGoal(0, 0, 0);
+     algo.Compute(nthreads, scale / 10000);
+     \endcode
+  */
+  template<class KernelT, class NeighborhoodT>
+  class TiledAlgorithm {
+  public:
+    typedef KernelT kernel_t;
+    typedef NeighborhoodT neighborhood_t;
+    typedef unsigned char mask_t;
+
+    TiledAlgorithm(ssize_t xsize, ssize_t ysize,
+		   KernelT const & kernel,
+		   /** edge length of the (square) tiles, in cells */
+		   ssize_t tile_size = 64)
+      : m_kernel(kernel),
+	m_xsize(xsize),
+	m_ysize(ysize),
+	m_tile_size(tile_size < 1 ? 1 : tile_size),
+	m_ntx((xsize + m_tile_size - 1) / m_tile_size),
+	m_nty((ysize + m_tile_size - 1) / m_tile_size),
+	m_nexpanded(0),
+	m_nrounds(0)
+    {
+      m_tile.reserve(m_ntx * m_nty);
+      for (ssize_t tx(0); tx < m_ntx; ++tx)
+	for (ssize_t ty(0); ty < m_nty; ++ty) {
+	  ssize_t const x0(tx * m_tile_size);
+	  ssize_t const y0(ty * m_tile_size);
+	  m_tile.push_back(new tile(x0, y0,
+				    minval(m_tile_size, xsize - x0),
+				    minval(m_tile_size, ysize - y0)));
+	}
+      for (size_t it(0); it < m_tile.size(); ++it)
+	InitHalo(*m_tile[it]);
+    }
+
+    ~TiledAlgorithm()
+    {
+      for (size_t it(0); it < m_tile.size(); ++it)
+	delete m_tile[it];
+    }
+
+    ssize_t GetXSize() const { return m_xsize; }
+    ssize_t GetYSize() const { return m_ysize; }
+
+    double GetValue(ssize_t ix, ssize_t iy) const
+    {
+      tile const & tt(GetTile(ix, iy));
+      return tt.value[tt.Index(ix, iy)];
+    }
+
+    double GetMeta(ssize_t ix, ssize_t iy) const
+    {
+      tile const & tt(GetTile(ix, iy));
+      return tt.meta[tt.Index(ix, iy)];
+    }
+
+    bool IsGoal(ssize_t ix, ssize_t iy) const
+    {
+      tile const & tt(GetTile(ix, iy));
+      return GOAL_CELL == tt.kind[tt.Index(ix, iy)];
+    }
+
+    /** \return The neighbors (as bits of NeighborhoodT slots) that
+	the value of the cell was computed from, zero for goals and
+	cells that were not reached. */
+    mask_t GetUpwind(ssize_t ix, ssize_t iy) const
+    {
+      tile const & tt(GetTile(ix, iy));
+      return tt.upwind[tt.Index(ix, iy)];
+    }
+
+    /** \return The number of cell expansions done by the last
+	Compute(), summed over all threads. */
+    size_t GetNExpanded() const { return m_nexpanded; }
+
+    /** \return The number of synchronization rounds of the last
+	Compute(). */
+    size_t GetNRounds() const { return m_nrounds; }
+
+    /** Change the meta of a cell. Takes effect at the next
+	Compute(), which always starts from scratch. */
+    void SetMeta(ssize_t ix, ssize_t iy, double meta)
+    {
+      tile & tt(GetTile(ix, iy));
+      tt.meta[tt.Index(ix, iy)] = meta;
+    }
+
+    void AddGoal(ssize_t ix, ssize_t iy, double value)
+    {
+      tile & tt(GetTile(ix, iy));
+      size_t const cell(tt.Index(ix, iy));
+      tt.kind[cell] = GOAL_CELL;
+      tt.rhs[cell] = value;
+    }
+
+    void RemoveGoal(ssize_t ix, ssize_t iy)
+    {
+      tile & tt(GetTile(ix, iy));
+      size_t const cell(tt.Index(ix, iy));
+      tt.kind[cell] = NORMAL_CELL;
+      tt.rhs[cell] = infinity;
+    }
+
+    /**
+       Compute the navigation function from scratch.
+
+       \return The number of cell expansions, same as GetNExpanded().
+    */
+    size_t Compute(/** number of worker threads, one means that
+		       everything happens in the calling thread */
+		   size_t nthreads,
+		   /** see Algorithm::ComputeOne() */
+		   double slack,
+		   /** width of the band of keys expanded per round, zero
+		       means half a tile of freespace */
+		   double band = 0)
+    {
+      if (nthreads < 1)
+	nthreads = 1;
+      if (nthreads > m_tile.size())
+	nthreads = m_tile.size();
+      if (band <= 0)
+	band = m_tile_size * m_kernel.scale
+	  / KernelT::traits::freespace_meta() / 2;
+      for (size_t it(0); it < m_tile.size(); ++it)
+	ResetTile(*m_tile[it]);
+
+      // One pool job per worker, which then deals with every
+      // nthreads-th tile.
+      ThreadPool pool(nthreads);
+      round_s round(*this, nthreads, slack);
+      m_nrounds = 0;
+      for (;;) {
+	double lowest(infinity);
+	for (size_t it(0); it < m_tile.size(); ++it)
+	  if (( ! m_tile[it]->queue.IsEmpty())
+	      && (m_tile[it]->queue.GetTopKey() < lowest))
+	    lowest = m_tile[it]->queue.GetTopKey();
+	if (infinity == lowest)
+	  break;
+	++m_nrounds;
+	round.ceiling = lowest + band;
+	pool.Run(ExpandJob, &round, nthreads);
+	pool.Run(ExchangeJob, &round, nthreads);
+      }
+
+      m_nexpanded = 0;
+      for (size_t iw(0); iw < nthreads; ++iw)
+	m_nexpanded += round.nexpanded[iw];
+      return m_nexpanded;
+    }
+
+  private:
+    /** Kinds of cells in a tile. Halo cells never get updated by
+	their tile. */
+    enum { NORMAL_CELL, GOAL_CELL, HALO_CELL };
+
+    struct tile;
+    
+    /** A halo cell and where its value comes from. */
+    struct halo_s {
+      size_t cell;
+      tile const * owner;
+      size_t owner_cell;
+    };
+
+    struct tile {
+      tile(ssize_t _x0, ssize_t _y0, ssize_t _nx, ssize_t _ny)
+	: x0(_x0), y0(_y0), nx(_nx), ny(_ny), ystride(_ny + 2),
+	  value((_nx + 2) * (_ny + 2), infinity),
+	  rhs(value.size(), infinity),
+	  meta(value.size(), KernelT::traits::freespace_meta()),
+	  kind(value.size(), HALO_CELL),
+	  upwind(value.size(), 0)
+      {
+	for (ssize_t ix(0); ix < nx; ++ix)
+	  for (ssize_t iy(0); iy < ny; ++iy)
+	    kind[(ix + 1) * ystride + iy + 1] = NORMAL_CELL;
+      }
+
+      size_t Index(ssize_t ix, ssize_t iy) const
+      { return (ix - x0 + 1) * ystride + iy - y0 + 1; }
+
+      ssize_t const x0, y0, nx, ny, ystride;
+      std::vector<double> value;
+      std::vector<double> rhs;
+      std::vector<double> meta;
+      std::vector<unsigned char> kind;
+      std::vector<mask_t> upwind;
+      std::vector<halo_s> halo;
+      HeapQueueBackend<4> queue;
+    };
+
+    /** What the pool jobs of Compute() need to know. */
+    struct round_s {
+      round_s(TiledAlgorithm & _algo, size_t _nthreads, double _slack)
+	: algo(_algo), nthreads(_nthreads), slack(_slack), ceiling(0),
+	  nexpanded(_nthreads, 0) {}
+      TiledAlgorithm & algo;
+      size_t const nthreads;
+      double const slack;
+      /** expand keys below this in the current round */
+      double ceiling;
+      /** number of expansions of each worker */
+      std::vector<size_t> nexpanded;
+    };
+
+    tile & GetTile(ssize_t ix, ssize_t iy)
+    {
+      BOOST_ASSERT((ix >= 0) && (ix < m_xsize) && (iy >= 0) && (iy < m_ysize));
+      return *m_tile[(ix / m_tile_size) * m_nty + iy / m_tile_size];
+    }
+
+    tile const & GetTile(ssize_t ix, ssize_t iy) const
+    {
+      BOOST_ASSERT((ix >= 0) && (ix < m_xsize) && (iy >= 0) && (iy < m_ysize));
+      return *m_tile[(ix / m_tile_size) * m_nty + iy / m_tile_size];
+    }
+
+    /** Halo cells outside the grid stay at infinity forever. */
+    void InitHalo(tile & tt)
+    {
+      for (ssize_t lx(0); lx < tt.nx + 2; ++lx)
+	for (ssize_t ly(0); ly < tt.ny + 2; ++ly) {
+	  if ((lx > 0) && (lx <= tt.nx) && (ly > 0) && (ly <= tt.ny))
+	    continue;
+	  ssize_t const ix(tt.x0 + lx - 1);
+	  ssize_t const iy(tt.y0 + ly - 1);
+	  if ((ix < 0) || (ix >= m_xsize) || (iy < 0) || (iy >= m_ysize))
+	    continue;
+	  halo_s hh;
+	  hh.cell = lx * tt.ystride + ly;
+	  hh.owner = &GetTile(ix, iy);
+	  hh.owner_cell = hh.owner->Index(ix, iy);
+	  tt.halo.push_back(hh);
+	}
+    }
+
+    void ResetTile(tile & tt)
+    {
+      tt.queue.Clear();
+      for (size_t cell(0); cell < tt.value.size(); ++cell) {
+	tt.value[cell] = infinity;
+	tt.upwind[cell] = 0;
+	if (GOAL_CELL == tt.kind[cell])
+	  tt.queue.Insert(cell, tt.rhs[cell]);
+	else if (NORMAL_CELL == tt.kind[cell])
+	  tt.rhs[cell] = infinity;
+      }
+    }
+
+    /** Lower the rhs of a cell if its neighbors allow it. */
+    void UpdateCell(tile & tt, size_t cell) const
+    {
+      if (NORMAL_CELL != tt.kind[cell])
+	return;
+      CandidateList<NeighborhoodT> cand;
+      for (size_t slot(0); slot < NeighborhoodT::size; ++slot)
+	cand.Add(tt.value[cell + Offset(tt, slot)], slot);
+      double const rhs(cand.Compute(m_kernel, tt.meta[cell]));
+      if (rhs >= tt.rhs[cell])
+	return;
+      tt.rhs[cell] = rhs;
+      tt.upwind[cell] = cand.template GetUpwindMask<mask_t>();
+      if (rhs >= tt.value[cell])
+	return;
+      double oldkey;
+      if (tt.queue.Find(cell, oldkey))
+	tt.queue.Update(cell, rhs);
+      else
+	tt.queue.Insert(cell, rhs);
+    }
+
+    static ssize_t Offset(tile const & tt, size_t slot)
+    {
+      return NeighborhoodT::dx(slot) * tt.ystride + NeighborhoodT::dy(slot);
+    }
+
+    /** Expand the cells of a tile whose key does not exceed the
+	bound. \return The number of expansions. */
+    size_t Expand(tile & tt, double bound, double slack) const
+    {
+      size_t nexpanded(0);
+      while (( ! tt.queue.IsEmpty()) && (tt.queue.GetTopKey() <= bound)) {
+	size_t const cell(tt.queue.PopTop());
+	double const rhs(tt.rhs[cell]);
+	if (tt.value[cell] - rhs <= slack)
+	  continue;
+	++nexpanded;
+	tt.value[cell] = rhs;
+	for (size_t slot(0); slot < NeighborhoodT::size; ++slot)
+	  UpdateCell(tt, cell + Offset(tt, slot));
+      }
+      return nexpanded;
+    }
+
+    /** Pull the neighbors' border values into the halo. */
+    void Exchange(tile & tt) const
+    {
+      for (size_t ih(0); ih < tt.halo.size(); ++ih) {
+	halo_s const & hh(tt.halo[ih]);
+	double const value(hh.owner->value[hh.owner_cell]);
+	if (value >= tt.value[hh.cell])
+	  continue;
+	tt.value[hh.cell] = value;
+	for (size_t slot(0); slot < NeighborhoodT::size; ++slot) {
+	  ssize_t const nbor(hh.cell + Offset(tt, slot));
+	  if ((nbor >= 0) && (nbor < static_cast<ssize_t>(tt.value.size())))
+	    UpdateCell(tt, nbor);
+	}
+      }
+    }
+
+    static void ExpandJob(void * arg, size_t first, size_t last)
+    {
+      round_s & rr(*reinterpret_cast<round_s*>(arg));
+      std::vector<tile*> const & tiles(rr.algo.m_tile);
+      for (size_t iw(first); iw < last; ++iw)
+	for (size_t it(iw); it < tiles.size(); it += rr.nthreads)
+	  rr.nexpanded[iw] += rr.algo.Expand(*tiles[it], rr.ceiling, rr.slack);
+    }
+
+    static void ExchangeJob(void * arg, size_t first, size_t last)
+    {
+      round_s & rr(*reinterpret_cast<round_s*>(arg));
+      std::vector<tile*> const & tiles(rr.algo.m_tile);
+      for (size_t iw(first); iw < last; ++iw)
+	for (size_t it(iw); it < tiles.size(); it += rr.nthreads)
+	  rr.algo.Exchange(*tiles[it]);
+    }
+
+    KernelT const m_kernel;
+    ssize_t const m_xsize;
+    ssize_t const m_ysize;
+    ssize_t const m_tile_size;
+    ssize_t const m_ntx;
+    ssize_t const m_nty;
+    std::vector<tile*> m_tile;
+    size_t m_nexpanded;
+    size_t m_nrounds;
+  };
+
+} // namespace estar
+
+#endif // ESTAR_TILED_ALGORITHM_HPP
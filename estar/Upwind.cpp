@@ -21,18 +21,96 @@
 #include "Upwind.hpp"
 #include "util.hpp"
 #include "pdebug.hpp"
+#include <stdexcept>
+#include <algorithm>
 
 
 namespace estar {
   
   
+  /** Reads a mask that another thread might be writing to. */
+  static inline Upwind::mask_t load_mask(Upwind::mask_t const & mask)
+  {
+    return __atomic_load_n(&mask, __ATOMIC_RELAXED);
+  }
+  
+  
+  /** Writes a mask that other threads might be reading. There is
+      only one writer, see Upwind, so this does not need to be a
+      single read-modify-write operation. */
+  static inline void store_mask(Upwind::mask_t & mask, Upwind::mask_t value)
+  {
+    __atomic_store_n(&mask, value, __ATOMIC_RELAXED);
+  }
+  
+  
+  Upwind::downwind_it::
+  downwind_it(adjacency_it nbor, mask_t mask)
+    : m_nbor(nbor),
+      m_mask(mask)
+  {
+    Skip();
+  }
+  
+  
+  void Upwind::downwind_it::
+  Skip()
+  {
+    // Bits are only ever set for existing neighbors, so this does
+    // not run past the end of the adjacency list.
+    if (0 != m_mask)
+      while ( ! (m_mask & (mask_t(1) << m_nbor.GetSlot())))
+	++m_nbor;
+  }
+  
+  
+  Upwind::downwind_it & Upwind::downwind_it::
+  operator ++ ()
+  {
+    m_mask &= ~(mask_t(1) << m_nbor.GetSlot());
+    if (0 != m_mask) {
+      ++m_nbor;
+      Skip();
+    }
+    return *this;
+  }
+  
+  
+  Upwind::
+  Upwind(cspace_t const & cspace)
+    : m_cspace(cspace),
+      m_edges(num_vertices(cspace))
+  {
+  }
+  
+  
+  size_t Upwind::
+  Slot(vertex_t vertex, vertex_t nbor) const
+  {
+    adjacency_it in, nend;
+    boost::tie(in, nend) = adjacent_vertices(vertex, m_cspace);
+    for (/**/; in != nend; ++in)
+      if (*in == nbor)
+	break;
+    if ((in == nend) || (in.GetSlot() >= nslots))
+      return nslots;
+    return in.GetSlot();
+  }
+  
+  
   bool Upwind::
   HaveEdge(vertex_t from, vertex_t to) const
   {
-    const set_t & fs(m_from_to[from]);
-    PVDEBUG("from: %lu to: %lu %s\n", from, to,
-	    ( ! fs.empty()) && (fs.find(to) != fs.end()) ? "TRUE" : "FALSE");
-    return ( ! fs.empty()) && (fs.find(to) != fs.end());
+    mask_t const downwind(from < m_edges.size()
+			  ? load_mask(m_edges[from].downwind) : 0);
+    if (0 == downwind) {
+      PVDEBUG("from: %lu to: %lu FALSE\n", from, to);
+      return false;
+    }
+    size_t const slot(Slot(from, to));
+    bool const result((slot < nslots) && (downwind & (mask_t(1) << slot)));
+    PVDEBUG("from: %lu to: %lu %s\n", from, to, result ? "TRUE" : "FALSE");
+    return result;
   }
   
   
@@ -45,8 +123,16 @@ namespace estar {
       PVDEBUG("from: %lu to: %lu REPLACE opposite edge\n", from, to);
       RemoveEdge(to, from);
     }
-    m_from_to[from].insert(to);
-    m_to_from[to].insert(from);
+    size_t const down(Slot(from, to));
+    size_t const up(Slot(to, from));
+    if ((down >= nslots) || (up >= nslots))
+      throw std::out_of_range("estar::Upwind::AddEdge() invalid neighbor");
+    if (m_edges.size() <= std::max(from, to))
+      m_edges.resize(num_vertices(m_cspace));
+    store_mask(m_edges[from].downwind,
+	       load_mask(m_edges[from].downwind) | (mask_t(1) << down));
+    store_mask(m_edges[to].upwind,
+	       load_mask(m_edges[to].upwind) | (mask_t(1) << up));
   }
   
   
@@ -54,40 +140,65 @@ namespace estar {
   RemoveEdge(vertex_t from, vertex_t to)
   {
     PVDEBUG("from: %lu to: %lu\n", from, to);
-    m_from_to[from].erase(to);
-    m_to_from[to].erase(from);
+    if ((from >= m_edges.size()) || (to >= m_edges.size()))
+      return;
+    size_t const down(Slot(from, to));
+    if (down < nslots)
+      store_mask(m_edges[from].downwind,
+		 load_mask(m_edges[from].downwind) & ~(mask_t(1) << down));
+    size_t const up(Slot(to, from));
+    if (up < nslots)
+      store_mask(m_edges[to].upwind,
+		 load_mask(m_edges[to].upwind) & ~(mask_t(1) << up));
+  }
+  
+  
+  void Upwind::
+  Renumber(std::vector<vertex_t> const & newid)
+  {
+    if (m_edges.size() < newid.size())
+      m_edges.resize(newid.size());
+    renumber_vertices(m_edges, newid);
   }
   
   
   void Upwind::
   RemoveIncoming(vertex_t to)
   {
-    set_t & ts(m_to_from[to]);
-    if(ts.empty()){
+    mask_t upwind(to < m_edges.size() ? load_mask(m_edges[to].upwind) : 0);
+    if (0 == upwind) {
       PVDEBUG("to: %lu EMPTY\n", to);
       return;
     }
     debugos dbg;
-    // bugfix from Filip: calling RemoveEdge() directly can invalidate
-    // the iterator, so first store them in a temporary area
-    std::vector<vertex_t> vertices_to_delete(8); // allocate 'probably enough'
-    for(set_t::iterator ifrom(ts.begin()); ifrom != ts.end(); ++ifrom){
-      dbg << " " << *ifrom;
-      vertices_to_delete.push_back(*ifrom);
-    }
-    for(std::vector<vertex_t>::iterator it(vertices_to_delete.begin());
-	it != vertices_to_delete.end();
-	++it){
-      RemoveEdge(*it, to);
+    adjacency_it in, nend;
+    boost::tie(in, nend) = adjacent_vertices(to, m_cspace);
+    for (/**/; (0 != upwind) && (in != nend); ++in) {
+      size_t const up(in.GetSlot());
+      if ((up >= nslots) || ! (upwind & (mask_t(1) << up)))
+	continue;
+      upwind &= ~(mask_t(1) << up);
+      dbg << " " << *in;
+      size_t const down(Slot(*in, to));
+      if (down < nslots)
+	store_mask(m_edges[*in].downwind,
+		   load_mask(m_edges[*in].downwind) & ~(mask_t(1) << down));
     }
+    store_mask(m_edges[to].upwind, 0);
     PVDEBUG("to: %lu from:%s\n", to, dbg.str().c_str());
   }
   
   
-  const Upwind::set_t & Upwind::
+  std::pair<Upwind::downwind_it, Upwind::downwind_it> Upwind::
   GetDownwind(vertex_t from) const
   {
-    return m_from_to[from];
+    mask_t const downwind(from < m_edges.size()
+			  ? load_mask(m_edges[from].downwind) : 0);
+    if (0 == downwind)
+      return std::make_pair(downwind_it(), downwind_it());
+    return std::make_pair(downwind_it(adjacent_vertices(from, m_cspace).first,
+				      downwind),
+			  downwind_it());
   }
   
 } // namespace estar
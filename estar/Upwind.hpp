@@ -23,38 +23,106 @@
 
 
 #include <estar/base.hpp>
-#include <set>
-#include <map>
+#include <vector>
 
 
 namespace estar {
   
   
-  /** Upwind graph for tracing propagation order. */
+  /**
+     Upwind graph for tracing propagation order. Upwind edges always
+     connect C-space neighbors, so instead of storing sets of vertices
+     we keep two bitmasks per vertex, indexed by the slot of the
+     neighbor in the C-space graph (see CSpaceGraph): one for the
+     outgoing (downwind) and one for the incoming (upwind) edges. This
+     costs 2*sizeof(mask_t) bytes per vertex and does not allocate
+     once the masks cover all vertices.
+     
+     The const methods never modify the Upwind, so other threads
+     (e.g. for visualization) can query it while Algorithm
+     propagates, without locking. The masks are loaded and stored
+     with the __atomic builtins of GCC, and each lookup loads one
+     mask per vertex exactly once, so a reader sees either the old
+     or the new edges of a vertex that is being updated. This only
+     holds for a single modifying thread: the non-const methods
+     read, modify, and write back a mask in separate steps. The
+     masks are sized to the C-space graph on construction.
+     AddEdge() only grows them if vertices were added to the graph
+     since then, which requires external locking anyway because it
+     also restructures the graph, and so does Renumber().
+     
+     \note Neighbors beyond slot nslots are not supported. Slots are
+     stable as long as explicit edges are only ever appended, which
+     is what BaseCSpace::AddNeighbor() does, and grid slots never
+     change.
+  */
   class Upwind {
   public:
-    typedef std::set<vertex_t> set_t;
-    typedef std::map<vertex_t, set_t > map_t;
-
+    typedef unsigned int mask_t;
+    static size_t const nslots = 8 * sizeof(mask_t);
+    
+    /**
+       Iterates over the downwind neighbors of a vertex, in adjacency
+       list order. It works on a copy of the edge bits, so it remains
+       valid while edges are added or removed, as long as the
+       C-space graph itself does not change.
+    */
+    class downwind_it {
+    public:
+      downwind_it(): m_mask(0) {}
+      downwind_it(adjacency_it nbor, mask_t mask);
+      
+      vertex_t operator * () const { return *m_nbor; }
+      downwind_it & operator ++ ();
+      
+      bool operator == (downwind_it const & rhs) const
+      { return (m_mask == rhs.m_mask)
+	  && ((0 == m_mask) || (m_nbor == rhs.m_nbor)); }
+      
+      bool operator != (downwind_it const & rhs) const
+      { return ! (*this == rhs); }
+      
+    private:
+      /** advance m_nbor to the slot of the lowest remaining bit */
+      void Skip();
+      
+      adjacency_it m_nbor;
+      mask_t m_mask;
+    };
+    
+    explicit Upwind(cspace_t const & cspace);
+    
     bool HaveEdge(vertex_t from, vertex_t to) const;
+    
+    /** \note Throws std::out_of_range if the two vertices are not
+	neighbors, or if one of them lies beyond slot nslots in the
+	adjacency list of the other. */
     void AddEdge(vertex_t from, vertex_t to);
-
-    /** \note Beware when feeding vertices from iterators to this
-	function, as it modifies the underlying tree structures this
-	can wreak havoc. Use a temporary structure to collect the
-	vertices to be removed, then loop over the temporary data.
-    */
-    void RemoveEdge(vertex_t from, vertex_t to);
     
-    /** see also RemoveEdge() */
+    void RemoveEdge(vertex_t from, vertex_t to);
     void RemoveIncoming(vertex_t to);
     
-    const map_t & GetMap() const { return m_from_to; }
-    const set_t & GetDownwind(vertex_t from) const;
+    /** Move the edges of each vertex v to newid[v]. The edges are
+	stored per neighbor slot, which renumbering does not change,
+	see CSpaceGraph::Renumber(). */
+    void Renumber(std::vector<vertex_t> const & newid);
+    
+    std::pair<downwind_it, downwind_it> GetDownwind(vertex_t from) const;
     
   private:
-    mutable map_t m_from_to;
-    mutable map_t m_to_from;
+    struct edges_t {
+      edges_t(): downwind(0), upwind(0) {}
+      mask_t downwind;
+      mask_t upwind;
+    };
+    
+    /** \return The slot of nbor among the neighbors of vertex, or
+	nslots if it is not a neighbor or lies beyond the first nslots
+	slots. */
+    size_t Slot(vertex_t vertex, vertex_t nbor) const;
+    
+    cspace_t const & m_cspace;
+    std::vector<edges_t> m_edges;
   };
   
 } // namespace estar
@@ -23,7 +23,10 @@
 
 
 #include <estar/numeric.hpp>
-#include <boost/graph/adjacency_list.hpp>
+#include <estar/CSpaceGraph.hpp>
+#include <boost/property_map/property_map.hpp>
+#include <boost/tuple/tuple.hpp>
+#include <vector>
 
 
 namespace estar {
@@ -59,83 +62,168 @@ namespace estar {
   
   
   //////////////////////////////////////////////////
-  // cspace traits
+  // cspace graph and supplementary traits
+  
+  /** Type describing the C-space graph. */
+  typedef CSpaceGraph cspace_t;
   
-  /** C-space graph out-edge list type selector. */
-  typedef boost::vecS cspace_OutEdgeListS;
-
-  /** C-space graph vertex list type selector. */
-  typedef boost::vecS cspace_VertexListS;
-
-  /** C-space graph edge directedness selector. */
-  typedef boost::undirectedS cspace_DirectedS;
-
-  /** Traits class of C-space graph. */
-  typedef boost::adjacency_list_traits<cspace_OutEdgeListS,
-				       cspace_VertexListS,
-				       cspace_DirectedS> cspace_traits;
-
   /** Vertex (node) descriptor of C-space graph. */
-  typedef cspace_traits::vertex_descriptor vertex_t;
+  typedef cspace_t::vertex_descriptor vertex_t;
   
+  /** Iterator over neighboring nodes. */
+  typedef cspace_t::adjacency_iterator adjacency_it;
   
-  //////////////////////////////////////////////////
-  // vertex properties
+  /** Iterator over C-space nodes. */
+  typedef cspace_t::vertex_iterator    vertex_it;
   
-  /** Value property tag attached to C-space nodes. */
-  struct value_p    { typedef boost::vertex_property_tag kind; };
   
-  /** Meta property tag attached to C-space nodes. */
-  struct meta_p     { typedef boost::vertex_property_tag kind; };
+  /**
+     Move each element of a per-vertex array to its new index, as
+     given by newid[vertex], see CSpaceGraph::Renumber(). Elements
+     beyond the end of newid stay where they are.
+  */
+  template<typename value_t>
+  void renumber_vertices(std::vector<value_t> & data,
+			 std::vector<vertex_t> const & newid)
+  {
+    std::vector<value_t> old(data);
+    for (size_t ii(0); (ii < newid.size()) && (ii < old.size()); ++ii)
+      data[newid[ii]] = old[ii];
+  }
   
-  /** "Right-hand-side" property tag attached to C-space nodes. */
-  struct rhs_p      { typedef boost::vertex_property_tag kind; };
   
-  /** Flag property tag attached to C-space nodes. */
-  struct flag_p     { typedef boost::vertex_property_tag kind; };
+  //////////////////////////////////////////////////
+  // vertex properties
   
+  /**
+     Lvalue property map over one of the per-vertex property arrays
+     of BaseCSpace. Each property lives in its own contiguous array
+     indexed by vertex_t, so loops over a single property (e.g. all
+     the values) touch no unrelated data. The map only holds a
+     pointer to the array, so it is cheap to copy and remains valid
+     when vertices are added.
+  */
+  template<typename value_t>
+  class cspace_property_map
+    : public boost::put_get_helper<value_t &, cspace_property_map<value_t> >
+  {
+  public:
+    typedef vertex_t key_type;
+    typedef value_t value_type;
+    typedef value_t & reference;
+    typedef boost::lvalue_property_map_tag category;
+    typedef std::vector<value_t> storage_t;
+    
+    cspace_property_map(): m_storage(0) {}
+    
+    explicit cspace_property_map(storage_t * storage)
+      : m_storage(storage) {}
+    
+    reference operator [] (key_type vertex) const
+    { return (*m_storage)[vertex]; }
+    
+  private:
+    storage_t * m_storage;
+  };
+  
+  
+  /** Epoch counter type, see cspace_epoch_state. */
+  typedef unsigned int cspace_epoch_t;
   
-  //////////////////////////////////////////////////
-  // cspace graph and supplementary traits
   
-  /** Properties attached to a C-space node. */
-  typedef boost::property<value_p, double,
-          boost::property<meta_p, double,
-	  boost::property<rhs_p, double,
-	  boost::property<flag_p, flag_t
-          > > > > cspace_vertex_property;
+  /**
+     Bookkeeping for resetting the value, rhs, and flag properties of
+     all vertices in O(1). Each vertex carries the epoch in which it
+     was last written. A vertex whose stamp differs from the current
+     epoch is "stale" and reads as value=rhs=infinity and flag=NONE.
+     Writing any of the three properties of a stale vertex first
+     brings all three to these defaults and stamps the vertex with the
+     current epoch. BaseCSpace::NewEpoch() thus resets the whole
+     C-space without touching a single vertex.
+  */
+  struct cspace_epoch_state
+  {
+    cspace_epoch_state(): current(1), value(0), rhs(0), flag(0) {}
+    
+    bool IsCurrent(vertex_t vertex) const
+    { return current == stamp[vertex]; }
+    
+    void Refresh(vertex_t vertex) {
+      if (current == stamp[vertex])
+	return;
+      (*value)[vertex] = infinity;
+      (*rhs)[vertex] = infinity;
+      (*flag)[vertex] = NONE;
+      stamp[vertex] = current;
+    }
+    
+    std::vector<cspace_epoch_t> stamp;
+    cspace_epoch_t current;
+    std::vector<cspace_real_t> * value;
+    std::vector<cspace_real_t> * rhs;
+    std::vector<flag_t> * flag;
+  };
   
-  /** Type describing the C-space graph. */
-  typedef boost::adjacency_list<cspace_OutEdgeListS,
-				cspace_VertexListS,
-				cspace_DirectedS,
-				cspace_vertex_property> cspace_t;
-
-  /** Iterator over neighboring nodes. */
-  typedef boost::graph_traits<cspace_t>::adjacency_iterator adjacency_it;
   
-  /** Iterator over C-space nodes. */
-  typedef boost::graph_traits<cspace_t>::vertex_iterator    vertex_it;
+  /**
+     Read/write property map over one of the epoch-stamped property
+     arrays of BaseCSpace (value, rhs, or flag). Stale vertices read
+     as the default value given at construction, see
+     cspace_epoch_state. As the stored value might not be the one
+     that get() returns, this is not an lvalue property map.
+  */
+  template<typename value_t>
+  class cspace_epoch_map
+  {
+  public:
+    typedef vertex_t key_type;
+    typedef value_t value_type;
+    typedef value_t reference;
+    typedef boost::read_write_property_map_tag category;
+    typedef std::vector<value_t> storage_t;
+    
+    cspace_epoch_map(): m_storage(0), m_state(0), m_default() {}
+    
+    cspace_epoch_map(storage_t * storage, cspace_epoch_state * state,
+		     value_t default_value)
+      : m_storage(storage), m_state(state), m_default(default_value) {}
+    
+    friend value_t get(cspace_epoch_map const & map, vertex_t vertex) {
+      if (map.m_state->IsCurrent(vertex))
+	return (*map.m_storage)[vertex];
+      return map.m_default;
+    }
+    
+    friend void put(cspace_epoch_map const & map, vertex_t vertex,
+		    value_t value) {
+      map.m_state->Refresh(vertex);
+      (*map.m_storage)[vertex] = value;
+    }
+    
+  private:
+    storage_t * m_storage;
+    cspace_epoch_state * m_state;
+    value_t m_default;
+  };
   
   
   //////////////////////////////////////////////////
   // property map types
   
   /** Node ID map, for adding custom node properties. */
-  typedef
-  boost::property_map<cspace_t, boost::vertex_index_t>::type vertexid_map_t;
+  typedef boost::typed_identity_property_map<vertex_t> vertexid_map_t;
   
   /** Value property map. */
-  typedef boost::property_map<cspace_t, value_p>::type    value_map_t;
+  typedef cspace_epoch_map<cspace_real_t> value_map_t;
 
   /** Meta information property map. */
-  typedef boost::property_map<cspace_t, meta_p>::type     meta_map_t;
+  typedef cspace_property_map<cspace_real_t> meta_map_t;
 
   /** "Right-hand-side" property map. */
-  typedef boost::property_map<cspace_t, rhs_p>::type      rhs_map_t;
+  typedef cspace_epoch_map<cspace_real_t> rhs_map_t;
 
   /** Flag property map. */
-  typedef boost::property_map<cspace_t, flag_p>::type     flag_map_t;
+  typedef cspace_epoch_map<flag_t> flag_map_t;
   
 } // namespace estar
 
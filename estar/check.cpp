@@ -103,7 +103,8 @@ namespace estar {
     for (vertex_read_iteration iv(base_cspace.begin());
 	 iv.not_at_end(); ++iv) {
       if ((base_cspace.GetFlag(*iv) & OPEN)
-	  && (queued_vs.find(*iv) == queued_vs.end())) {
+	  && (queued_vs.find(*iv) == queued_vs.end())
+	  && ( ! algo.GetQueue().IsParked(*iv))) {
  	result = false;
  	err << prefix << "  " << flag_name(base_cspace.GetFlag(*iv))
  	    << " not in queue i: ";
@@ -133,10 +134,9 @@ namespace estar {
     for(tie(vi, vend) = vertices(cspace); vi != vend; ++vi){
       typedef map<vertex_t, size_t> nbcount_t;
       nbcount_t nbcount;
-      typedef graph_traits<cspace_t>::out_edge_iterator eit_t;
-      eit_t ei, eend;
-      for(tie(ei, eend) = out_edges(*vi, cspace); ei != eend; ++ei){
-	vertex_t nbv(target(*ei, cspace));
+      adjacency_it ei, eend;
+      for(tie(ei, eend) = adjacent_vertices(*vi, cspace); ei != eend; ++ei){
+	vertex_t nbv(*ei);
 	nbcount_t::iterator nbci(nbcount.find(nbv));
 	if(nbcount.find(nbv) != nbcount.end())
 	  ++(nbci->second);
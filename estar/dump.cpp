@@ -466,9 +466,8 @@ namespace estar {
 	iv.not_at_end(); ++iv) {
       if (gcspace)
 	gfrom = gcspace->Lookup(*iv);
-      Upwind::set_t const & downwind(upwind.GetDownwind(*iv));
-      for(Upwind::set_t::const_iterator id(downwind.begin());
-	  id != downwind.end(); ++id){
+      Upwind::downwind_it id, dend;
+      for(tie(id, dend) = upwind.GetDownwind(*iv); id != dend; ++id){
 	fprintf(stream, "  (%zu, %zu)", *iv, *id);
 	if (gcspace && gfrom) {
 	  shared_ptr<GridNode const> gto(gcspace->Lookup(*id));
@@ -481,4 +480,45 @@ namespace estar {
     }
   }
   
+  
+  void dump_tiles(const Grid & grid, FILE * stream)
+  {
+    ssize_t const tsize(grid.GetTileSize());
+    if (0 == tsize) {
+      fprintf(stream, "not a tiled grid\n");
+      return;
+    }
+    GridCSpace const & cspace(*grid.GetCSpace());
+    ssize_t const ntx((grid.GetXEnd() - grid.GetXBegin() + tsize - 1) / tsize);
+    ssize_t const nty((grid.GetYEnd() - grid.GetYBegin() + tsize - 1) / tsize);
+    fprintf(stream, "%zu of %zd tiles of %zdx%zd cells, %zu vertices\n",
+	    cspace.GetNTiles(), ntx * nty, tsize, tsize,
+	    num_vertices(cspace.GetGraph()));
+    for (ssize_t ty(nty - 1); ty >= 0; --ty) {
+      ssize_t const y0(grid.GetYBegin() + ty * tsize);
+      ssize_t const y1(minval(y0 + tsize, grid.GetYEnd()));
+      for (ssize_t tx(0); tx < ntx; ++tx) {
+	ssize_t const x0(grid.GetXBegin() + tx * tsize);
+	ssize_t const x1(minval(x0 + tsize, grid.GetXEnd()));
+	if ( ! cspace.HaveTile(x0, y0)) {
+	  fputc('.', stream);
+	  continue;
+	}
+	vertex_t const first(cspace.FindVertex(x0, y0));
+	size_t nfinite(0);
+	for (ssize_t ix(x0); ix < x1; ++ix)
+	  for (ssize_t iy(y0); iy < y1; ++iy)
+	    if (cspace.GetValue(first + (ix - x0) * tsize + iy - y0)
+		< infinity)
+	      ++nfinite;
+	size_t const ncells((x1 - x0) * (y1 - y0));
+	if (nfinite == ncells)
+	  fputc('#', stream);
+	else
+	  fputc('0' + static_cast<int>((10 * nfinite) / ncells), stream);
+      }
+      fputc('\n', stream);
+    }
+  }
+  
 }
@@ -118,6 +118,16 @@ namespace estar {
 
   void dump_upwind(const Algorithm & algo, const Grid * grid,
 		   FILE * stream);
+  
+  /**
+     Write a map of the tiles of a tiled Grid (see Grid::InitTiled()),
+     one character per tile with the highest Y on top: '.' for tiles
+     that have not been created, '#' if all cells of the tile have a
+     finite value, otherwise the number of tenths of its cells that
+     do. Preceded by a line with the number of created tiles and
+     vertices.
+  */
+  void dump_tiles(const Grid & grid, FILE * stream);
     
 }
 
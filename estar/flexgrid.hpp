@@ -1,16 +1,16 @@
-/* 
+/*
  * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
- * 
+ *
  * This program is free software; you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
  * the Free Software Foundation; either version 2 of the License, or
  * (at your option) any later version.
- * 
+ *
  * This program is distributed in the hope that it will be useful,
  * but WITHOUT ANY WARRANTY; without even the implied warranty of
  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
  * GNU General Public License for more details.
- * 
+ *
  * You should have received a copy of the GNU General Public License
  * along with this program; if not, write to the Free Software
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
@@ -18,24 +18,45 @@
  */
 
 
+
 #ifndef ESTAR_FLEXGRID_HPP
 #define ESTAR_FLEXGRID_HPP
 
 
-#include <estar/sdeque.hpp>
 #include <estar/flexgrid_traits.hpp>
 #include <estar/flexgrid_iterator.hpp>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
 
 
 namespace estar {
   
   
+  /**
+     A two-dimensional array whose index ranges can grow (and shrink)
+     on all four sides. The cells live in a single contiguous buffer,
+     stored line by line (Y-major), which has some spare room around
+     the valid range. Growing within that room simply fills the newly
+     exposed cells. Growing beyond it reallocates the buffer, and adds
+     spare room proportional to the new size on each side that
+     overflowed, so that growing one cell at a time (as smart_at()
+     does) has amortized constant cost.
+     
+     at() is bounds checked and throws std::out_of_range, get() is
+     not and should be used in tight loops over ranges that are known
+     to be valid. References, pointers, iterators, and lines are
+     invalidated when the buffer gets reallocated.
+     
+     \note Uses std::vector for storage, so value_t must not be bool.
+  */
   template<typename value_t>
   class flexgrid
   {
   public:
     typedef flexgrid_traits<value_t>             traits;
     typedef typename traits::line_t              line_t;
+    typedef typename traits::const_line_t        const_line_t;
     typedef typename traits::cell_iterator       cell_iterator;
     typedef typename traits::const_cell_iterator const_cell_iterator;
     typedef typename traits::grid_t              grid_t;
@@ -44,190 +65,261 @@ namespace estar {
     typedef flexgrid_iterator<value_t>           iterator;
     typedef const_flexgrid_iterator<value_t>     const_iterator;
     
-    value_t & at(ssize_t ix, ssize_t iy) { return m_grid.at(iy).at(ix); }
+    flexgrid()
+      : m_xbegin(0), m_xend(0), m_ybegin(0), m_yend(0),
+	m_bx0(0), m_by0(0), m_bxsize(0), m_bysize(0), m_origin(0) {}
+    
+    value_t & at(ssize_t ix, ssize_t iy) {
+      if ( ! valid(ix, iy))
+	throw std::out_of_range("estar::flexgrid::at() range error");
+      return get(ix, iy);
+    }
+    
+    value_t const & at(ssize_t ix, ssize_t iy) const {
+      if ( ! valid(ix, iy))
+	throw std::out_of_range("estar::flexgrid::at() range error");
+      return get(ix, iy);
+    }
+    
+    /** Unchecked version of at(). */
+    value_t & get(ssize_t ix, ssize_t iy)
+    { return m_buffer[iy * m_bxsize + ix + m_origin]; }
     
-    value_t const & at(ssize_t ix, ssize_t iy) const
-    { return m_grid.at(iy).at(ix); }
+    /** Unchecked version of at(). */
+    value_t const & get(ssize_t ix, ssize_t iy) const
+    { return m_buffer[iy * m_bxsize + ix + m_origin]; }
     
     void resize_xbegin(ssize_t xbegin, value_t const & value) {
-      for (line_iterator ii(m_grid.begin()); ii != m_grid.end(); ++ii)
-	ii->resize_begin(xbegin, value);
-      m_default.resize_begin(xbegin);
+      if (xbegin > m_xend)
+	throw std::out_of_range("estar::flexgrid::resize_xbegin() range error");
+      reshape(xbegin, m_xend, m_ybegin, m_yend, value);
     }
     
     void resize_xbegin(ssize_t xbegin) { resize_xbegin(xbegin, value_t()); }
     
     void resize_xend(ssize_t xend, value_t const & value) {
-      for (line_iterator ii(m_grid.begin()); ii != m_grid.end(); ++ii)
-	ii->resize_end(xend, value);
-      m_default.resize_end(xend);
+      if (xend < m_xbegin)
+	throw std::out_of_range("estar::flexgrid::resize_xend() range error");
+      reshape(m_xbegin, xend, m_ybegin, m_yend, value);
     }
     
     void resize_xend(ssize_t xend) { resize_xend(xend, value_t()); }
     
     void resize_x(ssize_t xbegin, ssize_t xend, value_t const & value) {
-      if (xbegin < m_default.ibegin())
-	resize_xbegin(xbegin, value);
-      if (xend > m_default.iend())
-	resize_xend(xend, value);
+      reshape(std::min(xbegin, m_xbegin), std::max(xend, m_xend),
+	      m_ybegin, m_yend, value);
     }
     
-    void resize_x(ssize_t xbegin, ssize_t xend) {
-      if (xbegin < m_default.ibegin())
-	resize_xbegin(xbegin);
-      if (xend > m_default.iend())
-	resize_xend(xend);
-    }
+    void resize_x(ssize_t xbegin, ssize_t xend)
+    { resize_x(xbegin, xend, value_t()); }
     
-    /** \note Lots of copying if you're growing the range. Prefer the
-	version with implicit default value, it's gonna be faster. */
     void resize_ybegin(ssize_t ybegin, value_t const & value) {
-      if (ybegin > m_grid.ibegin()) // shrink
-	m_grid.resize_begin(ybegin, m_default);
-      else if (ybegin < m_grid.ibegin()) { // grow
-	line_t vline(m_default);
-	fill(vline.begin(), vline.end(), value);
-	m_grid.resize_begin(ybegin, vline);
-      }
-      // else do nothing
+      if (ybegin > m_yend)
+	throw std::out_of_range("estar::flexgrid::resize_ybegin() range error");
+      reshape(m_xbegin, m_xend, ybegin, m_yend, value);
     }
     
-    void resize_ybegin(ssize_t ybegin)
-    { m_grid.resize_begin(ybegin, m_default); }
+    void resize_ybegin(ssize_t ybegin) { resize_ybegin(ybegin, value_t()); }
     
-    /** \note Lots of copying if you're growing the range. Prefer the
-	version with implicit default value, it's gonna be faster. */
     void resize_yend(ssize_t yend, value_t const & value) {
-      if (yend < m_grid.iend()) // shrink
-	m_grid.resize_end(yend, m_default);
-      else if (yend > m_grid.iend()) { // grow
-	line_t vline(m_default);
-	fill(vline.begin(), vline.end(), value);
-	m_grid.resize_end(yend, vline);
-      }
-      // else do nothing
+      if (yend < m_ybegin)
+	throw std::out_of_range("estar::flexgrid::resize_yend() range error");
+      reshape(m_xbegin, m_xend, m_ybegin, yend, value);
     }
     
-    void resize_yend(ssize_t yend)
-    { m_grid.resize_end(yend, m_default); }
+    void resize_yend(ssize_t yend) { resize_yend(yend, value_t()); }
     
     void resize_y(ssize_t ybegin, ssize_t yend, value_t const & value) {
-      if (ybegin < m_grid.ibegin())
-	resize_ybegin(ybegin, value);
-      if (yend > m_grid.iend())
-	resize_yend(yend, value);
+      reshape(m_xbegin, m_xend,
+	      std::min(ybegin, m_ybegin), std::max(yend, m_yend), value);
     }
     
-    void resize_y(ssize_t ybegin, ssize_t yend) {
-      if (ybegin < m_grid.ibegin())
-	resize_ybegin(ybegin);
-      if (yend > m_grid.iend())
-	resize_yend(yend);
-    }
+    void resize_y(ssize_t ybegin, ssize_t yend)
+    { resize_y(ybegin, yend, value_t()); }
     
     /** \note Beware of parameter ordering, it is NOT like the
 	coordinates of a bounding box. */
     void resize(ssize_t xbegin, ssize_t xend,
 		ssize_t ybegin, ssize_t yend,
 		value_t const & value) {
-      if (xbegin < m_default.ibegin())
-	resize_xbegin(xbegin, value);
-      if (xend > m_default.iend())
-	resize_xend(xend, value);
-      if (ybegin < m_grid.ibegin())
-	resize_ybegin(ybegin, value);
-      if (yend > m_grid.iend())
-	resize_yend(yend, value);
+      reshape(std::min(xbegin, m_xbegin), std::max(xend, m_xend),
+	      std::min(ybegin, m_ybegin), std::max(yend, m_yend), value);
     }
     
     /** \note Beware of parameter ordering, it is NOT like the
 	coordinates of a boudning box. */
     void resize(ssize_t xbegin, ssize_t xend,
-		ssize_t ybegin, ssize_t yend) {
-      if (xbegin < m_default.ibegin())
-	resize_xbegin(xbegin);
-      if (xend > m_default.iend())
-	resize_xend(xend);
-      if (ybegin < m_grid.ibegin())
-	resize_ybegin(ybegin);
-      if (yend > m_grid.iend())
-	resize_yend(yend);
-    }
+		ssize_t ybegin, ssize_t yend)
+    { resize(xbegin, xend, ybegin, yend, value_t()); }
     
-    ssize_t xbegin() const { return m_default.ibegin(); }
+    ssize_t xbegin() const { return m_xbegin; }
     
-    ssize_t xend() const { return m_default.iend(); }
+    ssize_t xend() const { return m_xend; }
     
-    ssize_t ybegin() const { return m_grid.ibegin(); }
+    ssize_t ybegin() const { return m_ybegin; }
     
-    ssize_t yend() const { return m_grid.iend(); }
+    ssize_t yend() const { return m_yend; }
     
     /** Automatically resizes the flexgrid as required in order to
 	yield a valid value_t reference. */
     value_t & smart_at(ssize_t ix, ssize_t iy) {
-      if (ix < m_default.ibegin())
-	resize_xbegin(ix);
-      else if (ix >= m_default.iend())
-	resize_xend(ix + 1);
-      if (iy < m_grid.ibegin())
-	resize_ybegin(iy);
-      else if (iy >= m_grid.iend())
-	resize_yend(iy + 1);
-      return m_grid.at(iy).at(ix);
+      if ( ! valid(ix, iy))
+	reshape(std::min(ix, m_xbegin), std::max(ix + 1, m_xend),
+		std::min(iy, m_ybegin), std::max(iy + 1, m_yend),
+		value_t());
+      return get(ix, iy);
     }
     
-    line_iterator line_begin() { return m_grid.begin(); }
+    line_iterator line_begin()
+    { return line_iterator(line(m_ybegin), m_ybegin, m_bxsize); }
     
-    const_line_iterator line_begin() const { return m_grid.begin(); }
+    const_line_iterator line_begin() const
+    { return const_line_iterator(line(m_ybegin), m_ybegin, m_bxsize); }
     
-    line_iterator line_end() { return m_grid.end(); }
+    line_iterator line_end()
+    { return line_iterator(line(m_yend), m_yend, m_bxsize); }
     
-    const_line_iterator line_end() const { return m_grid.end(); }
+    const_line_iterator line_end() const
+    { return const_line_iterator(line(m_yend), m_yend, m_bxsize); }
     
-    iterator begin() {
-      return iterator(m_grid, m_default, m_default.ibegin(), m_grid.ibegin());
-    }
+    iterator begin()
+    { return iterator(*this, m_xbegin, m_ybegin); }
     
-    const_iterator begin() const {
-      return const_iterator(m_grid, m_default,
-			    m_default.ibegin(), m_grid.ibegin());
-    }
+    const_iterator begin() const
+    { return const_iterator(*this, m_xbegin, m_ybegin); }
     
     iterator end()
-    { return iterator(m_grid, m_default, m_default.iend(), m_grid.iend()); }
+    { return iterator(*this, m_xend, m_yend); }
     
-    const_iterator end() const {
-      return const_iterator(m_grid, m_default,
-			    m_default.iend(), m_grid.iend());
-    }
+    const_iterator end() const
+    { return const_iterator(*this, m_xend, m_yend); }
     
     bool valid(ssize_t ix, ssize_t iy) const {
-      return (ix >= m_default.ibegin())
-	&&   (ix <  m_default.iend())
-	&&   (iy >= m_grid.ibegin())
-	&&   (iy <  m_grid.iend());
+      return (ix >= m_xbegin)
+	&&   (ix <  m_xend)
+	&&   (iy >= m_ybegin)
+	&&   (iy <  m_yend);
     }
     
     bool valid_range(ssize_t xbegin, ssize_t xend,
 		     ssize_t ybegin, ssize_t yend) const {
-      return (xbegin >= m_default.ibegin())
-	&&   (xend   <= m_default.iend())
-	&&   (ybegin >= m_grid.ibegin())
-	&&   (yend   <= m_grid.iend());
+      return (xbegin >= m_xbegin)
+	&&   (xend   <= m_xend)
+	&&   (ybegin >= m_ybegin)
+	&&   (yend   <= m_yend);
     }
     
     bool valid_bbox(ssize_t x0, ssize_t y0, ssize_t x1, ssize_t y1) const {
-      return (x0 >= m_default.ibegin())
-	&&   (x1 <  m_default.iend())
-	&&   (y0 >= m_grid.ibegin())
-	&&   (y1 <  m_grid.iend());
+      return (x0 >= m_xbegin)
+	&&   (x1 <  m_xend)
+	&&   (y0 >= m_ybegin)
+	&&   (y1 <  m_yend);
     }
     
   protected:
     friend class flexgrid_iterator<value_t>;
     
-    grid_t m_grid;
-    line_t m_default;
+    /** valid index range */
+    ssize_t m_xbegin, m_xend, m_ybegin, m_yend;
+    /** index of the first buffer cell, and buffer dimensions */
+    ssize_t m_bx0, m_by0, m_bxsize, m_bysize;
+    /** buffer position of cell (0, 0), possibly outside the buffer */
+    ssize_t m_origin;
+    std::vector<value_t> m_buffer;
+    
+    /** Pointer to cell (xbegin, iy), also valid for the one-past-end
+	line (or when the buffer is empty) as long as it does not get
+	dereferenced. */
+    line_t line(ssize_t iy) {
+      value_t * base(0);
+      if ( ! m_buffer.empty())
+	base = &m_buffer[0] + ((iy - m_by0) * m_bxsize + m_xbegin - m_bx0);
+      return line_t(base, m_xbegin, m_xend);
+    }
+    
+    const_line_t line(ssize_t iy) const {
+      value_t const * base(0);
+      if ( ! m_buffer.empty())
+	base = &m_buffer[0] + ((iy - m_by0) * m_bxsize + m_xbegin - m_bx0);
+      return const_line_t(base, m_xbegin, m_xend);
+    }
+    
+    /** Set the valid range, reallocating if it does not fit into the
+	buffer, and fill all cells that were not valid before with the
+	given value. Cells that drop out of the valid range are simply
+	forgotten. */
+    void reshape(ssize_t xbegin, ssize_t xend,
+		 ssize_t ybegin, ssize_t yend,
+		 value_t const & value) {
+      bool const xfit((xbegin >= m_bx0) && (xend <= m_bx0 + m_bxsize));
+      bool const yfit((ybegin >= m_by0) && (yend <= m_by0 + m_bysize));
+      if (( ! xfit) || ( ! yfit))
+	reallocate(xbegin, xend, ybegin, yend);
+      ssize_t const oldxbegin(m_xbegin);
+      ssize_t const oldxend(m_xend);
+      ssize_t const oldybegin(m_ybegin);
+      ssize_t const oldyend(m_yend);
+      m_xbegin = xbegin;
+      m_xend = xend;
+      m_ybegin = ybegin;
+      m_yend = yend;
+      if ((xbegin >= xend) || (ybegin >= yend))
+	return;
+      bool const oldempty((oldxbegin >= oldxend) || (oldybegin >= oldyend));
+      for (ssize_t iy(ybegin); iy < yend; ++iy) {
+	value_t * row(&get(xbegin, iy));
+	if (oldempty || (iy < oldybegin) || (iy >= oldyend))
+	  std::fill(row, row + (xend - xbegin), value);
+	else {
+	  if (xbegin < oldxbegin)
+	    std::fill(row, row + (std::min(oldxbegin, xend) - xbegin), value);
+	  if (xend > oldxend)
+	    std::fill(row + (std::max(oldxend, xbegin) - xbegin),
+		      row + (xend - xbegin), value);
+	}
+      }
+    }
+    
+    /** Make the buffer cover the given range, with extra room on each
+	side that did not fit. The currently valid cells are copied
+	over, as far as they lie within the new range. */
+    void reallocate(ssize_t xbegin, ssize_t xend,
+		    ssize_t ybegin, ssize_t yend) {
+      ssize_t const xpad(std::max(xend - xbegin, static_cast<ssize_t>(1)));
+      ssize_t const ypad(std::max(yend - ybegin, static_cast<ssize_t>(1)));
+      ssize_t bx0(std::min(xbegin, m_bx0));
+      ssize_t bx1(std::max(xend, m_bx0 + m_bxsize));
+      ssize_t by0(std::min(ybegin, m_by0));
+      ssize_t by1(std::max(yend, m_by0 + m_bysize));
+      if (xbegin < m_bx0)
+	bx0 -= xpad;
+      if (xend > m_bx0 + m_bxsize)
+	bx1 += xpad;
+      if (ybegin < m_by0)
+	by0 -= ypad;
+      if (yend > m_by0 + m_bysize)
+	by1 += ypad;
+      
+      std::vector<value_t> buffer((by1 - by0) * (bx1 - bx0));
+      ssize_t const origin(- by0 * (bx1 - bx0) - bx0);
+      ssize_t const cx0(std::max(xbegin, m_xbegin));
+      ssize_t const cx1(std::min(xend, m_xend));
+      ssize_t const cy0(std::max(ybegin, m_ybegin));
+      ssize_t const cy1(std::min(yend, m_yend));
+      if (cx0 < cx1)
+	for (ssize_t iy(cy0); iy < cy1; ++iy) {
+	  value_t const * src(&get(cx0, iy));
+	  std::copy(src, src + (cx1 - cx0),
+		    &buffer[iy * (bx1 - bx0) + cx0 + origin]);
+	}
+      
+      m_buffer.swap(buffer);
+      m_bx0 = bx0;
+      m_by0 = by0;
+      m_bxsize = bx1 - bx0;
+      m_bysize = by1 - by0;
+      m_origin = origin;
+    }
   };
   
 }
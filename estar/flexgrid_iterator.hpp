@@ -36,7 +36,6 @@ namespace estar {
     typedef value_t * pointer_t;
     typedef value_t & reference_t;
     typedef typename traits::grid_t & grid_ref_t;
-    typedef typename traits::line_t & line_ref_t;
   };
   
   
@@ -47,7 +46,6 @@ namespace estar {
     typedef value_t const * pointer_t;
     typedef value_t const & reference_t;
     typedef typename traits::grid_t const & grid_ref_t;
-    typedef typename traits::line_t const & line_ref_t;
   };
   
   
@@ -67,16 +65,13 @@ namespace estar {
     
     // for const / non-const
     typedef typename traits::grid_ref_t     grid_ref_t;
-    typedef typename traits::line_ref_t     line_ref_t;
     
     
-    base_flexgrid_iterator(grid_ref_t grid, line_ref_t line,
-			   ssize_t ix, ssize_t iy)
-      : m_grid(grid), m_line(line), m_ix(ix), m_iy(iy) {}
+    base_flexgrid_iterator(grid_ref_t grid, ssize_t ix, ssize_t iy)
+      : m_grid(grid), m_ix(ix), m_iy(iy) {}
     
     base_flexgrid_iterator(base_flexgrid_iterator const & orig)
-      : m_grid(orig.m_grid), m_line(orig.m_line),
-	m_ix(orig.m_ix), m_iy(orig.m_iy) {}
+      : m_grid(orig.m_grid), m_ix(orig.m_ix), m_iy(orig.m_iy) {}
     
     bool at_end() const
     { return (m_ix >= xend()) || (m_iy >= yend()); }
@@ -85,10 +80,10 @@ namespace estar {
     { return (m_ix <= xbegin()) && (m_iy <= ybegin()); }
     
     reference operator*() const
-    { return m_grid.at(m_iy).at(m_ix); }
+    { return m_grid.get(m_ix, m_iy); }
     
     pointer operator->() const
-    { return &(m_grid.at(m_iy).at(m_ix)); }
+    { return &(m_grid.get(m_ix, m_iy)); }
     
     self & operator++() {
       increment();
@@ -129,13 +124,12 @@ namespace estar {
     
     ////  protected:
     grid_ref_t m_grid;
-    line_ref_t m_line;
     ssize_t m_ix, m_iy;
     
-    ssize_t xend() const { return m_line.iend(); }
-    ssize_t xbegin() const { return m_line.ibegin(); }
-    ssize_t yend() const { return m_grid.iend(); }
-    ssize_t ybegin() const { return m_grid.ibegin(); }
+    ssize_t xend() const { return m_grid.xend(); }
+    ssize_t xbegin() const { return m_grid.xbegin(); }
+    ssize_t yend() const { return m_grid.yend(); }
+    ssize_t ybegin() const { return m_grid.ybegin(); }
     
     void increment() {
       if (at_end())
@@ -183,10 +177,9 @@ namespace estar {
 				   flexgrid_iterator_traits<value_t> > base;
     
     typedef typename base::grid_ref_t grid_ref_t;
-    typedef typename base::line_ref_t line_ref_t;
     
-    flexgrid_iterator(grid_ref_t grid, line_ref_t line, ssize_t ix, ssize_t iy)
-      : base(grid, line, ix, iy) {}
+    flexgrid_iterator(grid_ref_t grid, ssize_t ix, ssize_t iy)
+      : base(grid, ix, iy) {}
     
     flexgrid_iterator(flexgrid_iterator const & orig)
       : base(orig) {}
@@ -204,11 +197,9 @@ namespace estar {
 			   flexgrid_const_iterator_traits<value_t> > base;
     
     typedef typename base::grid_ref_t grid_ref_t;
-    typedef typename base::line_ref_t line_ref_t;
     
-    const_flexgrid_iterator(grid_ref_t grid, line_ref_t line,
-			    ssize_t ix, ssize_t iy)
-      : base(grid, line, ix, iy) {}
+    const_flexgrid_iterator(grid_ref_t grid, ssize_t ix, ssize_t iy)
+      : base(grid, ix, iy) {}
     
     const_flexgrid_iterator(const_flexgrid_iterator const & orig)
       : base(orig) {}
@@ -1,16 +1,16 @@
-/* 
+/*
  * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
- * 
+ *
  * This program is free software; you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
  * the Free Software Foundation; either version 2 of the License, or
  * (at your option) any later version.
- * 
+ *
  * This program is distributed in the hope that it will be useful,
  * but WITHOUT ANY WARRANTY; without even the implied warranty of
  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
  * GNU General Public License for more details.
- * 
+ *
  * You should have received a copy of the GNU General Public License
  * along with this program; if not, write to the Free Software
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
@@ -18,27 +18,118 @@
  */
 
 
+
 #ifndef ESTAR_FLEXGRID_TRAITS_HPP
 #define ESTAR_FLEXGRID_TRAITS_HPP
 
 
-#include <estar/sdeque.hpp>
+#include <iterator>
+#include <unistd.h>
 
 
 namespace estar {
   
   
+  template<typename value_t>
+  class flexgrid;
+  
+  
+  /**
+     A view of one line (fixed Y index) of a flexgrid. It refers
+     directly into the contiguous storage of the grid and is
+     invalidated by anything that reallocates it, i.e. growing beyond
+     the current capacity.
+  */
+  template<typename pointer_t>
+  class flexgrid_line
+  {
+  public:
+    typedef pointer_t iterator;
+    typedef pointer_t const_iterator;
+    typedef typename std::iterator_traits<pointer_t>::reference reference;
+    
+    flexgrid_line(pointer_t base, ssize_t ibegin, ssize_t iend)
+      : m_base(base), m_ibegin(ibegin), m_iend(iend) {}
+    
+    /** \note Unchecked, as opposed to flexgrid::at(). */
+    reference at(ssize_t ii) const
+    { return m_base[ii - m_ibegin]; }
+    
+    ssize_t ibegin() const { return m_ibegin; }
+    
+    ssize_t iend() const { return m_iend; }
+    
+    iterator begin() const { return m_base; }
+    
+    iterator end() const { return m_base + (m_iend - m_ibegin); }
+    
+  private:
+    template<typename other_t> friend class flexgrid_line_iterator;
+    
+    pointer_t m_base;
+    ssize_t m_ibegin, m_iend;
+  };
+  
+  
+  /** Steps through the lines of a flexgrid, in increasing Y order. */
+  template<typename line_t>
+  class flexgrid_line_iterator
+  {
+  public:
+    flexgrid_line_iterator(line_t const & line, ssize_t iy, ssize_t stride)
+      : m_line(line), m_iy(iy), m_stride(stride) {}
+    
+    /** Allows converting line_iterator to const_line_iterator. */
+    template<typename other_t>
+    flexgrid_line_iterator(flexgrid_line_iterator<other_t> const & orig)
+      : m_line(orig.m_line.begin(), orig.m_line.ibegin(), orig.m_line.iend()),
+	m_iy(orig.m_iy), m_stride(orig.m_stride) {}
+    
+    line_t const & operator*() const { return m_line; }
+    
+    line_t const * operator->() const { return &m_line; }
+    
+    flexgrid_line_iterator & operator++() {
+      m_line.m_base += m_stride;
+      ++m_iy;
+      return *this;
+    }
+    
+    flexgrid_line_iterator & operator--() {
+      m_line.m_base -= m_stride;
+      --m_iy;
+      return *this;
+    }
+    
+    template<typename other_t>
+    bool operator==(flexgrid_line_iterator<other_t> const & other) const
+    { return m_iy == other.m_iy; }
+    
+    template<typename other_t>
+    bool operator!=(flexgrid_line_iterator<other_t> const & other) const
+    { return m_iy != other.m_iy; }
+    
+  private:
+    template<typename other_t> friend class flexgrid_line_iterator;
+    
+    line_t m_line;
+    ssize_t m_iy;
+    ssize_t m_stride;
+  };
+  
+  
   template<typename value_t>
   class flexgrid_traits
   {
   public:
-    typedef sdeque<value_t> line_t;
-    typedef typename line_t::iterator cell_iterator;
-    typedef typename line_t::const_iterator const_cell_iterator;
+    typedef flexgrid_line<value_t *> line_t;
+    typedef flexgrid_line<value_t const *> const_line_t;
+    typedef value_t * cell_iterator;
+    typedef value_t const * const_cell_iterator;
     
-    typedef sdeque<line_t> grid_t;
-    typedef typename grid_t::iterator line_iterator;
-    typedef typename grid_t::const_iterator const_line_iterator;
+    typedef flexgrid<value_t> grid_t;
+    typedef flexgrid_line_iterator<line_t> line_iterator;
+    typedef flexgrid_line_iterator<const_line_t> const_line_iterator;
   };
   
 }
@@ -435,17 +435,18 @@ namespace gfx {
 			double red, double green, double blue,
 			double linewidth, bool arrow)
   {
-    Upwind::map_t const & uwm(algo.GetUpwind().GetMap());
+    Upwind const & upwind(algo.GetUpwind());
 
     glLineWidth(linewidth);
     glBegin(GL_LINES);
     glColor3d(red, green, blue);
 
-    for(Upwind::map_t::const_iterator iu(uwm.begin()); iu != uwm.end(); ++iu){
+    for (vertex_read_iteration viter(cspace.begin());
+	 viter.not_at_end(); ++viter) {
       double xf, yf;
-      tie(xf, yf) = cspace.ComputePosition(iu->first);
-      const Upwind::set_t & ts(iu->second);
-      for(Upwind::set_t::const_iterator it(ts.begin()); it != ts.end(); ++it){
+      tie(xf, yf) = cspace.ComputePosition(*viter);
+      Upwind::downwind_it it, tend;
+      for(tie(it, tend) = upwind.GetDownwind(*viter); it != tend; ++it){
 	double xt, yt;
 	tie(xt, yt) = cspace.ComputePosition(*it);
 	double const xm(0.5 * (xf + xt));
@@ -535,6 +536,7 @@ namespace gfx {
       case FacadeReadInterface::WAVEFRONT: glColor3d(1, 0,   0); break;
       case FacadeReadInterface::GOAL:      glColor3d(0, 1,   0); break;
       case FacadeReadInterface::OBSTACLE:  glColor3d(1, 0,   1); break;
+      case FacadeReadInterface::BEYOND_HORIZON: glColor3d(0.5, 0.5, 0.5); break;
       case FacadeReadInterface::OUT_OF_GRID:
       default:
 	continue;
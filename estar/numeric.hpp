@@ -44,14 +44,28 @@
 namespace estar {
 
 
+#ifdef ESTAR_FLOAT_PROPERTIES
+  /** Storage type of the value, meta, and rhs C-space properties. */
+  typedef float cspace_real_t;
+#else
+  /** Storage type of the value, meta, and rhs C-space properties. */
+  typedef double cspace_real_t;
+#endif
+
+  // The infinity has to survive a round trip through cspace_real_t,
+  // so it is the largest finite value of the storage type.
 #ifdef WIN32
   // Under some circumstances, Visual C++ does not seem to like the
   // "proper" way, but sometimes it does. Anyway, this workaround
   // should do the trick. Note that initializing a non-integer static
   // const is not supposed to be standard either...
+# ifdef ESTAR_FLOAT_PROPERTIES
+  static const double infinity(FLT_MAX);
+# else
   static const double infinity(DBL_MAX);
+# endif
 #else
-  static const double infinity = std::numeric_limits<double>::max();
+  static const double infinity = std::numeric_limits<cspace_real_t>::max();
 #endif
 
   static const double epsilon = 1e3 * std::numeric_limits<double>::epsilon();
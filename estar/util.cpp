@@ -25,6 +25,10 @@
 # include <stdio.h>
 # include <signal.h>
 # include <stdlib.h>
+# include <time.h>
+# include <sys/time.h>
+#else // WIN32
+# include <time.h>
 #endif // WIN32
 
 
@@ -63,4 +67,22 @@ namespace estar {
   }
 #endif // WIN32
   
+  
+  double get_monotonic_time()
+  {
+#if defined(WIN32)
+    return static_cast<double>(clock()) / CLOCKS_PER_SEC;
+#elif defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+    if (0 == clock_gettime(CLOCK_MONOTONIC, &ts))
+      return ts.tv_sec + 1e-9 * ts.tv_nsec;
+    // fall back to the wall clock below
+#endif // WIN32 / CLOCK_MONOTONIC
+#ifndef WIN32
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + 1e-6 * tv.tv_usec;
+#endif // WIN32
+  }
+  
 }
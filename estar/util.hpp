@@ -43,6 +43,15 @@ namespace estar {
 #endif // WIN32
 
 
+  /**
+     \return Seconds on a monotonic clock (if the system provides
+     one), with an arbitrary origin. Only useful for measuring
+     durations and deadlines, such as for
+     Algorithm::ComputeUntil().
+  */
+  double get_monotonic_time();
+  
+  
   /**
      Simple 2D-array with "self destroying" underlying data.
    
@@ -0,0 +1,298 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+
+#include "DistanceTransform.hpp"
+#include "../estar/numeric.hpp"
+#include <algorithm>
+#include <cmath>
+
+
+using estar::infinity;
+using estar::square;
+
+
+namespace pnf {
+  
+  
+  DistanceTransform::
+  DistanceTransform(ssize_t _xsize, ssize_t _ysize, double _resolution)
+    : xsize(_xsize),
+      ysize(_ysize),
+      resolution(_resolution),
+      m_obstacle(_xsize * _ysize, 0),
+      m_dist2(m_obstacle.size(), infinity),
+      m_site(m_obstacle.size(), -1),
+      m_raise(m_obstacle.size(), 0),
+      m_dirty(false),
+      m_computed(false),
+      m_nupdated(0)
+  {
+  }
+  
+  
+  void DistanceTransform::
+  AddObstacle(ssize_t ix, ssize_t iy)
+  {
+    size_t const cell(Index(ix, iy));
+    if (m_obstacle[cell])
+      return;
+    m_obstacle[cell] = 1;
+    m_changed.push_back(cell);
+    m_dirty = true;
+  }
+  
+  
+  void DistanceTransform::
+  RemoveObstacle(ssize_t ix, ssize_t iy)
+  {
+    size_t const cell(Index(ix, iy));
+    if ( ! m_obstacle[cell])
+      return;
+    m_obstacle[cell] = 0;
+    m_changed.push_back(cell);
+    m_dirty = true;
+  }
+  
+  
+  double DistanceTransform::
+  GetValue(ssize_t ix, ssize_t iy) const
+  {
+    double const dist2(m_dist2[Index(ix, iy)]);
+    if (infinity == dist2)
+      return infinity;
+    return resolution * sqrt(dist2);
+  }
+  
+  
+  double DistanceTransform::
+  Distance2(size_t cell, size_t site) const
+  {
+    ssize_t const dx(static_cast<ssize_t>(cell / ysize)
+		     - static_cast<ssize_t>(site / ysize));
+    ssize_t const dy(static_cast<ssize_t>(cell % ysize)
+		     - static_cast<ssize_t>(site % ysize));
+    return dx * dx + dy * dy;
+  }
+  
+  
+  void DistanceTransform::
+  Compute()
+  {
+    // Beyond a sixteenth of the grid, the brushfire is unlikely to
+    // beat the linear-time transform.
+    if (( ! m_computed)
+	|| (16 * m_changed.size() > m_obstacle.size())) {
+      ComputeFromScratch();
+      return;
+    }
+    
+    m_nupdated = 0;
+    for (size_t ic(0); ic < m_changed.size(); ++ic) {
+      size_t const cell(m_changed[ic]);
+      // A cell might have changed back and forth, only its final
+      // state matters.
+      if (m_obstacle[cell]) {
+	if (static_cast<ssize_t>(cell) == m_site[cell])
+	  continue;
+	m_site[cell] = cell;
+	m_dist2[cell] = 0;
+	m_raise[cell] = 0;
+	++m_nupdated;
+	Push(cell, 0);
+      }
+      else if (static_cast<ssize_t>(cell) == m_site[cell]) {
+	m_site[cell] = -1;
+	m_dist2[cell] = infinity;
+	m_raise[cell] = 1;
+	++m_nupdated;
+	Push(cell, 0);
+      }
+    }
+    m_changed.clear();
+    
+    while ( ! m_queue.IsEmpty()) {
+      size_t const cell(m_queue.PopTop());
+      if (m_raise[cell])
+	Raise(cell);
+      else if ((0 <= m_site[cell]) && m_obstacle[m_site[cell]])
+	Lower(cell);
+    }
+    m_dirty = false;
+  }
+  
+  
+  void DistanceTransform::
+  Push(size_t cell, double key)
+  {
+    double oldkey;
+    if (m_queue.Find(cell, oldkey))
+      m_queue.Update(cell, key);
+    else
+      m_queue.Insert(cell, key);
+  }
+  
+  
+  /** Offer the nearest obstacle of a cell to its neighbors. */
+  void DistanceTransform::
+  Lower(size_t cell)
+  {
+    ssize_t const ix(cell / ysize);
+    ssize_t const iy(cell % ysize);
+    size_t const site(m_site[cell]);
+    for (ssize_t nx(ix - 1); nx <= ix + 1; ++nx) {
+      if ((nx < 0) || (nx >= xsize))
+	continue;
+      for (ssize_t ny(iy - 1); ny <= iy + 1; ++ny) {
+	if ((ny < 0) || (ny >= ysize))
+	  continue;
+	size_t const nbor(Index(nx, ny));
+	if (m_raise[nbor])
+	  continue;
+	double const dist2(Distance2(nbor, site));
+	if (dist2 < m_dist2[nbor]) {
+	  m_dist2[nbor] = dist2;
+	  m_site[nbor] = site;
+	  ++m_nupdated;
+	  Push(nbor, dist2);
+	}
+      }
+    }
+  }
+  
+  
+  /** Clear the neighbors whose nearest obstacle is gone, and queue
+      the others so that they fill in the cleared cells. */
+  void DistanceTransform::
+  Raise(size_t cell)
+  {
+    ssize_t const ix(cell / ysize);
+    ssize_t const iy(cell % ysize);
+    for (ssize_t nx(ix - 1); nx <= ix + 1; ++nx) {
+      if ((nx < 0) || (nx >= xsize))
+	continue;
+      for (ssize_t ny(iy - 1); ny <= iy + 1; ++ny) {
+	if ((ny < 0) || (ny >= ysize))
+	  continue;
+	size_t const nbor(Index(nx, ny));
+	if ((0 > m_site[nbor]) || m_raise[nbor])
+	  continue;
+	if (m_obstacle[m_site[nbor]])
+	  Push(nbor, m_dist2[nbor]);
+	else {
+	  double const key(m_dist2[nbor]);
+	  m_site[nbor] = -1;
+	  m_dist2[nbor] = infinity;
+	  m_raise[nbor] = 1;
+	  ++m_nupdated;
+	  Push(nbor, key);
+	}
+      }
+    }
+    m_raise[cell] = 0;
+  }
+  
+  
+  void DistanceTransform::
+  ComputeFromScratch()
+  {
+    m_changed.clear();
+    m_queue.Clear();
+    std::fill(m_raise.begin(), m_raise.end(), 0);
+    
+    // Columns are contiguous: find the nearest obstacle row within
+    // each column with one scan in each direction. Stored in m_site
+    // for now.
+    for (ssize_t ix(0); ix < xsize; ++ix) {
+      ssize_t * const row(&m_site[Index(ix, 0)]);
+      unsigned char const * const obstacle(&m_obstacle[Index(ix, 0)]);
+      ssize_t last(-1);
+      for (ssize_t iy(0); iy < ysize; ++iy) {
+	if (obstacle[iy])
+	  last = iy;
+	row[iy] = last;
+      }
+      last = -1;
+      for (ssize_t iy(ysize - 1); iy >= 0; --iy) {
+	if (obstacle[iy])
+	  last = iy;
+	if ((0 <= last)
+	    && ((0 > row[iy]) || (last - iy < iy - row[iy])))
+	  row[iy] = last;
+      }
+    }
+    
+    // Rows: lower envelope of the parabolas rooted at the nearest
+    // obstacle of each column. The row is gathered into scratch
+    // arrays so that the envelope works on unit strides.
+    std::vector<double> ff(xsize);
+    std::vector<ssize_t> colrow(xsize);
+    std::vector<ssize_t> vv(xsize);
+    std::vector<double> zz(xsize + 1);
+    for (ssize_t iy(0); iy < ysize; ++iy) {
+      for (ssize_t ix(0); ix < xsize; ++ix) {
+	colrow[ix] = m_site[Index(ix, iy)];
+	ff[ix] = (0 > colrow[ix]) ? infinity : square(double(iy - colrow[ix]));
+      }
+      ssize_t kk(-1);
+      for (ssize_t qq(0); qq < xsize; ++qq) {
+	if (infinity == ff[qq])
+	  continue;
+	double ss(-infinity);
+	while (kk >= 0) {
+	  ssize_t const pp(vv[kk]);
+	  ss = ((ff[qq] + qq * qq) - (ff[pp] + pp * pp)) / (2.0 * (qq - pp));
+	  if (ss > zz[kk])
+	    break;
+	  --kk;
+	}
+	if (kk < 0)
+	  ss = -infinity;
+	++kk;
+	vv[kk] = qq;
+	zz[kk] = ss;
+	zz[kk + 1] = infinity;
+      }
+      if (kk < 0) {
+	for (ssize_t ix(0); ix < xsize; ++ix) {
+	  m_dist2[Index(ix, iy)] = infinity;
+	  m_site[Index(ix, iy)] = -1;
+	}
+	continue;
+      }
+      ssize_t jj(0);
+      for (ssize_t qq(0); qq < xsize; ++qq) {
+	while (zz[jj + 1] < qq)
+	  ++jj;
+	ssize_t const pp(vv[jj]);
+	size_t const cell(Index(qq, iy));
+	m_dist2[cell] = square(double(qq - pp)) + ff[pp];
+	// Safe to overwrite: the column rows of this row were
+	// gathered into colrow above.
+	m_site[cell] = Index(pp, colrow[pp]);
+      }
+    }
+    
+    m_nupdated = m_obstacle.size();
+    m_computed = true;
+    m_dirty = false;
+  }
+  
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2007 Roland Philippsen <roland dot philippsen at gmx net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+
+#ifndef PNF_DISTANCE_TRANSFORM_HPP
+#define PNF_DISTANCE_TRANSFORM_HPP
+
+
+#include <estar/QueueBackend.hpp>
+#include <vector>
+
+
+namespace pnf {
+  
+  
+  /**
+     Euclidean distance from each cell of a grid to the center of the
+     nearest obstacle cell, as an alternative to propagating the
+     environment distance of Flow with E*.
+     
+     The first Compute() runs the separable transform of
+     Felzenszwalb and Huttenlocher: a scan along each column finds
+     the nearest obstacle in that column, then the lower envelope of
+     parabolas along each row gives the exact squared distance in
+     linear time. Obstacles that get added or removed later are
+     handled by a dynamic brushfire (Lau, Sprunk, and Burgard): each
+     cell remembers its nearest obstacle, insertions send out a
+     lowering wave, and removals first clear all cells that pointed
+     to the removed obstacle before the surrounding cells fill them
+     in again. Only the cells whose distance changes are touched.
+     
+     The brushfire passes nearest obstacles between eight-connected
+     neighbors, which is exact in practice. In rare configurations
+     it can report a slightly larger distance than the exact one,
+     which ComputeFromScratch() corrects.
+  */
+  class DistanceTransform
+  {
+  public:
+    DistanceTransform(ssize_t xsize, ssize_t ysize, double resolution);
+    
+    const ssize_t xsize, ysize;
+    const double resolution;
+    
+    /** Takes effect at the next Compute(). */
+    void AddObstacle(ssize_t ix, ssize_t iy);
+    
+    /** Takes effect at the next Compute(). */
+    void RemoveObstacle(ssize_t ix, ssize_t iy);
+    
+    bool IsObstacle(ssize_t ix, ssize_t iy) const
+    { return m_obstacle[Index(ix, iy)]; }
+    
+    /** \return true if obstacles have changed since the last
+	Compute(). */
+    bool HaveWork() const { return m_dirty; }
+    
+    /** Apply the obstacle changes since the last Compute(). This
+	runs the full transform the first time, or if a large part of
+	the grid has changed, and the brushfire otherwise. */
+    void Compute();
+    
+    /** Recompute all distances with the exact separable
+	transform. */
+    void ComputeFromScratch();
+    
+    /** \return The distance (in the units of the resolution) to the
+	nearest obstacle, infinity if there are none. */
+    double GetValue(ssize_t ix, ssize_t iy) const;
+    
+    /** \return The number of cells whose distance was set by the
+	last Compute(). */
+    size_t GetNUpdated() const { return m_nupdated; }
+    
+  private:
+    size_t Index(ssize_t ix, ssize_t iy) const { return ix * ysize + iy; }
+    
+    /** \return The squared distance between two cells, in cells. */
+    double Distance2(size_t cell, size_t site) const;
+    
+    void Push(size_t cell, double key);
+    void Lower(size_t cell);
+    void Raise(size_t cell);
+    
+    /** nonzero for obstacle cells */
+    std::vector<unsigned char> m_obstacle;
+    /** squared distance to the nearest obstacle, in cells */
+    std::vector<double> m_dist2;
+    /** index of the nearest obstacle, or -1 if there is none */
+    std::vector<ssize_t> m_site;
+    /** nonzero while a cell is part of a raise wave */
+    std::vector<unsigned char> m_raise;
+    /** cells whose obstacle status changed since the last Compute() */
+    std::vector<size_t> m_changed;
+    estar::HeapQueueBackend<4> m_queue;
+    bool m_dirty;
+    bool m_computed;
+    size_t m_nupdated;
+  };
+  
+}
+
+#endif // PNF_DISTANCE_TRANSFORM_HPP
@@ -25,6 +25,7 @@
 #include "Flow.hpp"
 #include "pnf_cooc.h"
 #include "BufferZone.hpp"
+#include "DistanceTransform.hpp"
 #include "../estar/RiskMap.hpp"
 #include "../estar/numeric.hpp"
 #include "../estar/Facade.hpp"
@@ -114,6 +115,20 @@ using namespace local;
 namespace pnf {
   
   
+  /** \return The environment distance of a vertex, taken from the
+      E* values unless the distance transform is used. */
+  static double envdist_value(GridCSpace const & cspace,
+			      value_map_t const & value_map,
+			      DistanceTransform const * edt,
+			      estar::vertex_t vertex)
+  {
+    if( ! edt)
+      return get(value_map, vertex);
+    GridNode const & node(cspace.LookupNode(vertex));
+    return edt->GetValue(node.ix, node.iy);
+  }
+  
+  
   Flow::
   Flow(ssize_t _xsize, ssize_t _ysize, double _resolution,
        bool _perform_convolution, bool _alternate_worst_case)
@@ -135,8 +150,10 @@ namespace pnf {
 			   _resolution,
 			   estar::GridOptions(0, _xsize, 0, _ysize),
 			   estar::AlgorithmOptions(),
-			   0))
-    // m_goal invalid until SetGoal()
+			   0)),
+      // m_goal invalid until SetGoal()
+      m_robdist_ceiling(infinity),
+      m_objdist_ceiling(infinity)
   {
   }
   
@@ -164,14 +181,43 @@ namespace pnf {
   void Flow::
   AddStaticObject(ssize_t ix, ssize_t iy)
   {
-    m_envdist->AddGoal(ix, iy, 0);
+    if(m_edt)
+      m_edt->AddObstacle(ix, iy);
+    else
+      m_envdist->AddGoal(ix, iy, 0);
   }
   
   
   void Flow::
   RemoveStaticObject(ssize_t ix, ssize_t iy)
   {
-    m_envdist->RemoveGoal(ix, iy);
+    if(m_edt)
+      m_edt->RemoveObstacle(ix, iy);
+    else
+      m_envdist->RemoveGoal(ix, iy);
+  }
+  
+  
+  void Flow::
+  SetEnvdistBackend(envdist_backend_t backend)
+  {
+    if(backend == GetEnvdistBackend())
+      return;
+    if(EDT_ENVDIST == backend){
+      m_edt.reset(new DistanceTransform(xsize, ysize, resolution));
+      for(ssize_t ix(0); ix < xsize; ++ix)
+	for(ssize_t iy(0); iy < ysize; ++iy)
+	  if(m_envdist->IsGoal(ix, iy))
+	    m_edt->AddObstacle(ix, iy);
+      m_envdist->RemoveAllGoals();
+    }
+    else{
+      for(ssize_t ix(0); ix < xsize; ++ix)
+	for(ssize_t iy(0); iy < ysize; ++iy)
+	  if(m_edt->IsObstacle(ix, iy))
+	    m_envdist->AddGoal(ix, iy, 0);
+      m_edt.reset();
+    }
   }
   
   
@@ -191,6 +237,7 @@ namespace pnf {
 			  estar::AlgorithmOptions(),
 			  0));
     BOOST_ASSERT( dist );
+    dist->SetCeiling(m_objdist_ceiling);
     const double object_radius(r + half_diagonal);
     shared_ptr<Object>
       obj(new Object(id, object_radius, v, region, dist, xsize, ysize));
@@ -229,6 +276,7 @@ namespace pnf {
 			  estar::AlgorithmOptions(),
 			  0));
     BOOST_ASSERT( dist );
+    dist->SetCeiling(m_robdist_ceiling);
     const double robot_radius(r + half_diagonal);
     m_robot.reset(new Robot(robot_radius, v, region, dist, xsize, ysize));
     
@@ -236,22 +284,49 @@ namespace pnf {
   }
   
   
-  /** \todo Can return true after reaching max {object, robot} radius,
-      see Algorithm::GetMaxKnownValue(). */
+  void Flow::
+  SetEnvdistCeiling(double ceiling)
+  {
+    m_envdist->SetCeiling(ceiling);
+  }
+  
+  
+  void Flow::
+  SetRobdistCeiling(double ceiling)
+  {
+    m_robdist_ceiling = ceiling;
+    if(m_robot)
+      m_robot->dist->SetCeiling(ceiling);
+  }
+  
+  
+  void Flow::
+  SetObjdistCeiling(double ceiling)
+  {
+    m_objdist_ceiling = ceiling;
+    for(objectmap_t::iterator io(m_object.begin()); io != m_object.end(); ++io)
+      io->second->dist->SetCeiling(ceiling);
+  }
+  
+  
   bool Flow::
   HaveEnvdist()
     const
   {
+    if(m_edt)
+      return ! m_edt->HaveWork();
     return ! m_envdist->HaveWork();
   }
   
   
-  /** \todo Can stop after reaching max {object, robot} radius, see
-      Algorithm::GetMaxKnownValue(). */
   void Flow::
   PropagateEnvdist(bool step)
   {
-    if(step){
+    if(m_edt){
+      if(m_edt->HaveWork())
+	m_edt->Compute();
+    }
+    else if(step){
       if(m_envdist->HaveWork())
 	m_envdist->ComputeOne();
     }
@@ -271,6 +346,7 @@ namespace pnf {
     const value_map_t & envdist(m_envdist->GetAlgorithm().GetValueMap());
     const vertexid_map_t &
       vertexid(m_envdist->GetAlgorithm().GetVertexIdMap());
+    const GridCSpace & envcspace(*m_envdist->GetCSpace());
     
     // if you want to be paranoid, this should be specific for each
     // object as well as the robot... but they're all using the same
@@ -287,7 +363,8 @@ namespace pnf {
       // various C-spaces!
       for (vertex_read_iteration viter(m_envdist->GetCSpace()->begin());
 	   viter.not_at_end(); ++viter)
-	if (viter.get(envdist) > m_robot->radius)
+	if (envdist_value(envcspace, envdist, m_edt.get(), *viter)
+	    > m_robot->radius)
 	  robalgo.SetMeta(viter.get(vertexid), freespace, robkernel);
 	else
 	  robalgo.SetMeta(viter.get(vertexid), obstacle, robkernel);
@@ -305,7 +382,8 @@ namespace pnf {
 	
 	for (vertex_read_iteration viter(m_envdist->GetCSpace()->begin());
 	     viter.not_at_end(); ++viter)
-	  if (viter.get(envdist) > io->second->radius)
+	  if (envdist_value(envcspace, envdist, m_edt.get(), *viter)
+	      > io->second->radius)
 	    objalgo.SetMeta(viter.get(vertexid), freespace, objkernel);
 	  else
 	    objalgo.SetMeta(viter.get(vertexid), obstacle, objkernel);
@@ -404,6 +482,7 @@ namespace pnf {
     ////const value_map_t & objdist(obj.dist->GetAlgorithm().GetValueMap());
     shared_ptr<Grid const> objgrid(obj.dist->GetGrid());
     shared_ptr<GridCSpace const> objcspace(obj.dist->GetCSpace());
+    const double ceiling(obj.dist->GetAlgorithm().GetCeiling());
     obj.max_lambda = -1;	// could be more paranoid...
     for(ssize_t ix(0); ix < xsize; ++ix)
       for(ssize_t iy(0); iy < ysize; ++iy){
@@ -418,7 +497,8 @@ namespace pnf {
 	  shared_ptr<GridNode const> node(objgrid->GetNode(jx, jy));
 	  if (node) {
 	    double const ll(objcspace->GetValue(node->vertex));
-	    if(ll < lambda)
+	    // values beyond the ceiling are stale or infinite anyway
+	    if((ll < lambda) && (ll <= ceiling))
 	      lambda = ll;
 	  }
 	}
@@ -490,10 +570,13 @@ namespace pnf {
     m_max_env_cooc = 0;
     const value_map_t & envdist(m_envdist->GetAlgorithm().GetValueMap());
     shared_ptr<GridCSpace const> const envcspace(m_envdist->GetCSpace());
+    const double ceiling(m_envdist->GetAlgorithm().GetCeiling());
     
     for (vertex_read_iteration viter(m_envdist->GetCSpace()->begin());
 	 viter.not_at_end(); ++viter) {
-      double const dist(viter.get(envdist));
+      double dist(envdist_value(*envcspace, envdist, m_edt.get(), *viter));
+      if (dist > ceiling)
+	dist = infinity;
       double cooc;
       
       if (buffer)
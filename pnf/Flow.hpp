@@ -52,6 +52,7 @@ namespace pnf {
   
   
   class BufferZone;
+  class DistanceTransform;
   
 
   /** High-level interface for PNF. Uses underlying estar::Facade
@@ -67,6 +68,14 @@ namespace pnf {
   public:
     typedef std::pair<const estar::array<double> *, double> array_info_t;
     
+    /** How the distance to static objects gets computed. */
+    typedef enum {
+      /** LSM E* wavefront, the original implementation */
+      ESTAR_ENVDIST,
+      /** exact Euclidean distance transform, see DistanceTransform */
+      EDT_ENVDIST
+    } envdist_backend_t;
+    
     const ssize_t xsize, ysize;
     const double resolution;
     const double half_diagonal;
@@ -77,6 +86,38 @@ namespace pnf {
 			 bool perform_convolution, bool alternate_worst_case);
     ~Flow();
     
+    /**
+       Value ceilings for the distance layers, see
+       estar::Algorithm::SetCeiling(). Cells beyond a layer's ceiling
+       are not propagated, and count as infinitely far away when
+       computing lambdas and co-occurrences. All ceilings are
+       infinite by default. The envdist ceiling should not be lower
+       than the largest object radius, or the robot radius times the
+       static buffer factor, whichever is larger. The robdist and
+       objdist ceilings also apply to robots and objects that are set
+       later on.
+    */
+    void SetEnvdistCeiling(double ceiling);
+    void SetRobdistCeiling(double ceiling);
+    void SetObjdistCeiling(double ceiling);
+    
+    /**
+       Switch the environment distance to another backend. The static
+       objects are carried over, so this can be called at any time,
+       but the distances need to be propagated again. With
+       EDT_ENVDIST, PropagateEnvdist() computes everything at once
+       even if step is true, and GetEnvdist() still returns the
+       (now unused) E* Facade.
+    */
+    void SetEnvdistBackend(envdist_backend_t backend);
+    
+    envdist_backend_t GetEnvdistBackend() const
+    { return m_edt ? EDT_ENVDIST : ESTAR_ENVDIST; }
+    
+    /** \return 0 unless the backend is EDT_ENVDIST */
+    const DistanceTransform * GetEnvdistTransform() const
+    { return m_edt.get(); }
+    
     bool HaveEnvdist() const;
     void PropagateEnvdist(bool step);
     
@@ -178,10 +219,14 @@ namespace pnf {
     typedef std::map<size_t, boost::shared_ptr<local::Object> > objectmap_t;
     
     boost::scoped_ptr<estar::Facade>  m_envdist;
+    /** only used for EDT_ENVDIST */
+    boost::scoped_ptr<DistanceTransform> m_edt;
     boost::scoped_ptr<local::Robot>   m_robot;
     objectmap_t                       m_object;
     boost::scoped_ptr<estar::Facade>  m_pnf;
     boost::scoped_ptr<estar::Region>  m_goal;
+    double                            m_robdist_ceiling;
+    double                            m_objdist_ceiling;
     
     boost::scoped_ptr<estar::array<double> > m_env_cooc;
     double m_max_env_cooc;